@@ -38,12 +38,14 @@ public:
 	uint64_t          off_;
 	CTimeout          timeout_;
 	AsyncIO           aio_;
+	struct timespec  *rxTs_;   // streams: kernel receive timestamp (optional)
 	CReadArgs()
 	: cacheable_ ( IField::UNKNOWN_CACHEABLE ),
 	  dst_       ( NULL ),
 	  nbytes_    ( 0 ),
 	  off_       ( 0 ),
-	  timeout_   ( TIMEOUT_INDEFINITE )
+	  timeout_   ( TIMEOUT_INDEFINITE ),
+	  rxTs_      ( NULL )
 	{
 	}
 };
@@ -192,6 +194,13 @@ class CAddressImpl : public IAddress {
 		virtual uint64_t dispatchRead (CompositePathIterator *node, CReadArgs *args)  const;
 		virtual uint64_t dispatchWrite(CompositePathIterator *node, CWriteArgs *args) const;
 
+		// Same as 'read/write(CompositePathIterator*, ...)' for a single
+		// element 'idx' (bypassing the path); used by precompiled access
+		// plans (CAccessPlan). A subclass which overrides the former must
+		// override these, too.
+		virtual uint64_t readElement (unsigned idx, CReadArgs  *args) const;
+		virtual uint64_t writeElement(unsigned idx, CWriteArgs *args) const;
+
 		virtual int  getOpenCount()
 		{
 			return openCount_.load( cpsw::memory_order_acquire );
@@ -166,6 +166,7 @@ class IProtoStackBuilder {
 public:
 	typedef enum SRPProtoVersion    { SRP_UDP_NONE = -1, SRP_UDP_V1 = 1, SRP_UDP_V2 = 2, SRP_UDP_V3 = 3 } SRPProtoVersion;
 	typedef enum DepackProtoVersion { DEPACKETIZER_V0 =  0, DEPACKETIZER_V2 = 2                         } DepackProtoVersion;
+	typedef enum SchedPolicy        { SCHED_POLICY_DEFAULT = -1, SCHED_POLICY_OTHER = 0, SCHED_POLICY_FIFO = 1, SCHED_POLICY_RR = 2 } SchedPolicy;
 
 	const static int DFLT_THREAD_PRIORITY =  0;
 	const static int NORT_THREAD_PRIORITY =  0;
@@ -189,6 +190,12 @@ public:
 	virtual void               setSRPDefaultWriteMode(WriteMode)   = 0; // default: POSTED
 	virtual WriteMode          getSRPDefaultWriteMode()            = 0;
 
+	// Let synchronous callers spin (polling the UDP socket) for up to
+	// this many us for a reply before blocking. Implies inline SRP
+	// demultiplexing; ignored if the stack has no plain UDP transport.
+	virtual void               setSRPBusyPollUS(unsigned)          = 0; // default: 0 (always block)
+	virtual unsigned           getSRPBusyPollUS()                  = 0;
+
 	virtual bool               hasTcp()                            = 0; // default: NO
     virtual void               setTcpPort(unsigned)                = 0; // default: 8192
 	virtual unsigned           getTcpPort()                        = 0;
@@ -196,6 +203,10 @@ public:
 	virtual unsigned           getTcpOutQueueDepth()               = 0;
 	virtual void               setTcpThreadPriority(int)           = 0;
 	virtual int                getTcpThreadPriority()              = 0;
+	virtual void               setTcpZeroCopyThreshold(unsigned)   = 0; // default: 0 (no MSG_ZEROCOPY)
+	virtual unsigned           getTcpZeroCopyThreshold()           = 0;
+	virtual void               setTcpUseUring(bool)                = 0; // default: NO (RX thread)
+	virtual bool               getTcpUseUring()                    = 0;
 
 	virtual bool               hasUdp()                            = 0; // default: YES
 	virtual void               setUdpPort(unsigned)                = 0; // default: 8192
@@ -208,6 +219,22 @@ public:
 	virtual int                getUdpPollSecs()                    = 0;
 	virtual void               setUdpThreadPriority(int)           = 0;
 	virtual int                getUdpThreadPriority()              = 0;
+	virtual void               setUdpUseReactor(bool)              = 0; // default: NO (RX/poller threads)
+	virtual bool               getUdpUseReactor()                  = 0;
+	virtual void               setUdpUseUring(bool)                = 0; // default: NO
+	virtual bool               getUdpUseUring()                    = 0;
+	virtual void               setUdpUsePacketRing(bool)           = 0; // default: NO
+	virtual bool               getUdpUsePacketRing()               = 0;
+	virtual void               setUdpUseSharedSocket(bool)         = 0; // default: NO
+	virtual bool               getUdpUseSharedSocket()             = 0;
+	virtual void               setUdpUseGso(bool)                  = 0; // default: NO
+	virtual bool               getUdpUseGso()                      = 0;
+	virtual void               setUdpUseGro(bool)                  = 0; // default: NO
+	virtual bool               getUdpUseGro()                      = 0;
+	virtual void               setUdpRcvBufSize(unsigned)          = 0; // default: 0 (kernel default)
+	virtual unsigned           getUdpRcvBufSize()                  = 0;
+	virtual void               setUdpSndBufSize(unsigned)          = 0; // default: 0 (kernel default)
+	virtual unsigned           getUdpSndBufSize()                  = 0;
 
 	virtual void               useRssi(bool)                       = 0; // default: NO
 	virtual bool               hasRssi()                           = 0;
@@ -236,6 +263,8 @@ public:
 	virtual unsigned           getSRPMuxOutQueueDepth()            = 0;
 	virtual void               setSRPMuxThreadPriority(int)        = 0;
 	virtual int                getSRPMuxThreadPriority()           = 0;
+	virtual void               setSRPMuxInlineDemux(bool)          = 0; // default: NO (use a thread)
+	virtual bool               getSRPMuxInlineDemux()              = 0;
 
 	virtual void               useTDestMux(bool)                   = 0; // default: NO
 	virtual bool               hasTDestMux()                       = 0;
@@ -249,6 +278,8 @@ public:
 	virtual unsigned           getTDestMuxInpQueueDepth()          = 0;
 	virtual void               setTDestMuxThreadPriority(int)      = 0;
 	virtual int                getTDestMuxThreadPriority()         = 0;
+	virtual void               setTDestMuxInlineDemux(bool)        = 0; // default: NO (use a thread)
+	virtual bool               getTDestMuxInlineDemux()            = 0;
 
 	virtual void               setIPAddr(uint32_t)                 = 0;
 	virtual uint32_t           getIPAddr()                         = 0;
@@ -260,6 +291,16 @@ public:
 	virtual void               setSocksProxy(LibSocksProxyPtr)     = 0;
 	virtual LibSocksProxyPtr   getSocksProxy()                     = 0;
 
+	// CPU affinity and scheduling policy for all threads of the stack's
+	// protocol modules (and the SRP async handler). The affinity is a list
+	// of CPUs, e.g., "2,4-7"; SCHED_POLICY_FIFO/RR use the modules' thread
+	// priorities (or 1 if these are <= 0). Process-wide defaults may be
+	// set with the environment variables CPSW_CPU_AFFINITY, CPSW_SCHED_POLICY.
+	virtual void               setThreadCpuAffinity(const char *)  = 0; // default: "" (process default)
+	virtual const char        *getThreadCpuAffinity()              = 0;
+	virtual void               setThreadSchedPolicy(SchedPolicy)   = 0; // default: SCHED_POLICY_DEFAULT
+	virtual SchedPolicy        getThreadSchedPolicy()              = 0;
+
 	virtual void               reset()                             = 0; // reset to defaults
 
 	virtual bool               getAutoStart()                      = 0;
@@ -315,6 +356,11 @@ public:
 	virtual const char *getSocksProxyString() const = 0;
 	virtual const char *getRssiBridgeString() const = 0;
 
+	// Dump statistics counters of all protocol stacks
+	// (keyed by child name and protocol module).
+	// The counters may be sampled at any time.
+	virtual void        dumpStats(YAML::Node &) const = 0;
+
 	static NetIODev create(const char *name, const char *ipaddr);
 };
 
@@ -421,6 +421,29 @@ public:
 	 * Retrieve a list of all children
 	 */
 	virtual Children   getChildren()               const = 0;
+
+	/*!
+	 * Raw snapshot of all readable integer registers underneath
+	 * this hub (in target byte order). The hierarchy is compiled
+	 * into a flat register table on first use; thereafter,
+	 * 'findByName' also resolves paths through this table.
+	 * The hub must be locked (i.e., be attached to a parent or
+	 * loaded from YAML).
+	 *
+	 * A snapshot can only be restored into the same hierarchy;
+	 * use 'dumpConfigToYaml' for a portable configuration.
+	 *
+	 * RETURNS: size of the snapshot (bytes)
+	 */
+	virtual uint64_t   saveRegisters(std::vector<uint8_t> *snapshot) const = 0;
+
+	/*!
+	 * Restore a snapshot taken by 'saveRegisters'; read-only
+	 * registers are skipped.
+	 *
+	 * RETURNS: size of the snapshot (bytes)
+	 */
+	virtual uint64_t   restoreRegisters(const std::vector<uint8_t> &snapshot) const = 0;
 };
 
 /*!
@@ -810,6 +833,25 @@ public:
 	 */
 	virtual int64_t read(uint8_t *buf, uint64_t size,  const CTimeout timeoutUs = TIMEOUT_INDEFINITE, uint64_t off = 0) = 0;
 
+	/*!
+	 * Read raw bytes (see above) and store the kernel receive timestamp
+	 * of the frame in 'rxTimestamp'. The timestamp is on the CLOCK_REALTIME
+	 * scale and taken when the (last) datagram or segment of the frame
+	 * arrived at the socket. It is zeroed if no timestamp is available
+	 * (or nothing was read).
+	 *
+	 * The default implementation (for streams that do not record
+	 * timestamps) forwards to the plain 'read' and zeroes 'rxTimestamp'.
+	 */
+	virtual int64_t read(uint8_t *buf, uint64_t size,  const CTimeout timeoutUs, uint64_t off, struct timespec *rxTimestamp)
+	{
+		if ( rxTimestamp ) {
+			rxTimestamp->tv_sec  = 0;
+			rxTimestamp->tv_nsec = 0;
+		}
+		return read( buf, size, timeoutUs, off );
+	}
+
 	/*!
 	 * Write raw bytes to a streaming interface and return the number of bytes written.
 	 */
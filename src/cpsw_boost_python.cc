@@ -412,6 +412,11 @@ public:
 		return s()->read( buf, size, timeoutUs, off );
 	}
 
+	virtual int64_t read(uint8_t *buf, uint64_t size,  const CTimeout timeoutUs, uint64_t off, struct timespec *rxTimestamp)
+	{
+		return s()->read( buf, size, timeoutUs, off, rxTimestamp );
+	}
+
 	virtual int64_t write(uint8_t *buf, uint64_t size, const CTimeout timeoutUs)
 	{
 		return s()->write( buf, size, timeoutUs );
@@ -40,6 +40,8 @@ private:
 	BufImpl      tail_;
 	unsigned     len_;
 	size_t       size_;
+	bool         hasRxTs_;
+	struct timespec rxTs_;
 
 	virtual void setHead(BufImpl h);
 	virtual void setTail(BufImpl t);
@@ -78,6 +80,9 @@ public:
 	virtual uint64_t extract(void *buf, uint64_t off, uint64_t size);
 	virtual void     insert(void *buf, uint64_t off, uint64_t size, size_t capa);
 
+	virtual bool     getRxTimestamp(struct timespec *ts_p);
+	virtual void     setRxTimestamp(const struct timespec *ts_p);
+
 	// when a shared pointer to a chain expires then the
 	// entire chain is automatically released - even without
 	// an explicit destructor. However, this process is recursive
@@ -432,7 +437,8 @@ unsigned rval, i;
 CBufChainImpl::CBufChainImpl( CFreeListNodeKey<CBufChainImpl> k )
 : CFreeListNode<CBufChainImpl>( k ),
   len_(0),
-  size_(0)
+  size_(0),
+  hasRxTs_(false)
 {
 }
 
@@ -694,6 +700,21 @@ CBufChainImpl::setLen(unsigned l)
 	len_   = l;
 }
 
+bool
+CBufChainImpl::getRxTimestamp(struct timespec *ts_p)
+{
+	if ( hasRxTs_ && ts_p )
+		*ts_p = rxTs_;
+	return hasRxTs_;
+}
+
+void
+CBufChainImpl::setRxTimestamp(const struct timespec *ts_p)
+{
+	if ( (hasRxTs_ = (0 != ts_p)) )
+		rxTs_ = *ts_p;
+}
+
 CBufChainImpl::~CBufChainImpl()
 {
 	BufImpl b = getTailImpl();
@@ -151,6 +151,14 @@ public:
 	// existing data are overwritten.
 	virtual void     insert(void *buf, uint64_t off, uint64_t size, size_t capa = IBuf::CAPA_MAX )  = 0;
 
+	// kernel receive timestamp (CLOCK_REALTIME) of the datagram
+	// or segment this chain was received in. A chain assembled
+	// from several of those carries the latest one.
+	// 'getRxTimestamp' RETURNS false if there is no timestamp;
+	// 'setRxTimestamp(NULL)' clears it.
+	virtual bool     getRxTimestamp(struct timespec *ts_p)       = 0;
+	virtual void     setRxTimestamp(const struct timespec *ts_p) = 0;
+
 	virtual ~IBufChain(){}
 
 	static BufChain create();
@@ -39,8 +39,6 @@ public:
 	virtual void getAbsTimeout(CTimeout *abs_timeout, const CTimeout *rel_timeout) = 0;
 
 	virtual IEventSource *getEventSource()                          = 0;
-
-	static void clockRealtimeGetAbsTimeout(CTimeout *abs_timeout, const CTimeout *rel_timeout);
 };
 
 class CEventBufSync : public IBufSync, public IIntEventSource, public IEventHandler {
@@ -361,19 +359,3 @@ BufChain CBufQueue::pop(bool wait, const CTimeout *abs_timeout)
 	// timeout (or trywait failed)
 	return BufChain( reinterpret_cast<BufChain::element_type *>(0) );
 }
-
-void IBufSync::clockRealtimeGetAbsTimeout(CTimeout *abs_timeout, const CTimeout *rel_timeout)
-{
-
-	if ( ! rel_timeout || rel_timeout->isIndefinite() ) {
-		*abs_timeout = TIMEOUT_INDEFINITE;
-		return;
-	}
-
-	if ( clock_gettime( CLOCK_REALTIME, &abs_timeout->tv_ ) )
-		throw InternalError("clock_gettime failed", errno);
-
-	if ( ! rel_timeout->isNone() ) {
-		*abs_timeout += *rel_timeout;
-	}
-}
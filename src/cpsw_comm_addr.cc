@@ -11,6 +11,7 @@
 
 #include <cpsw_comm_addr.h>
 #include <cpsw_yaml.h>
+#include <cpsw_thread.h>
 
 void CCommAddressImpl::dump(FILE *f) const
 {
@@ -23,6 +24,42 @@ void CCommAddressImpl::dump(FILE *f) const
 			m->dumpInfo( f );
 		}
 	}
+	fprintf(f,"\n");
+	{
+	std::vector<CRunnable*> threads;
+		getThreads( &threads );
+		CRunnable::dumpThreads( f, &threads );
+	}
+}
+
+void CCommAddressImpl::setThreadSched(const char *cpuAffinity, IProtoStackBuilder::SchedPolicy schedPolicy)
+{
+	threadCpuAffinity_ = cpuAffinity ? cpuAffinity : "";
+	threadSchedPolicy_ = schedPolicy;
+}
+
+void CCommAddressImpl::getThreads(std::vector<CRunnable*> *threads) const
+{
+	if ( protoStack_ ) {
+		ProtoMod m;
+		for ( m = protoStack_->getProtoMod(); m; m=m->getUpstreamProtoMod() ) {
+			m->getThreads( threads );
+		}
+	}
+}
+
+void CCommAddressImpl::dumpStats(YAML::Node &node) const
+{
+	if ( protoStack_ ) {
+		ProtoMod m;
+		for ( m = protoStack_->getProtoMod(); m; m=m->getUpstreamProtoMod() ) {
+			YAML::Node modStats;
+			m->dumpStats( modStats );
+			if ( modStats.size() > 0 ) {
+				writeNode(node, m->getName(), modStats);
+			}
+		}
+	}
 }
 
 void
@@ -35,6 +72,12 @@ ProtoPort port;
 	YAML::Node noSRP;
 	writeNode(noSRP, YAML_KEY_protocolVersion, IProtoStackBuilder::SRP_UDP_NONE);
 	writeNode(node , YAML_KEY_SRP,             noSRP                  );
+	if ( ! threadCpuAffinity_.empty() ) {
+		writeNode(node, YAML_KEY_cpuAffinity, threadCpuAffinity_);
+	}
+	if ( IProtoStackBuilder::SCHED_POLICY_DEFAULT != threadSchedPolicy_ ) {
+		writeNode(node, YAML_KEY_schedPolicy, threadSchedPolicy_);
+	}
 	for ( port = protoStack_; port; port = port->getUpstreamPort() ) {
 		port->dumpYaml( node );
 	}
@@ -101,6 +144,10 @@ BufChain bch;
 	if ( ! bch )
 		return 0;
 
+	if ( args->rxTs_ ) {
+		bch->getRxTimestamp( args->rxTs_ );
+	}
+
 	return bch->extract( args->dst_, args->off_, args->nbytes_ );
 }
 
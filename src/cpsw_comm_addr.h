@@ -10,10 +10,14 @@
 #ifndef CPSW_COMM_ADDRESS_H
 #define CPSW_COMM_ADDRESS_H
 
+#include <cpsw_api_builder.h>
 #include <cpsw_proto_mod.h>
 #include <cpsw_address.h>
 #include <cpsw_mutex.h>
 
+#include <string>
+#include <vector>
+
 class CCommAddressImpl : public CAddressImpl {
 protected:
 	ProtoPort      protoStack_;
@@ -23,12 +27,17 @@ protected:
 
 	CMtx           doorMtx_;
 
+	// per-stack thread settings (as configured; for dumpYaml)
+	std::string                     threadCpuAffinity_;
+	IProtoStackBuilder::SchedPolicy threadSchedPolicy_;
+
 public:
 	CCommAddressImpl(AKey k, ProtoPort protoStack)
-	: CAddressImpl( k          ),
-	  protoStack_ ( protoStack ),
-	  running_    ( false      ),
-	  mtu_        ( 0          )
+	: CAddressImpl      ( k                                      ),
+	  protoStack_       ( protoStack                             ),
+	  running_          ( false                                  ),
+	  mtu_              ( 0                                      ),
+	  threadSchedPolicy_( IProtoStackBuilder::SCHED_POLICY_DEFAULT )
 	{
 	}
 
@@ -55,8 +64,18 @@ public:
 	virtual uint64_t read (CReadArgs *args)  const;
 	virtual uint64_t write(CWriteArgs *args) const;
 
+	// record the stack's thread settings (already applied to the
+	// modules by the builder) so that they are dumped to YAML
+	virtual void setThreadSched(const char *cpuAffinity, IProtoStackBuilder::SchedPolicy schedPolicy);
+
+	// append the threads of all protocol modules
+	virtual void getThreads(std::vector<CRunnable*> *threads) const;
+
 	virtual void dump(FILE *f) const;
 
+	// collect statistics of all protocol modules
+	virtual void dumpStats(YAML::Node &) const;
+
 	virtual ~CCommAddressImpl();
 
 	virtual bool isRunning() const;
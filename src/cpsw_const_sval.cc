@@ -161,6 +161,20 @@ unsigned rval = getVal(buf, nelms, elsz, it);
 	return rval;
 }
 
+unsigned
+CConstIntEntryAdapt::getVal(AsyncIO aio, uint8_t  *buf, unsigned nelms, unsigned elsz, IndexRange *r)
+{
+SlicedPathIterator it( p_, r );
+	return getVal( aio, buf, nelms, elsz, &it );
+}
+
+unsigned
+CConstIntEntryAdapt::getVal(uint8_t  *buf, unsigned nelms, unsigned elsz, IndexRange *r)
+{
+SlicedPathIterator it( p_, r );
+	return getVal( buf, nelms, elsz, &it );
+}
+
 unsigned
 CConstIntEntryAdapt::getVal(uint8_t  *buf, unsigned nelms, unsigned elsz, SlicedPathIterator *it)
 {
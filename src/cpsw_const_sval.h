@@ -63,6 +63,10 @@ public:
 
 	virtual unsigned getVal(uint8_t  *, unsigned, unsigned, SlicedPathIterator *it);
 	virtual unsigned getVal(AsyncIO aio, uint8_t  *, unsigned, unsigned, SlicedPathIterator *it);
+
+	// no I/O; bypass the access plan
+	virtual unsigned getVal(uint8_t  *, unsigned, unsigned, IndexRange *r);
+	virtual unsigned getVal(AsyncIO aio, uint8_t  *, unsigned, unsigned, IndexRange *r);
 };
 
 class CConstDblEntryAdapt : public virtual CDoubleVal_ROAdapt {
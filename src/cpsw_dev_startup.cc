@@ -0,0 +1,255 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_dev_startup.h>
+#include <cpsw_stdio.h>
+
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <algorithm>
+
+using cpsw::dynamic_pointer_cast;
+
+CDevStartup::CWorker::CWorker(const char *name, CDevStartup *startup)
+: CRunnable( name    ),
+  startup_ ( startup )
+{
+}
+
+void *
+CDevStartup::CWorker::threadBody()
+{
+	startup_->work();
+	return NULL;
+}
+
+CDevStartup::CDevStartup(DevImpl root)
+: nDone_   ( 0             ),
+  t0_      ( 0             ),
+  totalUs_ ( 0             ),
+  nThreads_( 0             ),
+  mtx_     ( "CDevStartup" )
+{
+	collect( root, -1, root->getName() );
+}
+
+CDevStartup::CDevStartup(const std::vector<DevImpl> &roots)
+: nDone_   ( 0             ),
+  t0_      ( 0             ),
+  totalUs_ ( 0             ),
+  nThreads_( 0             ),
+  mtx_     ( "CDevStartup" )
+{
+unsigned i;
+
+	for ( i = 0; i < roots.size(); i++ ) {
+		collect( roots[i], -1, roots[i]->getName() );
+	}
+}
+
+int64_t
+CDevStartup::now()
+{
+struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void
+CDevStartup::collect(DevImpl dev, int parent, const std::string &name)
+{
+int                      me = nodes_.size();
+Node                     n;
+CDevImpl::const_iterator it;
+DevImpl                  child;
+
+	n.dev_     = dev;
+	n.name_    = name;
+	n.parent_  = parent;
+	n.pending_ = 0;
+	n.startUs_ = 0;
+	n.durUs_   = -1;
+
+	nodes_.push_back( n );
+
+	for ( it = dev->begin(); it != dev->end(); ++it ) {
+		if ( (child = dynamic_pointer_cast<CDevImpl>( it->second->getEntryImpl() )) ) {
+			nodes_[me].pending_++;
+			collect( child, me, name + "/" + it->first );
+		}
+	}
+
+	// leaves may start right away
+	if ( 0 == nodes_[me].pending_ ) {
+		ready_.push_back( me );
+	}
+}
+
+void
+CDevStartup::work()
+{
+unsigned     idx;
+int64_t      t;
+
+	while ( 1 ) {
+	CPSWErrorHdl err;
+
+		{
+		CMtx::lg GUARD( &mtx_ );
+			while ( ready_.empty() && ! error_ && nDone_ < nodes_.size() ) {
+				pthread_cond_wait( cond_.getp(), mtx_.getp() );
+			}
+			if ( error_ || nDone_ == nodes_.size() ) {
+				return;
+			}
+			idx = ready_.back();
+			ready_.pop_back();
+		}
+
+		t = now();
+
+		try {
+			nodes_[idx].dev_->startUp();
+		} catch ( CPSWError &e ) {
+			err = e.clone();
+		} catch ( std::exception &e ) {
+			err = cpsw::make_shared<CPSWError>( std::string( "Startup of " ) + nodes_[idx].name_ + ": " + e.what() );
+		}
+
+		{
+		CMtx::lg GUARD( &mtx_ );
+			nodes_[idx].startUs_ = t - t0_;
+			nodes_[idx].durUs_   = now() - t;
+			nDone_++;
+			if ( err ) {
+				if ( ! error_ ) {
+					error_ = err;
+				}
+			} else if ( nodes_[idx].parent_ >= 0 && 0 == --nodes_[ nodes_[idx].parent_ ].pending_ ) {
+				ready_.push_back( nodes_[idx].parent_ );
+			}
+			pthread_cond_broadcast( cond_.getp() );
+		}
+	}
+}
+
+void
+CDevStartup::run(unsigned nThreads)
+{
+std::vector<CWorker*> workers;
+unsigned              i;
+
+	if ( nThreads > nodes_.size() ) {
+		nThreads = nodes_.size();
+	}
+	if ( 0 == nThreads ) {
+		nThreads = 1;
+	}
+	nThreads_ = nThreads;
+
+	t0_ = now();
+
+	// the caller is a worker, too
+	for ( i = 1; i < nThreads; i++ ) {
+		workers.push_back( new CWorker( "CPSW Startup", this ) );
+		workers.back()->threadStart();
+	}
+
+	work();
+
+	for ( i = 0; i < workers.size(); i++ ) {
+		workers[i]->threadJoin();
+		delete workers[i];
+	}
+
+	totalUs_ = now() - t0_;
+
+	if ( error_ ) {
+		error_->throwMe();
+	}
+}
+
+struct SlowerThan {
+	const std::vector<CDevStartup::Node> *nodes_;
+
+	bool operator()(unsigned a, unsigned b) const
+	{
+		return (*nodes_)[a].durUs_ > (*nodes_)[b].durUs_;
+	}
+};
+
+void
+CDevStartup::dumpReport(FILE *f, unsigned max) const
+{
+std::vector<unsigned> order( nodes_.size() );
+SlowerThan            cmp;
+unsigned              i;
+
+	for ( i = 0; i < order.size(); i++ ) {
+		order[i] = i;
+	}
+	cmp.nodes_ = &nodes_;
+	std::stable_sort( order.begin(), order.end(), cmp );
+
+	if ( 0 == max || max > order.size() ) {
+		max = order.size();
+	}
+
+	fprintf(f, "Startup of %lu Devs (%u threads): %" PRId64 "us\n", (unsigned long)nodes_.size(), nThreads_, totalUs_);
+	fprintf(f, "  %12s %12s  %s\n", "took (us)", "at (us)", "Dev");
+	for ( i = 0; i < max; i++ ) {
+	const Node *n = &nodes_[ order[i] ];
+		if ( n->durUs_ < 0 ) {
+			fprintf(f, "  %12s %12s  %s\n", "-", "-", n->name_.c_str());
+		} else {
+			fprintf(f, "  %12" PRId64 " %12" PRId64 "  %s\n", n->durUs_, n->startUs_, n->name_.c_str());
+		}
+	}
+}
+
+static unsigned       startupThreads = CDevStartup::DFLT_THREADS;
+static unsigned       startupReport  = 0;
+static pthread_once_t startupOnce    = PTHREAD_ONCE_INIT;
+
+static void
+readStartupEnv()
+{
+const char *str;
+
+	if ( (str = getenv( "CPSW_STARTUP_THREADS" )) ) {
+		if ( 1 != sscanf( str, "%u", &startupThreads ) || 0 == startupThreads ) {
+			fprintf( CPSW::fErr(), "CDevStartup: ignoring invalid CPSW_STARTUP_THREADS: %s\n", str );
+			startupThreads = CDevStartup::DFLT_THREADS;
+		}
+	}
+	if ( (str = getenv( "CPSW_STARTUP_REPORT" )) ) {
+		if ( 1 != sscanf( str, "%u", &startupReport ) ) {
+			fprintf( CPSW::fErr(), "CDevStartup: ignoring invalid CPSW_STARTUP_REPORT: %s\n", str );
+			startupReport = 0;
+		}
+	}
+}
+
+unsigned
+CDevStartup::getDefaultThreads()
+{
+	pthread_once( &startupOnce, readStartupEnv );
+	return startupThreads;
+}
+
+unsigned
+CDevStartup::getDefaultReport()
+{
+	pthread_once( &startupOnce, readStartupEnv );
+	return startupReport;
+}
@@ -0,0 +1,114 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_DEV_STARTUP_H
+#define CPSW_DEV_STARTUP_H
+
+#include <cpsw_hub.h>
+#include <cpsw_mutex.h>
+#include <cpsw_condvar.h>
+#include <cpsw_thread.h>
+#include <cpsw_error.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Start up all Devs of a (locked) hierarchy, i.e., execute
+// 'CDevImpl::startUp()' (which brings up the protocol stacks of
+// NetIODevs: sockets, RSSI connections, SRP version probing, ...)
+// with bounded parallelism.
+//
+// Like the (serial) depth-first traversal this replaces, a Dev
+// is only started once all Devs below it have been started. Devs
+// in different branches are started concurrently by a pool of
+// worker threads -- a board which is down (and makes its RSSI
+// connection time out) no longer delays all the others.
+//
+// The first error thrown by any 'startUp()' is re-thrown (after
+// all running 'startUp()' calls have returned) from a clone, i.e.,
+// as a CPSWError; Devs which have not been started yet are then
+// skipped.
+//
+// The time every Dev took is recorded and may be reported.
+//
+// Defaults may be set with the environment variables
+//  CPSW_STARTUP_THREADS  max. number of workers (default: 8;
+//                        1 starts everything from the caller's
+//                        thread)
+//  CPSW_STARTUP_REPORT   print the N slowest Devs (and the total)
+//                        to the debug stream after startup
+//                        (default: 0, no report)
+
+class CDevStartup {
+public:
+	struct Node {
+		DevImpl      dev_;
+		std::string  name_;
+		int          parent_;   // index; < 0 for the root
+		unsigned     pending_;  // children not started yet
+		int64_t      startUs_;  // relative to the start of 'run()'
+		int64_t      durUs_;    // < 0 if not started
+	};
+
+private:
+	class CWorker : public CRunnable {
+	private:
+		CDevStartup *startup_;
+	protected:
+		virtual void *threadBody();
+	public:
+		CWorker(const char *name, CDevStartup *startup);
+		virtual ~CWorker() { threadStop(); }
+	};
+
+	std::vector<Node>      nodes_;
+	std::vector<unsigned>  ready_;
+	unsigned               nDone_;
+	int64_t                t0_;
+	int64_t                totalUs_;
+	unsigned               nThreads_;
+	CPSWErrorHdl           error_;
+	CMtx                   mtx_;
+	CCond                  cond_;
+
+	CDevStartup(const CDevStartup&);
+	CDevStartup & operator=(const CDevStartup&);
+
+	void     collect(DevImpl dev, int parent, const std::string &name);
+
+	// execute ready Devs until all are done (or an error occurred)
+	void     work();
+
+	static int64_t now();
+
+public:
+	static const unsigned DFLT_THREADS = 8;
+
+	CDevStartup(DevImpl root);
+
+	// multiple (independent) hierarchies
+	CDevStartup(const std::vector<DevImpl> &roots);
+
+	// start everything using (at most) 'nThreads' workers
+	void     run(unsigned nThreads = getDefaultThreads());
+
+	unsigned getNumDevs()          const { return nodes_.size(); }
+	const Node *getNode(unsigned i) const { return &nodes_[i];   }
+	int64_t  getTotalUs()          const { return totalUs_;      }
+
+	// the 'max' slowest Devs (0: all)
+	void     dumpReport(FILE *f, unsigned max = 0) const;
+
+	static unsigned getDefaultThreads();
+	static unsigned getDefaultReport();
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include <cpsw_entry_adapt.h>
 #include <cpsw_stream_adapt.h>
 #include <cpsw_hub.h>
+#include <cpsw_str_intern.h>
 #include <ctype.h>
 
 #include <cpsw_obj_cnt.h>
@@ -31,7 +32,7 @@ static DECLARE_OBJ_COUNTER( ocnt, "EntryImpl", 1 ) // root device
 void CEntryImpl::checkArgs()
 {
 const char *cptr;
-	for ( cptr = name_.c_str(); *cptr; cptr++ ) {
+	for ( cptr = name_; *cptr; cptr++ ) {
 		if ( ! isalnum( *cptr )
 		             && '_' != *cptr 
 		             && '-' != *cptr  )
@@ -41,13 +42,14 @@ const char *cptr;
 
 CEntryImpl::CEntryImpl(Key &k, const char *name, uint64_t size)
 : CShObj(k),
-  name_( name ),
-  singleInterfaceOnly_( false ),
+  name_( CStrIntern::intern( name ) ),
+  description_( CStrIntern::intern( "" ) ),
   size_( size),
+  pollSecs_(DFLT_POLL_SECS()),
   cacheable_( DFLT_CACHEABLE ),
   configPrio_( DFLT_CONFIG_PRIO ),
+  singleInterfaceOnly_( false ),
   configPrioSet_( false ),
-  pollSecs_(DFLT_POLL_SECS()),
   locked_( false )
 {
 	checkArgs();
@@ -58,12 +60,12 @@ CEntryImpl::CEntryImpl(const CEntryImpl &ei, Key &k)
 : CShObj(ei,k),
   name_(ei.name_),
   description_(ei.description_),
-  singleInterfaceOnly_(ei.singleInterfaceOnly_),
   size_(ei.size_),
+  pollSecs_( DFLT_POLL_SECS() ),       // reset copy to default
   cacheable_( DFLT_CACHEABLE ),      // reset copy to default
   configPrio_( DFLT_CONFIG_PRIO ),   // reset copy to default
+  singleInterfaceOnly_(ei.singleInterfaceOnly_),
   configPrioSet_( false ),           // reset copy to default
-  pollSecs_( DFLT_POLL_SECS() ),       // reset copy to default
   locked_( false )
 {
 	++ocnt();
@@ -71,13 +73,14 @@ CEntryImpl::CEntryImpl(const CEntryImpl &ei, Key &k)
 
 CEntryImpl::CEntryImpl(Key &key, YamlState &ypath)
 : CShObj(key),
-  name_( ypath.getName() ),
-  singleInterfaceOnly_( false ),
+  name_( CStrIntern::intern( ypath.getName() ) ),
+  description_( CStrIntern::intern( "" ) ),
   size_( DFLT_SIZE ),
+  pollSecs_( DFLT_POLL_SECS() ),
   cacheable_( DFLT_CACHEABLE ),
   configPrio_( DFLT_CONFIG_PRIO ),
+  singleInterfaceOnly_( false ),
   configPrioSet_( false ),
-  pollSecs_( DFLT_POLL_SECS() ),
   locked_( false )
 {
 
@@ -166,12 +169,12 @@ CEntryImpl::~CEntryImpl()
 
 void CEntryImpl::setDescription(const char *desc)
 {
-	description_ = desc;
+	description_ = CStrIntern::intern( desc );
 }
 
 void CEntryImpl::setDescription(const std::string &desc)
 {
-	description_ = desc;
+	description_ = CStrIntern::intern( desc );
 }
 
 
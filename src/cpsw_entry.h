@@ -48,9 +48,10 @@ class CEntryImpl: public virtual IField, public CShObj, public CYamlSupportBase
 		// WARNING -- when modifying fields you might need to
 		//            modify 'operator=' as well as the copy
 		//            constructor!
-		std::string	        name_;
-		std::string         description_;
-		bool                singleInterfaceOnly_;
+		// Fields are ordered by size (no padding); there may be
+		// many thousands of entries.
+		const char         *name_;        // interned (CStrIntern)
+		const char         *description_; // interned (CStrIntern)
 	protected:
 		uint64_t    	    size_;
 	private:
@@ -78,14 +79,14 @@ class CEntryImpl: public virtual IField, public CShObj, public CYamlSupportBase
 			~CUniqueListHead() throw();
 		};
 
+		mutable double          pollSecs_;
+		mutable CMtxLazy        uniqueListMtx_;
+		mutable CUniqueListHead uniqueListHead_;
 		mutable Cacheable       cacheable_;
 		mutable int             configPrio_;
+		bool                    singleInterfaceOnly_;
 		mutable bool            configPrioSet_;
-		mutable double          pollSecs_;
 		mutable bool            locked_;
-		mutable CMtxLazy        uniqueListMtx_;
-		mutable CUniqueListHead uniqueListHead_;
-		mutable int             started_;
 
 		CEntryImpl(const CEntryImpl &);
 		CEntryImpl &operator=(const CEntryImpl&);
@@ -129,12 +130,12 @@ class CEntryImpl: public virtual IField, public CShObj, public CYamlSupportBase
 
 		virtual const char *getName() const
 		{
-			return name_.c_str();
+			return name_;
 		}
 
 		virtual const char *getDescription() const
 		{
-			return description_.c_str();
+			return description_;
 		}
 
 		virtual double getPollSecs() const
@@ -179,7 +180,7 @@ class CEntryImpl: public virtual IField, public CShObj, public CYamlSupportBase
 			locked_ = true;
 		}
 
-		virtual bool getLocked()
+		virtual bool getLocked() const
 		{
 			return locked_;
 		}
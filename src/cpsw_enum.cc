@@ -9,6 +9,7 @@
 
 #include <cpsw_enum.h>
 #include <cpsw_obj_cnt.h>
+#include <cpsw_str_intern.h>
 
 #include <stdio.h>
 
@@ -85,9 +86,8 @@ IEnum::iterator CEnumImpl::end() const
 
 void CEnumImpl::add(const char *str, uint64_t val)
 {
-string *s  = new string(str);
-CString cs = CString(s);
-	push_back( Item( cs, val ) );
+	// identical items of many enums share one string
+	push_back( Item( CStrIntern::internCString( str ), val ) );
 	nelms_++;
 }
 
@@ -10,34 +10,124 @@
 #include <cpsw_shared_obj.h>
 #include <cpsw_event.h>
 #include <cpsw_mutex.h>
-#include <cpsw_condvar.h>
 #include <vector>
+#include <set>
 
 #include <pthread.h>
 #include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 
 using std::vector;
 using cpsw::weak_ptr;
 
+// Sources which notified the set are kept on a 'ready' list
+// (ordered by the time they were added to the set so that the
+// relative priority of sources is preserved). Only these are
+// polled; a source stays on the list until it is polled and
+// found idle. Threads waiting for events sleep on an eventfd.
+
 class CEventSet : public IEventSet, public CShObj {
 protected:
 	typedef std::pair<IEventSource*, IEventHandler *> Binding;
+	typedef std::pair<uint64_t, IEventSource*>        ReadyKey;
+	typedef std::set<ReadyKey>                        ReadySet;
 	typedef shared_ptr<CEventSet>                     EventSetImpl;
 private:
 	vector<Binding>       srcs_;
+	ReadySet              ready_;
+	uint64_t              seq_;
 
 	CMtx                  mutx_;
-	CCond                 cnd_;
+	int                   efd_;
+	unsigned              nSleepers_;
+	IEventListener       *listener_;
 
 	CEventSet(const CEventSet &orig);
 	CEventSet operator=(const CEventSet &orig);
 
 	bool tryRemoveSrc(IEventHandler *);
 
+	// release the mutex while sleeping; the destructor
+	// also runs if the sleeping thread is cancelled.
+	class CSleeper {
+	private:
+		CEventSet *set_;
+	public:
+		CSleeper(CEventSet *set)
+		: set_( set )
+		{
+			set_->nSleepers_++;
+			set_->mutx_.u();
+		}
+
+		~CSleeper()
+		{
+			set_->mutx_.l();
+			set_->nSleepers_--;
+		}
+	};
+
+	// NOTE: caller must hold mutx_
+	void markReady(IEventSource *src)
+	{
+		if ( ! src->listed_ ) {
+			ready_.insert( ReadyKey( src->seq_, src ) );
+			src->listed_ = true;
+		}
+	}
+
+	// NOTE: caller must hold mutx_
+	void unmarkReady(IEventSource *src)
+	{
+		if ( src->listed_ ) {
+			ready_.erase( ReadyKey( src->seq_, src ) );
+			src->listed_ = false;
+		}
+	}
+
+	// NOTE: caller must hold mutx_
+	void wakeup()
+	{
+	uint64_t one = 1;
+		if ( nSleepers_ > 0 ) {
+			if ( sizeof(one) != write( efd_, &one, sizeof(one) ) ) {
+				throw InternalError("CEventSet: unable to write eventfd", errno);
+			}
+		}
+		if ( listener_ ) {
+			listener_->eventNotify();
+		}
+	}
+
+	// NOTE: caller must hold mutx_
+	void removeAt(unsigned i)
+	{
+	unsigned j;
+		unmarkReady( srcs_[i].first );
+		srcs_[i].first->handler_ = 0;
+		for ( j=i+1; j<srcs_.size(); j++ ) {
+			srcs_[j-1] = srcs_[j];
+		}
+		srcs_.pop_back();
+	}
+
 public:
 
-	CEventSet(Key &k):CShObj(k), mutx_("EVS") {}
+	CEventSet(Key &k, IEventListener *listener = NULL)
+	: CShObj    ( k                                                ),
+	  seq_      ( 0                                                ),
+	  mutx_     ( "EVS"                                            ),
+	  efd_      ( eventfd( 0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC ) ),
+	  nSleepers_( 0                                                ),
+	  listener_ ( listener                                         )
+	{
+		if ( efd_ < 0 ) {
+			throw InternalError("CEventSet: unable to create eventfd", errno);
+		}
+	}
 
 	virtual void add(IEventSource *src, IEventHandler *h)
 	{
@@ -59,19 +149,27 @@ public:
 			for ( i=0; i<srcs_.size(); i++ ) {
 				if ( srcs_[i].first == src ) {
 					// replace existing
-					srcs_[i] = Binding(src,h);
+					srcs_[i]      = Binding(src,h);
+					src->handler_ = h;
 					src->setEventSet( getSelfAs<EventSetImpl>() );
+					markReady( src );
+					wakeup();
 					return;
 				}
 			}
 			srcs_.push_back( Binding(src,h) );
+			src->handler_ = h;
+			src->seq_     = seq_++;
 			src->setEventSet( getSelfAs<EventSetImpl>() );
+			// the condition might already be true
+			markReady( src );
+			wakeup();
 		}
 	}
 
 	virtual void del(IEventSource *src)
 	{
-	unsigned i,j;
+	unsigned i;
 
 	// Source hold the last reference to 'this' event set.
 	// Make sure the rug is not pulled out...
@@ -84,10 +182,7 @@ public:
 
 			for ( i=0; i<srcs_.size(); i++ ) {
 				if ( srcs_[i].first == src ) {
-					for ( j=i+1; j<srcs_.size(); j++ ) {
-						srcs_[j-1] = srcs_[j];
-					}
-					srcs_.pop_back();
+					removeAt( i );
 					src->clrEventSet( getSelfAs<EventSetImpl>() );
 					return;
 				}
@@ -114,30 +209,74 @@ public:
 		}
 	}
 
-
-	virtual Binding *pollAll()
+	// NOTE: caller must hold mutx_
+	virtual bool pollReady(Binding *b)
 	{
-	unsigned i;
-	Binding *rval;
-
-		for ( i=0; i<srcs_.size(); i++ ) {
-			rval = &srcs_[i];
-			if ( rval->second->isEnabled() && rval->first->poll() ) {
-				return rval;
+	ReadySet::iterator it = ready_.begin();
+	IEventSource      *src;
+
+		while ( it != ready_.end() ) {
+			src = it->second;
+			if ( ! src->handler_->isEnabled() ) {
+				// keep it listed; will be polled once re-enabled
+				++it;
+				continue;
 			}
+			if ( src->poll() ) {
+				// stays listed -- there may be more events
+				*b = Binding( src, src->handler_ );
+				return true;
+			}
+			src->listed_ = false;
+			ready_.erase( it++ );
 		}
-		return NULL;
+		return false;
 	}
 
-	virtual Binding *getEvent(bool wait, const CTimeout *abs_timeout)
+	// NOTE: caller must hold mutx_; returns false on timeout
+	virtual bool waitForWakeup(const CTimeout *abs_timeout)
 	{
-	int         st;
-	Binding   *rval     = 0;
-	CPSWError *theError = 0;
+	struct pollfd    pfd;
+	struct timespec  rel;
+	struct timespec *relp = 0;
+	uint64_t         val;
+	int              st;
+
+		if ( abs_timeout ) {
+			CTimeout now;
+			getAbsTime( &now );
+			if ( ! (now < *abs_timeout) ) {
+				return false;
+			}
+			rel  = (*abs_timeout - now).tv_;
+			relp = &rel;
+		}
 
-		mutx_.l();
+		pfd.fd      = efd_;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+
+		{
+		CSleeper sleeper( this );
+			st = ppoll( &pfd, 1, relp, NULL );
+			if ( st > 0 ) {
+				// may fail with EAGAIN if another sleeper took the token
+				if ( read( efd_, &val, sizeof(val) ) < 0 && EAGAIN != errno ) {
+					st = -1;
+				}
+			}
+		}
 
-		pthread_cleanup_push( CCond::pthread_mutex_unlock_wrapper, (void*)mutx_.getp() );
+		if ( st < 0 && EINTR != errno ) {
+			throw InternalError("CEventSet: waiting for events failed", errno);
+		}
+
+		return 0 != st;
+	}
+
+	virtual bool getEvent(bool wait, const CTimeout *abs_timeout, Binding *b)
+	{
+	CMtx::lg guard( &mutx_ );
 
 		if ( wait && abs_timeout ) {
 			if ( abs_timeout->isNone() ) {
@@ -147,73 +286,53 @@ public:
 			}
 		}
 
-		try {
-			while ( ! (rval = pollAll()) ) {
-
-				if ( wait ) {
-					if ( abs_timeout ) {
-						st = pthread_cond_timedwait( cnd_.getp(), mutx_.getp(), &abs_timeout->tv_ );
-					} else {
-						st = pthread_cond_wait( cnd_.getp(), mutx_.getp() );
-					}
-
-					if ( st ) {
-						if ( ETIMEDOUT == st )
-							break; // rval is NULL
-
-						throw CondWaitFailed();
-					}
-
-				} else {
-					break; // rval is NULL
-				}
+		while ( ! pollReady( b ) ) {
+			if ( ! wait || ! waitForWakeup( abs_timeout ) ) {
+				return false;
 			}
-		} catch ( CPSWError &err ) {
-			// it is not possible to preserve the precise type
-			// of the error (unless we put down a full list of catch clauses :-().
-			// We must preserve across pthread_cleanup_pop :-(
-			theError = new CPSWError( err );
-		}
-
-		pthread_cleanup_pop( 1 ); // unlocks mutx_
-
-		if ( theError ) {
-			// Assume this is rare...
-			CPSWError aCopy( *theError );
-			delete theError;
-			throw aCopy;
 		}
-
-		return rval;
+		return true;
 	}
 
 	virtual bool processEvent(bool wait, const CTimeout *abs_timeout)
 	{
-		Binding *b;
+		Binding b;
 
-		if ( (b = getEvent(wait, abs_timeout)) ) {
-			b->first->handle( b->second );
+		if ( getEvent(wait, abs_timeout, &b) ) {
+			b.first->handle( b.second );
 			return true;
 		}
 		return false;
 	}
 
-	virtual void notify()
+	virtual void notify(IEventSource *src)
 	{
 		// an event condition could have become true
 		// after the receiving thread last polled
-		// but before it went to sleep. In order to
-		// synchronize with this condition we
-		// must take the mutex!
+		// but before it went to sleep. The eventfd
+		// retains the wakeup in this case.
+		CMtx::lg guard( &mutx_ );
+
+		if ( src->handler_ ) {
+			markReady( src );
+		}
+		wakeup();
+	}
+
+	virtual void notify()
+	{
+	unsigned i;
 		CMtx::lg guard( &mutx_ );
 
-		if ( pthread_cond_signal( cnd_.getp() ) )
-			throw CondSignalFailed();
+		for ( i=0; i<srcs_.size(); i++ ) {
+			markReady( srcs_[i].first );
+		}
+		wakeup();
 	}
 
 	virtual void getAbsTimeout(CTimeout *abs_timeout, const CTimeout *rel_timeout)
 	{
-		if ( clock_gettime( CLOCK_REALTIME, & abs_timeout->tv_ ) )
+		if ( clock_gettime( CLOCK_MONOTONIC, & abs_timeout->tv_ ) )
 			throw InternalError("clock_gettime failed");
 		if ( rel_timeout )
 			*abs_timeout += *rel_timeout;
@@ -222,7 +341,7 @@ public:
 	virtual CTimeout getAbsTimeout(const CTimeout *rel_timeout)
 	{
 	CTimeout rval;
-		if ( clock_gettime( CLOCK_REALTIME, & rval.tv_ ) )
+		if ( clock_gettime( CLOCK_MONOTONIC, & rval.tv_ ) )
 			throw InternalError("clock_gettime failed");
 		if ( rel_timeout )
 			rval += *rel_timeout;
@@ -231,13 +350,13 @@ public:
 
 	virtual void getAbsTime(CTimeout *abs_time)
 	{
-		if ( clock_gettime( CLOCK_REALTIME, & abs_time->tv_ ) )
+		if ( clock_gettime( CLOCK_MONOTONIC, & abs_time->tv_ ) )
 			throw InternalError("clock_gettime failed");
 	}
 
 	virtual ~CEventSet() throw();
 
-	static EventSetImpl create();
+	static EventSetImpl create(IEventListener *listener = NULL);
 };
 
 EventSet IEventSet::create()
@@ -245,9 +364,14 @@ EventSet IEventSet::create()
 	return CEventSet::create();
 }
 
-CEventSet::EventSetImpl CEventSet::create()
+EventSet IEventSet::create(IEventListener *listener)
 {
-	return CShObj::create<EventSetImpl>();
+	return CEventSet::create( listener );
+}
+
+CEventSet::EventSetImpl CEventSet::create(IEventListener *listener)
+{
+	return CShObj::create<EventSetImpl>( listener );
 }
 
 IEventSource::~IEventSource()
@@ -287,7 +411,7 @@ void IEventSource::notify()
 CMtx::lg guard( &mtx_ );
 
 	if ( eventSet_ )
-		eventSet_->notify();
+		eventSet_->notify( this );
 }
 
 bool CIntEventSource::checkForEvent()
@@ -307,7 +431,7 @@ int sent = sentVal_.exchange( 0, memory_order_acquire );
 bool CEventSet::tryRemoveSrc(IEventHandler *h)
 {
 IEventSource *src;
-unsigned     i,j;
+unsigned     i;
 
 // Source hold the last reference to 'this' event set.
 // Make sure the rug is not pulled out...
@@ -326,10 +450,7 @@ CMtx::lg guard( &mutx_ );
 
 				CMtx::lg guard( &src->mtx_, false /* dont' block */);
 
-				for ( j=i+1; j<srcs_.size(); j++ ) {
-					srcs_[j-1] = srcs_[j];
-				}
-				srcs_.pop_back();
+				removeAt( i );
 				src->clrEventSet( getSelfAs<EventSetImpl>() );
 
 				return true;
@@ -350,6 +471,7 @@ CEventSet::~CEventSet() throw()
 	// every active source holds a reference to this event set
 	// which is released when the source is destroyed. The
 	// source destructor already removes itself from the event set.
+	close( efd_ );
 	if ( srcs_.size() > 0 ) {
 		throw InternalError("Event set not empty during destruction!");
 	}
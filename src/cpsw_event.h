@@ -65,6 +65,20 @@ class IIntEventSource;
 class IEventSet;
 typedef shared_ptr<IEventSet> EventSet;
 
+// An event set may inform a listener whenever one of its
+// sources notifies it (in addition to waking up threads which
+// are blocked in 'processEvent'). This lets an entity which
+// must not block (e.g., a handler executed by an I/O ring)
+// learn that it should poll. The listener is executed by the
+// notifying thread with the set's mutex held; it must not
+// block or call back into the event set.
+class IEventListener {
+public:
+	virtual void eventNotify() = 0;
+
+	virtual ~IEventListener() {}
+};
+
 class IEventHandler {
 private:
 	bool isEnabled_;
@@ -133,6 +147,11 @@ private:
 	EventSet  eventSet_;
 	CMtx      mtx_;
 
+	// managed by the event set (protected by its mutex)
+	IEventHandler *handler_;
+	uint64_t       seq_;
+	bool           listed_;
+
 	void setEventSet(EventSet newSet);
 	void clrEventSet(EventSet curSet);
 	void clrEventSet();
@@ -153,7 +172,10 @@ protected:
 public:
 	IEventSource()
 	: pending_(false),
-	  mtx_( CMtx::AttrRecursive(), "IEventSource" )
+	  mtx_( CMtx::AttrRecursive(), "IEventSource" ),
+	  handler_( 0 ),
+	  seq_( 0 ),
+	  listed_( false )
 	{
 	}
 
@@ -265,6 +287,14 @@ public:
 //          If this is not the case, THEN some care but be taken, e.g.,
 //          by letting the destructor of OBJECT remove it's handler
 //          from the EventSet (which is a good idea anyways).
+//
+// Only sources which have notified the set since they were last
+// found idle are polled, i.e., the cost of 'processEvent' does not
+// grow with the number of (idle) sources in the set.
+//
+// Absolute timeouts are based on CLOCK_MONOTONIC; they must be
+// obtained from 'getAbsTimeout()' (or the 'getAbsTimeoutXXX()'
+// methods of queues and ports which delegate here).
 class IEventSet {
 public:
 	// wait (up to 'abs_timeout' or forever if NULL is passed)
@@ -278,7 +308,11 @@ public:
 	virtual void del(IEventSource  *)                                 = 0;
 	virtual void del(IEventHandler *)                                 = 0;
 
-	// to be called by
+	// to be called by a member source when its event
+	// condition (may have) become true
+	virtual void notify(IEventSource *)                               = 0;
+
+	// wake up and poll all sources
 	virtual void notify()                                             = 0;
 
 	virtual ~IEventSet() {}
@@ -288,6 +322,7 @@ public:
 	virtual void     getAbsTime(CTimeout *abs_time)                                    = 0;
 
 	static EventSet create();
+	static EventSet create(IEventListener *listener);
 };
 
 #endif
@@ -10,6 +10,9 @@
 #include <cpsw_api_builder.h>
 #include <cpsw_hub.h>
 #include <cpsw_path.h>
+#include <cpsw_regmap.h>
+#include <cpsw_dev_startup.h>
+#include <cpsw_condvar.h>
 #include <cpsw_fs_addr.h>
 
 #define __STDC_FORMAT_MACROS
@@ -238,6 +241,21 @@ uint64_t  got;
 	return rval;
 }
 
+uint64_t  CAddressImpl::readElement(unsigned idx, CReadArgs *args) const
+{
+CReadArgs nargs = *args;
+uint64_t  got;
+
+	nargs.off_ += idx * args->nbytes_;
+
+	got = read( &nargs );
+
+	if ( isSync_ && nargs.aio_ ) {
+		nargs.aio_->callback( 0 );
+	}
+	return got;
+}
+
 uint64_t  CAddressImpl::read(CReadArgs *args) const
 {
 	throw ConfigurationError("Configuration Error: -- unable to route I/O for read");
@@ -281,6 +299,17 @@ uint64_t   put;
 	return rval;
 }
 
+uint64_t CAddressImpl::writeElement(unsigned idx, CWriteArgs *args) const
+{
+CWriteArgs nargs = *args;
+
+	nargs.off_ += idx * args->nbytes_;
+
+	checkWriteAlignmentReqs( &nargs );
+
+	return write( &nargs );
+}
+
 uint64_t CAddressImpl::write(CWriteArgs *args) const
 {
 	throw ConfigurationError("Configuration Error: -- unable to route I/O for write");
@@ -352,6 +381,13 @@ int       prio;
 		throw DuplicateNameError(child->getName());
 	}
 
+	// keep the load factor of the index <= 1/2
+	if ( 2*children_.size() > childIndex_.size() ) {
+		rebuildIndex();
+	} else {
+		indexChild( ret.first );
+	}
+
 	// add to the prioritiy list; priority 0 means no dumping
 	if ( (prio = e->getConfigPrio()) ) {
 		if ( configPrioList_.empty() || prio <= configPrioList_.front()->getEntryImpl()->getConfigPrio() ) {
@@ -378,20 +414,255 @@ Hub CDevImpl::isHub() const
 
 CDevImpl::~CDevImpl()
 {
+	delete pathCache_.load();
+	delete regMap_.load();
+	delete lazy_;
+}
+
+uint32_t CDevImpl::hashName(const char *name, size_t len)
+{
+uint32_t h = 2166136261U;
+size_t   i;
+
+	for ( i=0; i<len; i++ ) {
+		h ^= (uint8_t)name[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+void CDevImpl::indexChild(MyChildren::const_iterator it)
+{
+uint32_t mask = childIndex_.size() - 1;
+uint32_t h    = hashName( it->first, strlen( it->first ) );
+uint32_t i    = h & mask;
+
+	while ( childIndex_[i].used_ ) {
+		i = (i + 1) & mask;
+	}
+	childIndex_[i].hash_ = h;
+	childIndex_[i].it_   = it;
+	childIndex_[i].used_ = true;
+}
+
+void CDevImpl::rebuildIndex()
+{
+MyChildren::const_iterator it;
+size_t                     capa = 8;
+IndexSlot                  empty;
+
+	while ( capa < 4*children_.size() ) {
+		capa <<= 1;
+	}
+
+	empty.hash_ = 0;
+	empty.used_ = false;
+
+	childIndex_.assign( capa, empty );
+
+	for ( it = children_.begin(); it != children_.end(); ++it ) {
+		indexChild( it );
+	}
 }
 
 Address CDevImpl::getAddress(const char *name) const
 {
-MyChildren::const_iterator it( children_.find( name ) );
-	// operator[] creates an entry if the key is not found
-	if ( it == children_.end() )
+	return getAddress( name, strlen( name ) );
+}
+
+Address CDevImpl::getAddress(const char *name, size_t len) const
+{
+uint32_t h, mask, i;
+
+	if ( hasLazyChildren() )
+		instantiateLazyChildren();
+
+	if ( childIndex_.empty() )
 		return Address();
-	return it->second;
+
+	h    = hashName( name, len );
+	mask = childIndex_.size() - 1;
+
+	for ( i = h & mask; childIndex_[i].used_; i = (i + 1) & mask ) {
+	const IndexSlot &slot = childIndex_[i];
+		if (    slot.hash_ == h
+		     && 0 == strncmp( slot.it_->first, name, len )
+		     && 0 == slot.it_->first[len] ) {
+			return slot.it_->second;
+		}
+	}
+	return Address();
+}
+
+CPathCache *CDevImpl::getPathCache() const
+{
+CPathCache *rval = pathCache_.load( cpsw::memory_order_acquire );
+CPathCache *exp;
+unsigned    capa;
+
+	if ( rval || ! getLocked() || 0 == (capa = CPathCache::getDefaultCapacity()) )
+		return rval;
+
+	// lost races are harmless
+	rval = new CPathCache( capa );
+	exp  = 0;
+	if ( ! pathCache_.compare_exchange_strong( exp, rval ) ) {
+		delete rval;
+		rval = exp;
+	}
+	return rval;
+}
+
+const CRegMap *CDevImpl::getRegMap(bool compile) const
+{
+CRegMap *rval = regMap_.load( cpsw::memory_order_acquire );
+CRegMap *exp;
+
+	if ( rval || ! compile || ! getLocked() )
+		return rval;
+
+	// lost races are harmless
+	rval = new CRegMap( this );
+	exp  = 0;
+	if ( ! regMap_.compare_exchange_strong( exp, rval ) ) {
+		delete rval;
+		rval = exp;
+	}
+	return rval;
+}
+
+uint64_t CDevImpl::saveRegisters(std::vector<uint8_t> *snapshot) const
+{
+const CRegMap *map = getRegMap();
+
+	if ( ! map )
+		throw ConfigurationError("CDevImpl::saveRegisters: Dev not locked");
+
+	snapshot->resize( map->getRawSize() );
+	return snapshot->empty() ? 0 : map->readAll( &(*snapshot)[0] );
+}
+
+uint64_t CDevImpl::restoreRegisters(const std::vector<uint8_t> &snapshot) const
+{
+const CRegMap *map = getRegMap();
+
+	if ( ! map )
+		throw ConfigurationError("CDevImpl::restoreRegisters: Dev not locked");
+
+	if ( snapshot.size() != map->getRawSize() )
+		throw InvalidArgError("CDevImpl::restoreRegisters: snapshot size mismatch");
+
+	return snapshot.empty() ? 0 : map->writeAll( &snapshot[0] );
+}
+
+// serializes the creation of lazy children process-wide (YAML
+// processing is not thread-safe); recursive because creating the
+// children may create lazy children further down. Not held while
+// the new children are started.
+static CMtx *lazyMtx()
+{
+static CMtx theMtx( CMtx::AttrRecursive(), "CDevImpl lazy" );
+	return &theMtx;
+}
+
+// protects the state of all Devs' lazy children (held briefly)
+static CMtx *lazyStateMtx()
+{
+static CMtx theMtx( "CDevImpl lazy state" );
+	return &theMtx;
+}
+
+static CCond *lazyStateCond()
+{
+static CCond theCond;
+	return &theCond;
+}
+
+void CDevImpl::setLazyChildren(ILazyChildren *lazy)
+{
+	if ( lazy_ ) {
+		throw InternalError("CDevImpl::setLazyChildren() -- already set");
+	}
+	lazy_      = lazy;
+	lazyOptIn_ = true;
+	lazyState_.store( LAZY_PENDING, cpsw::memory_order_release );
+}
+
+void CDevImpl::instantiateLazyChildren() const
+{
+ILazyChildren       *lazy;
+MyChildren::iterator it;
+std::vector<DevImpl> devs;
+CPSWErrorHdl         err;
+
+	if ( ! hasLazyChildren() )
+		return;
+
+	{
+	CMtx::lg GUARD( lazyStateMtx() );
+		while ( LAZY_BUSY == lazyState_.load() ) {
+			// recursive call (the children look themselves up)
+			if ( pthread_equal( lazyOwner_, pthread_self() ) )
+				return;
+			pthread_cond_wait( lazyStateCond()->getp(), lazyStateMtx()->getp() );
+		}
+		if ( LAZY_DONE == lazyState_.load() )
+			return;
+		if ( LAZY_FAILED == lazyState_.load() )
+			lazyError_->throwMe();
+		lazy       = lazy_;
+		lazy_      = 0;
+		lazyOwner_ = pthread_self();
+		lazyState_.store( LAZY_BUSY );
+	}
+
+	try {
+		{
+		CMtx::lg GUARD( lazyMtx() );
+			lazy->instantiate( const_cast<CDevImpl*>( this ) );
+		}
+
+		if ( isStarted() ) {
+			// like 'startUp()': the Devs below first
+			for ( it = children_.begin(); it != children_.end(); ++it ) {
+			DevImpl d = cpsw::dynamic_pointer_cast<CDevImpl>( it->second->getEntryImpl() );
+				if ( d ) {
+					devs.push_back( d );
+				}
+			}
+			CDevStartup( devs ).run();
+
+			for ( it = children_.begin(); it != children_.end(); ++it ) {
+				it->second->startUp();
+			}
+		}
+	} catch ( CPSWError &e ) {
+		err = e.clone();
+	} catch ( std::exception &e ) {
+		err = cpsw::make_shared<CPSWError>( std::string( "Lazy children of " ) + getName() + ": " + e.what() );
+	}
+	delete lazy;
+
+	{
+	CMtx::lg GUARD( lazyStateMtx() );
+		lazyError_ = err;
+		lazyState_.store( err ? LAZY_FAILED : LAZY_DONE, cpsw::memory_order_release );
+		pthread_cond_broadcast( lazyStateCond()->getp() );
+	}
+
+	if ( err ) {
+		err->throwMe();
+	}
 }
 
 CDevImpl::CDevImpl(Key &k, const char *name, uint64_t size)
 : CEntryImpl(k, name, size),
-  started_  (0            )
+  started_    (0            ),
+  pathCache_  (0            ),
+  regMap_     (0            ),
+  lazy_       (0            ),
+  lazyState_  (LAZY_DONE    ),
+  lazyOptIn_  (false        )
 {
 	// by default - mark containers as write-through cacheable; user may still override
 	setCacheable( WB_CACHEABLE );
@@ -399,7 +670,12 @@ CDevImpl::CDevImpl(Key &k, const char *name, uint64_t size)
 
 CDevImpl::CDevImpl(Key &key, YamlState &ypath)
 : CEntryImpl(key, ypath),
-  started_  (0         )
+  started_    (0         ),
+  pathCache_  (0         ),
+  regMap_     (0         ),
+  lazy_       (0         ),
+  lazyState_  (LAZY_DONE ),
+  lazyOptIn_  (false     )
 {
 	setCacheable( WB_CACHEABLE ); // default for containers
 }
@@ -407,7 +683,12 @@ CDevImpl::CDevImpl(Key &key, YamlState &ypath)
 
 CDevImpl::CDevImpl(const CDevImpl &orig, Key &k)
 : CEntryImpl(orig, k),
-  started_  (0      )
+  started_    (0               ),
+  pathCache_  (0               ),
+  regMap_     (0               ),
+  lazy_       (0               ),
+  lazyState_  (LAZY_DONE       ),
+  lazyOptIn_  (orig.lazyOptIn_ )
 {
 	setCacheable( WB_CACHEABLE );
 
@@ -430,6 +711,9 @@ CDevImpl::postHook( ConstShObj orig )
 	if ( orig ) {
 		ConstDevImpl origDev( static_pointer_cast<ConstDevImpl::element_type>( orig ) );
 
+		// a clone gets all children
+		origDev->instantiateLazyChildren();
+
 		MyChildren::iterator it ( origDev->children_.begin() );
 		MyChildren::iterator ite( origDev->children_.end()   );
 
@@ -486,7 +770,11 @@ void
 CDevImpl::dumpYamlPart(YAML::Node &node) const
 {
 MyChildren::iterator it;
+	instantiateLazyChildren();
 	CEntryImpl::dumpYamlPart(node);
+	if ( lazyOptIn_ ) {
+		writeNode( node, YAML_KEY_lazyChildren, lazyOptIn_ );
+	}
 	YAML::Node children;
 	for ( it = children_.begin(); it != children_.end(); ++it ) {
 		YAML::Node child_node;
@@ -539,11 +827,15 @@ Dev       meAsDev( getSelfAs<DevImpl>() );
 
 Children CDevImpl::getChildren() const
 {
-Children rval( cpsw::make_shared<Children::element_type>( children_.size() ) );
+Children rval;
 int      i;
 
 MyChildren::iterator it;
 
+	instantiateLazyChildren();
+
+	rval = cpsw::make_shared<Children::element_type>( children_.size() );
+
 	// copy into a vector
 	for ( it = children_.begin(), i=0; it != children_.end(); ++it, ++i ) {
 		(*rval)[i] = it->second;
@@ -558,6 +850,9 @@ CDevImpl::processYamlConfig(Path p, YAML::Node &n, bool doDump) const
 const char *job  = doDump ? "'dump'" : "'load'";
 uint64_t    rval = 0;
 
+	// configuration covers all children
+	instantiateLazyChildren();
+
 	if ( !n || n.IsNull() ) {
 		// new node, i.e., first time config
 
@@ -16,6 +16,7 @@
 
 #include <map>
 #include <list>
+#include <vector>
 
 #include <stdio.h>
 #include <string.h>
@@ -25,11 +26,23 @@
 using cpsw::weak_ptr;
 
 class   Visitor;
+class   CPathCache;
+class   CRegMap;
 
 class   CDevImpl;
 typedef shared_ptr<CDevImpl>    DevImpl;
 typedef weak_ptr<CDevImpl>     WDevImpl;
 
+// Children which are created on first use (e.g., from
+// retained YAML nodes).
+class ILazyChildren {
+public:
+	// create the children and add them to 'd'
+	virtual void instantiate(CDevImpl *d) = 0;
+
+	virtual ~ILazyChildren() {}
+};
+
 class CDevImpl : public CEntryImpl, public virtual IDev {
 	private:
 		int      started_;
@@ -38,9 +51,35 @@ class CDevImpl : public CEntryImpl, public virtual IDev {
 		typedef  std::list<AddressImpl>                     PrioList;
 
 
+		// open-addressing hash table (linear probing) which
+		// points into 'children_'; the map keeps the (sorted)
+		// iteration order.
+		struct IndexSlot {
+			uint32_t                   hash_;
+			MyChildren::const_iterator it_;
+			bool                       used_;
+		};
+		typedef  std::vector<IndexSlot>                     ChildIndex;
+
 	private:
 		mutable  MyChildren children_;       // only by 'add' and 'startUp' methods
 		mutable  PrioList   configPrioList_; // order for dumping configuration fields
+		         ChildIndex childIndex_;     // only by 'add'
+		mutable  cpsw::atomic<CPathCache*> pathCache_; // created on first use
+		mutable  cpsw::atomic<CRegMap*>    regMap_;    // compiled on first use
+		mutable  ILazyChildren            *lazy_;      // NULL once instantiated
+		mutable  cpsw::atomic<int>         lazyState_;  // LAZY_xxx
+		mutable  pthread_t                 lazyOwner_;  // creating the children (LAZY_BUSY)
+		mutable  CPSWErrorHdl              lazyError_;  // LAZY_FAILED
+		         bool                      lazyOptIn_;  // for dumpYaml
+
+		static const int LAZY_DONE    = 0; // no (more) lazy children
+		static const int LAZY_PENDING = 1;
+		static const int LAZY_BUSY    = 2; // being created/started
+		static const int LAZY_FAILED  = 3; // creation/startup threw
+
+		void indexChild(MyChildren::const_iterator it);
+		void rebuildIndex();
 
 	protected:
 		virtual void add(AddressImpl a, Field child);
@@ -96,6 +135,42 @@ class CDevImpl : public CEntryImpl, public virtual IDev {
 
 		virtual Address getAddress(const char *name) const;
 
+		// look up a child by the first 'len' characters of 'name'
+		virtual Address getAddress(const char *name, size_t len) const;
+
+		// FNV-1a
+		static uint32_t hashName(const char *name, size_t len);
+
+		// cache of paths looked up from this Dev (NULL if
+		// the cache is disabled or the Dev is not locked)
+		virtual CPathCache *getPathCache() const;
+
+		// flat table of all leaves below this Dev (NULL if
+		// the Dev is not locked or, unless 'compile' is set,
+		// the table has not been compiled yet)
+		virtual const CRegMap *getRegMap(bool compile = true) const;
+
+		virtual uint64_t saveRegisters(std::vector<uint8_t> *snapshot) const;
+		virtual uint64_t restoreRegisters(const std::vector<uint8_t> &snapshot) const;
+
+		// defer creation of the children until they are first
+		// looked up or explored (takes ownership of 'lazy').
+		// Iterating ('begin/end') and visitors only see the
+		// children which have been created.
+		virtual void setLazyChildren(ILazyChildren *lazy);
+
+		virtual bool hasLazyChildren() const
+		{
+			return LAZY_DONE != lazyState_.load( cpsw::memory_order_acquire );
+		}
+
+		// create pending children now (and start them if this
+		// Dev has been started already); thread-safe. Other
+		// threads wait until the children are started; if
+		// creating or starting them failed then the error is
+		// re-thrown (here and on every later call).
+		virtual void instantiateLazyChildren() const;
+
 		virtual void accept(IVisitor *v, RecursionOrder order, int recursionDepth);
 
 		virtual Children getChildren() const;
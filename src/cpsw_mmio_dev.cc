@@ -15,6 +15,8 @@
 #include <cpsw_async_io.h>
 #include <cpsw_stdio.h>
 
+#include <typeinfo>
+
 //#define MMIODEV_DEBUG
 
 CMMIOAddressImpl::CMMIOAddressImpl(
@@ -163,6 +165,174 @@ void CMMIOAddressImpl::attach(EntryImpl child)
 	CAddressImpl::attach(child);
 }
 
+const CMMIOAddressImpl *CAccessPlan::asPlainMMIO(const IAddress *a)
+{
+	if ( typeid( *a ) != typeid( CMMIOAddressImpl ) )
+		return 0;
+	return static_cast<const CMMIOAddressImpl*>( a );
+}
+
+CAccessPlan::CAccessPlan()
+: transportIdx_( 0                          ),
+  off_         ( 0                          ),
+  stride_      ( 0                          ),
+  idxf_        ( 0                          ),
+  idxt_        ( -1                         ),
+  byteOrder_   ( UNKNOWN                    ),
+  cacheable_   ( IField::UNKNOWN_CACHEABLE  ),
+  valid_       ( false                      )
+{
+}
+
+CAccessPlan::CAccessPlan(AddressImpl transport, unsigned transportIdx, uint64_t off, const CMMIOAddressImpl *leaf, int idxf, int idxt)
+: transport_   ( transport                               ),
+  transportIdx_( transportIdx                            ),
+  off_         ( off                                     ),
+  stride_      ( leaf->getStride()                       ),
+  idxf_        ( idxf                                    ),
+  idxt_        ( idxt                                    ),
+  byteOrder_   ( leaf->getByteOrder()                    ),
+  cacheable_   ( leaf->getEntryImpl()->getCacheable()    ),
+  valid_       ( !! transport                            )
+{
+}
+
+CAccessPlan::CAccessPlan(ConstPath p)
+: transportIdx_( 0                          ),
+  off_         ( 0                          ),
+  stride_      ( 0                          ),
+  idxf_        ( 0                          ),
+  idxt_        ( -1                         ),
+  byteOrder_   ( UNKNOWN                    ),
+  cacheable_   ( IField::UNKNOWN_CACHEABLE  ),
+  valid_       ( false                      )
+{
+CompositePathIterator   it( p );
+const CMMIOAddressImpl *mmio;
+
+	if ( it.atEnd() || ! (mmio = asPlainMMIO( it->c_p_.get() )) )
+		return;
+
+	idxf_      = it->idxf_;
+	idxt_      = it->idxt_;
+	off_       = mmio->getOffset();
+	stride_    = mmio->getStride();
+	byteOrder_ = mmio->getByteOrder();
+	cacheable_ = mmio->getEntryImpl()->getCacheable();
+
+	for ( ++it; ! it.atEnd(); ++it ) {
+		if ( it->idxf_ != it->idxt_ )
+			return;
+		if ( ! (mmio = asPlainMMIO( it->c_p_.get() )) )
+			break;
+		off_ += mmio->getOffset() + it->idxf_ * mmio->getStride();
+	}
+
+	if ( it.atEnd() )
+		return;
+
+	if ( ! (transport_ = cpsw::dynamic_pointer_cast<CAddressImpl>( it->c_p_ )) )
+		return;
+	transportIdx_ = it->idxf_;
+
+	// levels above the transport are not involved in I/O but
+	// they must not multiply the number of elements
+	for ( ++it; ! it.atEnd(); ++it ) {
+		if ( it->idxf_ != it->idxt_ )
+			return;
+	}
+
+	valid_ = true;
+}
+
+bool CAccessPlan::slice(const IndexRange *range, Slice *s) const
+{
+	if ( ! valid_ )
+		return false;
+
+	s->f_ = idxf_;
+	s->t_ = idxt_;
+
+	if ( range && range->size() > 0 ) {
+		if ( range->size() != 1 ) {
+			throw InvalidArgError("Currently only 1-level of indices supported, sorry");
+		}
+		if ( range->getTo() >= 0 )
+			s->t_ = idxf_ + range->getTo();
+		if ( range->getFrom() >= 0 )
+			s->f_ = idxf_ + range->getFrom();
+		if ( s->f_ < idxf_ || s->t_ > idxt_ || s->t_ < s->f_ ) {
+			throw InvalidArgError("Array indices out of range");
+		}
+	}
+	return true;
+}
+
+uint64_t CAccessPlan::read(const Slice *s, CReadArgs *args) const
+{
+uint64_t   rval      = 0;
+uintptr_t  dstStride = args->nbytes_;
+int        to;
+CReadArgs  nargs     = *args;
+
+	if ( nargs.nbytes_ == stride_ && cacheable_ >= IField::WT_CACHEABLE ) {
+		// if strides == size then we can try to read all in one chunk
+		nargs.nbytes_ *= s->getNelms();
+		to             = s->f_;
+	} else {
+		to             = s->t_;
+	}
+
+	nargs.off_ += off_ + s->f_ * stride_;
+
+	if ( to > s->f_ && nargs.aio_ ) {
+		nargs.aio_ = IAsyncIOParallelCompletion::create( nargs.aio_ );
+	}
+
+	for ( int i = s->f_; i <= to; i++ ) {
+		rval += transport_->readElement( transportIdx_, &nargs );
+
+		nargs.off_ += stride_;
+
+		nargs.dst_ += dstStride;
+	}
+
+	return rval;
+}
+
+uint64_t CAccessPlan::write(const Slice *s, CWriteArgs *args) const
+{
+uint64_t   rval      = 0;
+uintptr_t  srcStride = args->nbytes_;
+int        to;
+CWriteArgs nargs     = *args;
+
+	if (    nargs.nbytes_ == stride_
+	     && cacheable_ >= IField::WB_CACHEABLE
+	     && nargs.msk1_ == 0
+	     && nargs.mskn_ == 0
+	   ) {
+		// if strides == size and we don't have to merge bits
+		// then we can try to write all in one chunk
+		nargs.nbytes_ *= s->getNelms();
+		to             = s->f_;
+	} else {
+		to             = s->t_;
+	}
+
+	nargs.off_ += off_ + s->f_ * stride_;
+
+	for ( int i = s->f_; i <= to; i++ ) {
+		rval += transport_->writeElement( transportIdx_, &nargs );
+
+		nargs.off_ += stride_;
+
+		nargs.src_ += srcStride;
+	}
+
+	return rval;
+}
+
 MMIODev IMMIODev::create(const char *name, uint64_t size, ByteOrder byteOrder)
 {
 	return CShObj::create<MMIODevImpl>(name, size, byteOrder);
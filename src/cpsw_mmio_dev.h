@@ -92,4 +92,64 @@ class CMMIODevImpl : public CDevImpl, public virtual IMMIODev {
 
 };
 
+// A path compiled into a flat access plan: the leaf and all
+// levels up to the first non-MMIO address (which carries out the
+// actual I/O, i.e., the 'transport') are reduced to a byte offset
+// and the leaf's stride. A plan can be compiled if the leaf and
+// the levels between the leaf and the transport are (plain)
+// CMMIOAddressImpl and if all levels but the leaf select a single
+// element. Otherwise it is not valid and the path must be used.
+class CAccessPlan {
+public:
+	// elements of the leaf which are actually accessed
+	struct Slice {
+		int f_, t_;
+
+		unsigned getNelms() const { return t_ - f_ + 1; }
+	};
+
+private:
+	AddressImpl       transport_;
+	unsigned          transportIdx_;
+	uint64_t          off_;          // sum of all offsets
+	uint64_t          stride_;       // of the leaf
+	int               idxf_, idxt_;  // of the leaf
+	ByteOrder         byteOrder_;    // of the leaf
+	IField::Cacheable cacheable_;    // of the leaf
+	bool              valid_;
+
+public:
+	// an invalid plan
+	CAccessPlan();
+
+	CAccessPlan(ConstPath p);
+
+	// a plan for the elements 'idxf'..'idxt' of a leaf which is
+	// attached to 'leaf'; 'off' is the offset of element 0 (the
+	// offsets of all MMIO levels summed up).
+	CAccessPlan(AddressImpl transport, unsigned transportIdx, uint64_t off, const CMMIOAddressImpl *leaf, int idxf, int idxt);
+
+	bool        isValid()         const { return valid_;        }
+	ByteOrder   getByteOrder()    const { return byteOrder_;    }
+	AddressImpl getTransport()    const { return transport_;    }
+	unsigned    getTransportIdx() const { return transportIdx_; }
+	uint64_t    getOffset()       const { return off_ + idxf_ * stride_; }
+	uint64_t    getStride()       const { return stride_;       }
+	unsigned    getNelms()        const { return idxt_ - idxf_ + 1; }
+
+	// only the plain class can be flattened; subclasses may do more
+	// than add offsets. RETURNS: NULL if 'a' is something else.
+	static const CMMIOAddressImpl *asPlainMMIO(const IAddress *a);
+
+	// apply the (optional) range to the leaf; throws if the range is
+	// invalid (like SlicedPathIterator).
+	// RETURNS: false if the plan is not valid.
+	bool      slice(const IndexRange *range, Slice *s) const;
+
+	// equivalent to 'read/write()' of the leaf address with a
+	// SlicedPathIterator
+	uint64_t  read (const Slice *s, CReadArgs  *args) const;
+	uint64_t  write(const Slice *s, CWriteArgs *args) const;
+};
+
 #endif
@@ -96,6 +96,18 @@ void CNetIODevImpl::dump(FILE *f) const
 	fprintf(f, "Peer: %s", ip_str_.c_str());
 }
 
+void CNetIODevImpl::dumpStats(YAML::Node &node) const
+{
+	Children myChildren = getChildren();
+
+	for ( Children::element_type::iterator it = myChildren->begin(); it != myChildren->end(); ++it ) {
+		shared_ptr<const CCommAddressImpl> child = static_pointer_cast<const CCommAddressImpl>( *it );
+		YAML::Node                         childStats;
+		child->dumpStats( childStats );
+		writeNode(node, (*it)->getName(), childStats);
+	}
+}
+
 static int operator!=(const struct sockaddr_in &a, const struct sockaddr_in &b)
 {
 	return a.sin_family != b.sin_family || a.sin_addr.s_addr != b.sin_addr.s_addr || a.sin_port != b.sin_port;
@@ -158,6 +170,8 @@ shared_ptr<CCommAddressImpl> addr;
 			throw InternalError("Unknown Communication Protocol");
 	}
 
+	addr->setThreadSched( bldr->getThreadCpuAffinity(), bldr->getThreadSchedPolicy() );
+
 	add(addr, child);
 
 	if ( bldr->getAutoStart() ) {
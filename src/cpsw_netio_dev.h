@@ -67,6 +67,8 @@ public:
 
 	virtual void dump(FILE *f) const;
 
+	virtual void dumpStats(YAML::Node &) const;
+
 	virtual void addAtAddress(Field child, ProtoStackBuilder bldr);
 
 	virtual void startUp();
@@ -0,0 +1,340 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_packet_ring.h>
+#include <cpsw_error.h>
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#if defined(__linux__)
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#endif
+
+#if defined(TPACKET3_HDRLEN) && defined(SO_ATTACH_FILTER)
+#define PACKET_RING_SUPPORTED
+#endif
+
+//#define PACKET_RING_DEBUG
+
+#ifdef PACKET_RING_SUPPORTED
+
+// frame size hint; TPACKET_V3 packs variable-size frames
+// into the blocks.
+#define FRAME_SIZE 2048
+
+// max. bytes of a frame copied into a block (entire datagram)
+#define SNAP_LEN   0x40000
+
+CPacketRing::CPacketRing(const struct sockaddr_in *dest, const struct sockaddr_in *me, unsigned blockSize, unsigned numBlocks)
+: sd_        ( -1        ),
+  ring_      ( NULL      ),
+  ringSz_    ( 0         ),
+  blockSize_ ( blockSize ),
+  numBlocks_ ( numBlocks ),
+  block_     ( 0         ),
+  nBlocks_   ( 0         ),
+  nDgrams_   ( 0         ),
+  nOctets_   ( 0         ),
+  nBad_      ( 0         ),
+  nKernDrops_( 0         )
+{
+struct tpacket_req3 req;
+struct sockaddr_ll  sll;
+int                 optval;
+unsigned            ifidx;
+
+	if ( 0 == blockSize_ || 0 != blockSize_ % getpagesize() || blockSize_ < FRAME_SIZE || 0 == numBlocks_ ) {
+		throw InvalidArgError("CPacketRing: invalid block size or count");
+	}
+
+	findIface( me );
+
+	if ( 0 == (ifidx = if_nametoindex( ifname_ )) ) {
+		throw IOError("CPacketRing: if_nametoindex() ", errno);
+	}
+
+	// protocol 0: receive nothing until the socket is bound (and
+	// the filter attached)
+	if ( (sd_ = ::socket( AF_PACKET, SOCK_DGRAM, 0 )) < 0 ) {
+		throw IOError("CPacketRing: socket(AF_PACKET) ", errno);
+	}
+
+	try {
+		attachFilter( dest, me );
+
+#ifdef PACKET_IGNORE_OUTGOING
+		// don't see our own transmissions on 'lo'; not essential
+		// (outgoing packets are skipped when walking a block)
+		optval = 1;
+		::setsockopt( sd_, SOL_PACKET, PACKET_IGNORE_OUTGOING, &optval, sizeof(optval) );
+#endif
+
+		optval = TPACKET_V3;
+		if ( ::setsockopt( sd_, SOL_PACKET, PACKET_VERSION, &optval, sizeof(optval) ) ) {
+			throw IOError("CPacketRing: setsockopt(PACKET_VERSION) ", errno);
+		}
+
+		memset( &req, 0, sizeof(req) );
+		req.tp_block_size       = blockSize_;
+		req.tp_block_nr         = numBlocks_;
+		req.tp_frame_size       = FRAME_SIZE;
+		req.tp_frame_nr         = (blockSize_ / FRAME_SIZE) * numBlocks_;
+		req.tp_retire_blk_tov   = BLOCK_TIMEOUT;
+
+		if ( ::setsockopt( sd_, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req) ) ) {
+			throw IOError("CPacketRing: setsockopt(PACKET_RX_RING) ", errno);
+		}
+
+		ringSz_ = (size_t)blockSize_ * (size_t)numBlocks_;
+
+		void *m = ::mmap( NULL, ringSz_, PROT_READ | PROT_WRITE, MAP_SHARED, sd_, 0 );
+		if ( MAP_FAILED == m ) {
+			throw IOError("CPacketRing: mmap() ", errno);
+		}
+		ring_ = (uint8_t*)m;
+
+		memset( &sll, 0, sizeof(sll) );
+		sll.sll_family   = AF_PACKET;
+		sll.sll_protocol = htons( ETH_P_IP );
+		sll.sll_ifindex  = ifidx;
+
+		if ( ::bind( sd_, (struct sockaddr*)&sll, sizeof(sll) ) ) {
+			throw IOError("CPacketRing: bind() ", errno);
+		}
+	} catch ( CPSWError & ) {
+		if ( ring_ ) {
+			::munmap( ring_, ringSz_ );
+		}
+		::close( sd_ );
+		throw;
+	}
+}
+
+CPacketRing::~CPacketRing()
+{
+	::munmap( ring_, ringSz_ );
+	::close( sd_ );
+}
+
+void
+CPacketRing::findIface(const struct sockaddr_in *me)
+{
+struct ifaddrs *ifa, *p;
+bool            found = false;
+
+	if ( ::getifaddrs( &ifa ) ) {
+		throw IOError("CPacketRing: getifaddrs() ", errno);
+	}
+
+	for ( p = ifa; p; p = p->ifa_next ) {
+		if ( p->ifa_addr && AF_INET == p->ifa_addr->sa_family
+		     && ((struct sockaddr_in*)p->ifa_addr)->sin_addr.s_addr == me->sin_addr.s_addr ) {
+			::strncpy( ifname_, p->ifa_name, sizeof(ifname_) - 1 );
+			ifname_[sizeof(ifname_) - 1] = 0;
+			found = true;
+			break;
+		}
+	}
+
+	::freeifaddrs( ifa );
+
+	if ( ! found ) {
+		throw NotFoundError( std::string("CPacketRing: no interface with address ") + inet_ntoa( me->sin_addr ) );
+	}
+}
+
+// Accept UDP datagrams 'dest' -> 'me' (unfragmented only). The
+// packet socket is SOCK_DGRAM, i.e., offsets are relative to the
+// IP header.
+void
+CPacketRing::attachFilter(const struct sockaddr_in *dest, const struct sockaddr_in *me)
+{
+struct sock_filter prog[] = {
+	/*  0 */ BPF_STMT( BPF_LD  | BPF_B   | BPF_ABS, 9                               ), // IP protocol
+	/*  1 */ BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K,   IPPROTO_UDP,               0, 10 ),
+	/*  2 */ BPF_STMT( BPF_LD  | BPF_W   | BPF_ABS, 12                              ), // IP source
+	/*  3 */ BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K,   ntohl( dest->sin_addr.s_addr ), 0, 8 ),
+	/*  4 */ BPF_STMT( BPF_LD  | BPF_H   | BPF_ABS, 6                               ), // flags, frag. offset
+	/*  5 */ BPF_JUMP( BPF_JMP | BPF_JSET| BPF_K,   0x3fff,                    6,  0 ),
+	/*  6 */ BPF_STMT( BPF_LDX | BPF_B   | BPF_MSH, 0                               ), // IP header length
+	/*  7 */ BPF_STMT( BPF_LD  | BPF_H   | BPF_IND, 0                               ), // UDP source port
+	/*  8 */ BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K,   ntohs( dest->sin_port ),   0,  3 ),
+	/*  9 */ BPF_STMT( BPF_LD  | BPF_H   | BPF_IND, 2                               ), // UDP dest. port
+	/* 10 */ BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K,   ntohs( me->sin_port ),     0,  1 ),
+	/* 11 */ BPF_STMT( BPF_RET | BPF_K,             SNAP_LEN                        ),
+	/* 12 */ BPF_STMT( BPF_RET | BPF_K,             0                               ),
+};
+struct sock_fprog fprog;
+
+	fprog.len    = sizeof(prog)/sizeof(prog[0]);
+	fprog.filter = prog;
+
+	if ( ::setsockopt( sd_, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog) ) ) {
+		throw IOError("CPacketRing: setsockopt(SO_ATTACH_FILTER) ", errno);
+	}
+}
+
+void
+CPacketRing::attachDropFilter(int sd)
+{
+struct sock_filter prog[] = {
+	BPF_STMT( BPF_RET | BPF_K, 0 ),
+};
+struct sock_fprog fprog;
+
+	fprog.len    = sizeof(prog)/sizeof(prog[0]);
+	fprog.filter = prog;
+
+	if ( ::setsockopt( sd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog) ) ) {
+		throw IOError("CPacketRing: setsockopt(SO_ATTACH_FILTER) ", errno);
+	}
+}
+
+unsigned
+CPacketRing::processBlock(IPacketRingHandler *hdlr, int timeout_ms)
+{
+struct tpacket_block_desc *bd = (struct tpacket_block_desc*)(ring_ + (size_t)block_ * blockSize_);
+struct tpacket3_hdr       *h;
+struct sockaddr_ll        *sll;
+struct pollfd              pfd;
+struct timespec            ts;
+uint8_t                   *ip;
+unsigned                   i, n, ihl, len;
+BufChain                   bc;
+
+	if ( ! (bd->hdr.bh1.block_status & TP_STATUS_USER) ) {
+		pfd.fd      = sd_;
+		pfd.events  = POLLIN | POLLERR;
+		pfd.revents = 0;
+		if ( ::poll( &pfd, 1, timeout_ms ) <= 0 ) {
+			return 0;
+		}
+		if ( ! (bd->hdr.bh1.block_status & TP_STATUS_USER) ) {
+			return 0;
+		}
+	}
+
+	// block contents are valid once we see the status
+	__sync_synchronize();
+
+	h = (struct tpacket3_hdr*)((uint8_t*)bd + bd->hdr.bh1.offset_to_first_pkt);
+
+	for ( i = n = 0; i < bd->hdr.bh1.num_pkts; i++, h = (struct tpacket3_hdr*)((uint8_t*)h + h->tp_next_offset) ) {
+
+		sll = (struct sockaddr_ll*)((uint8_t*)h + TPACKET_ALIGN( sizeof(*h) ));
+		if ( PACKET_OUTGOING == sll->sll_pkttype ) {
+			continue;
+		}
+
+		ip  = (uint8_t*)h + h->tp_net;
+		ihl = (ip[0] & 0xf) << 2;
+
+		if ( h->tp_snaplen < ihl + 8 ) {
+			nBad_.fetch_add( 1, cpsw::memory_order_relaxed );
+			continue;
+		}
+
+		// length from the UDP header
+		len = (ip[ihl + 4] << 8) | ip[ihl + 5];
+
+		if ( len < 8 || h->tp_snaplen < ihl + len ) {
+			nBad_.fetch_add( 1, cpsw::memory_order_relaxed );
+			continue;
+		}
+
+		len -= 8;
+
+		bc = IBufChain::create();
+		if ( len > 0 ) {
+			bc->insert( ip + ihl + 8, 0, len, IBuf::CAPA_ETH_BIG );
+		}
+
+		ts.tv_sec  = h->tp_sec;
+		ts.tv_nsec = h->tp_nsec;
+		bc->setRxTimestamp( &ts );
+
+		nDgrams_.fetch_add( 1,   cpsw::memory_order_relaxed );
+		nOctets_.fetch_add( len, cpsw::memory_order_relaxed );
+
+		hdlr->handleDgram( bc );
+		n++;
+	}
+
+#ifdef PACKET_RING_DEBUG
+	printf("CPacketRing: block %u, %u packets (%u delivered)\n", block_, bd->hdr.bh1.num_pkts, n);
+#endif
+
+	// hand the block back to the kernel
+	__sync_synchronize();
+	bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+	if ( ++block_ == numBlocks_ ) {
+		block_ = 0;
+	}
+
+	nBlocks_.fetch_add( 1, cpsw::memory_order_relaxed );
+
+	return n;
+}
+
+uint64_t
+CPacketRing::getNumKernDrops()
+{
+struct tpacket_stats_v3 st;
+socklen_t               sl = sizeof(st);
+
+	// the kernel resets the statistics when they are read
+	if ( 0 == ::getsockopt( sd_, SOL_PACKET, PACKET_STATISTICS, &st, &sl ) ) {
+		nKernDrops_.fetch_add( st.tp_drops, cpsw::memory_order_relaxed );
+	}
+	return nKernDrops_.load( cpsw::memory_order_relaxed );
+}
+
+#else /* PACKET_RING_SUPPORTED */
+
+CPacketRing::CPacketRing(const struct sockaddr_in *dest, const struct sockaddr_in *me, unsigned blockSize, unsigned numBlocks)
+{
+	throw InternalError("CPacketRing: TPACKET_V3 not supported by this build");
+}
+
+CPacketRing::~CPacketRing()                                             {}
+void     CPacketRing::findIface(const struct sockaddr_in *me)          {}
+void     CPacketRing::attachFilter(const struct sockaddr_in *dest, const struct sockaddr_in *me) {}
+void     CPacketRing::attachDropFilter(int sd)                          {}
+unsigned CPacketRing::processBlock(IPacketRingHandler *hdlr, int timeout_ms) { return 0; }
+uint64_t CPacketRing::getNumKernDrops()                                 { return 0; }
+
+#endif /* PACKET_RING_SUPPORTED */
+
+void
+CPacketRing::dumpInfo(FILE *f)
+{
+	fprintf(f, "CPacketRing:\n");
+	fprintf(f, "  Interface : %15s\n",          ifname_);
+	fprintf(f, "  Blocks    : %15u\n",          numBlocks_);
+	fprintf(f, "  Block size: %15u\n",          blockSize_);
+	fprintf(f, "  #RX blocks: %15" PRIu64 "\n", getNumBlocks());
+	fprintf(f, "  #RX DGRAMs: %15" PRIu64 "\n", getNumDgrams());
+	fprintf(f, "  #RX Octets: %15" PRIu64 "\n", getNumOctets());
+	fprintf(f, "  #RX bad   : %15" PRIu64 "\n", getNumBad());
+	fprintf(f, "  #RX kdrops: %15" PRIu64 "\n", getNumKernDrops());
+}
@@ -0,0 +1,115 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_PACKET_RING_H
+#define CPSW_PACKET_RING_H
+
+#include <cpsw_buf.h>
+#include <cpsw_compat.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+using cpsw::atomic;
+
+// Memory-mapped (TPACKET_V3) receive ring of a packet socket.
+//
+// The kernel fills blocks of the ring with the UDP datagrams
+// sent by a single peer to a single local port (selected by a
+// BPF filter which is attached to the packet socket) and
+// hands a block to user space once it is full or a timeout
+// expires. All datagrams in a block are thus consumed with
+// (at most) a single 'poll()' call.
+//
+// NOTES:
+//  - a packet socket requires CAP_NET_RAW; the constructor
+//    throws if it cannot be created.
+//  - the packet socket receives a copy of the traffic; the
+//    owner must still keep a UDP socket bound to the local
+//    port (otherwise the kernel would respond with ICMP
+//    'port unreachable' messages). 'attachDropFilter()'
+//    makes such a socket discard everything (in the kernel).
+//  - IP fragments are not reassembled (and are dropped), i.e.,
+//    datagrams must fit into the MTU.
+//  - datagrams are copied out of the ring (into IBufs of
+//    CAPA_ETH_BIG) so that blocks can be returned right away.
+//  - not thread-safe; a ring is intended to be serviced by a
+//    single thread.
+
+class IPacketRingHandler {
+public:
+	// a datagram was received; 'bc' carries the kernel receive
+	// timestamp.
+	virtual void handleDgram(BufChain bc) = 0;
+
+	virtual ~IPacketRingHandler() {}
+};
+
+class CPacketRing {
+private:
+	int               sd_;
+	uint8_t          *ring_;
+	size_t            ringSz_;
+	unsigned          blockSize_;
+	unsigned          numBlocks_;
+	unsigned          block_;      // next block to consume
+	char              ifname_[32];
+
+	atomic<uint64_t>  nBlocks_;
+	atomic<uint64_t>  nDgrams_;
+	atomic<uint64_t>  nOctets_;
+	atomic<uint64_t>  nBad_;       // truncated or not matching
+	atomic<uint64_t>  nKernDrops_; // accumulated PACKET_STATISTICS
+
+	CPacketRing(const CPacketRing&);
+	CPacketRing & operator=(const CPacketRing&);
+
+	void     findIface(const struct sockaddr_in *me);
+	void     attachFilter(const struct sockaddr_in *dest, const struct sockaddr_in *me);
+
+public:
+	static const unsigned DFLT_BLOCK_SIZE = 1 << 18;
+	static const unsigned DFLT_NUM_BLOCKS = 64;
+	// partially filled blocks are handed to user space after this
+	// timeout (ms); bounds the latency at low rates.
+	static const unsigned BLOCK_TIMEOUT   = 1;
+
+	// Bind to the interface which has the (local) address of 'me'
+	// and receive the datagrams 'dest' sends to 'me's port.
+	// 'blockSize' must be a multiple of the page size.
+	CPacketRing(const struct sockaddr_in *dest, const struct sockaddr_in *me, unsigned blockSize = DFLT_BLOCK_SIZE, unsigned numBlocks = DFLT_NUM_BLOCKS);
+
+	// Wait (up to 'timeout_ms'; negative: indefinitely) for the
+	// next block, pass each datagram it holds to 'hdlr' and
+	// return the block to the kernel.
+	// RETURNS the number of datagrams passed to 'hdlr'.
+	unsigned processBlock(IPacketRingHandler *hdlr, int timeout_ms);
+
+	int         getSd()       const { return sd_;     }
+	const char *getIfName()   const { return ifname_; }
+
+	uint64_t getNumBlocks()   const { return nBlocks_.load( cpsw::memory_order_relaxed ); }
+	uint64_t getNumDgrams()   const { return nDgrams_.load( cpsw::memory_order_relaxed ); }
+	uint64_t getNumOctets()   const { return nOctets_.load( cpsw::memory_order_relaxed ); }
+	uint64_t getNumBad()      const { return nBad_.load( cpsw::memory_order_relaxed );    }
+
+	// datagrams dropped by the kernel (ring full); may be
+	// called from any thread.
+	uint64_t getNumKernDrops();
+
+	void dumpInfo(FILE *f);
+
+	// make a (UDP) socket discard all traffic
+	static void attachDropFilter(int sd);
+
+	~CPacketRing();
+};
+
+#endif
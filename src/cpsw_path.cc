@@ -9,12 +9,15 @@
 
 #include <cpsw_path.h>
 #include <cpsw_hub.h>
+#include <cpsw_regmap.h>
 #include <cpsw_obj_cnt.h>
+#include <cpsw_stdio.h>
 #include <string>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <pthread.h>
 #include <iostream>
 
 //#define PATH_DEBUG
@@ -67,6 +70,7 @@ public:
 	CPathImpl::const_iterator begin() const;
 
 	virtual Path     findByName(const char *name) const;
+	void             doFindByName(const char *name);
 	virtual Path     clone()                      const;
 	virtual PathImpl cloneAsPathImpl()            const;
 
@@ -443,6 +447,90 @@ Path IPath::create(Hub h)
 }
 
 
+CPathCache::CPathCache(unsigned capa)
+: mtx_    ( "CPathCache" ),
+  capa_   ( capa         ),
+  nHits_  ( 0            ),
+  nMisses_( 0            )
+{
+}
+
+bool
+CPathCache::find(const char *key, PathEntryContainer *dst)
+{
+LruMap::iterator it;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	if ( (it = map_.find( key )) == map_.end() ) {
+		nMisses_++;
+		return false;
+	}
+	nHits_++;
+	lru_.splice( lru_.begin(), lru_, it->second );
+	*dst = it->second->second;
+	return true;
+}
+
+void
+CPathCache::insert(const char *key, const PathEntryContainer &entries)
+{
+	CMtx::lg GUARD( &mtx_ );
+
+	// another thread may have been faster
+	if ( map_.find( key ) != map_.end() )
+		return;
+
+	if ( map_.size() >= capa_ ) {
+		map_.erase( lru_.back().first.c_str() );
+		lru_.pop_back();
+	}
+	lru_.push_front( Entry( key, entries ) );
+	map_.insert( LruMap::value_type( lru_.front().first.c_str(), lru_.begin() ) );
+}
+
+unsigned
+CPathCache::getSize()
+{
+CMtx::lg GUARD( &mtx_ );
+	return map_.size();
+}
+
+uint64_t
+CPathCache::getNumHits()
+{
+CMtx::lg GUARD( &mtx_ );
+	return nHits_;
+}
+
+uint64_t
+CPathCache::getNumMisses()
+{
+CMtx::lg GUARD( &mtx_ );
+	return nMisses_;
+}
+
+static unsigned       pathCacheCapa = 0;
+static pthread_once_t pathCacheOnce = PTHREAD_ONCE_INIT;
+
+static void
+readPathCacheCapa()
+{
+const char *str = getenv( "CPSW_PATH_CACHE_SIZE" );
+
+	if ( str && 1 != sscanf( str, "%u", &pathCacheCapa ) ) {
+		fprintf( CPSW::fErr(), "CPathCache: ignoring invalid CPSW_PATH_CACHE_SIZE: %s\n", str );
+		pathCacheCapa = 0;
+	}
+}
+
+unsigned
+CPathCache::getDefaultCapacity()
+{
+	pthread_once( &pathCacheOnce, readPathCacheCapa );
+	return pathCacheCapa;
+}
+
 // scan a decimal number;
 // ASSUMPTIONS: from < to on entry
 static inline int getnum(const char *from, const char *to)
@@ -460,10 +548,43 @@ char         *endp;
 
 Path CPathImpl::findByName(const char *s) const
 {
+Path           rval  = cpsw::make_shared<CPathImpl>( *this );
+CPathImpl     *p     = _toPathImpl( rval );
+// paths from the origin of a locked Dev may be cached
+CPathCache    *cache = empty() ? originDev_->getPathCache() : 0;
+// or found in its register table (if it has been compiled)
+const CRegMap *map   = empty() ? originDev_->getRegMap( false ) : 0;
+const CRegMap::Leaf *l;
+
+	if ( map && (l = map->find( s )) ) {
+	std::vector<const CRegMap::Step*>           steps;
+	std::vector<const CRegMap::Step*>::iterator it;
+		map->getSteps( l, &steps );
+		for ( it = steps.begin(); it != steps.end(); ++it ) {
+			p->append( *(*it)->addr_, (*it)->idx_, (*it)->idx_ );
+		}
+		return rval;
+	}
+
+	if ( cache && cache->find( s, p ) ) {
+		return rval;
+	}
+
+	p->doFindByName( s );
+
+	if ( cache ) {
+		cache->insert( s, *p );
+	}
+
+	return rval;
+}
+
+// resolve 's' relative to the tail of this path
+void CPathImpl::doFindByName(const char *s)
+{
 Address      found;
 ConstDevImpl h;
-Path         rval = cpsw::make_shared<CPathImpl>( *this );
-CPathImpl    *p   = _toPathImpl( rval );
+CPathImpl    *p   = this;
 const char  *sl;
 
 shared_ptr<const EntryImpl::element_type> tailp;
@@ -499,7 +620,7 @@ CPSW::sDbg() <<"starting at: "<<found->getName() << "\n";
 
 		if ( ! *s ) {
 			// end of string reached; (this handles trailing slashes)
-			return rval;
+			return;
 		}
 
 		sl = strchr(s,'/');
@@ -550,16 +671,16 @@ CPSW::sDbg() <<"starting at: "<<found->getName() << "\n";
 				}
 			}
 
-			std::string key(s, (op ? op - s : ( sl ? sl - s : strlen(s) ) ) );
+			size_t len = op ? op - s : ( sl ? sl - s : strlen(s) );
 
 #ifdef PATH_DEBUG
-			CPSW::sDbg() << "looking for: " << key << " in: " << h->getName() << "\n";
+			CPSW::sDbg() << "looking for: " << std::string(s, len) << " in: " << h->getName() << "\n";
 #endif
 
-			found = h->getAddress( key.c_str() );
+			found = h->getAddress( s, len );
 
 			if ( ! found ) {
-				throw NotFoundError( key.c_str() );
+				throw NotFoundError( std::string(s, len).c_str() );
 			}
 
 			if ( idxt < 0 )
@@ -577,7 +698,7 @@ CPSW::sDbg() <<"starting at: "<<found->getName() << "\n";
 
 	} while ( (s = sl) != NULL );
 
-	return rval;
+	return;
 }
 
 ConstDevImpl CPathImpl::parentAsDevImpl() const
@@ -12,7 +12,10 @@
 
 #include <list>
 #include <vector>
-#include <cpsw_api_user.h>
+#include <map>
+#include <string>
+#include <cpsw_api_builder.h>
+#include <cpsw_mutex.h>
 
 #include <cstdarg>
 
@@ -91,6 +94,48 @@ public:
 
 };
 
+// LRU cache which maps path strings to the resolved path entries
+// (looked up from the Dev which owns the cache). Only locked Devs
+// use a cache; since their hierarchy is immutable, entries are
+// never invalidated.
+//
+// The capacity is set with the environment variable
+// CPSW_PATH_CACHE_SIZE (default: 0, i.e., no cache) which is read
+// once.
+class CPathCache {
+private:
+	typedef std::pair<std::string, PathEntryContainer>       Entry;
+	typedef std::list<Entry>                                  LruList;
+	// keys point to the strings in the list
+	typedef std::map<const char*, LruList::iterator, StrCmp> LruMap;
+
+	CMtx     mtx_;
+	LruList  lru_; // most recently used first
+	LruMap   map_;
+	unsigned capa_;
+	uint64_t nHits_;
+	uint64_t nMisses_;
+
+	CPathCache(const CPathCache&);
+	CPathCache & operator=(const CPathCache&);
+
+public:
+	CPathCache(unsigned capa);
+
+	// RETURNS: true (and a copy of the entries in 'dst') if 'key' was found
+	bool     find(const char *key, PathEntryContainer *dst);
+
+	// evicts the least recently used entry if the cache is full
+	void     insert(const char *key, const PathEntryContainer &entries);
+
+	unsigned getCapacity() const { return capa_; }
+	unsigned getSize();
+	uint64_t getNumHits();
+	uint64_t getNumMisses();
+
+	static unsigned getDefaultCapacity();
+};
+
 class SlicedPathIterator : public CompositePathIterator {
 public:
 	// 'suffix' (if used) must live for as long as this object is used
@@ -10,6 +10,7 @@
 
 #include <cpsw_proto_mod.h>
 #include <cpsw_stdio.h>
+#include <cpsw_thread.h>
 
 //#define PROTO_MOD_DEBUG
 
@@ -231,9 +232,23 @@ IPortImpl::getUpstreamPort()
 	return upstrm ? upstrm->close() : ProtoPort();
 }
 
+bool
+IPortImpl::pushTrain(const std::vector<BufChain> &train, const CTimeout *timeout, bool abs_timeout)
+{
+std::vector<BufChain>::const_iterator it;
+
+	for ( it = train.begin(); it != train.end(); ++it ) {
+		if ( ! push( *it, timeout, abs_timeout ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
 CPortImpl::CPortImpl(unsigned n)
 : outputQueue_( n > 0 ? IBufQueue::create( n ) : BufQueue() ),
-  depth_(n)
+  depth_(n),
+  inlineConsumer_( 0 )
 {
 }
 
@@ -249,6 +264,18 @@ CPortImpl::getReadEventSource()
 	return outputQueue_ ? outputQueue_->getReadEventSource() : NULL;
 }
 
+IEventSource *
+CPortImpl::getWriteEventSource()
+{
+	return outputQueue_ ? outputQueue_->getWriteEventSource() : NULL;
+}
+
+bool
+CPortImpl::isOutputQueueFull()
+{
+	return outputQueue_ && outputQueue_->isFull();
+}
+
 ProtoDoor
 CPortImpl::getUpstreamDoor()
 {
@@ -301,9 +328,15 @@ CPortImpl::pop(const CTimeout *timeout, bool abs_timeout)
 bool
 CPortImpl::pushDownstream(BufChain bc, const CTimeout *rel_timeout)
 {
+IInlineConsumer *consumer;
+
 	if ( ! isOpen() )
 		return true;
 
+	if ( (consumer = inlineConsumer_.load( cpsw::memory_order_acquire )) ) {
+		return consumer->consumeInline( bc, rel_timeout );
+	}
+
 	if ( outputQueue_ ) {
 		bool rval;
 		if ( !rel_timeout || rel_timeout->isIndefinite() ) {
@@ -327,6 +360,15 @@ CPortImpl::pushDownstream(BufChain bc, const CTimeout *rel_timeout)
 	}
 }
 
+bool
+CPortImpl::setInlineConsumer(IInlineConsumer *consumer)
+{
+	if ( ! outputQueue_ )
+		return false;
+	inlineConsumer_.store( consumer, cpsw::memory_order_release );
+	return true;
+}
+
 CTimeout
 CPortImpl::getAbsTimeoutPop(const CTimeout *rel_timeout)
 {
@@ -357,14 +399,29 @@ CPortImpl::tryPop()
 bool
 CPortImpl::push(BufChain bc, const CTimeout *timeout, bool abs_timeout)
 {
+BufChain frag;
+
 	if ( ! isOpen() )
 		return false;
+	if ( ! bc || bc->getSize() == 0 )
+		return true;
+
+	frag = processOutput( &bc );
+
+	if ( ! bc || bc->getSize() == 0 ) {
+		// not fragmented
+		return mustGetUpstreamDoor()->push( frag, timeout, abs_timeout );
+	}
+
+	// hand all fragments to the upstream door at once
+	// so that it may coalesce them
+	std::vector<BufChain> train;
+
+	train.push_back( frag );
 	while ( bc && bc->getSize() > 0 ) {
-		if ( ! mustGetUpstreamDoor()->push( processOutput( &bc ), timeout, abs_timeout ) ) {
-			return false;
-		}
+		train.push_back( processOutput( &bc ) );
 	}
-	return true;
+	return mustGetUpstreamDoor()->pushTrain( train, timeout, abs_timeout );
 }
 
 bool
@@ -390,13 +447,16 @@ CProtoModImpl::CProtoModImpl()
 }
 
 CProtoModBase::CProtoModBase()
-: started_( 0 )
+: started_ ( 0               ),
+  startMtx_( "CProtoModBase" )
 {
 }
 
 void
 CProtoModBase::modStartupOnce()
 {
+CMtx::lg GUARD( &startMtx_ );
+
 	if ( 0 == started_++ ) {
 		modStartup();
 	}
@@ -406,6 +466,8 @@ CProtoModBase::modStartupOnce()
 void
 CProtoModBase::modShutdownOnce()
 {
+CMtx::lg GUARD( &startMtx_ );
+
 	if ( 0 >= started_ ) {
 		throw InternalError("Protocol Module startup count <= 0");
 	}
@@ -414,6 +476,25 @@ CProtoModBase::modShutdownOnce()
 	}
 }
 
+void
+CProtoModBase::getThreads(std::vector<CRunnable*> *threads)
+{
+CRunnable *r = dynamic_cast<CRunnable*>( this );
+	if ( r ) {
+		threads->push_back( r );
+	}
+}
+
+void
+CProtoModBase::setThreadSched(const std::string &cpuAffinity, int schedPolicy)
+{
+CRunnable *r = dynamic_cast<CRunnable*>( this );
+	if ( r ) {
+		r->setCpuAffinity( cpuAffinity );
+		r->setSchedPolicy( schedPolicy );
+	}
+}
+
 void
 CProtoModImpl::modStartup()
 {
@@ -455,6 +536,11 @@ CProtoModImpl::dumpInfo(FILE *f)
 {
 }
 
+void
+CProtoModImpl::dumpStats(YAML::Node &node) const
+{
+}
+
 CProtoMod::CProtoMod(const CProtoMod &orig, Key &k)
 : CShObj(k),
   CProtoModImpl(orig),
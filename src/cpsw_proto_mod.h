@@ -14,10 +14,12 @@
 #include <cpsw_compat.h>
 
 #include <stdio.h>
+#include <vector>
 
 #include <cpsw_buf.h>
 #include <cpsw_shared_obj.h>
 #include <cpsw_event.h>
+#include <cpsw_mutex.h>
 
 using cpsw::weak_ptr;
 
@@ -35,6 +37,8 @@ typedef shared_ptr<CPortImpl> ProtoPortImpl;
 
 class ProtoPortMatchParams;
 
+class CRunnable;
+
 namespace YAML {
 	class Node;
 }
@@ -86,6 +90,38 @@ public:
 	virtual ~IProtoPortLocator(){}
 };
 
+// A downstream module may ask to have frames handed to it
+// directly, i.e., in the context of the thread which pushes
+// them into the door's output queue (see 'setInlineConsumer').
+class IInlineConsumer {
+public:
+	// consume a frame; this is executed by the upstream
+	// producer. The timeout (NULL: indefinite) is the one the
+	// producer would have used for pushing into the queue.
+	virtual bool consumeInline(BufChain, const CTimeout *rel_timeout) = 0;
+
+	virtual ~IInlineConsumer() {}
+};
+
+// A transport module may let a caller which is waiting for
+// input poll for it directly, i.e., receive pending frames and
+// push them upstream in the caller's context (which, combined
+// with inline demultiplexing, avoids waking up any thread).
+class IRxPoller {
+public:
+	// enable busy-polling; 'us' is a hint for how long the
+	// callers may spin (e.g., for SO_BUSY_POLL).
+	virtual void     setBusyPoll(unsigned us)          = 0;
+	virtual unsigned getBusyPoll()               const = 0;
+
+	// receive and dispatch pending input without blocking.
+	// Returns the number of frames dispatched; 0 if there
+	// was nothing or if another caller is polling already.
+	virtual unsigned pollRx()                          = 0;
+
+	virtual ~IRxPoller() {}
+};
+
 class IProtoDoor : public IProtoPort {
 public:
 	// returns NULL shared_ptr on timeout; throws on error
@@ -96,6 +132,12 @@ public:
 	virtual bool push(BufChain , const CTimeout *, bool abs_timeout) = 0;
 	virtual bool tryPush(BufChain)                           = 0;
 
+	// Push a sequence of frames (e.g., the fragments of a
+	// single message). A door may hand the entire train to
+	// the transport at once (UDP segmentation offload).
+	// Returns 'false' if a frame could not be pushed.
+	virtual bool pushTrain(const std::vector<BufChain> &train, const CTimeout *, bool abs_timeout) = 0;
+
 	// obtain mas. fragment size that fits (without 'this'
 	// protocol's header)
 	virtual unsigned getMTU()                                = 0;
@@ -108,6 +150,11 @@ public:
 	//                      door.reset();
 	//
 	virtual ProtoPort close()                                = 0;
+
+	// Bypass the output queue and hand frames directly to
+	// 'consumer' (NULL restores normal queueing). Returns
+	// 'false' if the door does not support this mode.
+	virtual bool setInlineConsumer(IInlineConsumer *consumer) = 0;
 };
 
 // find a protocol stack based on parameters
@@ -302,6 +349,9 @@ public:
 
 	virtual void dumpInfo(FILE *)                      = 0;
 
+	// dump statistics counters (if the module has any)
+	virtual void dumpStats(YAML::Node &)         const = 0;
+
 	virtual void modStartup()                          = 0;
 	virtual void modShutdown()                         = 0;
 	virtual void modStartupOnce()                      = 0;
@@ -309,6 +359,15 @@ public:
 
 	virtual const char *getName() const                = 0;
 
+	// apply a CPU affinity list (e.g., "0,2-3"; empty: process
+	// default) and scheduling policy (CRunnable::DFLT_POLICY,
+	// SCHED_OTHER, SCHED_FIFO, SCHED_RR) to all threads owned
+	// by the module.
+	virtual void setThreadSched(const std::string &cpuAffinity, int schedPolicy) = 0;
+
+	// append all threads owned by the module to 'threads'
+	virtual void getThreads(std::vector<CRunnable*> *threads) = 0;
+
 	virtual ~IProtoMod() {}
 };
 
@@ -337,6 +396,14 @@ public:
 
 	virtual int isOpen() const;
 
+	virtual bool setInlineConsumer(IInlineConsumer *consumer)
+	{
+		return false;
+	}
+
+	// default: push frame by frame
+	virtual bool pushTrain(const std::vector<BufChain> &train, const CTimeout *timeout, bool abs_timeout);
+
 	friend class CloseManager;
 };
 
@@ -345,6 +412,7 @@ private:
 	weak_ptr< ProtoMod::element_type > downstream_;
 	BufQueue                           outputQueue_;
 	unsigned                           depth_;
+	cpsw::atomic<IInlineConsumer*>     inlineConsumer_;
 
 protected:
 
@@ -382,13 +450,22 @@ public:
 
 	virtual IEventSource *getReadEventSource();
 
+	// space in the output queue; producers which must not
+	// block may bind this source to their own event set
+	// (NULL if there is no output queue)
+	virtual IEventSource *getWriteEventSource();
+
+	virtual bool          isOutputQueueFull();
+
 	virtual void      addAtPort(ProtoMod downstream);
 
 	virtual bool pushDownstream(BufChain bc, const CTimeout *rel_timeout);
 
+	virtual bool setInlineConsumer(IInlineConsumer *consumer);
+
 	// getAbsTimeout is not a member of the CTimeout class:
 	// the clock to be used is implementation dependent.
-	// ProtoMod uses a semaphore which uses CLOCK_REALTIME.
+	// ProtoMod uses an event set which uses CLOCK_MONOTONIC.
 	// The conversion to abs-time should be a member
 	// of the same class which uses the clock-dependent
 	// resource...
@@ -415,6 +492,8 @@ public:
 class CProtoModBase : public IProtoMod {
 private:
 	int        started_;
+	// stacks may be shared and started up from multiple threads
+	CMtx       startMtx_;
 public:
 	CProtoModBase();
 
@@ -423,6 +502,9 @@ public:
 	virtual void modStartupOnce();
 	virtual void modShutdownOnce();
 
+	// default: applies to the module itself if it is a CRunnable
+	virtual void setThreadSched(const std::string &cpuAffinity, int schedPolicy);
+	virtual void getThreads(std::vector<CRunnable*> *threads);
 };
 
 class CProtoModImpl : public CProtoModBase {
@@ -445,6 +527,8 @@ public:
 	virtual ProtoMod  getUpstreamProtoMod();
 
 	virtual void dumpInfo(FILE *f);
+
+	virtual void dumpStats(YAML::Node &) const;
 };
 
 // protocol module with single downstream port
@@ -16,8 +16,15 @@
 #include <cpsw_yaml.h>
 
 // Protocol demultiplexer with a max. of 256 'virtual-channels'
+//
+// In 'inline' mode the demultiplexer does not run a thread of
+// its own but dispatches frames in the context of the upstream
+// module's producer (e.g., the UDP receiver thread) which saves
+// a thread and a queue hop. The upstream door must support this
+// (see IProtoDoor::setInlineConsumer); if it does not then the
+// thread is used.
 
-template <typename PORT> class CProtoModByteMux : public CShObj, public CProtoModImpl, public CRunnable {
+template <typename PORT> class CProtoModByteMux : public CShObj, public CProtoModImpl, public CRunnable, public IInlineConsumer {
 
 public:
 	const static int DEST_MIN = 0;   // the code relies on 'dest' occupying 1 byte
@@ -27,6 +34,9 @@ private:
 
 	weak_ptr<typename PORT::element_type> downstream_[DEST_MAX-DEST_MIN+1];
 	unsigned nPorts_;
+	bool     inlineDemux_;
+	bool     inlineActive_;
+	cpsw::atomic<uint64_t> nInlineDrops_;
 
 protected:
 	ProtoPort upstream_;
@@ -35,7 +45,10 @@ protected:
 	: CShObj(k),
 	  CProtoModImpl(orig),
 	  CRunnable(orig),
-	  nPorts_(orig.nPorts_)
+	  nPorts_(orig.nPorts_),
+	  inlineDemux_(orig.inlineDemux_),
+	  inlineActive_(false),
+	  nInlineDrops_(0)
 	{
 	unsigned i;
 		for ( i=0; i < sizeof(downstream_)/sizeof(downstream_[0]); i++ ) {
@@ -71,7 +84,10 @@ public:
 	CProtoModByteMux(Key &k, const char *name, int threadPriority)
 	: CShObj(k),
 	  CRunnable(name, threadPriority),
-	  nPorts_(0)
+	  nPorts_(0),
+	  inlineDemux_(false),
+	  inlineActive_(false),
+	  nInlineDrops_(0)
 	{
 	}
 
@@ -82,12 +98,40 @@ public:
 		return nPorts_;
 	}
 
+	// request inline mode; must be set before the
+	// module is started.
+	virtual void setInlineDemux(bool v)
+	{
+		inlineDemux_ = v;
+	}
+
+	virtual bool getInlineDemux() const
+	{
+		return inlineDemux_;
+	}
+
+	// whether inline mode is actually in effect
+	virtual bool isInlineActive() const
+	{
+		return inlineActive_;
+	}
+
+	virtual uint64_t getNumInlineDrops() const
+	{
+		return nInlineDrops_.load( cpsw::memory_order_relaxed );
+	}
+
 	virtual void dumpInfo(FILE *f)
 	{
 	unsigned slot;
 		fprintf(f,"%s:\n", getName());
 		fprintf(f,"  # virtual channels in use: %u\n", getNumPortsUsed());
-		fprintf(f,"  Thread Priority          : %d\n", getPrio());
+		if ( inlineActive_ ) {
+			fprintf(f,"  Inline demultiplexing    : YES\n");
+			fprintf(f,"  Inline drops             : %llu\n", (unsigned long long)getNumInlineDrops());
+		} else {
+			fprintf(f,"  Thread Priority          : %d\n", getPrio());
+		}
 		for ( slot = 0; slot < sizeof(downstream_)/sizeof(downstream_[0]); slot++ ) {
 			PORT p = downstream_[slot].lock();
 			if ( p )
@@ -137,8 +181,18 @@ public:
 		return NULL;
 	}
 
+	// executed by the upstream producer; it blocks as long as
+	// it would have blocked pushing into our input queue.
+	virtual bool consumeInline(BufChain bc, const CTimeout *rel_timeout)
+	{
+		if ( ! pushDown( bc, rel_timeout ) ) {
+			nInlineDrops_.fetch_add( 1, cpsw::memory_order_relaxed );
+			return false;
+		}
+		return true;
+	}
 
-	virtual PORT findPort(int dest)
+	virtual PORT findPort(int dest) const
 	{
 		if ( dest < DEST_MIN || dest > DEST_MAX )
 			throw InvalidArgError("Destination channel number out of range");
@@ -149,12 +203,27 @@ public:
 
 	virtual void modStartup()
 	{
-		threadStart();
+	ProtoDoor up;
+	BufChain  bc;
+		if ( inlineDemux_ && (up = getUpstreamDoor()) && up->setInlineConsumer( this ) ) {
+			inlineActive_ = true;
+			// dispatch anything that was queued before we switched
+			while ( (bc = up->tryPop()) ) {
+				consumeInline( bc, &TIMEOUT_NONE );
+			}
+		} else {
+			threadStart();
+		}
 	}
 
 	virtual void modShutdown()
 	{
-		threadStop();
+		if ( inlineActive_ ) {
+			getUpstreamDoor()->setInlineConsumer( 0 );
+			inlineActive_ = false;
+		} else {
+			threadStop();
+		}
 	}
 
 	virtual ~CProtoModByteMux()
@@ -239,7 +308,7 @@ public:
 			writeNode(node, YAML_KEY_threadPriority, prio);
 	}
 
-	OwnerType getOwner()
+	OwnerType getOwner() const
 	{
 		return owner_;
 	}
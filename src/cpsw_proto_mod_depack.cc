@@ -15,6 +15,7 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <inttypes.h>
 
 #include <cpsw_yaml.h>
 
@@ -41,9 +42,18 @@ unsigned i;
 
 void CFrame::updateChain()
 {
-unsigned idx = oldestFrag_ & (fragWin_.size() - 1);
+unsigned        idx = oldestFrag_ & (fragWin_.size() - 1);
+struct timespec fragTs, prodTs;
 	while ( fragWin_[idx] ) {
 		Buf b;
+		// the frame carries the latest fragment timestamp
+		if ( fragWin_[idx]->getRxTimestamp( &fragTs ) ) {
+			if (    ! prod_->getRxTimestamp( &prodTs )
+			     || prodTs.tv_sec  <  fragTs.tv_sec
+			     || ( prodTs.tv_sec == fragTs.tv_sec && prodTs.tv_nsec < fragTs.tv_nsec ) ) {
+				prod_->setRxTimestamp( &fragTs );
+			}
+		}
 		while ( (b = fragWin_[idx]->getHead()) ) {
 			b->unlink();
 			prod_->addAtTail( b );
@@ -60,22 +70,6 @@ unsigned idx = oldestFrag_ & (fragWin_.size() - 1);
 CProtoModDepack::CProtoModDepack(Key &k, unsigned oqueueDepth, unsigned ldFrameWinSize, unsigned ldFragWinSize, CTimeout timeout, int threadPrio)
 	: CProtoMod(k, oqueueDepth),
 	  CRunnable("'Depacketizer' protocol module", threadPrio),
-	  badHeaderDrops_(0),
-	  oldFrameDrops_(0),
-	  newFrameDrops_(0),
-	  oldFragDrops_(0),
-	  newFragDrops_(0),
-	  duplicateFragDrops_(0),
-	  duplicateLastSeen_(0),
-	  noLastSeen_(0),
-	  fragsAccepted_(0),
-	  framesAccepted_(0),
-	  oqueueFullDrops_(0),
-	  evictedFrames_(0),
-	  incompleteDrops_(0),
-	  emptyDrops_(0),
-	  timedOutFrames_(0),
-	  pastLastDrops_(0),
 	  cachedMTU_(0),
 	  timeout_( timeout ),
 	  frameWinSize_( 1<<ldFrameWinSize ),
@@ -130,22 +124,7 @@ void CProtoModDepack::modShutdown()
 CProtoModDepack::CProtoModDepack(CProtoModDepack &orig, Key &k)
 	: CProtoMod(orig, k),
 	  CRunnable(orig),
-	  badHeaderDrops_(0),
-	  oldFrameDrops_(0),
-	  newFrameDrops_(0),
-	  oldFragDrops_(0),
-	  newFragDrops_(0),
-	  duplicateFragDrops_(0),
-	  duplicateLastSeen_(0),
-	  noLastSeen_(0),
-	  fragsAccepted_(0),
-	  framesAccepted_(0),
-	  oqueueFullDrops_(0),
-	  evictedFrames_(0),
-	  incompleteDrops_(0),
-	  emptyDrops_(0),
-	  timedOutFrames_(0),
-	  pastLastDrops_(0),
+	  cachedMTU_(0),
 	  timeout_( orig.timeout_ ),
 	  frameWinSize_( orig.frameWinSize_ ),
 	  fragWinSize_( orig.fragWinSize_ ),
@@ -187,7 +166,7 @@ void * CProtoModDepack::threadBody()
 #ifdef DEPACK_DEBUG
 {
 CTimeout del;
-	clock_gettime( CLOCK_REALTIME, &del.tv_ );
+	clock_gettime( CLOCK_MONOTONIC, &del.tv_ );
 	if ( frame && frame->running_ )
 		del -= frame->timeout_;
 	fprintf(CPSW::fDbg(), "Depack input timeout (late: %ld.%ld)\n", del.tv_.tv_sec, del.tv_.tv_nsec/1000);
@@ -280,6 +259,8 @@ Buf bh = bc->getHead();
 		}
 	}
 
+	frameWinHighWater_.max( CAxisFrameHeader::moduloFrameSz( hdr.getFrameNo() - oldestFrame_ ) + 1 );
+
 	unsigned frameIdx = toFrameIdx( hdr.getFrameNo() );
 	unsigned fragIdx  = toFragIdx( hdr.getFragNo() );
 
@@ -307,12 +288,15 @@ Buf bh = bc->getHead();
 		return;
 	}
 
+	fragWinHighWater_.max( hdr.getFragNo() - frame->oldestFrag_ + 1 );
+
 	if ( CFrame::NO_FRAME == frame->frameID_ ) {
 		// first frag of a frame -- may accept
 
 		// Looks good
 		frame->prod_             = IBufChain::create();
 		frame->frameID_          = hdr.getFrameNo();
+		CLatencyHistogram::now( &frame->started_ );
 
 #ifdef DEPACK_DEBUG
 		fprintf(CPSW::fDbg(), "First frag (%d) of frame # %d\n", hdr.getFragNo(), frame->frameID_);
@@ -398,6 +382,7 @@ bool CProtoModDepack::releaseOldestFrame(bool onlyComplete)
 
 	BufChain completeFrame = frame->prod_;
 	bool     isComplete    = frame->isComplete(); // frame invalid after release
+	struct timespec started = frame->started_;
 #ifdef DEPACK_DEBUG
 	bool     wasRunning    = frame->running_;
 #endif
@@ -420,6 +405,7 @@ bool CProtoModDepack::releaseOldestFrame(bool onlyComplete)
 #endif
 			fragsAccepted_  += l;
 			framesAccepted_ += 1;
+			reassemblyLatency_.record( &started );
 		}
 	} else {
 		if ( completeFrame )
@@ -565,7 +551,7 @@ struct timespec now;
 	if ( frame->running_ )
 		return;
 
-	if ( clock_gettime( CLOCK_REALTIME, &now ) ) 
+	if ( clock_gettime( CLOCK_MONOTONIC, &now ) ) 
 		throw InternalError("clock_gettime failed");
 
 	frame->timeout_ = upstream_->getAbsTimeoutPop( &timeout_ );
@@ -643,20 +629,49 @@ void CProtoModDepack::dumpInfo(FILE *f)
 	fprintf(f,"CProtoModDepack:\n");
 	fprintf(f,"  Frame Window Size: %4d, Frag Window Size: %4d\n", frameWinSize_, fragWinSize_);
 	fprintf(f,"  Timeout          : %4ld.%09lds\n", timeout_.tv_.tv_sec, timeout_.tv_.tv_nsec);
-	fprintf(f,"  **Good Fragments Accepted     **: %8d\n", fragsAccepted_);
-	fprintf(f,"  **Good Frames Accepted        **: %8d\n", framesAccepted_);
-	fprintf(f,"  Frames dropped due to bad header: %8d\n", badHeaderDrops_);
-	fprintf(f,"  Frames dropped below Frame Win  : %8d\n", oldFrameDrops_);
-	fprintf(f,"  Frames dropped beyond Frame Win : %8d\n", newFrameDrops_);
-	fprintf(f,"  Frags  dropped below Frag Window: %8d\n", oldFragDrops_);
-	fprintf(f,"  Frags  dropped beyond Frag Win  : %8d\n", newFragDrops_);
-	fprintf(f,"  Duplicates of Fragments dropped : %8d\n", duplicateFragDrops_);
-	fprintf(f,"  Duplicate EOF seen              : %8d\n", duplicateLastSeen_);
-	fprintf(f,"  No EOF seen                     : %8d\n", noLastSeen_);
-	fprintf(f,"  Frames dropped due outQueue full: %8d\n", oqueueFullDrops_);
-	fprintf(f,"  Frames dropped due to Eviction  : %8d\n", evictedFrames_);
-	fprintf(f,"  Incomplete Frames dropped (sync): %8d\n", incompleteDrops_);
-	fprintf(f,"  Empty fragments dropped         : %8d\n", emptyDrops_);
-	fprintf(f,"  Incomplete Frames with Timeout  : %8d\n", timedOutFrames_);
-	fprintf(f,"  Frames past EOF dropped         : %8d\n", pastLastDrops_);
+	fprintf(f,"  **Good Fragments Accepted     **: %8" PRIu64 "\n", fragsAccepted_.get());
+	fprintf(f,"  **Good Frames Accepted        **: %8" PRIu64 "\n", framesAccepted_.get());
+	fprintf(f,"  Frames dropped due to bad header: %8" PRIu64 "\n", badHeaderDrops_.get());
+	fprintf(f,"  Frames dropped below Frame Win  : %8" PRIu64 "\n", oldFrameDrops_.get());
+	fprintf(f,"  Frames dropped beyond Frame Win : %8" PRIu64 "\n", newFrameDrops_.get());
+	fprintf(f,"  Frags  dropped below Frag Window: %8" PRIu64 "\n", oldFragDrops_.get());
+	fprintf(f,"  Frags  dropped beyond Frag Win  : %8" PRIu64 "\n", newFragDrops_.get());
+	fprintf(f,"  Duplicates of Fragments dropped : %8" PRIu64 "\n", duplicateFragDrops_.get());
+	fprintf(f,"  Duplicate EOF seen              : %8" PRIu64 "\n", duplicateLastSeen_.get());
+	fprintf(f,"  No EOF seen                     : %8" PRIu64 "\n", noLastSeen_.get());
+	fprintf(f,"  Frames dropped due outQueue full: %8" PRIu64 "\n", oqueueFullDrops_.get());
+	fprintf(f,"  Frames dropped due to Eviction  : %8" PRIu64 "\n", evictedFrames_.get());
+	fprintf(f,"  Incomplete Frames dropped (sync): %8" PRIu64 "\n", incompleteDrops_.get());
+	fprintf(f,"  Empty fragments dropped         : %8" PRIu64 "\n", emptyDrops_.get());
+	fprintf(f,"  Incomplete Frames with Timeout  : %8" PRIu64 "\n", timedOutFrames_.get());
+	fprintf(f,"  Frames past EOF dropped         : %8" PRIu64 "\n", pastLastDrops_.get());
+	fprintf(f,"  Frame Window high-water mark    : %8" PRIu64 "\n", frameWinHighWater_.get());
+	fprintf(f,"  Frag  Window high-water mark    : %8" PRIu64 "\n", fragWinHighWater_.get());
+	reassemblyLatency_.dumpInfo( f, "  " );
+}
+
+void CProtoModDepack::dumpStats(YAML::Node &node) const
+{
+	writeNode(node, "framesCompleted"   , framesAccepted_.get()     );
+	writeNode(node, "fragsCompleted"    , fragsAccepted_.get()      );
+	writeNode(node, "framesEvicted"     , evictedFrames_.get()      );
+	writeNode(node, "framesTimedOut"    , timedOutFrames_.get()     );
+	writeNode(node, "incompleteDrops"   , incompleteDrops_.get()    );
+	writeNode(node, "badHeaderDrops"    , badHeaderDrops_.get()     );
+	writeNode(node, "oldFrameDrops"     , oldFrameDrops_.get()      );
+	writeNode(node, "newFrameDrops"     , newFrameDrops_.get()      );
+	writeNode(node, "oldFragDrops"      , oldFragDrops_.get()       );
+	writeNode(node, "newFragDrops"      , newFragDrops_.get()       );
+	writeNode(node, "duplicateFragDrops", duplicateFragDrops_.get() );
+	writeNode(node, "duplicateLast"     , duplicateLastSeen_.get()  );
+	writeNode(node, "noLastSeen"        , noLastSeen_.get()         );
+	writeNode(node, "pastLastDrops"     , pastLastDrops_.get()      );
+	writeNode(node, "outQueueFullDrops" , oqueueFullDrops_.get()    );
+	writeNode(node, "frameWinHighWater" , frameWinHighWater_.get()  );
+	writeNode(node, "fragWinHighWater"  , fragWinHighWater_.get()   );
+	{
+	YAML::Node hist;
+		reassemblyLatency_.dumpYaml( hist );
+		writeNode(node, "reassemblyLatency", hist);
+	}
 }
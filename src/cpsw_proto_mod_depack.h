@@ -16,6 +16,7 @@
 #include <cpsw_proto_mod.h>
 #include <cpsw_thread.h>
 #include <cpsw_proto_depack.h>
+#include <cpsw_stats.h>
 
 #include <pthread.h>
 
@@ -38,6 +39,7 @@ protected:
 	FragID           oldestFrag_;
 	FragID           lastFrag_;
 	CTimeout         timeout_;
+	struct timespec  started_; // arrival of first fragment (monotonic)
 	vector<BufChain> fragWin_;
 	bool             isComplete_;
 	bool             running_;
@@ -66,22 +68,26 @@ protected:
 
 class CProtoModDepack : public CProtoMod, public CRunnable {
 private:
-	unsigned badHeaderDrops_;
-	unsigned oldFrameDrops_;
-	unsigned newFrameDrops_;
-	unsigned oldFragDrops_;
-	unsigned newFragDrops_;
-	unsigned duplicateFragDrops_;
-	unsigned duplicateLastSeen_;
-	unsigned noLastSeen_;
-	unsigned fragsAccepted_;
-	unsigned framesAccepted_;
-	unsigned oqueueFullDrops_;
-	unsigned evictedFrames_;
-	unsigned incompleteDrops_;
-	unsigned emptyDrops_;
-	unsigned timedOutFrames_;
-	unsigned pastLastDrops_;
+	CStatCounter badHeaderDrops_;
+	CStatCounter oldFrameDrops_;
+	CStatCounter newFrameDrops_;
+	CStatCounter oldFragDrops_;
+	CStatCounter newFragDrops_;
+	CStatCounter duplicateFragDrops_;
+	CStatCounter duplicateLastSeen_;
+	CStatCounter noLastSeen_;
+	CStatCounter fragsAccepted_;
+	CStatCounter framesAccepted_;
+	CStatCounter oqueueFullDrops_;
+	CStatCounter evictedFrames_;
+	CStatCounter incompleteDrops_;
+	CStatCounter emptyDrops_;
+	CStatCounter timedOutFrames_;
+	CStatCounter pastLastDrops_;
+	CStatCounter frameWinHighWater_;
+	CStatCounter fragWinHighWater_;
+
+	CLatencyHistogram reassemblyLatency_;
 
 	unsigned cachedMTU_;
 
@@ -144,6 +150,21 @@ public:
 	virtual bool tryPush(BufChain);
 
 	virtual void dumpYaml(YAML::Node &node) const;
+
+	virtual void dumpStats(YAML::Node &node) const;
+
+	// statistics; these may be read from any thread
+	virtual uint64_t getNumFramesCompleted()     const { return framesAccepted_.get();    }
+	virtual uint64_t getNumFramesEvicted()       const { return evictedFrames_.get();     }
+	virtual uint64_t getNumFramesTimedOut()      const { return timedOutFrames_.get();    }
+	virtual uint64_t getNumOldFragDrops()        const { return oldFragDrops_.get();      }
+	virtual uint64_t getNumNewFragDrops()        const { return newFragDrops_.get();      }
+	virtual uint64_t getNumDuplicateLast()       const { return duplicateLastSeen_.get(); }
+	virtual uint64_t getNumOQueueFullDrops()     const { return oqueueFullDrops_.get();   }
+	virtual uint64_t getFrameWinHighWater()      const { return frameWinHighWater_.get(); }
+	virtual uint64_t getFragWinHighWater()       const { return fragWinHighWater_.get();  }
+
+	virtual const CLatencyHistogram *getReassemblyLatency() const { return &reassemblyLatency_; }
 };
 
 #endif
@@ -106,6 +106,15 @@ const CRssiConfigParams *config = getConfigParams();
 	if( deflts.forcedSegsMax_    != config->forcedSegsMax_    ) {
 		writeNode(parms, YAML_KEY_maxSegmentSize, config->forcedSegsMax_ );
 	}
+	if( deflts.txPacing_         != config->txPacing_         ) {
+		writeNode(parms, YAML_KEY_txPacing, config->txPacing_ );
+	}
+	if( deflts.txRateSegsPerSec_ != config->txRateSegsPerSec_ ) {
+		writeNode(parms, YAML_KEY_txRateSegsPerSec, config->txRateSegsPerSec_ );
+	}
+	if( deflts.extendedAcks_     != config->extendedAcks_     ) {
+		writeNode(parms, YAML_KEY_extendedAcks, config->extendedAcks_ );
+	}
 
 	writeNode(node, YAML_KEY_RSSI, parms );
 }
@@ -189,6 +198,36 @@ CProtoModRssi::dumpInfo(FILE *f)
 	CRssi::dumpStats( f );
 }
 
+void
+CProtoModRssi::dumpStats(YAML::Node &node) const
+{
+	writeNode(node, "outgoingDropped"   , stats_.outgoingDropped_.get()    );
+	writeNode(node, "rexSegments"       , stats_.rexSegments_.get()        );
+	writeNode(node, "rexTimeouts"       , stats_.rexTimeouts_.get()        );
+	writeNode(node, "busyDeassertRex"   , stats_.busyDeassertRex_.get()    );
+	writeNode(node, "ackTimeouts"       , stats_.ackTimeouts_.get()        );
+	writeNode(node, "nulTimeouts"       , stats_.nulTimeouts_.get()        );
+	writeNode(node, "badChecksum"       , stats_.badChecksum_.get()        );
+	writeNode(node, "badSynDropped"     , stats_.badSynDropped_.get()      );
+	writeNode(node, "badHdrDropped"     , stats_.badHdrDropped_.get()      );
+	writeNode(node, "rejectedSegs"      , stats_.rejectedSegs_.get()       );
+	writeNode(node, "skippedNULs"       , stats_.skippedNULs_.get()        );
+	writeNode(node, "numSegsAckedByPeer", stats_.numSegsAckedByPeer_.get() );
+	writeNode(node, "numSegsGivenToUser", stats_.numSegsGivenToUser_.get() );
+	writeNode(node, "busyFlagsCountedRx", stats_.busyFlagsCountedRx_.get() );
+	writeNode(node, "busyFlagsCountedTx", stats_.busyFlagsCountedTx_.get() );
+	writeNode(node, "eacksSent"         , stats_.eacksSent_.get()          );
+	writeNode(node, "segsSackedByPeer"  , stats_.numSegsSackedByPeer_.get());
+	writeNode(node, "fastRetransmits"   , stats_.fastRetransmits_.get()    );
+	writeNode(node, "srttUs"            , stats_.srttUs_.get()             );
+	writeNode(node, "rtoUs"             , stats_.rtoUs_.get()              );
+	if ( getConfigParams()->txPacing_ ) {
+		writeNode(node, "pacingDelays"      , stats_.pacingDelays_.get()       );
+		writeNode(node, "cwndCuts"          , stats_.cwndCuts_.get()           );
+		writeNode(node, "cwndSegs"          , stats_.cwndSegs_.get()           );
+	}
+}
+
 const char *
 CProtoModRssi::getName() const
 {
@@ -75,6 +75,9 @@ public:
 
 	virtual void          dumpInfo(FILE *);
 
+	using                 CRssi::dumpStats;
+	virtual void          dumpStats(YAML::Node &) const;
+
 	virtual ~CProtoModRssi();
 
 	virtual void dumpYaml(YAML::Node &) const;
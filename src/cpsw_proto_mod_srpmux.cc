@@ -112,6 +112,8 @@ YAML::Node parms;
 
 	writeNode(parms, YAML_KEY_virtualChannel, getDest());
 	writeNode(parms, YAML_KEY_outQueueDepth,  queueDepth_);
+	if ( getOwner()->getInlineDemux() )
+		writeNode(parms, YAML_KEY_inlineDemux, true);
 
 	writeNode(node, YAML_KEY_SRPMux, parms);
 }
@@ -17,8 +17,19 @@
 #include <cpsw_stdio.h>
 
 #include <errno.h>
+#include <poll.h>
 #include <sys/select.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
+#include <limits.h>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#endif
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define TCP_HAVE_ZEROCOPY
+#endif
 
 #include <stdio.h>
 
@@ -30,7 +41,25 @@
 
 #define NBUFS_MAX 8
 
-static void xfer(
+// the RX thread cannot receive frames which do not fit into
+// NBUFS_MAX buffers; the io_uring handler enforces the same
+// limit (a bogus length header would make it buffer forever).
+#define RX_FRAME_MAX (NBUFS_MAX * IBuf::CAPA_ETH_BIG)
+
+#ifdef IOV_MAX
+#define TX_IOVS_MAX IOV_MAX
+#else
+#define TX_IOVS_MAX 1024
+#endif
+
+// wrap-around safe comparison of zero-copy sequence numbers
+static inline bool seqLE(uint32_t a, uint32_t b)
+{
+	return (int32_t)(b - a) >= 0;
+}
+
+// returns the number of system calls
+static unsigned xfer(
 	const char   *nm,
 	ssize_t     (*op)(int, const struct iovec*, int),
 	int sd,
@@ -38,8 +67,10 @@ static void xfer(
 	unsigned      niovs,
 	ssize_t       len)
 {
-ssize_t xfr;
+ssize_t  xfr;
+unsigned ncalls = 0;
 	while ( len > 0 ) {
+		ncalls++;
 		xfr = op( sd, iop, niovs );
 		if ( xfr <= 0 ) {
 			throw InternalError( std::string("TCP: ") + std::string(nm) + std::string(" error: "), errno );
@@ -54,15 +85,44 @@ ssize_t xfr;
 		iop->iov_base = reinterpret_cast<void*>( reinterpret_cast<uintptr_t>( iop->iov_base ) + xfr );
 		len    -= xfr;
 	}
+	return ncalls;
+}
+
+// Refill the read-ahead buffer (blocking); appends whatever
+// the socket has available.
+void CProtoModTcp::CRxHandlerThread::fill(const char *what)
+{
+ssize_t      got;
+struct iovec iov;
+
+	if ( rd_ > 0 ) {
+		if ( wr_ > rd_ ) {
+			memmove( &ring_[0], &ring_[rd_], wr_ - rd_ );
+		}
+		wr_ -= rd_;
+		rd_  = 0;
+	}
+
+	iov.iov_base = &ring_[wr_];
+	iov.iov_len  = ring_.size() - wr_;
+	if ( (got = CSockSd::recvInfo( sd_, &iov, 1, 0, &rxInfo_ )) <= 0 ) {
+		throw InternalError( what, errno );
+	}
+
+	nReads_.fetch_add( 1, cpsw::memory_order_relaxed );
+
+	wr_ += got;
 }
 
 void * CProtoModTcp::CRxHandlerThread::threadBody()
 {
-	ssize_t          got,siz,cap;
+	ssize_t          siz,cap,have;
 	std::vector<Buf> bufs;
-	unsigned         idx, i;
+	unsigned         idx, i, cur;
 
 	struct iovec     iov[NBUFS_MAX];
+	struct iovec     dio[NBUFS_MAX];
+	size_t           filled[NBUFS_MAX];
 	unsigned         niovs;
 
 	uint32_t         len;
@@ -73,22 +133,21 @@ void * CProtoModTcp::CRxHandlerThread::threadBody()
 		cap += (iov[niovs].iov_len  = bufs[niovs]->getAvail());
 	}
 
+	rd_ = wr_ = 0;
+
 	while ( 1 ) {
-		uint8_t      *p;
 
 #ifdef TCP_DEBUG
 		fprintf(CPSW::fDbg(), "TCP -- waiting for data\n");
 #endif
 
-		siz = sizeof(len);
-		p   = reinterpret_cast<uint8_t*>( &len );
-		while ( siz > 0 ) {
-			if ( (got = ::read(sd_, p, siz)) <= 0 )
-				throw InternalError("TCP reading length: ", errno);
-			p   += got;
-			siz -= got;
+		while ( wr_ - rd_ < sizeof(len) ) {
+			fill( "TCP reading length: " );
 		}
 
+		memcpy( &len, &ring_[rd_], sizeof(len) );
+		rd_ += sizeof(len);
+
 		len = ntohl(len);
 
 #ifdef TCP_DEBUG
@@ -106,16 +165,51 @@ void * CProtoModTcp::CRxHandlerThread::threadBody()
 				iov[idx].iov_len = siz;
 				siz = 0;
 			}
+			filled[idx] = 0;
 			idx++;
 		}
-			
-		xfer("readv()", ::readv, sd_, iov, idx, len);
+
+		// slice the payload out of the read-ahead buffer; read
+		// what is missing from the socket.
+		siz = len;
+		cur = 0;
+		while ( siz > 0 ) {
+			if ( rd_ == wr_ ) {
+				if ( (size_t)siz >= RX_DIRECT_MIN ) {
+					// large remainder; read directly into the buffers
+					for ( i = cur; i < idx; i++ ) {
+						dio[i].iov_base = static_cast<uint8_t*>( iov[i].iov_base ) + filled[i];
+						dio[i].iov_len  = iov[i].iov_len - filled[i];
+					}
+					nReads_.fetch_add( xfer("readv()", ::readv, sd_, dio + cur, idx - cur, siz), cpsw::memory_order_relaxed );
+					nDirect_.fetch_add( 1, cpsw::memory_order_relaxed );
+					break;
+				}
+				fill( "TCP reading data: " );
+			}
+			while ( siz > 0 && rd_ < wr_ ) {
+				have = iov[cur].iov_len - filled[cur];
+				if ( (size_t)have > wr_ - rd_ )
+					have = wr_ - rd_;
+				memcpy( static_cast<uint8_t*>( iov[cur].iov_base ) + filled[cur], &ring_[rd_], have );
+				rd_       += have;
+				siz       -= have;
+				if ( (filled[cur] += have) == iov[cur].iov_len ) {
+					cur++;
+				}
+			}
+		}
 
 		nDgrams_.fetch_add(1,   cpsw::memory_order_relaxed);
 		nOctets_.fetch_add(len, cpsw::memory_order_relaxed);
 
 		BufChain bufch = IBufChain::create();
 
+		// stamped with the last read into the read-ahead buffer;
+		// frames completed by a direct read carry the timestamp
+		// of the preceding buffered read.
+		bufch->setRxTimestamp( rxInfo_.hasTs_ ? &rxInfo_.ts_ : 0 );
+
 		for ( i=0; i<idx; i++ ) {
 			bufs[i]->setSize( iov[i].iov_len );
 #ifdef TCP_DEBUG
@@ -165,6 +259,11 @@ CProtoModTcp::CRxHandlerThread::CRxHandlerThread(const char *name, int threadPri
   sd_(sd),
   nOctets_(0),
   nDgrams_(0),
+  nReads_(0),
+  nDirect_(0),
+  ring_(RX_RING_SIZE),
+  rd_(0),
+  wr_(0),
   owner_(owner)
 {
 }
@@ -174,10 +273,255 @@ CProtoModTcp::CRxHandlerThread::CRxHandlerThread(CRxHandlerThread &orig, int sd,
   sd_(sd),
   nOctets_(0),
   nDgrams_(0),
+  nReads_(0),
+  nDirect_(0),
+  ring_(RX_RING_SIZE),
+  rd_(0),
+  wr_(0),
   owner_(owner)
 {
 }
 
+CProtoModTcp::CRxUringHandler::CRxUringHandler(int sd, CProtoModTcp *owner)
+: sd_         ( sd    ),
+  nOctets_    ( 0     ),
+  nDgrams_    ( 0     ),
+  nReads_     ( 0     ),
+  nPaused_    ( 0     ),
+  nResumed_   ( 0     ),
+  hdrHave_    ( 0     ),
+  need_       ( 0     ),
+  eof_        ( false ),
+  rxPaused_   ( false ),
+  rxHandle_   ( 0     ),
+  timerHandle_( 0     ),
+  kickHandle_ ( 0     ),
+  waiting_    ( false ),
+  wrEvSrc_    ( NULL  ),
+  owner_      ( owner )
+{
+}
+
+CProtoModTcp::CRxUringHandler::~CRxUringHandler()
+{
+	stop();
+}
+
+void
+CProtoModTcp::CRxUringHandler::start()
+{
+CUring *uring = CUring::getTheUring();
+
+	if ( rxHandle_ ) {
+		return;
+	}
+	timerHandle_ = uring->addTimer( this );
+	kickHandle_  = uring->addTimer( this );
+	// NOTE: the queue's write event source is moved out of the
+	// queue's own event set; the ring thread never blocks in
+	// 'push' (the RX thread, which does, is not used).
+	if ( (wrEvSrc_ = owner_->getWriteEventSource()) ) {
+		wrEvSet_ = IEventSet::create( this );
+		wrEvSet_->add( wrEvSrc_, &wrHdlr_ );
+	}
+	rxHandle_    = uring->addRecv( sd_, this );
+}
+
+void
+CProtoModTcp::CRxUringHandler::stop()
+{
+CUring *uring;
+
+	if ( ! rxHandle_ ) {
+		return;
+	}
+
+	uring = CUring::getTheUring();
+
+	uring->remove( rxHandle_ );
+	rxHandle_ = 0;
+	if ( wrEvSrc_ ) {
+		wrEvSet_->del( wrEvSrc_ );
+		wrEvSet_.reset();
+		wrEvSrc_ = NULL;
+	}
+	uring->remove( kickHandle_ );
+	kickHandle_ = 0;
+	uring->remove( timerHandle_ );
+	timerHandle_ = 0;
+}
+
+void
+CProtoModTcp::CRxUringHandler::finish()
+{
+	frame_->setRxTimestamp( rxInfo_.hasTs_ ? &rxInfo_.ts_ : 0 );
+
+	nDgrams_.fetch_add(1,                  cpsw::memory_order_relaxed);
+	nOctets_.fetch_add(frame_->getSize(), cpsw::memory_order_relaxed);
+
+	pend_.push_back( frame_ );
+	frame_.reset();
+}
+
+// RETURNS 'false' if the stream carries a bogus frame length
+bool
+CProtoModTcp::CRxUringHandler::consume(Buf b)
+{
+uint8_t *p = b->getPayload();
+size_t   n = b->getSize();
+size_t   k;
+uint32_t len;
+
+	while ( n > 0 ) {
+		if ( ! frame_ ) {
+			k = sizeof(hdr_) - hdrHave_;
+			if ( k > n )
+				k = n;
+			memcpy( hdr_ + hdrHave_, p, k );
+			hdrHave_ += k;
+			p        += k;
+			n        -= k;
+			if ( sizeof(hdr_) == hdrHave_ ) {
+				memcpy( &len, hdr_, sizeof(len) );
+				hdrHave_ = 0;
+				need_    = ntohl( len );
+				if ( need_ > RX_FRAME_MAX ) {
+					return false;
+				}
+				frame_   = IBufChain::create();
+				if ( 0 == need_ ) {
+					finish();
+				}
+			}
+			continue;
+		}
+
+		k = need_ < n ? need_ : n;
+		if ( k == n ) {
+			// the remainder of the segment belongs to this frame
+			b->setPayload( p );
+			frame_->addAtTail( b );
+		} else {
+			frame_->insert( p, frame_->getSize(), k );
+		}
+		p     += k;
+		n     -= k;
+		need_ -= k;
+		if ( 0 == need_ ) {
+			finish();
+		}
+	}
+	return true;
+}
+
+bool
+CProtoModTcp::CRxUringHandler::deliver()
+{
+	while ( ! pend_.empty() ) {
+		if ( ! owner_->pushDown( pend_.front(), &TIMEOUT_NONE ) ) {
+			return false;
+		}
+		pend_.pop_front();
+	}
+	return true;
+}
+
+bool
+CProtoModTcp::CRxUringHandler::handleRecv(BufChain bc, const CSockRxInfo *info)
+{
+Buf b;
+
+	nReads_.fetch_add( 1, cpsw::memory_order_relaxed );
+
+	if ( 0 == bc->getSize() ) {
+		if ( ! eof_ ) {
+			fprintf(CPSW::fErr(), "TCP io_uring handler: connection closed by peer\n");
+			eof_ = true;
+		}
+		return false;
+	}
+
+	if ( info->hasTs_ ) {
+		rxInfo_ = *info;
+	}
+
+	while ( (b = bc->getHead()) ) {
+		b->unlink();
+		if ( ! consume( b ) ) {
+			// same as the RX thread: give up on this connection
+			fprintf(CPSW::fErr(), "TCP io_uring handler: frame length %" PRIu32 " exceeds limit (%u) -- closing connection\n", need_, (unsigned)RX_FRAME_MAX);
+			frame_.reset();
+			pend_.clear();
+			eof_ = true;
+			::shutdown( sd_, SHUT_RDWR );
+			return false;
+		}
+	}
+
+	if ( deliver() ) {
+		if ( waiting_.load( cpsw::memory_order_relaxed ) ) {
+			waiting_.store( false );
+		}
+		return true;
+	}
+
+	waitForSpace();
+
+	// keep reading ahead (cancelling and re-arming the receive
+	// for every frame is expensive) until the backlog is full
+	if ( pend_.size() < PEND_MAX ) {
+		return true;
+	}
+	nPaused_.fetch_add( 1, cpsw::memory_order_relaxed );
+	rxPaused_ = true;
+	return false;
+}
+
+// Delivery failed; ring thread only.
+void
+CProtoModTcp::CRxUringHandler::waitForSpace()
+{
+	// 'eventNotify' kicks us once the consumer dequeues; check
+	// after announcing that we wait (the consumer may have
+	// dequeued already). If the queue is not full then something
+	// else refused the frame and we must poll.
+	waiting_.store( true );
+	if ( ! wrEvSrc_ || ! owner_->isOutputQueueFull() ) {
+		CUring::getTheUring()->armTimer( timerHandle_, RETRY_US );
+	}
+}
+
+void
+CProtoModTcp::CRxUringHandler::eventNotify()
+{
+	// the failing producer (i.e., the ring thread) notifies
+	// too; only a queue with space is worth a kick.
+	if ( waiting_.load() && ! owner_->isOutputQueueFull() && waiting_.exchange( false ) ) {
+		nResumed_.fetch_add( 1, cpsw::memory_order_relaxed );
+		CUring::getTheUring()->armTimer( kickHandle_, 0 );
+	}
+}
+
+void
+CProtoModTcp::CRxUringHandler::handleError(int err)
+{
+	fprintf(CPSW::fErr(), "TCP io_uring handler: receive failed (%s)\n", strerror( err ));
+}
+
+void
+CProtoModTcp::CRxUringHandler::handleTimer()
+{
+	if ( deliver() ) {
+		waiting_.store( false );
+	} else {
+		waitForSpace();
+	}
+	if ( rxPaused_ && ! eof_ && pend_.size() <= PEND_MAX/2 ) {
+		rxPaused_ = false;
+		CUring::getTheUring()->resume( rxHandle_ );
+	}
+}
+
 void CProtoModTcp::createThread(int threadPriority)
 {
 	// might be called by the copy constructor
@@ -193,12 +537,30 @@ void CProtoModTcp::modStartup()
 {
 	if ( rxHandler_ )
 		rxHandler_->threadStart();
+	if ( rxUring_ )
+		rxUring_->start();
 }
 
 void CProtoModTcp::modShutdown()
 {
 	if ( rxHandler_ )
 		rxHandler_->threadStop();
+	if ( rxUring_ )
+		rxUring_->stop();
+}
+
+void CProtoModTcp::setThreadSched(const std::string &cpuAffinity, int schedPolicy)
+{
+	if ( rxHandler_ ) {
+		rxHandler_->setCpuAffinity( cpuAffinity );
+		rxHandler_->setSchedPolicy( schedPolicy );
+	}
+}
+
+void CProtoModTcp::getThreads(std::vector<CRunnable*> *threads)
+{
+	if ( rxHandler_ )
+		threads->push_back( rxHandler_ );
 }
 
 CProtoModTcp::CProtoModTcp(
@@ -207,30 +569,71 @@ CProtoModTcp::CProtoModTcp(
 	unsigned                  depth,
 	int                       threadPriority,
 	const LibSocksProxy      *proxy,
-	const struct sockaddr_in *via
+	const struct sockaddr_in *via,
+	unsigned                  zeroCopyThreshold,
+	bool                      useUring
 )
 :CProtoMod(k, depth),
- dest_     (*dest               ),
- via_      ( via ? *via : *dest ),
- sd_       (SOCK_STREAM, proxy  ),
- nTxOctets_(0                   ),
- nTxDgrams_(0                   ),
- rxHandler_(NULL                )
+ dest_       (*dest               ),
+ via_        ( via ? *via : *dest ),
+ sd_         (SOCK_STREAM, proxy  ),
+ nTxOctets_  (0                   ),
+ nTxDgrams_  (0                   ),
+ nTxCalls_   (0                   ),
+ nTxZcCalls_ (0                   ),
+ nTxZcCopied_(0                   ),
+ nTxZcFull_  (0                   ),
+ txGen_      (0                   ),
+ txFailGen_  ((uint64_t)-1        ),
+ zcThreshold_(zeroCopyThreshold   ),
+ zcEnabled_  (false               ),
+ zcSeq_      (0                   ),
+ rxHandler_  (NULL                ),
+ rxUring_    (NULL                )
 {
 	sd_.init( &via_, 0, false );
-	createThread( threadPriority );
+	enableZeroCopy();
+	if ( useUring && CUring::getTheUring() ) {
+		rxUring_ = new CRxUringHandler( sd_.getSd(), this );
+	} else {
+		createThread( threadPriority );
+	}
+}
+
+void
+CProtoModTcp::enableZeroCopy()
+{
+	zcEnabled_ = false;
+	if ( 0 == zcThreshold_ )
+		return;
+#ifdef TCP_HAVE_ZEROCOPY
+	int one = 1;
+	if ( setsockopt( sd_.getSd(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one) ) ) {
+		fprintf(CPSW::fErr(), "TCP: unable to enable SO_ZEROCOPY (%s) -- sending all frames by copy\n", strerror(errno));
+		return;
+	}
+	zcEnabled_ = true;
+#else
+	fprintf(CPSW::fErr(), "TCP: MSG_ZEROCOPY not supported on this system -- sending all frames by copy\n");
+#endif
 }
 
 void
 CProtoModTcp::dumpYaml(YAML::Node &node) const
 {
-int prio = rxHandler_->getPrio();
+int prio = rxHandler_ ? rxHandler_->getPrio() : IProtoStackBuilder::DFLT_THREAD_PRIORITY;
 	YAML::Node tcpParms;
 	writeNode(tcpParms, YAML_KEY_port,          getDestPort()     );
 	writeNode(tcpParms, YAML_KEY_outQueueDepth, getQueueDepth()   );
 	if ( prio != IProtoStackBuilder::DFLT_THREAD_PRIORITY ) {
 		writeNode(tcpParms, YAML_KEY_threadPriority, prio);
 	}
+	if ( zcThreshold_ ) {
+		writeNode(tcpParms, YAML_KEY_zeroCopyThreshold, zcThreshold_);
+	}
+	if ( rxUring_ ) {
+		writeNode(tcpParms, YAML_KEY_useUring, true);
+	}
 	writeNode(node, YAML_KEY_TCP, tcpParms);
 }
 
@@ -240,26 +643,68 @@ CProtoModTcp::CProtoModTcp(CProtoModTcp &orig, Key &k)
  via_ (orig.via_ ),
  sd_  (orig.sd_  ),
  nTxOctets_(0),
- nTxDgrams_(0)
+ nTxDgrams_(0),
+ nTxCalls_(0),
+ nTxZcCalls_(0),
+ nTxZcCopied_(0),
+ nTxZcFull_(0),
+ txGen_(0),
+ txFailGen_((uint64_t)-1),
+ zcThreshold_(orig.zcThreshold_),
+ zcEnabled_(false),
+ zcSeq_(0),
+ rxHandler_(NULL),
+ rxUring_(NULL)
 {
 	sd_.init( &via_, 0, false );
-	createThread( orig.rxHandler_->getPrio() );
+	enableZeroCopy();
+	if ( orig.rxUring_ ) {
+		rxUring_ = new CRxUringHandler( sd_.getSd(), this );
+	} else {
+		createThread( orig.rxHandler_->getPrio() );
+	}
 }
 
 uint64_t CProtoModTcp::getNumRxOctets()
 {
+	if ( rxUring_ )
+		return rxUring_->getNumOctets();
 	return rxHandler_ ? rxHandler_->getNumOctets() : 0;
 }
 
 uint64_t CProtoModTcp::getNumRxDgrams()
 {
+	if ( rxUring_ )
+		return rxUring_->getNumDgrams();
 	return rxHandler_ ? rxHandler_->getNumDgrams() : 0;
 }
 
+uint64_t CProtoModTcp::getNumRxReads()
+{
+	if ( rxUring_ )
+		return rxUring_->getNumReads();
+	return rxHandler_ ? rxHandler_->getNumReads() : 0;
+}
+
+uint64_t CProtoModTcp::getNumRxDirect()
+{
+	return rxHandler_ ? rxHandler_->getNumDirect() : 0;
+}
+
 CProtoModTcp::~CProtoModTcp()
 {
 	if ( rxHandler_ )
 		delete rxHandler_;
+	if ( rxUring_ )
+		delete rxUring_;
+	// give the kernel a chance to release buffers
+	// still referenced by zero-copy transmissions
+	if ( ! zcPend_.empty() ) {
+		try {
+			zcReap( 100 );
+		} catch ( CPSWError &e ) {
+		}
+	}
 }
 
 void CProtoModTcp::dumpInfo(FILE *f)
@@ -270,19 +715,242 @@ void CProtoModTcp::dumpInfo(FILE *f)
 
 	fprintf(f,"CProtoModTcp:\n");
 	fprintf(f,"  Peer port : %15u\n",    getDestPort());
+	if ( rxUring_ ) {
+	fprintf(f,"  io_uring  :               Y\n");
+	} else {
 	fprintf(f,"  ThreadPrio: %15d\n",    rxHandler_->getPrio());
+	}
 	fprintf(f,"  #TX Octets: %15" PRIu64 "\n", getNumTxOctets());
 	fprintf(f,"  #TX DGRAMs: %15" PRIu64 "\n", getNumTxDgrams());
+	fprintf(f,"  #TX calls : %15" PRIu64 "\n", getNumTxCalls());
+	if ( getNumTxCalls() ) {
+	fprintf(f,"  Bytes/call: %15.1f\n", (double)getNumTxOctets()/(double)getNumTxCalls());
+	}
+	if ( zcThreshold_ ) {
+	fprintf(f,"  ZC thresh.: %15u%s\n", zcThreshold_, zcEnabled_ ? "" : " (unsupported)");
+	fprintf(f,"  #TX ZC    : %15" PRIu64 "\n", getNumTxZcCalls());
+	fprintf(f,"  #TX ZC cpy: %15" PRIu64 "\n", getNumTxZcCopied());
+	fprintf(f,"  #TX ZC ful: %15" PRIu64 "\n", getNumTxZcFull());
+		if ( getNumTxZcCalls() ) {
+	fprintf(f,"  ZC hits   : %14.1f%%\n", 100.0*(double)(getNumTxZcCalls() - getNumTxZcCopied())/(double)getNumTxZcCalls());
+		}
+	}
 	fprintf(f,"  #RX Octets: %15" PRIu64 "\n", getNumRxOctets());
 	fprintf(f,"  #RX DGRAMs: %15" PRIu64 "\n", getNumRxDgrams());
+	fprintf(f,"  #RX reads : %15" PRIu64 "\n", getNumRxReads());
+	fprintf(f,"  #RX direct: %15" PRIu64 "\n", getNumRxDirect());
+	if ( rxUring_ ) {
+	fprintf(f,"  #RX paused: %15" PRIu64 "\n", rxUring_->getNumPaused());
+	fprintf(f,"  #RX resum.: %15" PRIu64 "\n", rxUring_->getNumResumed());
+	}
+}
+
+void
+CProtoModTcp::dumpStats(YAML::Node &node) const
+{
+	writeNode(node, "txOctets", nTxOctets_.load( cpsw::memory_order_relaxed ) );
+	writeNode(node, "txFrames", nTxDgrams_.load( cpsw::memory_order_relaxed ) );
+	writeNode(node, "txCalls" , nTxCalls_.load ( cpsw::memory_order_relaxed ) );
+	if ( zcThreshold_ ) {
+		writeNode(node, "txZeroCopyCalls" , nTxZcCalls_.load ( cpsw::memory_order_relaxed ) );
+		writeNode(node, "txZeroCopyCopied", nTxZcCopied_.load( cpsw::memory_order_relaxed ) );
+		writeNode(node, "txZeroCopyFull"  , nTxZcFull_.load  ( cpsw::memory_order_relaxed ) );
+	}
+	if ( rxHandler_ ) {
+		writeNode(node, "rxOctets"      , rxHandler_->getNumOctets() );
+		writeNode(node, "rxFrames"      , rxHandler_->getNumDgrams() );
+		writeNode(node, "rxReads"       , rxHandler_->getNumReads()  );
+		writeNode(node, "rxDirectReads" , rxHandler_->getNumDirect() );
+	}
+	if ( rxUring_ ) {
+		writeNode(node, "rxOctets"      , rxUring_->getNumOctets() );
+		writeNode(node, "rxFrames"      , rxUring_->getNumDgrams() );
+		writeNode(node, "rxReads"       , rxUring_->getNumReads()  );
+		writeNode(node, "rxPaused"      , rxUring_->getNumPaused() );
+		writeNode(node, "rxResumed"     , rxUring_->getNumResumed());
+	}
+}
+
+// Send a gather list; returns after all data are written.
+void CProtoModTcp::txSend(struct iovec *iop, unsigned niovs, size_t len, int flags)
+{
+struct msghdr msg;
+ssize_t       xfr;
+
+	memset( &msg, 0, sizeof(msg) );
+
+	while ( len > 0 ) {
+		msg.msg_iov    = iop;
+		msg.msg_iovlen = niovs;
+		xfr = ::sendmsg( sd_.getSd(), &msg, flags );
+		if ( xfr <= 0 ) {
+#ifdef TCP_HAVE_ZEROCOPY
+			if ( (flags & MSG_ZEROCOPY) && ENOBUFS == errno ) {
+				// out of option memory for pinning pages; copy this one
+				flags &= ~MSG_ZEROCOPY;
+				continue;
+			}
+#endif
+			throw InternalError( "TCP: sendmsg() error: ", errno );
+		}
+		nTxCalls_.fetch_add( 1, cpsw::memory_order_relaxed );
+#ifdef TCP_HAVE_ZEROCOPY
+		if ( (flags & MSG_ZEROCOPY) ) {
+			// every successful MSG_ZEROCOPY call consumes a sequence number
+			zcSeq_++;
+			nTxZcCalls_.fetch_add( 1, cpsw::memory_order_relaxed );
+		}
+#endif
+		while ( (size_t)xfr >= iop->iov_len ) {
+			xfr    -= iop->iov_len;
+			len    -= iop->iov_len;
+			iop++;
+			niovs--;
+			if ( 0 == len )
+				return;
+		}
+		iop->iov_len -= xfr;
+		iop->iov_base = reinterpret_cast<void*>( reinterpret_cast<uintptr_t>( iop->iov_base ) + xfr );
+		len    -= xfr;
+	}
+}
+
+// Harvest zero-copy completions from the socket's error queue
+// (waiting up to 'timeoutMs' for one to arrive) and release
+// the buffers of completed frames.
+void CProtoModTcp::zcReap(int timeoutMs)
+{
+#ifdef TCP_HAVE_ZEROCOPY
+struct msghdr             msg;
+char                      ctrl[CMSG_SPACE( sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6) )];
+struct cmsghdr           *cm;
+struct sock_extended_err *ee;
+struct pollfd             pfd;
+uint32_t                  lo, hi, s, e;
+std::deque<ZcFrame>::iterator it;
+
+	if ( timeoutMs > 0 ) {
+		// POLLERR is always reported (pending error-queue data)
+		pfd.fd      = sd_.getSd();
+		pfd.events  = 0;
+		pfd.revents = 0;
+		::poll( &pfd, 1, timeoutMs );
+	}
+
+	while ( 1 ) {
+		memset( &msg, 0, sizeof(msg) );
+		msg.msg_control    = ctrl;
+		msg.msg_controllen = sizeof(ctrl);
+		if ( ::recvmsg( sd_.getSd(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT ) < 0 ) {
+			if ( EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno )
+				break;
+			throw InternalError( "TCP: reading zero-copy completions: ", errno );
+		}
+		for ( cm = CMSG_FIRSTHDR( &msg ); cm; cm = CMSG_NXTHDR( &msg, cm ) ) {
+			if (   ! ( SOL_IP   == cm->cmsg_level && IP_RECVERR   == cm->cmsg_type )
+			    && ! ( SOL_IPV6 == cm->cmsg_level && IPV6_RECVERR == cm->cmsg_type ) ) {
+				continue;
+			}
+			ee = reinterpret_cast<struct sock_extended_err*>( CMSG_DATA( cm ) );
+			if ( SO_EE_ORIGIN_ZEROCOPY != ee->ee_origin || 0 != ee->ee_errno ) {
+				continue;
+			}
+			lo = ee->ee_info;
+			hi = ee->ee_data;
+			if ( (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) ) {
+				nTxZcCopied_.fetch_add( hi - lo + 1, cpsw::memory_order_relaxed );
+			}
+			for ( it = zcPend_.begin(); it != zcPend_.end(); ++it ) {
+				s = seqLE( lo, it->lo_ ) ? it->lo_ : lo;
+				e = seqLE( hi, it->hi_ ) ? hi      : it->hi_;
+				if ( seqLE( s, e ) ) {
+					it->done_ += e - s + 1;
+				}
+			}
+		}
+	}
+
+	while ( ! zcPend_.empty() && zcPend_.front().done_ == zcPend_.front().hi_ - zcPend_.front().lo_ + 1 ) {
+		zcPend_.pop_front();
+	}
+#endif
+}
+
+// Write a batch of frames. Consecutive frames sent by copy are
+// gathered into a single call; MSG_MORE is set on all but the
+// last call so that the stack does not push out partial segments.
+void CProtoModTcp::txFlush(std::vector<BufChain> *frames)
+{
+std::vector<struct iovec> iov;
+size_t                    len = 0;
+unsigned                  f, nios, first;
+Buf                       b;
+ZcFrame                   zf;
+
+	iov.reserve( 2*frames->size() );
+
+	for ( f = 0; f < frames->size(); f++ ) {
+		BufChain bc   = (*frames)[f];
+		bool     more = ( f + 1 < frames->size() );
+		bool     zc   = zcEnabled_ && bc->getSize() >= zcThreshold_;
+
+		if ( zc && zcPend_.size() >= ZC_MAX_PENDING ) {
+			// the kernel has not released enough buffers (e.g.,
+			// the peer stalls); don't wait for it but copy.
+			zcReap( 0 );
+			if ( zcPend_.size() >= ZC_MAX_PENDING ) {
+				nTxZcFull_.fetch_add( 1, cpsw::memory_order_relaxed );
+				zc = false;
+			}
+		}
+
+		if ( zc || iov.size() + bc->getLen() > TX_IOVS_MAX ) {
+			if ( len > 0 ) {
+				txSend( &iov[0], iov.size(), len, MSG_MORE );
+				iov.clear();
+				len = 0;
+			}
+		}
+
+		first = iov.size();
+		for ( nios = 0, b = bc->getHead(); b; nios++, b = b->getNext() ) {
+			struct iovec v;
+			v.iov_base = b->getPayload();
+			v.iov_len  = b->getSize();
+			iov.push_back( v );
+			len += v.iov_len;
+		}
+
+#ifdef TCP_HAVE_ZEROCOPY
+		if ( zc ) {
+			zf.lo_   = zcSeq_;
+			txSend( &iov[first], nios, len, MSG_ZEROCOPY | ( more ? MSG_MORE : 0 ) );
+			iov.clear();
+			len      = 0;
+			if ( zf.lo_ != zcSeq_ ) {
+				zf.hi_   = zcSeq_ - 1;
+				zf.done_ = 0;
+				zf.bc_   = bc;
+				zcPend_.push_back( zf );
+			}
+		}
+#endif
+	}
+
+	if ( len > 0 ) {
+		txSend( &iov[0], iov.size(), len, 0 );
+	}
+
+	if ( zcEnabled_ ) {
+		zcReap( 0 );
+	}
 }
 
 bool CProtoModTcp::doPush(BufChain bc, bool wait, const CTimeout *timeout, bool abs_timeout)
 {
-Buf            b;
-uint32_t       len = bc->getSize();
-struct iovec   iov[ bc->getLen() ];
-unsigned       nios;
+uint32_t              len = bc->getSize();
+uint64_t              gen;
+std::vector<BufChain> frames;
 
 	// there could be two models for sending a chain of buffers:
 	// a) the chain describes a gather list (one TCP message assembled from chain)
@@ -302,22 +970,48 @@ unsigned       nios;
 
 	memcpy( h->getPayload(), &lenNBO, sizeof(lenNBO) );
 
-	len += sizeof(lenNBO);
-
 	}
 
 	nTxDgrams_.fetch_add( 1, cpsw::memory_order_relaxed );
 	nTxOctets_.fetch_add( bc->getSize(), cpsw::memory_order_relaxed );
 
-	for ( nios=0, b=bc->getHead(); b; nios++, b=b->getNext() ) {
-		iov[nios].iov_base = b->getPayload();
-		iov[nios].iov_len  = b->getSize();
+	// Queue the frame; whoever obtains the writer lock next
+	// sends everything queued so far. If that was another thread
+	// then our frame is already gone (the generation changed).
+	// If sending that batch failed then we report the failure,
+	// too. Any failure breaks the stream; later batches are
+	// thus considered failed as well.
+	{
+	CMtx::lg GUARD( &txMtx_ );
+		txPend_.push_back( bc );
+		gen = txGen_;
 	}
 
 	{
-	CMtx::lg GUARD( &txMtx_ );
+	CMtx::lg WGUARD( &txWrMtx_ );
 
-	xfer( "writev()", ::writev, sd_.getSd(), iov, nios, len );
+		{
+		CMtx::lg GUARD( &txMtx_ );
+			if ( gen != txGen_ ) {
+				if ( gen >= txFailGen_ ) {
+					txErr_->throwMe();
+				}
+				return true;
+			}
+			frames.swap( txPend_ );
+			txGen_++;
+		}
+
+		try {
+			txFlush( &frames );
+		} catch ( CPSWError &e ) {
+			CMtx::lg GUARD( &txMtx_ );
+			if ( gen < txFailGen_ ) {
+				txFailGen_ = gen;
+				txErr_     = e.clone();
+			}
+			throw;
+		}
 
 	}
 
@@ -14,12 +14,16 @@
 #include <cpsw_proto_mod.h>
 #include <cpsw_thread.h>
 #include <cpsw_sock.h>
+#include <cpsw_uring.h>
 #include <cpsw_mutex.h>
 #include <cpsw_compat.h>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
+#include <vector>
+#include <deque>
+
 using cpsw::atomic;
 
 class CProtoModTcp;
@@ -27,6 +31,12 @@ typedef shared_ptr<CProtoModTcp> ProtoModTcp;
 
 // TCP transport for framed traffic. Frames are prepended a 32-bit
 // 'length' header in network byte order.
+//
+// Frames pushed while another thread is busy writing are queued
+// and sent by the busy thread with a single 'sendmsg' (and with
+// MSG_MORE while more data are pending). Frames that are at least
+// 'zeroCopyThreshold' bytes long are sent with MSG_ZEROCOPY; their
+// buffers are held until the kernel reports completion.
 
 class CProtoModTcp : public CProtoMod {
 protected:
@@ -36,7 +46,28 @@ protected:
 			int              sd_;
 			atomic<uint64_t> nOctets_;
 			atomic<uint64_t> nDgrams_;
+			atomic<uint64_t> nReads_;
+			atomic<uint64_t> nDirect_;
+
+			// Read-ahead buffer; a single recv() usually
+			// delivers many (small) frames which are then
+			// sliced out of here. Partial frames carry over.
+			std::vector<uint8_t> ring_;
+			size_t               rd_, wr_;
+
+			// kernel receive timestamp of the last read
+			// into the read-ahead buffer
+			CSockRxInfo          rxInfo_;
+
+			void fill(const char *what);
+
 		public:
+			// frame payload not yet in the read-ahead buffer
+			// is read directly into the destination buffers
+			// if there is at least that much of it.
+			static const size_t RX_DIRECT_MIN = 4096;
+			static const size_t RX_RING_SIZE  = 65536;
+
 			// cannot use smart pointer here because CProtoModUdp's
 			// constructor creates the threads (and a smart ptr is
 			// not available yet).
@@ -54,20 +85,119 @@ protected:
 
 			virtual uint64_t getNumOctets() { return nOctets_.load( cpsw::memory_order_relaxed ); }
 			virtual uint64_t getNumDgrams() { return nDgrams_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumReads()  { return nReads_.load ( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumDirect() { return nDirect_.load( cpsw::memory_order_relaxed ); }
 
 			virtual ~CRxHandlerThread() { threadStop(); }
 	};
 
+	// Alternative to the RX thread: the socket is serviced by
+	// the io_uring ring thread which must not block. Frames are
+	// sliced out of the received segments (segments which end
+	// with the frame are linked, others are copied). If the
+	// upstream queue is full then frames are held back; once
+	// PEND_MAX of them are waiting reception is paused (the
+	// peer is throttled by TCP flow control). The queue's write
+	// event source is bound to an event set which informs this
+	// handler when the consumer dequeues; delivery then resumes
+	// from a (zero-length) ring timer. Delivery is retried
+	// periodically only if it failed for another reason (e.g.,
+	// an inline consumer which could not take the frame).
+	class CRxUringHandler : public IUringHandler, public IEventListener {
+		private:
+			int                  sd_;
+			atomic<uint64_t>     nOctets_;
+			atomic<uint64_t>     nDgrams_;
+			atomic<uint64_t>     nReads_;
+			atomic<uint64_t>     nPaused_;
+			atomic<uint64_t>     nResumed_;
+			uint8_t              hdr_[sizeof(uint32_t)];
+			unsigned             hdrHave_;
+			uint32_t             need_;
+			BufChain             frame_;
+			std::deque<BufChain> pend_;
+			CSockRxInfo          rxInfo_;
+			bool                 eof_;
+			bool                 rxPaused_;
+			uint64_t             rxHandle_;
+			uint64_t             timerHandle_;
+			uint64_t             kickHandle_;
+			atomic<bool>         waiting_;
+			EventSet             wrEvSet_;
+			IEventSource        *wrEvSrc_;
+			CNoopEventHandler    wrHdlr_;
+			CProtoModTcp        *owner_;
+
+			bool consume(Buf b);
+			void finish();
+			bool deliver();
+			void waitForSpace();
+
+		public:
+			// delivery retry interval while paused for a reason
+			// other than a full upstream queue
+			static const unsigned long RETRY_US = 100;
+			// max. number of frames held back before reception
+			// is paused
+			static const unsigned      PEND_MAX = 32;
+
+			CRxUringHandler(int sd, CProtoModTcp *owner);
+
+			virtual bool handleRecv(BufChain bc, const CSockRxInfo *info);
+			virtual void handleError(int err);
+			virtual void handleTimer();
+
+			// the upstream queue may have space
+			virtual void eventNotify();
+
+			virtual void start();
+			virtual void stop();
+
+			virtual uint64_t getNumOctets() { return nOctets_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumDgrams() { return nDgrams_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumReads()  { return nReads_.load ( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumPaused() { return nPaused_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumResumed(){ return nResumed_.load( cpsw::memory_order_relaxed ); }
+
+			virtual ~CRxUringHandler();
+	};
+
 private:
-	struct sockaddr_in dest_;
-	struct sockaddr_in via_;
-	CSockSd            sd_;
-	atomic<uint64_t>   nTxOctets_;
-	atomic<uint64_t>   nTxDgrams_;
-	CMtx               txMtx_;
+	// zero-copy frame awaiting completion; the kernel numbers
+	// MSG_ZEROCOPY calls and reports ranges of such numbers.
+	struct ZcFrame {
+		uint32_t lo_, hi_, done_;
+		BufChain bc_;
+	};
+
+	struct sockaddr_in    dest_;
+	struct sockaddr_in    via_;
+	CSockSd               sd_;
+	atomic<uint64_t>      nTxOctets_;
+	atomic<uint64_t>      nTxDgrams_;
+	atomic<uint64_t>      nTxCalls_;
+	atomic<uint64_t>      nTxZcCalls_;
+	atomic<uint64_t>      nTxZcCopied_;
+	atomic<uint64_t>      nTxZcFull_;
+	CMtx                  txMtx_;   // protects txPend_, txGen_, txFailGen_, txErr_
+	CMtx                  txWrMtx_; // held while writing to the socket
+	std::vector<BufChain> txPend_;
+	uint64_t              txGen_;
+	uint64_t              txFailGen_; // first batch which failed
+	CPSWErrorHdl          txErr_;
+	unsigned              zcThreshold_;
+	bool                  zcEnabled_;
+	uint32_t              zcSeq_;
+	std::deque<ZcFrame>   zcPend_;
+
+	void     enableZeroCopy();
+	void     txFlush(std::vector<BufChain> *frames);
+	void     txSend(struct iovec *iov, unsigned niovs, size_t len, int flags);
+	void     zcReap(int timeoutMs);
 
 protected:
 	CRxHandlerThread  *rxHandler_;
+	CRxUringHandler   *rxUring_;
 
 	void createThread(int threadPriority);
 
@@ -86,13 +216,20 @@ protected:
 	virtual int iMatch(ProtoPortMatchParams *cmp);
 
 public:
+	// max. number of zero-copy frames awaiting completion;
+	// more frames are sent by copy (rather than waiting for
+	// the kernel to report completions).
+	static const unsigned ZC_MAX_PENDING = 64;
+
 	CProtoModTcp(
 		Key                      &k,
 		const struct sockaddr_in *dest,
 		unsigned                  depth,
 		int                       threadPriority,
 		const LibSocksProxy      *proxy,
-		const struct sockaddr_in *via
+		const struct sockaddr_in *via,
+		unsigned                  zeroCopyThreshold = 0,
+		bool                      useUring = false
 	);
 
 	CProtoModTcp(CProtoModTcp &orig, Key &k);
@@ -118,12 +255,23 @@ public:
 
 	virtual uint64_t getNumTxOctets() { return nTxOctets_.load( cpsw::memory_order_relaxed ); }
 	virtual uint64_t getNumTxDgrams() { return nTxDgrams_.load( cpsw::memory_order_relaxed ); }
+	virtual uint64_t getNumTxCalls()  { return nTxCalls_.load ( cpsw::memory_order_relaxed ); }
+	virtual uint64_t getNumTxZcCalls(){ return nTxZcCalls_.load( cpsw::memory_order_relaxed ); }
+	virtual uint64_t getNumTxZcCopied(){ return nTxZcCopied_.load( cpsw::memory_order_relaxed ); }
+	virtual uint64_t getNumTxZcFull() { return nTxZcFull_.load( cpsw::memory_order_relaxed ); }
+	virtual unsigned getZeroCopyThreshold() const { return zcThreshold_; }
 	virtual uint64_t getNumRxOctets();
 	virtual uint64_t getNumRxDgrams();
+	virtual uint64_t getNumRxReads();
+	virtual uint64_t getNumRxDirect();
 	virtual void modStartup();
 	virtual void modShutdown();
 
+	virtual void setThreadSched(const std::string &cpuAffinity, int schedPolicy);
+	virtual void getThreads(std::vector<CRunnable*> *threads);
+
 	virtual void dumpYaml(YAML::Node &) const;
+	virtual void dumpStats(YAML::Node &) const;
 
 	virtual ~CProtoModTcp();
 
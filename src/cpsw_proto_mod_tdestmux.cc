@@ -12,6 +12,9 @@
 
 #include <cpsw_yaml.h>
 
+#include <inttypes.h>
+#include <stdio.h>
+
 int CProtoModTDestMux::extractDest(BufChain bc)
 {
 Buf b = bc->getHead();
@@ -37,7 +40,13 @@ bool CTDestPort::pushDownstream(BufChain bc, const CTimeout *rel_timeout)
 		b->setSize( b->getSize() - tsize );
 	}
 
-	return CByteMuxPort<CProtoModTDestMux>::pushDownstream(bc, rel_timeout);
+	rxFramCnt_++;
+
+	if ( ! CByteMuxPort<CProtoModTDestMux>::pushDownstream(bc, rel_timeout) ) {
+		oQueueDropCnt_++;
+		return false;
+	}
+	return true;
 }
 
 BufChain CTDestPort::processOutput(BufChain *bcp)
@@ -84,6 +93,41 @@ YAML::Node parms;
 	writeNode(parms, YAML_KEY_stripHeader  , stripHeader_   );
 	writeNode(parms, YAML_KEY_outQueueDepth, getQueueDepth());
 	writeNode(parms, YAML_KEY_TDEST        , getDest()      );
+	if ( getOwner()->getInlineDemux() )
+		writeNode(parms, YAML_KEY_inlineDemux, true);
 
 	writeNode(node, YAML_KEY_TDESTMux, parms);
 }
+
+void
+CTDestPort::dumpInfo(FILE *f)
+{
+	CByteMuxPort<CProtoModTDestMux>::dumpInfo( f );
+	fprintf(f,"    RX - frames            : %10" PRIu64 "\n", rxFramCnt_.get()     );
+	fprintf(f,"    RX - dropped (q-full)  : %10" PRIu64 "\n", oQueueDropCnt_.get() );
+}
+
+void
+CTDestPort::dumpStats(YAML::Node &node) const
+{
+	writeNode(node, "TDEST"         , getDest()            );
+	writeNode(node, "rxFrames"      , rxFramCnt_.get()     );
+	writeNode(node, "outQueueDrops" , oQueueDropCnt_.get() );
+}
+
+void
+CProtoModTDestMux::dumpStats(YAML::Node &node) const
+{
+YAML::Node ports;
+int        dest;
+
+	for ( dest = DEST_MIN; dest <= DEST_MAX; dest++ ) {
+		TDestPort p = findPort( dest );
+		if ( p ) {
+			YAML::Node portStats;
+			p->dumpStats( portStats );
+			ports.push_back( portStats );
+		}
+	}
+	writeNode(node, "ports", ports);
+}
@@ -11,6 +11,7 @@
 #define CPSW_PROTO_MOD_TDEST_MUX_H
 
 #include <cpsw_proto_mod_bytemux.h>
+#include <cpsw_stats.h>
 
 class CProtoModTDestMux;
 typedef shared_ptr<CProtoModTDestMux>  ProtoModTDestMux;
@@ -53,12 +54,16 @@ public:
 		return "TDEST Demultiplexer";
 	}
 
+	virtual void dumpStats(YAML::Node &) const;
+
 	virtual ~CProtoModTDestMux() {}
 };
 
 class CTDestPort : public CByteMuxPort<CProtoModTDestMux> {
 private:
-	bool stripHeader_;
+	bool          stripHeader_;
+	CStatCounter  rxFramCnt_;
+	CStatCounter  oQueueDropCnt_;  // dropped because output queue was full
 
 protected:
 	CTDestPort(const CTDestPort &orig, Key k)
@@ -81,6 +86,10 @@ public:
 
 	virtual void dumpYaml(YAML::Node &) const;
 
+	virtual void dumpInfo(FILE *f);
+
+	virtual void dumpStats(YAML::Node &) const;
+
 	virtual bool pushDownstream(BufChain bc, const CTimeout *rel_timeout);
 
 	virtual CTDestPort *clone(Key k)
@@ -14,6 +14,8 @@
 #include <cpsw_stdio.h>
 #include <cpsw_crc32_le.h>
 
+#include <inttypes.h>
+
 // Support for SLAC Depacketizer V2 protocol.
 //
 // https://confluence.slac.stanford.edu/display/ppareg/AxiStreamPackerizer+Protocol+Version+2
@@ -61,6 +63,21 @@ CProtoModTDestMux2::modShutdown()
 	CProtoModByteMux<TDestPort2>::modShutdown();
 }
 
+void
+CProtoModTDestMux2::setThreadSched(const std::string &cpuAffinity, int schedPolicy)
+{
+	CProtoModByteMux<TDestPort2>::setThreadSched( cpuAffinity, schedPolicy );
+	muxer_.setCpuAffinity( cpuAffinity );
+	muxer_.setSchedPolicy( schedPolicy );
+}
+
+void
+CProtoModTDestMux2::getThreads(std::vector<CRunnable*> *threads)
+{
+	CProtoModByteMux<TDestPort2>::getThreads( threads );
+	threads->push_back( &muxer_ );
+}
+
 bool
 CProtoModTDestMux2::sendFrag(unsigned current)
 {
@@ -391,6 +408,7 @@ bool CTDestPort2::pushDownstream(BufChain bc, const CTimeout *rel_timeout)
 				// just take over the chain
 				assembleBuffer_ = bc;
 				fragNo_         = 0;
+				CLatencyHistogram::now( &assembleStarted_ );
 			} else {
 				if ( ! assembleBuffer_ || ( (++fragNo_ & ((1<<CDepack2Header::FRAG_NO_BIT_SIZE) - 1)) != hdr.getFragNo() ) ) {
 					nonSeqFragCnt_++;
@@ -414,7 +432,17 @@ bool CTDestPort2::pushDownstream(BufChain bc, const CTimeout *rel_timeout)
 			goodRxFramCnt_++;
 			bc = assembleBuffer_;
 			assembleBuffer_.reset();
-			return CByteMuxPort<CProtoModTDestMux2>::pushDownstream(bc, rel_timeout);
+			// try without blocking first so that we learn about a full queue
+			if ( ! CByteMuxPort<CProtoModTDestMux2>::pushDownstream(bc, &TIMEOUT_NONE) ) {
+				oQueueFullCnt_++;
+				if (    ( rel_timeout && rel_timeout->isNone() )
+				     || ! CByteMuxPort<CProtoModTDestMux2>::pushDownstream(bc, rel_timeout) ) {
+					oQueueDropCnt_++;
+					return false;
+				}
+			}
+			reassemblyLatency_.record( &assembleStarted_ );
+			return true;
 		}
 
 	} catch (CDepack2Header::InvalidHeaderException) {
@@ -478,6 +506,8 @@ CTDestPort2::dumpYaml(YAML::Node &node) const
 		writeNode(parms, YAML_KEY_outQueueDepth, getQueueDepth()   );
 		writeNode(parms, YAML_KEY_inpQueueDepth, getInpQueueDepth());
 		writeNode(parms, YAML_KEY_TDEST        , getDest()         );
+		if ( getOwner()->getInlineDemux() )
+			writeNode(parms, YAML_KEY_inlineDemux, true);
 
 		writeNode(node, YAML_KEY_TDESTMux, parms);
 	}
@@ -557,18 +587,58 @@ void
 CProtoModTDestMux2::dumpInfo(FILE *f)
 {
 	CProtoModByteMux<TDestPort2>::dumpInfo(f);
-	fprintf(f,"  TX - good fragments      : %10ld\n", goodTxFragCnt_ );
-	fprintf(f,"  TX - good frames         : %10ld\n", goodTxFramCnt_ );
+	fprintf(f,"  TX - good fragments      : %10" PRIu64 "\n", goodTxFragCnt_.get() );
+	fprintf(f,"  TX - good frames         : %10" PRIu64 "\n", goodTxFramCnt_.get() );
+}
+
+void
+CProtoModTDestMux2::dumpStats(YAML::Node &node) const
+{
+YAML::Node ports;
+int        dest;
+
+	writeNode(node, "txFrags" , goodTxFragCnt_.get());
+	writeNode(node, "txFrames", goodTxFramCnt_.get());
+
+	for ( dest = DEST_MIN; dest <= DEST_MAX; dest++ ) {
+		TDestPort2 p = findPort( dest );
+		if ( p ) {
+			YAML::Node portStats;
+			p->dumpStats( portStats );
+			ports.push_back( portStats );
+		}
+	}
+	writeNode(node, "ports", ports);
 }
 
 void
 CTDestPort2::dumpInfo(FILE *f)
 {
 	CByteMuxPort<CProtoModTDestMux2>::dumpInfo( f );
-	fprintf(f,"    RX - good fragments    : %10ld\n", goodRxFragCnt_ );
-	fprintf(f,"    RX - good frames       : %10ld\n", goodRxFramCnt_ );
-	fprintf(f,"    RX - dropped (non-seq) : %10ld\n", nonSeqFragCnt_ );
-	fprintf(f,"    RX - dropped (bad-hdr) : %10ld\n", badHeadersCnt_ );
+	fprintf(f,"    RX - good fragments    : %10" PRIu64 "\n", goodRxFragCnt_.get() );
+	fprintf(f,"    RX - good frames       : %10" PRIu64 "\n", goodRxFramCnt_.get() );
+	fprintf(f,"    RX - dropped (non-seq) : %10" PRIu64 "\n", nonSeqFragCnt_.get() );
+	fprintf(f,"    RX - dropped (bad-hdr) : %10" PRIu64 "\n", badHeadersCnt_.get() );
+	fprintf(f,"    RX - out-queue full    : %10" PRIu64 "\n", oQueueFullCnt_.get() );
+	fprintf(f,"    RX - dropped (q-full)  : %10" PRIu64 "\n", oQueueDropCnt_.get() );
+	reassemblyLatency_.dumpInfo( f, "    " );
+}
+
+void
+CTDestPort2::dumpStats(YAML::Node &node) const
+{
+	writeNode(node, "TDEST"          , getDest()            );
+	writeNode(node, "rxFrags"        , goodRxFragCnt_.get() );
+	writeNode(node, "rxFrames"       , goodRxFramCnt_.get() );
+	writeNode(node, "nonSeqDrops"    , nonSeqFragCnt_.get() );
+	writeNode(node, "badHeaderDrops" , badHeadersCnt_.get() );
+	writeNode(node, "outQueueFull"   , oQueueFullCnt_.get() );
+	writeNode(node, "outQueueDrops"  , oQueueDropCnt_.get() );
+	{
+	YAML::Node hist;
+		reassemblyLatency_.dumpYaml( hist );
+		writeNode(node, "reassemblyLatency", hist);
+	}
 }
 
 
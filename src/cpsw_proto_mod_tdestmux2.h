@@ -15,6 +15,7 @@
 #include <cpsw_event.h>
 #include <cpsw_proto_depack.h>
 #include <cpsw_thread.h>
+#include <cpsw_stats.h>
 #include <vector>
 #include <stdio.h>
 
@@ -67,9 +68,9 @@ private:
 	EventSet           inputDataAvailable_;
 	Work               work_[DEST_MAX-DEST_MIN+1];
 	unsigned           numWork_;
-	unsigned long      goodTxFragCnt_;
-	unsigned long      goodTxFramCnt_;
-	unsigned long      badHeadersCnt_;
+	CStatCounter       goodTxFragCnt_;
+	CStatCounter       goodTxFramCnt_;
+	CStatCounter       badHeadersCnt_;
 	unsigned           myMTUCached_;
 	
 	CTDestMuxer2Thread muxer_;
@@ -79,9 +80,6 @@ protected:
 	: CProtoModByteMux<TDestPort2>(orig, k),
 	  inputDataAvailable_( IEventSet::create() ),
 	  numWork_           ( 0                   ),
-	  goodTxFragCnt_     ( 0                   ),
-	  goodTxFramCnt_     ( 0                   ),
-	  badHeadersCnt_     ( 0                   ),
 	  myMTUCached_       ( 0                   ),
 	  muxer_             ( orig.muxer_         )
 	{
@@ -111,9 +109,7 @@ public:
 	: CProtoModByteMux<TDestPort2>(k, "TDEST VC Demux V2", threadPriority),
 	  inputDataAvailable_( IEventSet::create()  ),
 	  numWork_           ( 0                    ),
-	  goodTxFragCnt_     ( 0                    ),
-	  goodTxFramCnt_     ( 0                    ),
-	  badHeadersCnt_     ( 0                    ),
+	  myMTUCached_       ( 0                    ),
 	  muxer_             ( this, threadPriority )
 	{
 	}
@@ -141,9 +137,17 @@ public:
 
 	virtual void dumpInfo(FILE *f);
 
+	virtual void dumpStats(YAML::Node &) const;
+
+	virtual uint64_t getNumTxFrags()  const { return goodTxFragCnt_.get(); }
+	virtual uint64_t getNumTxFrames() const { return goodTxFramCnt_.get(); }
+
 	virtual void modStartup();
 	virtual void modShutdown();
 
+	virtual void setThreadSched(const std::string &cpuAffinity, int schedPolicy);
+	virtual void getThreads(std::vector<CRunnable*> *threads);
+
 	virtual ~CProtoModTDestMux2() {}
 };
 
@@ -156,19 +160,20 @@ private:
 
 	BufChain      assembleBuffer_;
 	FragID        fragNo_;
-	unsigned long badHeadersCnt_;
-	unsigned long nonSeqFragCnt_;
-	unsigned long goodRxFragCnt_;
-	unsigned long goodRxFramCnt_;
+	struct timespec assembleStarted_;
+	CStatCounter  badHeadersCnt_;
+	CStatCounter  nonSeqFragCnt_;
+	CStatCounter  goodRxFragCnt_;
+	CStatCounter  goodRxFramCnt_;
+	CStatCounter  oQueueFullCnt_;  // output queue was found full (stalled)
+	CStatCounter  oQueueDropCnt_;  // dropped because output queue was full
+
+	CLatencyHistogram reassemblyLatency_;
 
 protected:
 	CTDestPort2(const CTDestPort2 &orig, Key k)
 	: CByteMuxPort<CProtoModTDestMux2>(orig, k),
-	  slot_         ( -1 ),
-	  badHeadersCnt_(  0 ),
-	  nonSeqFragCnt_(  0 ),
-	  goodRxFragCnt_(  0 ),
-	  goodRxFramCnt_(  0 )
+	  slot_         ( -1 )
 	{
 	}
 
@@ -180,11 +185,7 @@ public:
 	  stripHeader_  ( stripHeader                  ),
 	  inpQueueDepth_( iQDepth                      ),
 	  inputQueue_   ( IBufQueue::create( iQDepth ) ),
-	  slot_         ( -1                           ),
-	  badHeadersCnt_( 0                            ),
-	  nonSeqFragCnt_( 0                            ),
-	  goodRxFragCnt_( 0                            ),
-	  goodRxFramCnt_( 0                            )
+	  slot_         ( -1                           )
 	{
 	}
 
@@ -230,6 +231,14 @@ public:
 	virtual unsigned getMTU();
 
 	virtual void dumpInfo(FILE *f);
+
+	virtual void dumpStats(YAML::Node &) const;
+
+	virtual uint64_t getNumRxFrags()          const { return goodRxFragCnt_.get(); }
+	virtual uint64_t getNumRxFrames()         const { return goodRxFramCnt_.get(); }
+	virtual uint64_t getNumOQueueFullDrops()  const { return oQueueDropCnt_.get(); }
+
+	virtual const CLatencyHistogram *getReassemblyLatency() const { return &reassemblyLatency_; }
 };
 
 #endif
@@ -17,8 +17,13 @@
 #include <cpsw_stdio.h>
 
 #include <errno.h>
+#include <unistd.h>
+#include <string.h>
 #include <sys/select.h>
 #include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <netinet/udp.h>
 
 #include <stdio.h>
 
@@ -45,76 +50,47 @@ CUdpHandlerThread::CUdpHandlerThread(CUdpHandlerThread &orig, struct sockaddr_in
 	sd_.init( dest, me_p, false );
 }
 
-#define NBUFS_MAX 8
-
 void * CProtoModUdp::CUdpRxHandlerThread::threadBody()
 {
-	ssize_t          got,siz,cap;
-	std::vector<Buf> bufs;
-	unsigned         idx;
-
-	struct iovec     iov[NBUFS_MAX];
-	int              niovs;
-
-	for ( niovs = 0, cap = 0; niovs<NBUFS_MAX && cap < (ssize_t)IBuf::CAPA_ETH_JUM; niovs++ ) {
-		bufs.push_back( IBuf::getBuf( IBuf::CAPA_ETH_BIG ) );
-		iov[niovs].iov_base = bufs[niovs]->getPayload();
-		cap += (iov[niovs].iov_len  = bufs[niovs]->getAvail());
-	}
+	ssize_t          got;
+	CSockRxBufs       rxBufs( owner_->usesGro() ? IBuf::CAPA_MAX : IBuf::CAPA_ETH_JUM );
 
 	while ( 1 ) {
 
 #ifdef UDP_DEBUG
 		fprintf(CPSW::fDbg(), "UDP -- waiting for data\n");
 #endif
-		got = ::readv( sd_.getSd(), iov, niovs );
+		got = rxBufs.receive( sd_.getSd() );
 		if ( got < 0 ) {
 			perror("rx thread");
 			sleep(10);
 			continue;
 		}
-		nDgrams_.fetch_add(1,   cpsw::memory_order_relaxed);
+		nDgrams_.fetch_add(rxBufs.getNumDgrams( got ), cpsw::memory_order_relaxed);
 		nOctets_.fetch_add(got, cpsw::memory_order_relaxed);
+		kernDrops_.update( rxBufs );
 
-		if ( got > 0 ) {
-#ifdef UDP_DEBUG
-#ifdef UDP_DEBUG_STRM
-			unsigned fram, frag;
-#endif
-#endif
-			BufChain bufch = IBufChain::create();
+		if ( got > 0 && rxBufs.getNumDgrams( got ) > 1 ) {
+			// coalesced by the kernel
+			nRxDrop_.fetch_add( owner_->pushDownSegs( &rxBufs, got ), cpsw::memory_order_relaxed );
+		} else if ( got > 0 ) {
+			BufChain bufch = rxBufs.harvest( got );
 
-			siz = got;
-			idx = 0;
-			while ( siz > 0 ) {
-				if ( siz < (cap = bufs[idx]->getAvail()) ) {
-					cap = siz;
-				}
-				bufs[idx]->setSize( cap );
 #ifdef UDP_DEBUG
-				if ( idx == 0 ) {
-					int      i;
-					uint8_t  *p = bufs[idx]->getPayload();
+			{
+			int      i;
+			uint8_t  *p = bufch->getHead()->getPayload();
 #ifdef UDP_DEBUG_STRM
-					fram = (p[1]<<4) | (p[0]>>4);
-					frag = (p[4]<<16) | (p[3] << 8) | p[2];
-#endif
-					fprintf(CPSW::fDbg(), "UDP data: ");
-					for ( i=0; i< (got < 4 ? got : 4); i++ )
-						fprintf(CPSW::fDbg(), "%02x ", p[i]);
-					fprintf(CPSW::fDbg(), "\n");
-				}
+			unsigned fram = (p[1]<<4) | (p[0]>>4);
+			unsigned frag = (p[4]<<16) | (p[3] << 8) | p[2];
+			fprintf(CPSW::fDbg(), "UDP fram # %4d, frag # %4d\n", fram, frag);
 #endif
-
-				bufch->addAtTail( bufs[idx] );
-
-				// get new buffers
-				bufs[idx] = IBuf::getBuf( IBuf::CAPA_ETH_BIG );
-				iov[idx].iov_base = bufs[idx]->getPayload();
-				iov[idx].iov_len  = bufs[idx]->getAvail();
-				idx++;
-				siz -= cap;
+			fprintf(CPSW::fDbg(), "UDP data: ");
+			for ( i=0; i< (got < 4 ? got : 4); i++ )
+				fprintf(CPSW::fDbg(), "%02x ", p[i]);
+			fprintf(CPSW::fDbg(), "\n");
 			}
+#endif
 
 		bool st=
 			// do NOT wait indefinitely
@@ -126,16 +102,13 @@ void * CProtoModUdp::CUdpRxHandlerThread::threadBody()
 
 #ifdef UDP_DEBUG
 			fprintf(CPSW::fDbg(), "UDP got %d", (int)got);
-#ifdef UDP_DEBUG_STRM
-			fprintf(CPSW::fDbg(), " fram # %4d, frag # %4d", fram, frag);
-#endif
 			if ( st )
 				fprintf(CPSW::fDbg(), " (pushdown SUCC)\n");
 			else
 				fprintf(CPSW::fDbg(), " (pushdown DROP)\n");
 #endif
 
-			if ( st ) {
+			if ( ! st ) {
 				nRxDrop_.fetch_add(1,   cpsw::memory_order_relaxed);
 			}
 		}
@@ -199,12 +172,343 @@ CUdpPeerPollerThread::CUdpPeerPollerThread(CUdpPeerPollerThread &orig, struct so
 {
 }
 
+CProtoModUdp::CUdpRxReactorHandler::CUdpRxReactorHandler(
+	struct sockaddr_in *dest,
+	struct sockaddr_in *me,
+	int                 pollSecs,
+	CProtoModUdp       *owner
+)
+: nOctets_    ( 0                         ),
+  nDgrams_    ( 0                         ),
+  nRxDrop_    ( 0                         ),
+  pollSecs_   ( pollSecs > 0 ? pollSecs : 0 ),
+  timerFd_    ( -1                        ),
+  pollTimer_  ( this                      ),
+  rxHandle_   ( 0                         ),
+  timerHandle_( 0                         ),
+  owner_      ( owner                     )
+{
+	init( dest, me );
+}
+
+CProtoModUdp::CUdpRxReactorHandler::CUdpRxReactorHandler(CUdpRxReactorHandler &orig, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner)
+: sd_         ( orig.sd_                  ),
+  nOctets_    ( 0                         ),
+  nDgrams_    ( 0                         ),
+  nRxDrop_    ( 0                         ),
+  pollSecs_   ( orig.pollSecs_            ),
+  timerFd_    ( -1                        ),
+  pollTimer_  ( this                      ),
+  rxHandle_   ( 0                         ),
+  timerHandle_( 0                         ),
+  owner_      ( owner                     )
+{
+	init( dest, me );
+}
+
+void
+CProtoModUdp::CUdpRxReactorHandler::init(struct sockaddr_in *dest, struct sockaddr_in *me)
+{
+	sd_.init( dest, me, true );
+	if ( pollSecs_ > 0 ) {
+		if ( (timerFd_ = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC )) < 0 ) {
+			throw InternalError( "UDP: unable to create poll timer", errno );
+		}
+	}
+}
+
+CProtoModUdp::CUdpRxReactorHandler::~CUdpRxReactorHandler()
+{
+	stop();
+	if ( timerFd_ >= 0 ) {
+		::close( timerFd_ );
+	}
+}
+
+void
+CProtoModUdp::CUdpRxReactorHandler::start()
+{
+CReactor          *reactor = CReactor::getTheReactor();
+struct itimerspec  its;
+
+	if ( rxHandle_ ) {
+		return;
+	}
+
+	rxHandle_ = reactor->add( sd_.getSd(), this );
+
+	if ( timerFd_ >= 0 ) {
+		// first poll right away
+		its.it_value.tv_sec     = 0;
+		its.it_value.tv_nsec    = 1;
+		its.it_interval.tv_sec  = pollSecs_;
+		its.it_interval.tv_nsec = 0;
+		if ( timerfd_settime( timerFd_, 0, &its, NULL ) ) {
+			throw InternalError( "UDP: unable to arm poll timer", errno );
+		}
+		timerHandle_ = reactor->add( timerFd_, &pollTimer_ );
+	}
+}
+
+void
+CProtoModUdp::CUdpRxReactorHandler::stop()
+{
+CReactor          *reactor;
+struct itimerspec  its;
+
+	if ( ! rxHandle_ ) {
+		return;
+	}
+
+	reactor = CReactor::getTheReactor();
+
+	reactor->remove( rxHandle_ );
+	rxHandle_ = 0;
+
+	if ( timerHandle_ ) {
+		reactor->remove( timerHandle_ );
+		timerHandle_ = 0;
+		memset( &its, 0, sizeof(its) );
+		timerfd_settime( timerFd_, 0, &its, NULL );
+	}
+}
+
+void
+CProtoModUdp::CUdpRxReactorHandler::handleInput()
+{
+ssize_t  got;
+unsigned n;
+
+	for ( n = 0; n < RX_BATCH; n++ ) {
+		got = rxBufs_.receive( sd_.getSd() );
+		if ( got < 0 ) {
+			if ( EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno ) {
+				perror("UDP reactor handler");
+			}
+			return;
+		}
+		nDgrams_.fetch_add(rxBufs_.getNumDgrams( got ), cpsw::memory_order_relaxed);
+		nOctets_.fetch_add(got, cpsw::memory_order_relaxed);
+		kernDrops_.update( rxBufs_ );
+
+		if ( got > 0 ) {
+			nRxDrop_.fetch_add( owner_->pushDownSegs( &rxBufs_, got ), cpsw::memory_order_relaxed );
+		}
+	}
+}
+
+bool
+CProtoModUdp::CUdpRxReactorHandler::setGro()
+{
+	if ( ! CSockSd::setUdpGro( sd_.getSd() ) ) {
+		return false;
+	}
+	rxBufs_.setCapacity( IBuf::CAPA_MAX );
+	return true;
+}
+
+void
+CProtoModUdp::CUdpRxReactorHandler::pollPeer()
+{
+uint64_t exp;
+uint8_t  buf[4];
+
+	// consume the expiration count
+	if ( ::read( timerFd_, &exp, sizeof(exp) ) < 0 ) {
+		return;
+	}
+	if ( ::write( sd_.getSd(), buf, 0 ) < 0 ) {
+		perror("UDP reactor poller (write)");
+	}
+}
+
+CProtoModUdp::CUdpRxMuxHandler::CUdpRxMuxHandler(
+	struct sockaddr_in *dest,
+	int                 pollSecs,
+	CProtoModUdp       *owner
+)
+: dest_       ( *dest                     ),
+  sock_       ( NULL                      ),
+  nOctets_    ( 0                         ),
+  nDgrams_    ( 0                         ),
+  nRxDrop_    ( 0                         ),
+  pollSecs_   ( pollSecs > 0 ? pollSecs : 0 ),
+  owner_      ( owner                     )
+{
+	sock_ = CUdpMux::getTheMux()->attach( &dest_, this, pollSecs_ );
+}
+
+CProtoModUdp::CUdpRxMuxHandler::~CUdpRxMuxHandler()
+{
+	sock_->detach( &dest_ );
+}
+
+void
+CProtoModUdp::CUdpRxMuxHandler::handleInput(CSockRxBufs *rxBufs, ssize_t got)
+{
+	nDgrams_.fetch_add(rxBufs->getNumDgrams( got ), cpsw::memory_order_relaxed);
+	nOctets_.fetch_add(got, cpsw::memory_order_relaxed);
+
+	if ( got > 0 ) {
+		nRxDrop_.fetch_add( owner_->pushDownSegs( rxBufs, got ), cpsw::memory_order_relaxed );
+	}
+}
+
+CProtoModUdp::CUdpRxUringHandler::CUdpRxUringHandler(
+	struct sockaddr_in *dest,
+	struct sockaddr_in *me,
+	int                 pollSecs,
+	CProtoModUdp       *owner
+)
+: nOctets_    ( 0                         ),
+  nDgrams_    ( 0                         ),
+  nRxDrop_    ( 0                         ),
+  pollSecs_   ( pollSecs > 0 ? pollSecs : 0 ),
+  rxHandle_   ( 0                         ),
+  timerHandle_( 0                         ),
+  owner_      ( owner                     )
+{
+	sd_.init( dest, me, true );
+}
+
+CProtoModUdp::CUdpRxUringHandler::CUdpRxUringHandler(CUdpRxUringHandler &orig, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner)
+: sd_         ( orig.sd_                  ),
+  nOctets_    ( 0                         ),
+  nDgrams_    ( 0                         ),
+  nRxDrop_    ( 0                         ),
+  pollSecs_   ( orig.pollSecs_            ),
+  rxHandle_   ( 0                         ),
+  timerHandle_( 0                         ),
+  owner_      ( owner                     )
+{
+	sd_.init( dest, me, true );
+}
+
+CProtoModUdp::CUdpRxUringHandler::~CUdpRxUringHandler()
+{
+	stop();
+}
+
+void
+CProtoModUdp::CUdpRxUringHandler::start()
+{
+CUring *uring = CUring::getTheUring();
+
+	if ( rxHandle_ ) {
+		return;
+	}
+
+	rxHandle_ = uring->addRecv( sd_.getSd(), this );
+
+	if ( pollSecs_ > 0 ) {
+		timerHandle_ = uring->addTimer( this );
+		// first poll right away
+		handleTimer();
+	}
+}
+
+void
+CProtoModUdp::CUdpRxUringHandler::stop()
+{
+CUring *uring;
+
+	if ( ! rxHandle_ ) {
+		return;
+	}
+
+	uring = CUring::getTheUring();
+
+	uring->remove( rxHandle_ );
+	rxHandle_ = 0;
+
+	if ( timerHandle_ ) {
+		uring->remove( timerHandle_ );
+		timerHandle_ = 0;
+	}
+}
+
+bool
+CProtoModUdp::CUdpRxUringHandler::handleRecv(BufChain bc, const CSockRxInfo *info)
+{
+size_t got = bc->getSize();
+
+	nDgrams_.fetch_add(1,   cpsw::memory_order_relaxed);
+	nOctets_.fetch_add(got, cpsw::memory_order_relaxed);
+	kernDrops_.update( info );
+
+	if ( got > 0 ) {
+		if ( ! owner_->pushDown( bc, &TIMEOUT_NONE ) ) {
+			nRxDrop_.fetch_add(1,   cpsw::memory_order_relaxed);
+		}
+	}
+	return true;
+}
+
+void
+CProtoModUdp::CUdpRxUringHandler::handleError(int err)
+{
+	fprintf(CPSW::fErr(), "UDP io_uring handler: receive failed (%s)\n", strerror( err ));
+}
+
+void
+CProtoModUdp::CUdpRxUringHandler::handleTimer()
+{
+uint8_t  buf[4];
+
+	if ( ::write( sd_.getSd(), buf, 0 ) < 0 ) {
+		perror("UDP io_uring poller (write)");
+	}
+	CUring::getTheUring()->armTimer( timerHandle_, (unsigned long)pollSecs_ * 1000000UL );
+}
+
+CProtoModUdp::CUdpRxPacketRingThread::CUdpRxPacketRingThread(
+	const char         *name,
+	int                 threadPriority,
+	struct sockaddr_in *dest,
+	struct sockaddr_in *me,
+	CProtoModUdp       *owner
+)
+: CUdpHandlerThread( name, threadPriority, dest, me ),
+  ring_            ( dest, me                     ),
+  nRxDrop_         ( 0                            ),
+  owner_           ( owner                        )
+{
+	CPacketRing::attachDropFilter( sd_.getSd() );
+}
+
+CProtoModUdp::CUdpRxPacketRingThread::CUdpRxPacketRingThread(CUdpRxPacketRingThread &orig, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner)
+: CUdpHandlerThread( orig, dest, me ),
+  ring_            ( dest, me         ),
+  nRxDrop_         ( 0                ),
+  owner_           ( owner            )
+{
+	CPacketRing::attachDropFilter( sd_.getSd() );
+}
+
+void * CProtoModUdp::CUdpRxPacketRingThread::threadBody()
+{
+	while ( 1 ) {
+		ring_.processBlock( this, -1 );
+	}
+	return NULL;
+}
+
+void
+CProtoModUdp::CUdpRxPacketRingThread::handleDgram(BufChain bc)
+{
+	if ( bc->getSize() > 0 ) {
+		if ( ! owner_->pushDown( bc, &TIMEOUT_NONE ) ) {
+			nRxDrop_.fetch_add(1,   cpsw::memory_order_relaxed);
+		}
+	}
+}
+
 void CProtoModUdp::createThreads(unsigned nRxThreads, int pollSeconds)
 {
 	unsigned i;
 	struct sockaddr_in me;
 
-	tx_.getMyAddr( &me );
+	tx_->getMyAddr( &me );
 
 	if ( poller_ ) {
 		// called from copy constructor
@@ -229,6 +533,14 @@ void CProtoModUdp::createThreads(unsigned nRxThreads, int pollSeconds)
 void CProtoModUdp::modStartup()
 {
 unsigned i;
+	if ( rxMux_ )
+		rxMux_->start();
+	if ( rxReactor_ )
+		rxReactor_->start();
+	if ( rxUring_ )
+		rxUring_->start();
+	if ( rxRing_ )
+		rxRing_->threadStart();
 	if ( poller_ )
 		poller_->threadStart();
 	for ( i=0; i<rxHandlers_.size(); i++ ) {
@@ -239,6 +551,14 @@ unsigned i;
 void CProtoModUdp::modShutdown()
 {
 unsigned i;
+	if ( rxMux_ )
+		rxMux_->stop();
+	if ( rxReactor_ )
+		rxReactor_->stop();
+	if ( rxUring_ )
+		rxUring_->stop();
+	if ( rxRing_ )
+		rxRing_->threadStop();
 	if ( poller_ )
 		poller_->threadStop();
 
@@ -247,23 +567,100 @@ unsigned i;
 	}
 }
 
+void CProtoModUdp::setThreadSched(const std::string &cpuAffinity, int schedPolicy)
+{
+unsigned i;
+	if ( poller_ ) {
+		poller_->setCpuAffinity( cpuAffinity );
+		poller_->setSchedPolicy( schedPolicy );
+	}
+	if ( rxRing_ ) {
+		rxRing_->setCpuAffinity( cpuAffinity );
+		rxRing_->setSchedPolicy( schedPolicy );
+	}
+	for ( i=0; i<rxHandlers_.size(); i++ ) {
+		rxHandlers_[i]->setCpuAffinity( cpuAffinity );
+		rxHandlers_[i]->setSchedPolicy( schedPolicy );
+	}
+}
+
+void CProtoModUdp::getThreads(std::vector<CRunnable*> *threads)
+{
+unsigned i;
+	if ( poller_ )
+		threads->push_back( poller_ );
+	if ( rxRing_ )
+		threads->push_back( rxRing_ );
+	for ( i=0; i<rxHandlers_.size(); i++ ) {
+		threads->push_back( rxHandlers_[i] );
+	}
+}
+
 CProtoModUdp::CProtoModUdp(
 	Key                &k,
 	struct sockaddr_in *dest,
 	unsigned            depth,
 	int                 threadPriority,
 	unsigned            nRxThreads,
-	int                 pollSecs
+	int                 pollSecs,
+	bool                useReactor,
+	bool                useUring,
+	bool                usePacketRing,
+	bool                useSharedSocket
 )
 :CProtoMod(k, depth),
  dest_(*dest),
+ tx_( useSharedSocket ? NULL : new CSockSd() ),
  nTxOctets_(0),
  nTxDgrams_(0),
  threadPriority_(threadPriority),
- poller_( NULL )
+ busyPollUs_(0),
+ pollBufs_( NULL ),
+ pollBusy_( false ),
+ nPollOctets_(0),
+ nPollDgrams_(0),
+ nPollRxDrop_(0),
+ rcvBufSize_(0),
+ sndBufSize_(0),
+ useGso_(false),
+ useGro_(false),
+ nGsoSends_(0),
+ nGroMsgs_(0),
+ poller_( NULL ),
+ rxReactor_( NULL ),
+ rxUring_( NULL ),
+ rxRing_( NULL ),
+ rxMux_( NULL )
 {
-	tx_.init( dest, 0, true );
-	createThreads( nRxThreads, pollSecs );
+	if ( useSharedSocket ) {
+		rxMux_ = new CUdpRxMuxHandler( &dest_, pollSecs, this );
+		return;
+	}
+	tx_->init( dest, 0, true );
+	if ( usePacketRing ) {
+	struct sockaddr_in me;
+		tx_->getMyAddr( &me );
+		try {
+			rxRing_ = new CUdpRxPacketRingThread( "UDP RX Packet Ring (UDP protocol module)", threadPriority_, &dest_, &me, this );
+			threadPriority_ = rxRing_->getPrio();
+		} catch ( CPSWError &e ) {
+			fprintf( CPSW::fErr(), "%s -- UDP: packet ring not available\n", e.getInfo().c_str() );
+		}
+	}
+	if ( rxRing_ ) {
+		// poller only
+		createThreads( 0, pollSecs );
+	} else if ( useUring && CUring::getTheUring() ) {
+	struct sockaddr_in me;
+		tx_->getMyAddr( &me );
+		rxUring_ = new CUdpRxUringHandler( &dest_, &me, pollSecs, this );
+	} else if ( useReactor ) {
+	struct sockaddr_in me;
+		tx_->getMyAddr( &me );
+		rxReactor_ = new CUdpRxReactorHandler( &dest_, &me, pollSecs, this );
+	} else {
+		createThreads( nRxThreads, pollSecs );
+	}
 }
 
 void
@@ -272,25 +669,248 @@ CProtoModUdp::dumpYaml(YAML::Node &node) const
 	YAML::Node udpParms;
 	writeNode(udpParms, YAML_KEY_port,          getDestPort()     );
 	writeNode(udpParms, YAML_KEY_outQueueDepth, getQueueDepth()   );
-	writeNode(udpParms, YAML_KEY_numRxThreads,  rxHandlers_.size());
-	writeNode(udpParms, YAML_KEY_pollSecs,      poller_ ? poller_->getPollSecs() : 0);
+	if ( rxMux_ ) {
+		writeNode(udpParms, YAML_KEY_useSharedSocket, true);
+		writeNode(udpParms, YAML_KEY_pollSecs,      rxMux_->getPollSecs());
+	} else if ( rxRing_ ) {
+		writeNode(udpParms, YAML_KEY_usePacketRing, true);
+		writeNode(udpParms, YAML_KEY_pollSecs,      poller_ ? poller_->getPollSecs() : 0);
+	} else if ( rxUring_ ) {
+		writeNode(udpParms, YAML_KEY_useUring,      true);
+		writeNode(udpParms, YAML_KEY_pollSecs,      rxUring_->getPollSecs());
+	} else if ( rxReactor_ ) {
+		writeNode(udpParms, YAML_KEY_useReactor,    true);
+		writeNode(udpParms, YAML_KEY_pollSecs,      rxReactor_->getPollSecs());
+	} else {
+		writeNode(udpParms, YAML_KEY_numRxThreads,  rxHandlers_.size());
+		writeNode(udpParms, YAML_KEY_pollSecs,      poller_ ? poller_->getPollSecs() : 0);
+	}
 	if ( threadPriority_ != IProtoStackBuilder::DFLT_THREAD_PRIORITY ) {
 		writeNode(udpParms, YAML_KEY_threadPriority,  threadPriority_);
 	}
+	if ( rcvBufSize_ ) {
+		writeNode(udpParms, YAML_KEY_rcvBufSize,    rcvBufSize_);
+	}
+	if ( sndBufSize_ ) {
+		writeNode(udpParms, YAML_KEY_sndBufSize,    sndBufSize_);
+	}
+	if ( useGso_ ) {
+		writeNode(udpParms, YAML_KEY_useGso,        true);
+	}
+	if ( useGro_ ) {
+		writeNode(udpParms, YAML_KEY_useGro,        true);
+	}
 	writeNode(node, YAML_KEY_UDP, udpParms);
 }
 
 CProtoModUdp::CProtoModUdp(CProtoModUdp &orig, Key &k)
 :CProtoMod(orig, k),
  dest_(orig.dest_),
- tx_(orig.tx_),
+ tx_( orig.tx_ ? new CSockSd( *orig.tx_ ) : NULL ),
  nTxOctets_(0),
  nTxDgrams_(0),
  threadPriority_(orig.threadPriority_),
- poller_(orig.poller_)
+ busyPollUs_(0),
+ pollBufs_( NULL ),
+ pollBusy_( false ),
+ nPollOctets_(0),
+ nPollDgrams_(0),
+ nPollRxDrop_(0),
+ rcvBufSize_(0),
+ sndBufSize_(0),
+ useGso_(false),
+ useGro_(false),
+ nGsoSends_(0),
+ nGroMsgs_(0),
+ poller_(orig.poller_),
+ rxReactor_( NULL ),
+ rxUring_( NULL ),
+ rxRing_( NULL ),
+ rxMux_( NULL )
+{
+	if ( tx_ ) {
+		tx_->init( &dest_, 0, true );
+	}
+	if ( orig.rxMux_ ) {
+		// attached to a different socket of the pool
+		rxMux_ = new CUdpRxMuxHandler( &dest_, orig.rxMux_->getPollSecs(), this );
+	} else if ( orig.rxRing_ ) {
+	struct sockaddr_in me;
+		tx_->getMyAddr( &me );
+		rxRing_ = new CUdpRxPacketRingThread( *orig.rxRing_, &dest_, &me, this );
+		createThreads( 0, -1 );
+	} else if ( orig.rxUring_ ) {
+	struct sockaddr_in me;
+		tx_->getMyAddr( &me );
+		rxUring_ = new CUdpRxUringHandler( *orig.rxUring_, &dest_, &me, this );
+	} else if ( orig.rxReactor_ ) {
+	struct sockaddr_in me;
+		tx_->getMyAddr( &me );
+		rxReactor_ = new CUdpRxReactorHandler( *orig.rxReactor_, &dest_, &me, this );
+	} else {
+		createThreads( orig.rxHandlers_.size(), -1 );
+	}
+	if ( orig.busyPollUs_ ) {
+		setBusyPoll( orig.busyPollUs_ );
+	}
+	if ( orig.rcvBufSize_ || orig.sndBufSize_ ) {
+		setSockBufSizes( orig.rcvBufSize_, orig.sndBufSize_ );
+	}
+	if ( orig.useGso_ || orig.useGro_ ) {
+		setOffload( orig.useGso_, orig.useGro_ );
+	}
+}
+
+void CProtoModUdp::setSockBufSizes(unsigned rcvBufSize, unsigned sndBufSize)
+{
+unsigned i;
+
+	if ( rxMux_ ) {
+		rxMux_->getMuxSock()->raiseBufSizes( rcvBufSize, sndBufSize );
+		if ( rcvBufSize )
+			rcvBufSize_ = rcvBufSize;
+		if ( sndBufSize )
+			sndBufSize_ = sndBufSize;
+		return;
+	}
+
+	if ( rcvBufSize ) {
+		for ( i=0; i<rxHandlers_.size(); i++ )
+			CSockSd::setBufSize( rxHandlers_[i]->getSd(), true, rcvBufSize );
+		if ( rxReactor_ )
+			CSockSd::setBufSize( rxReactor_->getSd(), true, rcvBufSize );
+		if ( rxUring_ )
+			CSockSd::setBufSize( rxUring_->getSd(), true, rcvBufSize );
+		rcvBufSize_ = rcvBufSize;
+	}
+	if ( sndBufSize ) {
+		CSockSd::setBufSize( tx_->getSd(), false, sndBufSize );
+		sndBufSize_ = sndBufSize;
+	}
+}
+
+void CProtoModUdp::setOffload(bool gso, bool gro)
+{
+unsigned i;
+
+	useGso_ = gso && ! rxUring_ && CSockSd::hasUdpGso( txSd() );
+
+	if ( gro && ( rxUring_ || rxRing_ || rxMux_ ) ) {
+		gro = false;
+	}
+	for ( i=0; gro && i<rxHandlers_.size(); i++ ) {
+		gro = CSockSd::setUdpGro( rxHandlers_[i]->getSd() );
+	}
+	if ( gro && rxReactor_ ) {
+		gro = rxReactor_->setGro();
+	}
+	useGro_ = gro;
+
+	if ( useGro_ && pollBufs_ ) {
+		pollBufs_->setCapacity( IBuf::CAPA_MAX );
+	}
+}
+
+unsigned CProtoModUdp::pushDownSegs(CSockRxBufs *rxBufs, ssize_t got)
+{
+std::vector<BufChain> dgrams;
+unsigned              i, nDrop = 0;
+
+	if ( rxBufs->getNumDgrams( got ) < 2 ) {
+		return pushDown( rxBufs->harvest( got ), &TIMEOUT_NONE ) ? 0 : 1;
+	}
+
+	nGroMsgs_.fetch_add( 1, cpsw::memory_order_relaxed );
+
+	rxBufs->harvest( got, &dgrams );
+	for ( i=0; i<dgrams.size(); i++ ) {
+		if ( ! pushDown( dgrams[i], &TIMEOUT_NONE ) ) {
+			nDrop++;
+		}
+	}
+	return nDrop;
+}
+
+void CProtoModUdp::setBusyPoll(unsigned us)
+{
+unsigned i;
+std::vector<int> sds;
+
+	if ( ! us ) {
+		// cannot safely revoke the buffers from a concurrent poller
+		throw InvalidArgError("UDP: busy-polling cannot be disabled");
+	}
+
+	if ( ! pollBufs_ ) {
+		pollBufs_ = new CSockRxBufs( useGro_ ? IBuf::CAPA_MAX : IBuf::CAPA_ETH_JUM );
+	}
+	busyPollUs_ = us;
+
+	for ( i=0; i<rxHandlers_.size(); i++ )
+		sds.push_back( rxHandlers_[i]->getSd() );
+	if ( rxReactor_ )
+		sds.push_back( rxReactor_->getSd() );
+	if ( rxUring_ )
+		sds.push_back( rxUring_->getSd() );
+
+#ifdef SO_BUSY_POLL
+	// let the kernel spin on the device queue, too. Raising
+	// the value above net.core.busy_read requires CAP_NET_ADMIN;
+	// failure is not an error (we still spin in user space).
+	{
+	int optval = us;
+		for ( i=0; i<sds.size(); i++ ) {
+			::setsockopt( sds[i], SOL_SOCKET, SO_BUSY_POLL, &optval, sizeof(optval) );
+		}
+	}
+#endif
+}
+
+unsigned CProtoModUdp::pollSd(int sd, CUdpKernDrops *kernDrops)
+{
+ssize_t       got;
+unsigned      n;
+
+	for ( n = 0; n < POLL_BATCH; ) {
+		if ( (got = pollBufs_->receive( sd, MSG_DONTWAIT )) < 0 ) {
+			if ( EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno ) {
+				perror("UDP busy-poll");
+			}
+			break;
+		}
+		nPollDgrams_.fetch_add(pollBufs_->getNumDgrams( got ), cpsw::memory_order_relaxed);
+		nPollOctets_.fetch_add(got, cpsw::memory_order_relaxed);
+		kernDrops->update( *pollBufs_ );
+		if ( got > 0 ) {
+			n += pollBufs_->getNumDgrams( got );
+			nPollRxDrop_.fetch_add( pushDownSegs( pollBufs_, got ), cpsw::memory_order_relaxed );
+		}
+	}
+	return n;
+}
+
+unsigned CProtoModUdp::pollRx()
 {
-	tx_.init( &dest_, 0, true );
-	createThreads( orig.rxHandlers_.size(), -1 );
+unsigned i, n = 0;
+
+	if ( ! pollBufs_ || pollBusy_.exchange( true, cpsw::memory_order_acquire ) ) {
+		return 0;
+	}
+
+	try {
+		for ( i=0; i<rxHandlers_.size(); i++ )
+			n += pollSd( rxHandlers_[i]->getSd(), rxHandlers_[i]->getKernDrops() );
+		if ( rxReactor_ )
+			n += pollSd( rxReactor_->getSd(), rxReactor_->getKernDrops() );
+		if ( rxUring_ )
+			n += pollSd( rxUring_->getSd(), rxUring_->getKernDrops() );
+	} catch ( ... ) {
+		pollBusy_.store( false, cpsw::memory_order_release );
+		throw;
+	}
+
+	pollBusy_.store( false, cpsw::memory_order_release );
+	return n;
 }
 
 uint64_t CProtoModUdp::getNumRxOctets()
@@ -300,7 +920,15 @@ uint64_t rval = 0;
 
 	for ( i=0; i<rxHandlers_.size(); i++ )
 		rval += rxHandlers_[i]->getNumOctets();
-	return rval;
+	if ( rxReactor_ )
+		rval += rxReactor_->getNumOctets();
+	if ( rxUring_ )
+		rval += rxUring_->getNumOctets();
+	if ( rxRing_ )
+		rval += rxRing_->getNumOctets();
+	if ( rxMux_ )
+		rval += rxMux_->getNumOctets();
+	return rval + nPollOctets_.load( cpsw::memory_order_relaxed );
 }
 
 uint64_t CProtoModUdp::getNumRxDgrams()
@@ -310,7 +938,15 @@ uint64_t rval = 0;
 
 	for ( i=0; i<rxHandlers_.size(); i++ )
 		rval += rxHandlers_[i]->getNumDgrams();
-	return rval;
+	if ( rxReactor_ )
+		rval += rxReactor_->getNumDgrams();
+	if ( rxUring_ )
+		rval += rxUring_->getNumDgrams();
+	if ( rxRing_ )
+		rval += rxRing_->getNumDgrams();
+	if ( rxMux_ )
+		rval += rxMux_->getNumDgrams();
+	return rval + nPollDgrams_.load( cpsw::memory_order_relaxed );
 }
 
 uint64_t CProtoModUdp::getNumRxDrops()
@@ -320,6 +956,30 @@ uint64_t rval = 0;
 
 	for ( i=0; i<rxHandlers_.size(); i++ )
 		rval += rxHandlers_[i]->getNumRxDrop();
+	if ( rxReactor_ )
+		rval += rxReactor_->getNumRxDrop();
+	if ( rxUring_ )
+		rval += rxUring_->getNumRxDrop();
+	if ( rxRing_ )
+		rval += rxRing_->getNumRxDrop();
+	if ( rxMux_ )
+		rval += rxMux_->getNumRxDrop();
+	return rval + nPollRxDrop_.load( cpsw::memory_order_relaxed );
+}
+
+uint64_t CProtoModUdp::getNumRxKernDrops()
+{
+unsigned i;
+uint64_t rval = 0;
+
+	for ( i=0; i<rxHandlers_.size(); i++ )
+		rval += rxHandlers_[i]->getKernDrops()->get();
+	if ( rxReactor_ )
+		rval += rxReactor_->getKernDrops()->get();
+	if ( rxUring_ )
+		rval += rxUring_->getKernDrops()->get();
+	if ( rxRing_ )
+		rval += rxRing_->getRing()->getNumKernDrops();
 	return rval;
 }
 
@@ -331,6 +991,18 @@ unsigned i;
 		delete rxHandlers_[i];
 	if ( poller_ )
 		delete poller_;
+	if ( rxReactor_ )
+		delete rxReactor_;
+	if ( rxUring_ )
+		delete rxUring_;
+	if ( rxRing_ )
+		delete rxRing_;
+	if ( rxMux_ )
+		delete rxMux_;
+	if ( tx_ )
+		delete tx_;
+	if ( pollBufs_ )
+		delete pollBufs_;
 }
 
 void CProtoModUdp::dumpInfo(FILE *f)
@@ -340,23 +1012,84 @@ void CProtoModUdp::dumpInfo(FILE *f)
 
 	fprintf(f,"CProtoModUdp:\n");
 	fprintf(f,"  Peer port : %15u\n",    getDestPort());
+	if ( rxMux_ ) {
+	fprintf(f,"  Shared at : %15u\n",    rxMux_->getMuxSock()->getPort());
+	fprintf(f,"  Has Poller:               %c\n", rxMux_->getPollSecs() ? 'Y' : 'N');
+	} else if ( rxRing_ ) {
+	fprintf(f,"  Pkt. ring : %15s\n",    rxRing_->getRing()->getIfName());
+	fprintf(f,"  #RX blocks: %15" PRIu64 "\n", rxRing_->getRing()->getNumBlocks());
+	fprintf(f,"  ThreadPrio: %15d\n",    threadPriority_);
+	fprintf(f,"  Has Poller:               %c\n", poller_ ? 'Y' : 'N');
+	} else if ( rxUring_ ) {
+	fprintf(f,"  io_uring  :               Y\n");
+	fprintf(f,"  Has Poller:               %c\n", rxUring_->getPollSecs() ? 'Y' : 'N');
+	} else if ( rxReactor_ ) {
+	fprintf(f,"  Reactor   :               Y\n");
+	fprintf(f,"  Has Poller:               %c\n", rxReactor_->getPollSecs() ? 'Y' : 'N');
+	} else {
 	fprintf(f,"  RX Threads: %15lu\n",   (unsigned long)rxHandlers_.size());
 	fprintf(f,"  ThreadPrio: %15d\n",    threadPriority_);
 	fprintf(f,"  Has Poller:               %c\n", poller_ ? 'Y' : 'N');
+	}
 	fprintf(f,"  #TX Octets: %15" PRIu64 "\n", getNumTxOctets());
 	fprintf(f,"  #TX DGRAMs: %15" PRIu64 "\n", getNumTxDgrams());
 	fprintf(f,"  #RX Octets: %15" PRIu64 "\n", getNumRxOctets());
 	fprintf(f,"  #RX DGRAMs: %15" PRIu64 "\n", getNumRxDgrams());
 	fprintf(f,"  #RX droppd: %15" PRIu64 "\n", getNumRxDrops() );
+	fprintf(f,"  #RX kdrops: %15" PRIu64 "\n", getNumRxKernDrops() );
+	if ( rxHandlers_.size() > 0 || rxReactor_ || rxUring_ || rxMux_ ) {
+	fprintf(f,"  RX sockbuf: %15u\n",    CSockSd::getBufSize( rxMux_ ? rxMux_->getSd() : rxUring_ ? rxUring_->getSd() : rxReactor_ ? rxReactor_->getSd() : rxHandlers_[0]->getSd(), true ));
+	}
+	fprintf(f,"  TX sockbuf: %15u\n",    CSockSd::getBufSize( txSd(), false ));
+	if ( useGso_ ) {
+	fprintf(f,"  #TX GSO   : %15" PRIu64 "\n", getNumGsoSends());
+	}
+	if ( useGro_ ) {
+	fprintf(f,"  #RX GRO   : %15" PRIu64 "\n", getNumGroMsgs());
+	}
+	if ( busyPollUs_ ) {
+	fprintf(f,"  Busy-poll : %13uus\n",   busyPollUs_);
+	fprintf(f,"  #RX polled: %15" PRIu64 "\n", nPollDgrams_.load( cpsw::memory_order_relaxed ));
+	}
 }
 
-bool CProtoModUdp::doPush(BufChain bc, bool wait, const CTimeout *timeout, bool abs_timeout)
+int CProtoModUdp::txSd() const
+{
+	return tx_ ? tx_->getSd() : rxMux_->getSd();
+}
+
+bool CProtoModUdp::waitTx(const CTimeout *timeout)
 {
 fd_set         fds;
-int            selres, sndres;
+int            selres;
+
+	FD_ZERO( &fds );
+
+	FD_SET( txSd(), &fds );
+
+	// use pselect: does't modify the timeout and it's a timespec
+	selres = ::pselect( txSd() + 1, NULL, &fds, NULL, !timeout || timeout->isIndefinite() ? NULL : &timeout->tv_, NULL );
+	if ( selres < 0  ) {
+		perror("::pselect() - dropping message due to error");
+		return false;
+	}
+	if ( selres == 0 ) {
+#ifdef UDP_DEBUG
+		fprintf(CPSW::fDbg(), "UDP doPush -- pselect timeout\n");
+#endif
+		// TIMEOUT
+		return false;
+	}
+	return true;
+}
+
+bool CProtoModUdp::doPush(BufChain bc, bool wait, const CTimeout *timeout, bool abs_timeout)
+{
+int            sndres;
 Buf            b;
 struct iovec   iov[bc->getLen()];
 unsigned       nios;
+struct msghdr  msg;
 
 	// there could be two models for sending a chain of buffers:
 	// a) the chain describes a gather list (one UDP message assembled from chain)
@@ -368,35 +1101,34 @@ unsigned       nios;
 	nTxDgrams_.fetch_add( 1, cpsw::memory_order_relaxed );
 	nTxOctets_.fetch_add( bc->getSize(), cpsw::memory_order_relaxed );
 
+	// queued to the ring (if possible) without waiting
+	if ( rxUring_ && CUring::getTheUring()->send( tx_->getSd(), bc ) ) {
+		return true;
+	}
+
 	for (nios=0, b=bc->getHead(); nios<bc->getLen(); nios++, b=b->getNext()) {
 		iov[nios].iov_base = b->getPayload();
 		iov[nios].iov_len  = b->getSize();
 	}
 
-	if ( wait ) {
-		FD_ZERO( &fds );
-
-		FD_SET( tx_.getSd(), &fds );
-
-		// use pselect: does't modify the timeout and it's a timespec
-		selres = ::pselect( tx_.getSd() + 1, NULL, &fds, NULL, !timeout || timeout->isIndefinite() ? NULL : &timeout->tv_, NULL );
-		if ( selres < 0  ) {
-			perror("::pselect() - dropping message due to error");
-			return false;
-		}
-		if ( selres == 0 ) {
-#ifdef UDP_DEBUG
-			fprintf(CPSW::fDbg(), "UDP doPush -- pselect timeout\n");
-#endif
-			// TIMEOUT
-			return false;
-		}
+	if ( wait && ! waitTx( timeout ) ) {
+		return false;
 	}
 
-	sndres = writev( tx_.getSd(), iov, nios );
+	if ( rxMux_ ) {
+		// shared socket is not connected
+		memset( &msg, 0, sizeof(msg) );
+		msg.msg_name    = &dest_;
+		msg.msg_namelen = sizeof(dest_);
+		msg.msg_iov     = iov;
+		msg.msg_iovlen  = nios;
+		sndres = ::sendmsg( txSd(), &msg, 0 );
+	} else {
+		sndres = writev( tx_->getSd(), iov, nios );
+	}
 
 	if ( sndres < 0 ) {
-		perror("::writev() - dropping message due to error");
+		perror(rxMux_ ? "::sendmsg() - dropping message due to error" : "::writev() - dropping message due to error");
 #ifdef UDP_DEBUG
 // this could help debugging the occasinal EPERM I get here...
 #warning FIXME
@@ -414,6 +1146,123 @@ abort();
 	return true;
 }
 
+// Hand a train of frames to the kernel with as few system calls
+// as possible: every run of equal-sized frames (the last one may
+// be shorter) becomes a single message which the kernel (or NIC)
+// segments into datagrams of the run's frame size (UDP_SEGMENT).
+// All messages are sent with a single 'sendmmsg()' (unless the
+// socket buffer fills up).
+bool CProtoModUdp::pushTrain(const std::vector<BufChain> &train, const CTimeout *timeout, bool abs_timeout)
+{
+#ifdef UDP_SEGMENT
+union CtlBuf {
+	struct cmsghdr align;
+	char           buf[CMSG_SPACE(sizeof(uint16_t))];
+};
+unsigned                    i, j, k, nbufs, nmsgs;
+size_t                      seg, bytes;
+int                         sent;
+Buf                         b;
+struct cmsghdr             *cmsg;
+std::vector<struct iovec>   iovs;
+std::vector<struct mmsghdr> msgs;
+std::vector<CtlBuf>         ctls;
+std::vector<unsigned>       first;
+
+	if ( ! useGso_ || train.size() < 2 ) {
+		return CProtoMod::pushTrain( train, timeout, abs_timeout );
+	}
+
+	for ( i = 0, nbufs = 0; i < train.size(); i++ ) {
+		nbufs += train[i]->getLen();
+	}
+
+	iovs.resize( nbufs );
+	msgs.resize( train.size() );
+	ctls.resize( train.size() );
+	first.resize( train.size() + 1 );
+
+	for ( i = 0, nbufs = 0, nmsgs = 0; i < train.size(); i = j, nmsgs++ ) {
+		seg   = train[i]->getSize();
+		bytes = seg;
+		for ( j = i + 1; seg > 0 && j < train.size() && j - i < CSockSd::GSO_MAX_SEGS; j++ ) {
+			if ( train[j]->getSize() > seg || bytes + train[j]->getSize() > CSockSd::GSO_MAX_BYTES ) {
+				break;
+			}
+			bytes += train[j]->getSize();
+			if ( train[j]->getSize() < seg ) {
+				// short one terminates the run
+				j++;
+				break;
+			}
+		}
+
+		memset( &msgs[nmsgs], 0, sizeof(msgs[nmsgs]) );
+		if ( rxMux_ ) {
+			// shared socket is not connected
+			msgs[nmsgs].msg_hdr.msg_name    = &dest_;
+			msgs[nmsgs].msg_hdr.msg_namelen = sizeof(dest_);
+		}
+		first[nmsgs]                   = i;
+		msgs[nmsgs].msg_hdr.msg_iov    = &iovs[nbufs];
+		for ( k = i; k < j; k++ ) {
+			for ( b = train[k]->getHead(); b; b = b->getNext() ) {
+				iovs[nbufs].iov_base = b->getPayload();
+				iovs[nbufs].iov_len  = b->getSize();
+				nbufs++;
+			}
+		}
+		msgs[nmsgs].msg_hdr.msg_iovlen = &iovs[nbufs] - msgs[nmsgs].msg_hdr.msg_iov;
+
+		if ( j - i > 1 ) {
+			msgs[nmsgs].msg_hdr.msg_control    = ctls[nmsgs].buf;
+			msgs[nmsgs].msg_hdr.msg_controllen = sizeof(ctls[nmsgs].buf);
+			cmsg             = CMSG_FIRSTHDR( &msgs[nmsgs].msg_hdr );
+			cmsg->cmsg_level = SOL_UDP;
+			cmsg->cmsg_type  = UDP_SEGMENT;
+			cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+			*(uint16_t*)CMSG_DATA( cmsg ) = seg;
+		}
+	}
+	first[nmsgs] = train.size();
+
+	for ( k = 0; k < nmsgs; k += sent ) {
+		if ( ! waitTx( timeout ) ) {
+			return false;
+		}
+		if ( (sent = ::sendmmsg( txSd(), &msgs[k], nmsgs - k, 0 )) < 0 ) {
+			sent = 0;
+			if ( EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno ) {
+				continue;
+			}
+			if ( ( EIO == errno || EINVAL == errno ) && msgs[k].msg_hdr.msg_control ) {
+				// offload rejected (e.g., no checksum offload); send
+				// the rest frame by frame from now on
+				useGso_ = false;
+				for ( i = first[k]; i < train.size(); i++ ) {
+					if ( ! push( train[i], timeout, abs_timeout ) ) {
+						return false;
+					}
+				}
+				return true;
+			}
+			perror("::sendmmsg() - dropping message due to error");
+			return false;
+		}
+		for ( i = k; i < k + sent; i++ ) {
+			nTxDgrams_.fetch_add( first[i+1] - first[i], cpsw::memory_order_relaxed );
+			nTxOctets_.fetch_add( msgs[i].msg_len,       cpsw::memory_order_relaxed );
+			if ( msgs[i].msg_hdr.msg_control ) {
+				nGsoSends_.fetch_add( 1, cpsw::memory_order_relaxed );
+			}
+		}
+	}
+	return true;
+#else
+	return CProtoMod::pushTrain( train, timeout, abs_timeout );
+#endif
+}
+
 int CProtoModUdp::iMatch(ProtoPortMatchParams *cmp)
 {
 	cmp->udpDestPort_.handledBy_ = getProtoMod();
@@ -426,7 +1275,17 @@ int CProtoModUdp::iMatch(ProtoPortMatchParams *cmp)
 
 unsigned CProtoModUdp::getMTU()
 {
-int rval = tx_.getMTU();
+int rval;
+
+	if ( tx_ ) {
+		rval = tx_->getMTU();
+	} else {
+		// the shared socket is not connected; look up the
+		// path MTU with a temporary one
+		CSockSd tmp;
+		tmp.init( &dest_, 0, false );
+		rval = tmp.getMTU();
+	}
 #ifdef UDP_DEBUG
 	fprintf(CPSW::fDbg(), "UDP SOCKET MTU: %d\n", rval);
 #endif
@@ -15,9 +15,14 @@
 #include <cpsw_thread.h>
 #include <cpsw_sock.h>
 #include <cpsw_compat.h>
+#include <cpsw_reactor.h>
+#include <cpsw_uring.h>
+#include <cpsw_packet_ring.h>
+#include <cpsw_udp_mux.h>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
 
 #include <vector>
 
@@ -26,6 +31,30 @@ using cpsw::atomic;
 class CProtoModUdp;
 typedef shared_ptr<CProtoModUdp> ProtoModUdp;
 
+// Datagrams dropped by the kernel (socket buffer full) as
+// last reported by SO_RXQ_OVFL; the count is cumulative
+// (per socket).
+class CUdpKernDrops {
+private:
+	atomic<uint32_t> cnt_;
+
+public:
+	CUdpKernDrops() : cnt_(0) {}
+
+	void update(const CSockRxInfo *info)
+	{
+		if ( info->hasDrops_ )
+			cnt_.store( info->drops_, cpsw::memory_order_relaxed );
+	}
+
+	void update(const CSockRxBufs &rxBufs)
+	{
+		update( rxBufs.getInfo() );
+	}
+
+	uint64_t get() const { return cnt_.load( cpsw::memory_order_relaxed ); }
+};
+
 class CUdpHandlerThread : public CRunnable {
 protected:
 	CSockSd        sd_;
@@ -36,6 +65,11 @@ public:
 		sd_.getMyAddr( addr_p );
 	}
 
+	virtual int getSd() const
+	{
+		return sd_.getSd();
+	}
+
 	CUdpHandlerThread(const char *name, int threadPriority, struct sockaddr_in *dest, struct sockaddr_in *me_p = NULL);
 	CUdpHandlerThread(CUdpHandlerThread &orig, struct sockaddr_in *dest, struct sockaddr_in *me_p);
 
@@ -62,7 +96,7 @@ public:
 	virtual ~CUdpPeerPollerThread() { threadStop(); }
 };
 
-class CProtoModUdp : public CProtoMod {
+class CProtoModUdp : public CProtoMod, public IRxPoller {
 protected:
 
 	class CUdpRxHandlerThread : public CUdpHandlerThread {
@@ -70,6 +104,7 @@ protected:
 			atomic<uint64_t> nOctets_;
 			atomic<uint64_t> nDgrams_;
 			atomic<uint64_t> nRxDrop_;
+			CUdpKernDrops    kernDrops_;
 		public:
 			// cannot use smart pointer here because CProtoModUdp's
 			// constructor creates the threads (and a smart ptr is
@@ -90,18 +125,192 @@ protected:
 			virtual uint64_t getNumDgrams() { return nDgrams_.load( cpsw::memory_order_relaxed ); }
 			virtual uint64_t getNumRxDrop() { return nRxDrop_.load( cpsw::memory_order_relaxed ); }
 
+			virtual CUdpKernDrops *getKernDrops() { return &kernDrops_; }
+
 			virtual ~CUdpRxHandlerThread() { threadStop(); }
 	};
 
+	// Alternative to the RX (and poller) threads: the
+	// socket is serviced by the shared reactor.
+	class CUdpRxReactorHandler : public IReactorHandler {
+		private:
+			class CPollTimer : public IReactorHandler {
+				private:
+					CUdpRxReactorHandler *h_;
+				public:
+					CPollTimer(CUdpRxReactorHandler *h) : h_(h) {}
+					virtual void handleInput() { h_->pollPeer(); }
+			};
+
+			CSockSd          sd_;
+			CSockRxBufs       rxBufs_;
+			atomic<uint64_t> nOctets_;
+			atomic<uint64_t> nDgrams_;
+			atomic<uint64_t> nRxDrop_;
+			CUdpKernDrops    kernDrops_;
+			unsigned         pollSecs_;
+			int              timerFd_;
+			CPollTimer       pollTimer_;
+			uint64_t         rxHandle_;
+			uint64_t         timerHandle_;
+			CProtoModUdp    *owner_;
+
+			void init(struct sockaddr_in *dest, struct sockaddr_in *me);
+
+		public:
+			// max. datagrams handled per invocation
+			static const unsigned RX_BATCH = 32;
+
+			CUdpRxReactorHandler(struct sockaddr_in *dest, struct sockaddr_in *me, int pollSecs, CProtoModUdp *owner);
+			CUdpRxReactorHandler(CUdpRxReactorHandler &orig, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner);
+
+			virtual void handleInput();
+			virtual void pollPeer();
+
+			// let the kernel coalesce datagrams (UDP_GRO)
+			virtual bool setGro();
+
+			virtual void start();
+			virtual void stop();
+
+			virtual unsigned getPollSecs()  const { return pollSecs_; }
+			virtual int      getSd()        const { return sd_.getSd(); }
+
+			virtual uint64_t getNumOctets() { return nOctets_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumDgrams() { return nDgrams_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumRxDrop() { return nRxDrop_.load( cpsw::memory_order_relaxed ); }
+
+			virtual CUdpKernDrops *getKernDrops() { return &kernDrops_; }
+
+			virtual ~CUdpRxReactorHandler();
+	};
+
+	// Alternative to the RX (and poller) threads: the
+	// socket is serviced by the io_uring ring thread.
+	class CUdpRxUringHandler : public IUringHandler {
+		private:
+			CSockSd          sd_;
+			atomic<uint64_t> nOctets_;
+			atomic<uint64_t> nDgrams_;
+			atomic<uint64_t> nRxDrop_;
+			CUdpKernDrops    kernDrops_;
+			unsigned         pollSecs_;
+			uint64_t         rxHandle_;
+			uint64_t         timerHandle_;
+			CProtoModUdp    *owner_;
+
+		public:
+			CUdpRxUringHandler(struct sockaddr_in *dest, struct sockaddr_in *me, int pollSecs, CProtoModUdp *owner);
+			CUdpRxUringHandler(CUdpRxUringHandler &orig, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner);
+
+			virtual bool handleRecv(BufChain bc, const CSockRxInfo *info);
+			virtual void handleError(int err);
+			virtual void handleTimer();
+
+			virtual void start();
+			virtual void stop();
+
+			virtual unsigned getPollSecs()  const { return pollSecs_; }
+			virtual int      getSd()        const { return sd_.getSd(); }
+
+			virtual uint64_t getNumOctets() { return nOctets_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumDgrams() { return nDgrams_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumRxDrop() { return nRxDrop_.load( cpsw::memory_order_relaxed ); }
+
+			virtual CUdpKernDrops *getKernDrops() { return &kernDrops_; }
+
+			virtual ~CUdpRxUringHandler();
+	};
+
+	// Alternative to the RX threads: datagrams are picked up
+	// from a memory-mapped packet-socket ring (one block of
+	// datagrams per wakeup). The UDP socket only keeps the
+	// port bound; it discards everything it receives.
+	class CUdpRxPacketRingThread : public CUdpHandlerThread, public IPacketRingHandler {
+		private:
+			CPacketRing      ring_;
+			atomic<uint64_t> nRxDrop_;
+			CProtoModUdp    *owner_;
+
+		protected:
+			virtual void* threadBody();
+
+		public:
+			CUdpRxPacketRingThread(const char *name, int threadPriority, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner);
+			CUdpRxPacketRingThread(CUdpRxPacketRingThread &orig, struct sockaddr_in *dest, struct sockaddr_in *me, CProtoModUdp *owner);
+
+			virtual void handleDgram(BufChain bc);
+
+			virtual CPacketRing *getRing() { return &ring_; }
+
+			virtual uint64_t getNumOctets() { return ring_.getNumOctets(); }
+			virtual uint64_t getNumDgrams() { return ring_.getNumDgrams(); }
+			virtual uint64_t getNumRxDrop() { return nRxDrop_.load( cpsw::memory_order_relaxed ); }
+
+			virtual ~CUdpRxPacketRingThread() { threadStop(); }
+	};
+
+	// Alternative to the RX (and poller) threads and to the
+	// module's own sockets: the peer is served by a socket
+	// which is shared with other modules (see CUdpMux).
+	class CUdpRxMuxHandler : public IUdpMuxHandler {
+		private:
+			struct sockaddr_in dest_;
+			CUdpMuxSock     *sock_;
+			atomic<uint64_t> nOctets_;
+			atomic<uint64_t> nDgrams_;
+			atomic<uint64_t> nRxDrop_;
+			unsigned         pollSecs_;
+			CProtoModUdp    *owner_;
+
+		public:
+			CUdpRxMuxHandler(struct sockaddr_in *dest, int pollSecs, CProtoModUdp *owner);
+
+			virtual void handleInput(CSockRxBufs *rxBufs, ssize_t got);
+
+			virtual void start() { sock_->setActive( &dest_, true  ); }
+			virtual void stop()  { sock_->setActive( &dest_, false ); }
+
+			virtual CUdpMuxSock *getMuxSock()   const { return sock_;     }
+			virtual unsigned     getPollSecs()  const { return pollSecs_; }
+			virtual int          getSd()        const { return sock_->getSd(); }
+
+			virtual uint64_t getNumOctets() { return nOctets_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumDgrams() { return nDgrams_.load( cpsw::memory_order_relaxed ); }
+			virtual uint64_t getNumRxDrop() { return nRxDrop_.load( cpsw::memory_order_relaxed ); }
+
+			virtual ~CUdpRxMuxHandler();
+	};
+
 private:
 	struct sockaddr_in dest_;
-	CSockSd            tx_;
+	CSockSd           *tx_;    // NULL if the socket is shared
 	atomic<uint64_t>   nTxOctets_;
 	atomic<uint64_t>   nTxDgrams_;
 	int                threadPriority_;
+	unsigned           busyPollUs_;
+	CSockRxBufs        *pollBufs_;
+	atomic<bool>       pollBusy_;
+	atomic<uint64_t>   nPollOctets_;
+	atomic<uint64_t>   nPollDgrams_;
+	atomic<uint64_t>   nPollRxDrop_;
+	unsigned           rcvBufSize_;
+	unsigned           sndBufSize_;
+	bool               useGso_;
+	bool               useGro_;
+	atomic<uint64_t>   nGsoSends_;
+	atomic<uint64_t>   nGroMsgs_;
+
+	unsigned           pollSd(int sd, CUdpKernDrops *kernDrops);
+	bool               waitTx(const CTimeout *timeout);
+	int                txSd() const;
 protected:
 	std::vector< CUdpRxHandlerThread * > rxHandlers_;
 	CUdpPeerPollerThread                 *poller_;
+	CUdpRxReactorHandler                 *rxReactor_;
+	CUdpRxUringHandler                   *rxUring_;
+	CUdpRxPacketRingThread               *rxRing_;
+	CUdpRxMuxHandler                     *rxMux_;
 
 	void createThreads(unsigned nRxThreads, int pollSeconds);
 
@@ -117,11 +326,31 @@ protected:
 		return doPush(bc, false, NULL, true);
 	}
 
+	// send runs of equal-sized frames with UDP_SEGMENT (if enabled)
+	virtual bool pushTrain(const std::vector<BufChain> &train, const CTimeout *timeout, bool abs_timeout);
+
+	// pass a received message down; splits datagrams which were
+	// coalesced by the kernel (GRO).
+	// RETURNS the number of datagrams dropped.
+	virtual unsigned pushDownSegs(CSockRxBufs *rxBufs, ssize_t got);
+
 	virtual int iMatch(ProtoPortMatchParams *cmp);
 
 public:
 	// negative or zero 'pollSecs' avoids creating a poller thread
-	CProtoModUdp(Key &k, struct sockaddr_in *dest, unsigned depth, int threadPriority, unsigned nRxThreads = 1, int pollSecs = 4);
+	// 'useReactor' replaces the RX and poller threads by handlers
+	// executed by the shared reactor ('nRxThreads' is ignored).
+	// 'useUring' does the same with the io_uring ring thread and
+	// also transmits through the ring; if io_uring is unavailable
+	// then the reactor or threads are used instead.
+	// 'usePacketRing' receives from a TPACKET_V3 ring (replaces
+	// the RX threads, reactor or io_uring for reception); falls
+	// back to the above if the packet socket cannot be created
+	// (requires CAP_NET_RAW).
+	// 'useSharedSocket' sends and receives through a socket of
+	// the process-wide pool (CUdpMux) instead of creating any
+	// sockets or threads; all other options are ignored.
+	CProtoModUdp(Key &k, struct sockaddr_in *dest, unsigned depth, int threadPriority, unsigned nRxThreads = 1, int pollSecs = 4, bool useReactor = false, bool useUring = false, bool usePacketRing = false, bool useSharedSocket = false);
 
 	CProtoModUdp(CProtoModUdp &orig, Key &k);
 
@@ -147,9 +376,47 @@ public:
 	virtual uint64_t getNumRxOctets();
 	virtual uint64_t getNumRxDgrams();
 	virtual uint64_t getNumRxDrops();
+	// datagrams dropped by the kernel (SO_RXQ_OVFL)
+	virtual uint64_t getNumRxKernDrops();
+	virtual bool     usesReactor() const { return !!rxReactor_; }
+	virtual bool     usesUring()   const { return !!rxUring_;   }
+	virtual bool     usesPacketRing() const { return !!rxRing_; }
+	virtual bool     usesSharedSocket() const { return !!rxMux_; }
 	virtual void modStartup();
 	virtual void modShutdown();
 
+	virtual void setThreadSched(const std::string &cpuAffinity, int schedPolicy);
+	virtual void getThreads(std::vector<CRunnable*> *threads);
+
+	// socket buffer sizes (bytes); zero leaves the kernel default.
+	// The receive buffer applies to the RX sockets, the send buffer
+	// to the TX socket.
+	virtual void     setSockBufSizes(unsigned rcvBufSize, unsigned sndBufSize);
+	virtual unsigned getRcvBufSize() const { return rcvBufSize_; }
+	virtual unsigned getSndBufSize() const { return sndBufSize_; }
+
+	// segmentation offload; trains of fragments are handed to the
+	// kernel as a single message (UDP_SEGMENT) and datagrams may be
+	// coalesced on reception (UDP_GRO). Either is silently turned
+	// off if the kernel does not support it. GRO only applies to
+	// the RX threads and the reactor (not io_uring or the packet
+	// ring); GSO is not used with io_uring.
+	// Must be called before 'modStartup()'.
+	virtual void     setOffload(bool gso, bool gro);
+	virtual bool     usesGso() const { return useGso_; }
+	virtual bool     usesGro() const { return useGro_; }
+	virtual uint64_t getNumGsoSends() { return nGsoSends_.load( cpsw::memory_order_relaxed ); }
+	virtual uint64_t getNumGroMsgs()  { return nGroMsgs_.load( cpsw::memory_order_relaxed );  }
+
+	// busy-polling; reads the RX sockets (non-blocking) in the
+	// caller's context. The RX threads (or reactor) remain
+	// active and handle anything which is not polled for.
+	static const unsigned POLL_BATCH = 8;
+
+	virtual void     setBusyPoll(unsigned us);
+	virtual unsigned getBusyPoll() const { return busyPollUs_; }
+	virtual unsigned pollRx();
+
 	virtual unsigned getMTU();
 
 	virtual void dumpYaml(YAML::Node &) const;
@@ -20,6 +20,7 @@
 #include <cpsw_proto_mod_tdestmux2.h>
 #include <cpsw_proto_depack.h>
 #include <cpsw_stdio.h>
+#include <cpsw_thread.h>
 
 #include <cpsw_yaml.h>
 #include <cpsw_debug.h>
@@ -45,13 +46,24 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 		int                        SRPDynTimeout_;
 		unsigned                   SRPRetryCount_;
 		SRPWriteMode               SRPDefaultWriteMode_;
+		unsigned                   SRPBusyPollUS_;
 		TransportProto             Xprt_;
 		unsigned                   XprtPort_;
 		unsigned                   XprtOutQueueDepth_;
         int                        UdpThreadPriority_;
 		unsigned                   UdpNumRxThreads_;
 		int                        UdpPollSecs_;
+		bool                       UdpUseReactor_;
+		bool                       UdpUseUring_;
+		bool                       UdpUsePacketRing_;
+		bool                       UdpUseSharedSocket_;
+		bool                       UdpUseGso_;
+		bool                       UdpUseGro_;
+		unsigned                   UdpRcvBufSize_;
+		unsigned                   UdpSndBufSize_;
         int                        TcpThreadPriority_;
+		unsigned                   TcpZeroCopyThreshold_;
+		bool                       TcpUseUring_;
 		bool                       hasRssi_;
         int                        RssiThreadPriority_;
 		int                        hasDepack_;
@@ -64,17 +76,21 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 		unsigned                   SRPMuxVirtualChannel_;
 		unsigned                   SRPMuxOutQueueDepth_;
 		int                        SRPMuxThreadPriority_;
+		bool                       SRPMuxInlineDemux_;
 		bool                       hasTDestMux_;
 		unsigned                   TDestMuxTDEST_;
 		int                        TDestMuxStripHeader_;
 		unsigned                   TDestMuxOutQueueDepth_;
 		unsigned                   TDestMuxInpQueueDepth_;
 		int                        TDestMuxThreadPriority_;
+		bool                       TDestMuxInlineDemux_;
 		in_addr_t                  IPAddr_;
 		struct LibSocksProxy       socksProxy_;
 		in_addr_t                  rssiBridgeIPAddr_;
 		CRssiConfigParams          rssiConfig_;
 		bool                       autoStart_;
+		std::string                threadCpuAffinity_;
+		SchedPolicy                threadSchedPolicy_;
 	public:
 		virtual void reset()
 		{
@@ -83,13 +99,24 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			SRPDynTimeout_          = -1;
 			SRPRetryCount_          = -1;
 			SRPDefaultWriteMode_    = UNSP;
+			SRPBusyPollUS_          = 0;
 			Xprt_                   = UDP;
 			XprtPort_               = 8192;
 			XprtOutQueueDepth_      = 0;
 			UdpThreadPriority_      = IProtoStackBuilder::DFLT_THREAD_PRIORITY;
 			UdpNumRxThreads_        = 0;
 			UdpPollSecs_            = -1;
+			UdpUseReactor_          = false;
+			UdpUseUring_            = false;
+			UdpUsePacketRing_       = false;
+			UdpUseSharedSocket_     = false;
+			UdpUseGso_              = false;
+			UdpUseGro_              = false;
+			UdpRcvBufSize_          = 0;
+			UdpSndBufSize_          = 0;
 			TcpThreadPriority_      = IProtoStackBuilder::DFLT_THREAD_PRIORITY;
+			TcpZeroCopyThreshold_   = 0;
+			TcpUseUring_            = false;
 			hasRssi_                = false;
 			hasDepack_              = -1;
 			depackProto_            = DEPACKETIZER_V0;
@@ -102,17 +129,21 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			SRPMuxOutQueueDepth_    = 0;
 			SRPMuxVirtualChannel_   = 0;
 			SRPMuxThreadPriority_   = IProtoStackBuilder::DFLT_THREAD_PRIORITY;
+			SRPMuxInlineDemux_      = false;
 			hasTDestMux_            = false;
 			TDestMuxTDEST_          = 0;
 			TDestMuxStripHeader_    = -1;
 			TDestMuxOutQueueDepth_  = 0;
 			TDestMuxInpQueueDepth_  = 0;
 			TDestMuxThreadPriority_ = IProtoStackBuilder::DFLT_THREAD_PRIORITY;
+			TDestMuxInlineDemux_    = false;
 			IPAddr_                 = INADDR_NONE;
 			rssiBridgeIPAddr_       = INADDR_NONE;
 			socksProxy_.version     = SOCKS_VERSION_NONE;
 			rssiConfig_             = CRssiConfigParams();
 			autoStart_              = true; // legacy behaviour
+			threadCpuAffinity_      = "";
+			threadSchedPolicy_      = SCHED_POLICY_DEFAULT;
 		}
 
 		CProtoStackBuilder()
@@ -207,6 +238,16 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			return SRPDefaultWriteMode_ == SYNC ? SYNCHRONOUS : POSTED;
 		}
 
+		virtual void            setSRPBusyPollUS(unsigned v)
+		{
+			SRPBusyPollUS_ = v;
+		}
+
+		virtual unsigned        getSRPBusyPollUS()
+		{
+			return SRP_UDP_NONE == getSRPVersion() ? 0 : SRPBusyPollUS_;
+		}
+
 		virtual void            setSRPRetryCount(unsigned v)
 		{
 			SRPRetryCount_ = v;
@@ -282,6 +323,26 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			return TcpThreadPriority_;
 		}
 
+		virtual void            setTcpZeroCopyThreshold(unsigned v)
+		{
+			TcpZeroCopyThreshold_ = v;
+		}
+
+		virtual unsigned        getTcpZeroCopyThreshold()
+		{
+			return TcpZeroCopyThreshold_;
+		}
+
+		virtual void            setTcpUseUring(bool v)
+		{
+			TcpUseUring_ = v;
+		}
+
+		virtual bool            getTcpUseUring()
+		{
+			return TcpUseUring_;
+		}
+
 		virtual void            setUdpThreadPriority(int prio)
 		{
 			UdpThreadPriority_ = prio;
@@ -343,6 +404,86 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			return UdpNumRxThreads_;
 		}
 
+		virtual void            setUdpUseReactor(bool v)
+		{
+			UdpUseReactor_ = v;
+		}
+
+		virtual bool            getUdpUseReactor()
+		{
+			return UdpUseReactor_;
+		}
+
+		virtual void            setUdpUseUring(bool v)
+		{
+			UdpUseUring_ = v;
+		}
+
+		virtual bool            getUdpUseUring()
+		{
+			return UdpUseUring_;
+		}
+
+		virtual void            setUdpUsePacketRing(bool v)
+		{
+			UdpUsePacketRing_ = v;
+		}
+
+		virtual bool            getUdpUsePacketRing()
+		{
+			return UdpUsePacketRing_;
+		}
+
+		virtual void            setUdpUseSharedSocket(bool v)
+		{
+			UdpUseSharedSocket_ = v;
+		}
+
+		virtual bool            getUdpUseSharedSocket()
+		{
+			return UdpUseSharedSocket_;
+		}
+
+		virtual void            setUdpUseGso(bool v)
+		{
+			UdpUseGso_ = v;
+		}
+
+		virtual bool            getUdpUseGso()
+		{
+			return UdpUseGso_;
+		}
+
+		virtual void            setUdpUseGro(bool v)
+		{
+			UdpUseGro_ = v;
+		}
+
+		virtual bool            getUdpUseGro()
+		{
+			return UdpUseGro_;
+		}
+
+		virtual void            setUdpRcvBufSize(unsigned v)
+		{
+			UdpRcvBufSize_ = v;
+		}
+
+		virtual unsigned        getUdpRcvBufSize()
+		{
+			return UdpRcvBufSize_;
+		}
+
+		virtual void            setUdpSndBufSize(unsigned v)
+		{
+			UdpSndBufSize_ = v;
+		}
+
+		virtual unsigned        getUdpSndBufSize()
+		{
+			return UdpSndBufSize_;
+		}
+
 		virtual void            setUdpPollSecs(int v)
 		{
 			UdpPollSecs_ = v;
@@ -513,6 +654,18 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			return hasSRPMux() ? SRPMuxThreadPriority_ : IProtoStackBuilder::NO_THREAD_PRIORITY;
 		}
 
+		virtual void            setSRPMuxInlineDemux(bool v)
+		{
+			if ( v )
+				useSRPMux( true );
+			SRPMuxInlineDemux_ = v;
+		}
+
+		virtual bool            getSRPMuxInlineDemux()
+		{
+			return hasSRPMux() && ( SRPMuxInlineDemux_ || getSRPBusyPollUS() > 0 );
+		}
+
 
 		virtual void            useTDestMux(bool v)
 		{
@@ -593,6 +746,38 @@ class CProtoStackBuilder : public IProtoStackBuilder {
 			return hasTDestMux() ? TDestMuxThreadPriority_ : IProtoStackBuilder::NO_THREAD_PRIORITY;
 		}
 
+		virtual void            setTDestMuxInlineDemux(bool v)
+		{
+			if ( v )
+				useTDestMux( true );
+			TDestMuxInlineDemux_ = v;
+		}
+
+		virtual bool            getTDestMuxInlineDemux()
+		{
+			return hasTDestMux() && TDestMuxInlineDemux_;
+		}
+
+		virtual void            setThreadCpuAffinity(const char *cpus)
+		{
+			threadCpuAffinity_ = cpus ? cpus : "";
+		}
+
+		virtual const char     *getThreadCpuAffinity()
+		{
+			return threadCpuAffinity_.c_str();
+		}
+
+		virtual void            setThreadSchedPolicy(SchedPolicy v)
+		{
+			threadSchedPolicy_ = v;
+		}
+
+		virtual SchedPolicy     getThreadSchedPolicy()
+		{
+			return threadSchedPolicy_;
+		}
+
 		virtual shared_ptr<CProtoStackBuilder> cloneInternal()
 		{
 			return cpsw::make_shared<CProtoStackBuilder>( *this );
@@ -640,9 +825,16 @@ bool                       b;
 SRPProtoVersion            proto_vers;
 int                        i;
 WriteMode                  writeMode;
+std::string                str;
+SchedPolicy                schedPolicy;
 
 	reset();
 
+	if ( readNode(node, YAML_KEY_cpuAffinity, &str) )
+		setThreadCpuAffinity( str.c_str() );
+	if ( readNode(node, YAML_KEY_schedPolicy, &schedPolicy) )
+		setThreadSchedPolicy( schedPolicy );
+
 	{
 		YamlState nn( &node, YAML_KEY_SRP );
 		if ( !!nn && nn.IsMap() )
@@ -661,6 +853,8 @@ WriteMode                  writeMode;
 				useSRPDynTimeout( b );
 			if ( readNode(nn, YAML_KEY_retryCount, &u) )
 				setSRPRetryCount( u );
+			if ( readNode(nn, YAML_KEY_busyPollUS, &u) )
+				setSRPBusyPollUS( u );
 			if ( readNode(nn, YAML_KEY_defaultWriteMode, &writeMode) )
 			{
 				if ( hasSRPMux_ < 0 || UNSP == SRPDefaultWriteMode_ ) {
@@ -681,6 +875,10 @@ WriteMode                  writeMode;
 					setTcpOutQueueDepth( u );
 				if ( readNode(nn, YAML_KEY_threadPriority, &i) )
 					setTcpThreadPriority( i );
+				if ( readNode(nn, YAML_KEY_zeroCopyThreshold, &u) )
+					setTcpZeroCopyThreshold( u );
+				if ( readNode(nn, YAML_KEY_useUring, &b) )
+					setTcpUseUring( b );
 			}
 		}
 	}
@@ -702,6 +900,22 @@ WriteMode                  writeMode;
 					setUdpPollSecs( i );
 				if ( readNode(nn, YAML_KEY_threadPriority, &i) )
 					setUdpThreadPriority( i );
+				if ( readNode(nn, YAML_KEY_useReactor, &b) )
+					setUdpUseReactor( b );
+				if ( readNode(nn, YAML_KEY_useUring, &b) )
+					setUdpUseUring( b );
+				if ( readNode(nn, YAML_KEY_usePacketRing, &b) )
+					setUdpUsePacketRing( b );
+				if ( readNode(nn, YAML_KEY_useSharedSocket, &b) )
+					setUdpUseSharedSocket( b );
+				if ( readNode(nn, YAML_KEY_useGso, &b) )
+					setUdpUseGso( b );
+				if ( readNode(nn, YAML_KEY_useGro, &b) )
+					setUdpUseGro( b );
+				if ( readNode(nn, YAML_KEY_rcvBufSize, &u) )
+					setUdpRcvBufSize( u );
+				if ( readNode(nn, YAML_KEY_sndBufSize, &u) )
+					setUdpSndBufSize( u );
 			}
 		}
 	}
@@ -748,6 +962,15 @@ WriteMode                  writeMode;
 			if ( readNode(nn, YAML_KEY_maxSegmentSize,          &u) ) {
 				rssiConfig_.forcedSegsMax_     = u;
 			}
+			if ( readNode(nn, YAML_KEY_txPacing,                &b) ) {
+				rssiConfig_.txPacing_          = b;
+			}
+			if ( readNode(nn, YAML_KEY_txRateSegsPerSec,        &u) ) {
+				rssiConfig_.txRateSegsPerSec_  = u;
+			}
+			if ( readNode(nn, YAML_KEY_extendedAcks,            &b) ) {
+				rssiConfig_.extendedAcks_      = b;
+			}
 		}
 	}
 	{
@@ -781,6 +1004,8 @@ WriteMode                  writeMode;
 				setSRPMuxOutQueueDepth( u );
 			if ( readNode(nn, YAML_KEY_threadPriority, &i) )
 				setSRPMuxThreadPriority( i );
+			if ( readNode(nn, YAML_KEY_inlineDemux, &b) )
+				setSRPMuxInlineDemux( b );
 			if ( readNode(nn, YAML_KEY_instantiate, &b) )
 				useSRPMux( b );
 			if ( readNode(nn, YAML_KEY_defaultWriteMode, &writeMode) )
@@ -805,6 +1030,8 @@ WriteMode                  writeMode;
 				setTDestMuxInpQueueDepth( u );
 			if ( readNode(nn, YAML_KEY_threadPriority, &i) )
 				setTDestMuxThreadPriority( i );
+			if ( readNode(nn, YAML_KEY_inlineDemux, &b) )
+				setTDestMuxInlineDemux( b );
 			if ( readNode(nn, YAML_KEY_instantiate, &b) )
 				useTDestMux( b );
 		}
@@ -1021,12 +1248,21 @@ bool                           hasSRP = IProtoStackBuilder::SRP_UDP_NONE != bldr
 
 		if ( bldr->hasUdp() ) {
 			// Note: transport module MUST have a queue if RSSI is used
-			rval = CShObj::create< ProtoModUdp >( &dst,
+			ProtoModUdp udp = CShObj::create< ProtoModUdp >( &dst,
 			                                       bldr->getUdpOutQueueDepth(),
 			                                       bldr->getUdpThreadPriority(),
 			                                       bldr->getUdpNumRxThreads(),
-			                                       bldr->getUdpPollSecs()
+			                                       bldr->getUdpPollSecs(),
+			                                       bldr->getUdpUseReactor(),
+			                                       bldr->getUdpUseUring(),
+			                                       bldr->getUdpUsePacketRing(),
+			                                       bldr->getUdpUseSharedSocket()
 			);
+			udp->setSockBufSizes( bldr->getUdpRcvBufSize(), bldr->getUdpSndBufSize() );
+			if ( bldr->getUdpUseGso() || bldr->getUdpUseGro() ) {
+				udp->setOffload( bldr->getUdpUseGso(), bldr->getUdpUseGro() );
+			}
+			rval = udp;
 		} else {
 			struct sockaddr_in via = dst;
 
@@ -1066,7 +1302,9 @@ bool                           hasSRP = IProtoStackBuilder::SRP_UDP_NONE != bldr
 			                                      bldr->getTcpOutQueueDepth(),
 			                                      bldr->getTcpThreadPriority(),
 			                                      bldr->getSocksProxy(),
-			                                      &via
+			                                      &via,
+			                                      bldr->getTcpZeroCopyThreshold(),
+			                                      bldr->getTcpUseUring()
 			);
 		}
 
@@ -1151,6 +1389,12 @@ bool                           hasSRP = IProtoStackBuilder::SRP_UDP_NONE != bldr
 				}
 			}
 		}
+		if ( bldr->getTDestMuxInlineDemux() ) {
+			if ( v2 )
+				v2->setInlineDemux( true );
+			else
+				v0->setInlineDemux( true );
+		}
 		if ( v2 ) {
 #ifdef PSBLDR_DEBUG
 			if ( cpsw_psbldr_debug > 0 ) {
@@ -1187,6 +1431,9 @@ bool                           hasSRP = IProtoStackBuilder::SRP_UDP_NONE != bldr
 			srpMuxMod   = CShObj::create< ProtoModSRPMux >( bldr->getSRPVersion(), bldr->getSRPMuxThreadPriority() );
 			rval->addAtPort( srpMuxMod );
 		}
+		if ( bldr->getSRPMuxInlineDemux() ) {
+			srpMuxMod->setInlineDemux( true );
+		}
 		// reserve enough queue depth - must potentially hold replies to synchronous retries
 		// until the synchronous reader comes along for the next time!
 		unsigned retryCount = bldr->getSRPRetryCount() & 0xffff; // undocumented hack to test byte-resolution access
@@ -1198,5 +1445,19 @@ bool                           hasSRP = IProtoStackBuilder::SRP_UDP_NONE != bldr
 #endif
 	}
 
+	if ( *bldr->getThreadCpuAffinity() || SCHED_POLICY_DEFAULT != bldr->getThreadSchedPolicy() ) {
+		ProtoMod m;
+		int      pol;
+		switch ( bldr->getThreadSchedPolicy() ) {
+			case SCHED_POLICY_OTHER: pol = SCHED_OTHER;             break;
+			case SCHED_POLICY_FIFO:  pol = SCHED_FIFO;              break;
+			case SCHED_POLICY_RR:    pol = SCHED_RR;                break;
+			default:                 pol = CRunnable::DFLT_POLICY;  break;
+		}
+		for ( m = rval->getProtoMod(); m; m = m->getUpstreamProtoMod() ) {
+			m->setThreadSched( bldr->getThreadCpuAffinity(), pol );
+		}
+	}
+
 	return rval;
 }
@@ -0,0 +1,230 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_reactor.h>
+#include <cpsw_error.h>
+#include <cpsw_stdio.h>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include <exception>
+
+//#define REACTOR_DEBUG
+
+CReactor::CWorker::CWorker(const char *name, CReactor *reactor)
+: CRunnable( name ),
+  reactor_ ( reactor )
+{
+}
+
+void *
+CReactor::CWorker::threadBody()
+{
+struct epoll_event evs[MAX_EVENTS];
+int                n, i;
+
+	while ( 1 ) {
+		n = epoll_wait( reactor_->epfd_, evs, MAX_EVENTS, -1 );
+		if ( n < 0 ) {
+			if ( EINTR == errno )
+				continue;
+			throw InternalError( "CReactor: epoll_wait failed", errno );
+		}
+		reactor_->nWakeups_.fetch_add( 1, cpsw::memory_order_relaxed );
+		reactor_->nEvents_.fetch_add( n, cpsw::memory_order_relaxed );
+		for ( i = 0; i < n; i++ ) {
+			reactor_->dispatch( evs[i].data.u64 );
+		}
+	}
+	return NULL;
+}
+
+CReactor::CReactor(unsigned numThreads)
+: epfd_    ( epoll_create1( EPOLL_CLOEXEC ) ),
+  mtx_     ( "CReactor"                     ),
+  nextId_  ( 1                              ),
+  nWakeups_( 0                              ),
+  nEvents_ ( 0                              )
+{
+unsigned i;
+
+	if ( epfd_ < 0 ) {
+		throw InternalError( "CReactor: epoll_create1 failed", errno );
+	}
+
+	for ( i = 0; i < numThreads; i++ ) {
+		workers_.push_back( new CWorker( "CPSW Reactor", this ) );
+		workers_.back()->threadStart();
+	}
+}
+
+CReactor::~CReactor()
+{
+unsigned i;
+	for ( i = 0; i < workers_.size(); i++ ) {
+		delete workers_[i];
+	}
+	close( epfd_ );
+}
+
+// Handlers are registered 'one-shot' so that only a single
+// worker executes a given handler. The descriptor is re-armed
+// after the handler returns.
+void
+CReactor::dispatch(uint64_t id)
+{
+IReactorHandler    *hdlr;
+int                 fd;
+struct epoll_event  ev;
+RegMap::iterator    it;
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+		if ( (it = regs_.find( id )) == regs_.end() || it->second.removing_ ) {
+			// removed while the event was pending
+			return;
+		}
+		it->second.busy_ = true;
+		hdlr             = it->second.hdlr_;
+		fd               = it->second.fd_;
+	}
+
+	try {
+		hdlr->handleInput();
+	} catch ( CPSWError &e ) {
+		fprintf( CPSW::fErr(), "CReactor: handler threw exception: %s\n", e.getInfo().c_str() );
+	} catch ( std::exception &e ) {
+		fprintf( CPSW::fErr(), "CReactor: handler threw exception: %s\n", e.what() );
+	}
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+		if ( (it = regs_.find( id )) != regs_.end() ) {
+			it->second.busy_ = false;
+			// if 'remove' has already deleted the descriptor
+			// from the epoll set then it must not be re-armed
+			if ( ! it->second.removing_ ) {
+				ev.events   = EPOLLIN | EPOLLONESHOT;
+				ev.data.u64 = id;
+				if ( epoll_ctl( epfd_, EPOLL_CTL_MOD, fd, &ev ) ) {
+					fprintf( CPSW::fErr(), "CReactor: unable to re-arm descriptor %d: %s\n", fd, strerror( errno ) );
+				}
+			}
+		}
+		// 'remove' may be waiting for us
+		pthread_cond_broadcast( idle_.getp() );
+	}
+}
+
+uint64_t
+CReactor::add(int fd, IReactorHandler *hdlr)
+{
+struct epoll_event ev;
+Reg                reg;
+uint64_t           id;
+
+	reg.fd_   = fd;
+	reg.hdlr_     = hdlr;
+	reg.busy_     = false;
+	reg.removing_ = false;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	id = nextId_++;
+	regs_[ id ] = reg;
+
+	ev.events   = EPOLLIN | EPOLLONESHOT;
+	ev.data.u64 = id;
+	if ( epoll_ctl( epfd_, EPOLL_CTL_ADD, fd, &ev ) ) {
+		int err = errno;
+		regs_.erase( id );
+		throw InternalError( "CReactor: unable to add descriptor", err );
+	}
+
+#ifdef REACTOR_DEBUG
+	fprintf( CPSW::fDbg(), "CReactor: added fd %d (handle %" PRIu64 ")\n", fd, id );
+#endif
+
+	return id;
+}
+
+void
+CReactor::remove(uint64_t id)
+{
+RegMap::iterator it;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	if ( (it = regs_.find( id )) == regs_.end() ) {
+		return;
+	}
+
+	it->second.removing_ = true;
+	epoll_ctl( epfd_, EPOLL_CTL_DEL, it->second.fd_, NULL );
+
+	while ( it->second.busy_ ) {
+		pthread_cond_wait( idle_.getp(), mtx_.getp() );
+		if ( (it = regs_.find( id )) == regs_.end() ) {
+			return;
+		}
+	}
+
+	regs_.erase( it );
+}
+
+void
+CReactor::dumpInfo(FILE *f)
+{
+unsigned n;
+	{
+	CMtx::lg GUARD( &mtx_ );
+		n = regs_.size();
+	}
+	fprintf(f, "CReactor:\n");
+	fprintf(f, "  Threads   : %15u\n",          getNumThreads());
+	fprintf(f, "  Handlers  : %15u\n",          n);
+	fprintf(f, "  Wakeups   : %15" PRIu64 "\n", getNumWakeups());
+	fprintf(f, "  Events    : %15" PRIu64 "\n", getNumEvents());
+}
+
+static CReactor       *theReactor = 0;
+static pthread_once_t  reactorOnce = PTHREAD_ONCE_INIT;
+
+void
+CReactor::createTheReactor()
+{
+const char *str = getenv( "CPSW_REACTOR_THREADS" );
+unsigned    n   = CReactor::DFLT_THREADS;
+
+	if ( str && 1 != sscanf( str, "%u", &n ) ) {
+		fprintf( CPSW::fErr(), "CReactor: ignoring invalid CPSW_REACTOR_THREADS: %s\n", str );
+		n = CReactor::DFLT_THREADS;
+	}
+	if ( 0 == n ) {
+		n = 1;
+	}
+	theReactor = new CReactor( n );
+}
+
+// The reactor is never destroyed; its threads live as long as
+// the process.
+CReactor *
+CReactor::getTheReactor()
+{
+	pthread_once( &reactorOnce, createTheReactor );
+	return theReactor;
+}
@@ -0,0 +1,128 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_REACTOR_H
+#define CPSW_REACTOR_H
+
+#include <cpsw_thread.h>
+#include <cpsw_mutex.h>
+#include <cpsw_condvar.h>
+#include <cpsw_compat.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+using cpsw::atomic;
+
+// A small pool of threads which wait (epoll) for any of a
+// (possibly large) set of file descriptors to become readable
+// and then execute the associated handler.
+//
+// Protocol modules may use the (process-wide) reactor instead
+// of dedicating a thread (or several) to every single socket.
+// Currently only the UDP transport does so; upper modules keep
+// their threads. The reactor saves threads, it does not reduce
+// latency (it adds an epoll hop).
+//
+// Handlers must not block. A given handler is never executed
+// by more than one thread at a time (but not necessarily always
+// by the same thread).
+//
+// The number of threads may be set with the environment variable
+// CPSW_REACTOR_THREADS (default: 2) before the reactor is first
+// used.
+
+class IReactorHandler {
+public:
+	// called when the file descriptor is readable; should
+	// consume the available data (or a bounded amount of it;
+	// the handler is called again if more remains).
+	virtual void handleInput()             = 0;
+
+	virtual ~IReactorHandler() {}
+};
+
+class CReactor {
+private:
+	class CWorker : public CRunnable {
+	private:
+		CReactor *reactor_;
+	protected:
+		virtual void *threadBody();
+	public:
+		CWorker(const char *name, CReactor *reactor);
+		virtual ~CWorker() { threadStop(); }
+	};
+
+	struct Reg {
+		int              fd_;
+		IReactorHandler *hdlr_;
+		bool             busy_;
+		bool             removing_; // descriptor deleted from epoll set
+	};
+
+	typedef std::map<uint64_t, Reg> RegMap;
+
+	int                    epfd_;
+	CMtx                   mtx_;
+	CCond                  idle_;
+	RegMap                 regs_;
+	uint64_t               nextId_;
+	std::vector<CWorker*>  workers_;
+	atomic<uint64_t>       nWakeups_;
+	atomic<uint64_t>       nEvents_;
+
+	CReactor(unsigned numThreads);
+
+	static void createTheReactor();
+
+	CReactor(const CReactor&);
+	CReactor & operator=(const CReactor&);
+
+	void dispatch(uint64_t id);
+
+public:
+	static const unsigned DFLT_THREADS = 2;
+	static const unsigned MAX_EVENTS   = 32;
+
+	// Register a handler for 'fd'; the handler is
+	// active once this routine returns. Returns a
+	// handle to be passed to 'remove'.
+	uint64_t add(int fd, IReactorHandler *hdlr);
+
+	// Deregister; waits until the handler (if it is
+	// currently executing) returns. Must not be called
+	// from the handler itself.
+	void     remove(uint64_t handle);
+
+	unsigned getNumThreads() const
+	{
+		return workers_.size();
+	}
+
+	uint64_t getNumWakeups() const
+	{
+		return nWakeups_.load( cpsw::memory_order_relaxed );
+	}
+
+	uint64_t getNumEvents() const
+	{
+		return nEvents_.load( cpsw::memory_order_relaxed );
+	}
+
+	void dumpInfo(FILE *f);
+
+	static CReactor *getTheReactor();
+
+	~CReactor();
+};
+
+#endif
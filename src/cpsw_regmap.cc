@@ -0,0 +1,314 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_regmap.h>
+#include <cpsw_hub.h>
+#include <cpsw_sval.h>
+#include <cpsw_const_sval.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+CRegMap::CRegMap(const CDevImpl *root)
+: rawSize_( 0 )
+{
+Ctx         ctx;
+std::string name;
+
+	ctx.transportIdx_ = 0;
+	ctx.off_          = 0;
+	ctx.step_         = 0;
+
+	compile( root, ctx, &name );
+
+	buildIndex();
+}
+
+void
+CRegMap::compile(const CDevImpl *dev, const Ctx &ctx, std::string *name)
+{
+CDevImpl::const_iterator it;
+size_t                   nameLen = name->size();
+unsigned                 i, n;
+char                     ibuf[32];
+
+	// the table covers everything
+	dev->instantiateLazyChildren();
+
+	for ( it = dev->begin(); it != dev->end(); ++it ) {
+	const AddressImpl      &a    = it->second;
+	EntryImpl               e    = a->getEntryImpl();
+	ConstDevImpl            d    = e->isConstDevImpl();
+	const CMMIOAddressImpl *mmio = CAccessPlan::asPlainMMIO( a.get() );
+
+		n = a->getNelms();
+
+		if ( nameLen > 0 )
+			name->append( "/" );
+		name->append( it->first );
+
+		if ( ! d ) {
+			addLeaf( &a, ctx, mmio, *name );
+		} else {
+		size_t subLen = name->size();
+			for ( i = 0; i < n; i++ ) {
+			Ctx sub = ctx;
+				sub.step_ = addStep( &a, ctx, i );
+				if ( mmio ) {
+					sub.off_         += mmio->getOffset() + i * mmio->getStride();
+				} else {
+					// the deepest non-MMIO level owns the leaves below
+					sub.transport_    = a;
+					sub.transportIdx_ = i;
+					sub.off_          = 0;
+				}
+				if ( n > 1 ) {
+					snprintf( ibuf, sizeof(ibuf), "[%u]", i );
+					name->append( ibuf );
+				}
+				compile( d.get(), sub, name );
+				name->resize( subLen );
+			}
+		}
+
+		name->resize( nameLen );
+	}
+}
+
+unsigned
+CRegMap::addStep(const AddressImpl *a, const Ctx &ctx, int idx)
+{
+Step s;
+
+	s.addr_ = a;
+	s.up_   = ctx.step_;
+	s.idx_  = idx;
+	steps_.push_back( s );
+
+	return steps_.size();
+}
+
+void
+CRegMap::addLeaf(const AddressImpl *a, const Ctx &ctx, const CMMIOAddressImpl *mmio, const std::string &name)
+{
+Leaf                 l;
+const CEntryImpl    *e     = (*a)->getEntryImpl().get();
+unsigned             nelms = (*a)->getNelms();
+const CIntEntryImpl *ie    = dynamic_cast<const CIntEntryImpl*>( e );
+
+	l.entry_    = e;
+	l.name_     = names_.size();
+	l.step_     = addStep( a, ctx, -1 ) - 1;
+	l.size_     = e->getSize();
+	l.sizeBits_ = ie ? ie->getSizeBits() : 8 * l.size_;
+	l.lsBit_    = ie ? ie->getLsBit()    : 0;
+	l.msk1_     = 0x00;
+	l.mskn_     = 0x00;
+	l.bulk_     = false;
+	l.writable_ = false;
+
+	if ( mmio && ctx.transport_ ) {
+		l.plan_ = CAccessPlan( ctx.transport_, ctx.transportIdx_, ctx.off_ + mmio->getOffset(), mmio, 0, nelms - 1 );
+	}
+
+	if ( ie && l.plan_.isValid() && l.size_ > 0 && ! dynamic_cast<const CConstIntEntryImpl*>( e ) ) {
+		l.bulk_     = IVal_Base::WO != ie->getMode();
+		l.writable_ = IVal_Base::RO != ie->getMode();
+	}
+
+	// same as IIntEntryAdapt::setVal()
+	if ( l.lsBit_ != 0 || l.sizeBits_ % 8 != 0 ) {
+		l.msk1_ =   (1 << l.lsBit_) - 1;
+		l.mskn_ = ~ ((1 << ( (l.lsBit_ + l.sizeBits_) % 8 )) - 1);
+		if ( l.mskn_ == 0xff )
+			l.mskn_ = 0x00;
+		if ( BE == l.plan_.getByteOrder() ) {
+		uint8_t tmp = l.msk1_;
+			l.msk1_ = l.mskn_;
+			l.mskn_ = tmp;
+		}
+	}
+
+	if ( l.bulk_ ) {
+		rawSize_ += getRawSize( &l );
+	}
+
+	names_.insert( names_.end(), name.begin(), name.end() );
+	names_.push_back( 0 );
+
+	leaves_.push_back( l );
+}
+
+void
+CRegMap::buildIndex()
+{
+size_t   capa = 8;
+uint32_t mask, i;
+unsigned row;
+
+	while ( capa < 2*leaves_.size() ) {
+		capa <<= 1;
+	}
+
+	index_.assign( capa, 0 );
+	mask = capa - 1;
+
+	for ( row = 0; row < leaves_.size(); row++ ) {
+	const char *nm = getName( &leaves_[row] );
+		for ( i = CDevImpl::hashName( nm, strlen( nm ) ) & mask; index_[i]; i = (i + 1) & mask )
+			;
+		index_[i] = row + 1;
+	}
+}
+
+const CRegMap::Leaf *
+CRegMap::find(const char *name) const
+{
+uint32_t mask = index_.size() - 1;
+uint32_t i;
+
+	while ( '/' == *name )
+		name++;
+
+	for ( i = CDevImpl::hashName( name, strlen( name ) ) & mask; index_[i]; i = (i + 1) & mask ) {
+	const Leaf *l = &leaves_[ index_[i] - 1 ];
+		if ( 0 == strcmp( getName( l ), name ) )
+			return l;
+	}
+	return 0;
+}
+
+void
+CRegMap::getSteps(const Leaf *l, std::vector<const Step*> *steps) const
+{
+size_t   first = steps->size();
+unsigned i;
+
+	for ( i = l->step_ + 1; i; i = steps_[i - 1].up_ ) {
+		steps->push_back( &steps_[i - 1] );
+	}
+	std::reverse( steps->begin() + first, steps->end() );
+}
+
+uint64_t
+CRegMap::read(const Leaf *l, uint8_t *dst, const CTimeout &timeout) const
+{
+CAccessPlan::Slice s;
+CReadArgs          args;
+
+	if ( ! l->plan_.slice( 0, &s ) )
+		return 0;
+
+	args.cacheable_ = l->entry_->getCacheable();
+	args.dst_       = dst;
+	args.nbytes_    = l->size_;
+	args.timeout_   = timeout;
+
+	l->plan_.read( &s, &args );
+
+	return getRawSize( l );
+}
+
+uint64_t
+CRegMap::write(const Leaf *l, const uint8_t *src, const CTimeout &timeout) const
+{
+CAccessPlan::Slice s;
+CWriteArgs         args;
+
+	if ( ! l->plan_.slice( 0, &s ) )
+		return 0;
+
+	args.cacheable_ = l->entry_->getCacheable();
+	args.src_       = const_cast<uint8_t*>( src );
+	args.nbytes_    = l->size_;
+	args.msk1_      = l->msk1_;
+	args.mskn_      = l->mskn_;
+	args.timeout_   = timeout;
+
+	l->plan_.write( &s, &args );
+
+	return getRawSize( l );
+}
+
+uint64_t
+CRegMap::readAll(uint8_t *dst) const
+{
+uint64_t rval = 0;
+unsigned i;
+
+	for ( i = 0; i < leaves_.size(); i++ ) {
+		if ( leaves_[i].bulk_ ) {
+			rval += read( &leaves_[i], dst + rval );
+		}
+	}
+	return rval;
+}
+
+uint64_t
+CRegMap::writeAll(const uint8_t *src) const
+{
+uint64_t off = 0;
+unsigned i;
+
+	for ( i = 0; i < leaves_.size(); i++ ) {
+		if ( leaves_[i].bulk_ ) {
+			if ( leaves_[i].writable_ ) {
+				write( &leaves_[i], src + off );
+			}
+			off += getRawSize( &leaves_[i] );
+		}
+	}
+	return off;
+}
+
+uint64_t
+CRegMap::getMemUsage() const
+{
+	return   leaves_.capacity() * sizeof(Leaf)
+	       + steps_.capacity()  * sizeof(Step)
+	       + names_.capacity()
+	       + index_.capacity()  * sizeof(unsigned);
+}
+
+void
+CRegMap::dumpInfo(FILE *f) const
+{
+	fprintf(f, "CRegMap:\n");
+	fprintf(f, "  Leaves    : %15lu\n",   (unsigned long)leaves_.size());
+	fprintf(f, "  Raw size  : %15" PRIu64 "\n", rawSize_);
+	fprintf(f, "  Mem usage : %15" PRIu64 "\n", getMemUsage());
+}
+
+void
+CRegMap::dump(FILE *f) const
+{
+unsigned i;
+
+	for ( i = 0; i < leaves_.size(); i++ ) {
+	const Leaf *l = &leaves_[i];
+		if ( l->plan_.isValid() ) {
+			fprintf(f, "0x%08" PRIx64 " %4u x %3u (stride %4" PRIu64 ", bits %2d..%3" PRIu64 ") via %s[%u]: %s\n",
+			        l->plan_.getOffset(),
+			        l->plan_.getNelms(),
+			        l->size_,
+			        l->plan_.getStride(),
+			        l->lsBit_,
+			        l->lsBit_ + l->sizeBits_ - 1,
+			        l->plan_.getTransport()->getName(),
+			        l->plan_.getTransportIdx(),
+			        getName( l ));
+		} else {
+			fprintf(f, "%-62s: %s\n", "(not flattened)", getName( l ));
+		}
+	}
+}
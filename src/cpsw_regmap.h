@@ -0,0 +1,132 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_REGMAP_H
+#define CPSW_REGMAP_H
+
+#include <cpsw_api_builder.h>
+#include <cpsw_mmio_dev.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+class CEntryImpl;
+class CDevImpl;
+
+// A 'register map': the hierarchy below a (locked) Dev compiled
+// into a flat table with one row per leaf (and per element of every
+// array on the way to the leaf). Each row holds everything needed
+// to access the leaf's registers without walking the hierarchy:
+// absolute offset, size, bit position, stride and the owning
+// transport (i.e., a CAccessPlan).
+//
+// Rows are stored in depth-first order (children sorted by name,
+// array elements in ascending order) -- neighbouring registers are
+// adjacent in the table.
+//
+// Rows are named like the paths 'findByName()' accepts (relative
+// to the root) with an explicit index on every array level above
+// the leaf (e.g., "mmio/dev[2]/reg"). The leaf itself is not
+// indexed; a row covers all of its elements.
+//
+// Each row also records the chain of addresses (with array indices)
+// from the root to the leaf so that 'findByName()' can resolve the
+// row names from the table.
+//
+// The table is immutable once compiled and may be used by multiple
+// threads.
+//
+// The YAML configuration dump/load does not use the table: it
+// visits the hierarchy in the order given by 'configPrio' and uses
+// the per-field encodings (enums, doubles, strings) of the adapters.
+// 'readAll()/writeAll()' is the table-driven (raw) equivalent.
+
+class CRegMap {
+public:
+	// one level of the path from the root to a leaf
+	struct Step {
+		const AddressImpl *addr_;     // in the child map of the (locked) parent
+		unsigned           up_;       // parent step + 1; 0 at the root
+		int                idx_;      // array index; -1: all elements (leaf)
+	};
+
+	struct Leaf {
+		const CEntryImpl *entry_;
+		CAccessPlan       plan_;     // invalid if the leaf cannot be flattened
+		unsigned          name_;     // offset into the name pool
+		unsigned          step_;     // last step of the path to the leaf
+		unsigned          size_;     // bytes per element (including the bit shift)
+		uint64_t          sizeBits_; // 8*size_ for non-integer leaves
+		int               lsBit_;
+		uint8_t           msk1_;     // bits of the first/last byte which do not
+		uint8_t           mskn_;     // belong to the leaf (and are preserved)
+		bool              bulk_;     // included in 'readAll()/writeAll()'
+		bool              writable_;
+	};
+
+private:
+	std::vector<Leaf>     leaves_;
+	std::vector<Step>     steps_;
+	std::vector<char>     names_;
+	std::vector<unsigned> index_;    // open addressing; 0 marks an empty slot, else row + 1
+	uint64_t              rawSize_;  // of all 'bulk' rows
+
+	CRegMap(const CRegMap&);
+	CRegMap & operator=(const CRegMap&);
+
+	struct Ctx {
+		AddressImpl transport_;
+		unsigned    transportIdx_;
+		uint64_t    off_;
+		unsigned    step_;  // + 1; 0 at the root
+	};
+
+	void     compile(const CDevImpl *dev, const Ctx &ctx, std::string *name);
+	void     addLeaf(const AddressImpl *a, const Ctx &ctx, const CMMIOAddressImpl *mmio, const std::string &name);
+	unsigned addStep(const AddressImpl *a, const Ctx &ctx, int idx);
+	void     buildIndex();
+
+public:
+	// 'root' should be locked (i.e., must not change anymore)
+	CRegMap(const CDevImpl *root);
+
+	unsigned     getNumLeaves()            const { return leaves_.size(); }
+	const Leaf  *getLeaf(unsigned i)       const { return &leaves_[i];    }
+	const char  *getName(const Leaf *l)    const { return &names_[l->name_]; }
+
+	// RETURNS: NULL if there is no leaf with this name
+	const Leaf  *find(const char *name)    const;
+
+	// the path from the root to a leaf (root first)
+	void         getSteps(const Leaf *l, std::vector<const Step*> *steps) const;
+
+	// raw (target-byte-order) contents of all elements of a leaf;
+	// 'dst' must hold 'getRawSize(l)' bytes.
+	// RETURNS: number of bytes read; 0 if the leaf cannot be flattened.
+	uint64_t     read (const Leaf *l, uint8_t *dst,       const CTimeout &timeout = TIMEOUT_INDEFINITE) const;
+	// bits which do not belong to the leaf are preserved
+	uint64_t     write(const Leaf *l, const uint8_t *src, const CTimeout &timeout = TIMEOUT_INDEFINITE) const;
+
+	static uint64_t getRawSize(const Leaf *l) { return (uint64_t)l->size_ * l->plan_.getNelms(); }
+
+	// snapshot of all readable integer registers (in table order)
+	uint64_t     getRawSize()              const { return rawSize_; }
+	uint64_t     readAll (uint8_t *dst)    const;
+	// restore a snapshot; read-only registers are skipped
+	uint64_t     writeAll(const uint8_t *src) const;
+
+	uint64_t     getMemUsage()             const;
+
+	void         dumpInfo(FILE *f)         const;
+	// one line per leaf
+	void         dump(FILE *f)             const;
+};
+
+#endif
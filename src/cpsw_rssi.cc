@@ -55,6 +55,7 @@ CRssi::CRssi(
   IRexTimer      ( &timers_ ),
   IAckTimer      ( &timers_ ),
   INulTimer      ( &timers_ ),
+  IPacTimer      ( &timers_ ),
 
 
   defaults_      ( defaults ? defaults->assertValid() : CRssiConfigParams() ),
@@ -74,7 +75,6 @@ CRssi::CRssi(
   unOrderedSegs_ ( defaults_.ldMaxUnackedSegs_       )
 {
 	conID_ = (uint32_t)time(NULL);
-	::memset( &stats_, 0, sizeof(stats_) );
 
 	closedReopenDelay_.tv_nsec = 0;
 	closedReopenDelay_.tv_sec  = 0;
@@ -84,13 +84,35 @@ CRssi::CRssi(
 	eventSet_->add( outQ_->getWriteEventSource(), usrOEH() );
 }
 
-void CRssi::processAckNumber(uint8_t flags, SeqNo ackNo)
+// RETURNS: true if a fast retransmission is due
+bool CRssi::processAckNumber(uint8_t flags, SeqNo ackNo, bool hasPayload)
 {
-int acked;
+int      acked;
+SeqNo    oldest  = unAckedSegs_.getOldest();
+bool     fastRex = false;
+CTimeout now;
+
 	if ( (flags & RssiHeader::FLG_ACK) ) {
 		if ( (acked = unAckedSegs_.ack( ackNo )) > 0 ) {
-			numRex_ = 0;
+			numRex_  = 0;
+			dupAcks_ = 0;
 			stats_.numSegsAckedByPeer_ += acked;
+			growCwnd( acked );
+			if ( rttTiming_ && (SeqNo)(rttSeq_ - oldest) < (unsigned)acked ) {
+				rttTiming_ = false;
+				eventSet_->getAbsTime( &now );
+				if ( rttStart_ < now ) {
+					updateRtt( (now - rttStart_).getUs() );
+				}
+			}
+		} else if (    0 == acked
+		            && ! hasPayload
+		            && ! (flags & (RssiHeader::FLG_SYN | RssiHeader::FLG_NUL | RssiHeader::FLG_RST | RssiHeader::FLG_BSY))
+		            && unAckedSegs_.getSize() > 0 ) {
+			// duplicate ACK; a busy peer is not counted (flow control, not loss)
+			if ( ++dupAcks_ == DUP_ACK_THRESH ) {
+				fastRex = true;
+			}
 		}
 		if ( unAckedSegs_.getSize() == 0 ) {
 #ifdef RSSI_DEBUG
@@ -108,6 +130,26 @@ int acked;
 #endif
 		}
 	}
+	return fastRex;
+}
+
+void CRssi::processEack(RssiHeader &hdr)
+{
+unsigned i, n = hdr.getNumEacks();
+
+	// segments acknowledged selectively are kept (they still
+	// occupy the window until cumulatively ACKed) but are
+	// no longer retransmitted.
+	for ( i = 0; i < n; i++ ) {
+		if ( unAckedSegs_.sack( hdr.getEack( i ) ) ) {
+			stats_.numSegsSackedByPeer_++;
+		}
+	}
+#ifdef RSSI_DEBUG
+	if ( cpsw_rssi_debug > 3 ) {
+		fprintf(CPSW::fDbg(),"%s: got EACK (%d entries)\n", getName(), n);
+	}
+#endif
 }
 
 void CRssi::handleRxEvent(IIntEventSource *src)
@@ -160,9 +202,11 @@ void CRssi::close()
 	ackTimer()->cancel();
 	nulTimer()->cancel();
 	rexTimer()->cancel();
+	pacTimer()->cancel();
 
 	// initial default values
 	resetNegotiableParams();
+	resetRtt();
 
 	unAckedSegs_.purge();
 	unOrderedSegs_.purge();
@@ -172,6 +216,9 @@ void CRssi::close()
 
 	peerBSY_        = false;
 
+	// the peer announces EACK support in its SYN
+	eack_           = false;
+
 	// we don't know the peer's setting yet (it's in the SYN packet)
 	// -> don't verify their checksum but always add ours
 	verifyChecksum_ = false;
@@ -180,6 +227,11 @@ void CRssi::close()
 	peerOssMX_      = maxUnackedSegs_;
 	peerSgsMX_      = MAX_SEGMENT_SIZE;
 
+	cwnd_           = peerOssMX_ << CWND_SHIFT;
+	nextTx_         = CTimeout( 0, 0 );
+	lastCwndCut_    = CTimeout( 0, 0 );
+	publishGauges();
+
 	conID_++;
 }
 
@@ -209,6 +261,11 @@ void CRssi::sendBuf(BufChain bc, bool retrans)
 
 	hdr.setAckNo( lastSeqRecv_ );
 
+	// Karn: RTT samples are ambiguous while retransmitting
+	if ( retrans ) {
+		rttTiming_ = false;
+	}
+
 #ifdef RSSI_DEBUG
 	if ( cpsw_rssi_debug > 1 ) {
 		fprintf(CPSW::fDbg(),"tX: %s -- ", getName());
@@ -241,7 +298,7 @@ void CRssi::armRexAndNulTimer()
 		eventSet_->getAbsTime( &now );
 
 		if ( ! peerBSY_ ) {
-			rexTimer()->arm_abs( now + rexTO_ );
+			rexTimer()->arm_abs( now + rto_ );
 #ifdef RSSI_DEBUG
 			if ( cpsw_rssi_debug > 2 ) {
 				fprintf(CPSW::fDbg(),"%s: REX timer armed (state %s)\n", getName(), state_->getName());
@@ -260,8 +317,202 @@ void CRssi::armRexAndNulTimer()
 	}
 }
 
+void CRssi::resetRtt()
+{
+	rto_       = rexTO_;
+	srttUs_    = 0;
+	rttvarUs_  = 0;
+	minRttUs_  = 0;
+	rttTiming_ = false;
+	dupAcks_   = 0;
+}
+
+void CRssi::updateRtt(uint64_t sampleUs)
+{
+uint64_t rto, dev;
+
+	if ( 0 == srttUs_ ) {
+		srttUs_   = sampleUs;
+		rttvarUs_ = sampleUs/2;
+	} else {
+		dev       = srttUs_ > sampleUs ? srttUs_ - sampleUs : sampleUs - srttUs_;
+		rttvarUs_ = (3*rttvarUs_ + dev)/4;
+		srttUs_   = (7*srttUs_ + sampleUs)/8;
+	}
+	if ( 0 == srttUs_ ) {
+		srttUs_ = 1;
+	}
+	if ( 0 == minRttUs_ || sampleUs < minRttUs_ ) {
+		minRttUs_ = sampleUs ? sampleUs : 1;
+	}
+
+	rto = srttUs_ + 4*rttvarUs_;
+	if ( rto < RTO_MIN_US )
+		rto = RTO_MIN_US;
+	if ( rto > rexTO_.getUs() )
+		rto = rexTO_.getUs();
+	rto_ = CTimeout( rto );
+	publishGauges();
+}
+
+void CRssi::backoffRto()
+{
+uint64_t rto = 2*rto_.getUs();
+
+	if ( rto > rexTO_.getUs() )
+		rto = rexTO_.getUs();
+	rto_ = CTimeout( rto );
+	publishGauges();
+}
+
+void CRssi::fastRetransmit()
+{
+RingBuf::iterator it = unAckedSegs_.begin();
+BufChain          bc;
+unsigned          i, n, lastSacked;
+
+	// Every segment preceding one which the peer holds (EACK)
+	// is missing; w/o EACK we only know about the oldest one.
+	for ( n = lastSacked = 0; (bc = *it); ++it ) {
+		n++;
+		if ( it.isSacked() )
+			lastSacked = n;
+	}
+	if ( 0 == lastSacked )
+		lastSacked = 1;
+
+#ifdef RSSI_DEBUG
+	if ( cpsw_rssi_debug > 2 ) {
+		fprintf(CPSW::fDbg(),"%s: fast retransmission (%d dup ACKs)\n", getName(), dupAcks_);
+	}
+#endif
+
+	cutCwnd();
+
+	for ( i = 0, it = unAckedSegs_.begin(); i < lastSacked && (bc = *it); i++, ++it ) {
+		if ( it.isSacked() )
+			continue;
+		stats_.rexSegments_++;
+		stats_.fastRetransmits_++;
+		sendBuf( bc, true );
+	}
+	armRexAndNulTimer();
+}
+
+unsigned CRssi::getTxWindow()
+{
+unsigned w;
+
+	if ( ! defaults_.txPacing_ ) {
+		return peerOssMX_;
+	}
+	w = cwnd_ >> CWND_SHIFT;
+	if ( w < 1 )
+		w = 1;
+	return w < peerOssMX_ ? w : peerOssMX_;
+}
+
+// Spread the congestion window over one RTT but do not exceed
+// a configured rate. Use the minimal RTT; the smoothed RTT also
+// contains the peer's ACK delay -- which grows with the pacing
+// interval.
+uint64_t CRssi::getTxIntervalNs()
+{
+uint64_t ns = 0;
+uint64_t cfg;
+
+	if ( minRttUs_ ) {
+		ns = ( (minRttUs_ * 1000) << CWND_SHIFT ) / cwnd_;
+	}
+	if ( defaults_.txRateSegsPerSec_ ) {
+		cfg = (uint64_t)1000000000 / defaults_.txRateSegsPerSec_;
+		if ( cfg > ns )
+			ns = cfg;
+	}
+	return ns;
+}
+
+// RETURNS: true if a DAT segment may be sent now; arms
+//          the pacing timer otherwise.
+bool CRssi::txPaceOk()
+{
+CTimeout now;
+
+	if ( ! defaults_.txPacing_ ) {
+		return true;
+	}
+
+	eventSet_->getAbsTime( &now );
+	if ( now < nextTx_ ) {
+		if ( ! pacTimer()->isArmed() ) {
+			pacTimer()->arm_abs( nextTx_ );
+			stats_.pacingDelays_++;
+		}
+		return false;
+	}
+	return true;
+}
+
+// AIMD: additive increase by one segment per window...
+void CRssi::growCwnd(unsigned acked)
+{
+unsigned max = peerOssMX_ << CWND_SHIFT;
+
+	if ( defaults_.txPacing_ && cwnd_ < max ) {
+		cwnd_ += ( acked << (2*CWND_SHIFT) ) / cwnd_;
+		if ( cwnd_ > max )
+			cwnd_ = max;
+		publishGauges();
+	}
+}
+
+// ... multiplicative decrease (at most once per RTT) on loss
+void CRssi::cutCwnd()
+{
+CTimeout now;
+unsigned min;
+
+	if ( ! defaults_.txPacing_ ) {
+		return;
+	}
+
+	eventSet_->getAbsTime( &now );
+	if ( now < lastCwndCut_ + CTimeout( srttUs_ ) ) {
+		return;
+	}
+	lastCwndCut_ = now;
+
+	// the peer only ACKs after 'cakMX' segments (or a timeout);
+	// a smaller window would just stall.
+	min = cakMX_ > 0 ? cakMX_ + 1 : 1;
+	if ( min > peerOssMX_ )
+		min = peerOssMX_;
+	min <<= CWND_SHIFT;
+
+	cwnd_ /= 2;
+	if ( cwnd_ < min )
+		cwnd_ = min;
+	stats_.cwndCuts_++;
+	publishGauges();
+}
+
+// the algorithm state is private to the RSSI thread;
+// mirror what 'dumpStats' reports
+void CRssi::publishGauges()
+{
+	stats_.srttUs_.set  ( srttUs_             );
+	stats_.rtoUs_.set   ( rto_.getUs()        );
+	stats_.cwndSegs_.set( cwnd_ >> CWND_SHIFT );
+}
+
 void CRssi::sendBufAndKeepForRetransmission(BufChain b)
 {
+	if ( ! rttTiming_ ) {
+		rttTiming_ = true;
+		rttSeq_    = RssiHeader( b->getHead()->getPayload() ).getSeqNo();
+		eventSet_->getAbsTime( &rttStart_ );
+	}
+
 	sendBuf( b, false );
 	unAckedSegs_.push( b );
 	armRexAndNulTimer();
@@ -278,6 +529,18 @@ Buf b = bc->getHead();
 	hdr.setFlags( RssiHeader::FLG_ACK );
 	hdr.setSeqNo( ++lastSeqSent_ );
 	sendBufAndKeepForRetransmission( bc );
+
+	if ( defaults_.txPacing_ ) {
+	CTimeout now;
+	uint64_t ns = getTxIntervalNs();
+
+		eventSet_->getAbsTime( &now );
+		// don't accumulate credit while idle
+		if ( nextTx_ < now ) {
+			nextTx_ = now;
+		}
+		nextTx_ += CTimeout( ns / 1000000000, ns % 1000000000 );
+	}
 }
 
 void CRssi::sendACK()
@@ -285,10 +548,36 @@ void CRssi::sendACK()
 BufChain   bc = IBufChain::create();
 Buf        b  = bc->createAtHead( IBuf::CAPA_ETH_HDR );
 RssiHeader hdr( b->getPayload(), b->getAvail(), false, RssiHeader::SET );
+uint8_t    held[256];
+unsigned   n  = 0;
+unsigned   max;
 
 	hdr.setFlags( RssiHeader::FLG_ACK );
 	hdr.setSeqNo( lastSeqSent_ + 1 );
 
+	// only if there is a gap (otherwise the output queue is just full)
+	if ( eack_ && ! unOrderedSegs_.peek() ) {
+		// an even number leaves room for padding
+		max = (b->getAvail() - hdr.getHSize()) & ~1;
+		if ( max > sizeof(held) )
+			max = sizeof(held);
+		n = unOrderedSegs_.getHeld( held, max );
+	}
+
+	if ( n > 0 ) {
+	unsigned i;
+		hdr.setFlags( RssiHeader::FLG_ACK | RssiHeader::FLG_EAC );
+		for ( i = 0; i < n; i++ ) {
+			hdr.setEack( i, held[i] );
+		}
+		if ( (n & 1) ) {
+			hdr.setEack( n, held[n-1] );
+			n++;
+		}
+		hdr.setHSize( hdr.getHSize() + n );
+		stats_.eacksSent_++;
+	}
+
 	b->setSize( hdr.getHSize() );
 
 	// ACK is never retransmitted
@@ -375,6 +664,11 @@ int           maxSegSize;
 	flags = RssiSynHeader::XFL_ONE;
 	if ( addChecksum_ )
 		flags |= RssiSynHeader::XFL_CHK;
+	// XFL_EAK is not defined by the RSSI spec (firmware); the client
+	// only sets it if configured to; the server only echoes a request
+	// ('eack_' is set by 'extractConnectionParams' before the SYN-ACK).
+	if ( isServer_ ? eack_ : defaults_.extendedAcks_ )
+		flags |= RssiSynHeader::XFL_EAK;
 
 	synHdr.setXflgs( flags                         );
 	synHdr.setVersn( RssiSynHeader::RSSI_VERSION_1 );
@@ -445,6 +739,8 @@ int           maxSegSize;
 void CRssi::processRetransmissionTimeout()
 {
 	stats_.rexTimeouts_++;
+	backoffRto();
+	cutCwnd();
 #ifdef RSSI_DEBUG
 	if ( cpsw_rssi_debug > 2 ) {
 		fprintf(CPSW::fDbg(),"%s: RexTimer expired\n", getName());
@@ -475,6 +771,16 @@ void CRssi::processNulTimeout()
 	state_->processNulTimeout( this );
 }
 
+void CRssi::processPaceTimeout()
+{
+#ifdef RSSI_DEBUG
+	if ( cpsw_rssi_debug > 2 ) {
+		fprintf(CPSW::fDbg(),"%s: PacTimer expired\n", getName());
+	}
+#endif
+	state_->processPaceTimeout( this );
+}
+
 void * CRssi::threadBody()
 {
 	while ( 1 ) {
@@ -555,21 +861,31 @@ CRssi::~CRssi()
 void CRssi::dumpStats(FILE *f)
 {
 	fprintf(f ,"RSSI (%s) statistics (%s mode):\n", getName(), isServer_ ? "Server" : "Client");
-	fprintf(f ,"  # outgoing segments dropped: %12u\n", stats_.outgoingDropped_   );
-	fprintf(f ,"  # retransmitted segments   : %12u\n", stats_.rexSegments_       );
-	fprintf(f ,"  # retransmission timeouts  : %12u\n", stats_.rexTimeouts_       );
-	fprintf(f ,"  # retrans. due to BSY deass: %12u\n", stats_.busyDeassertRex_   );
-	fprintf(f ,"  # cumulative ACK timeouts  : %12u\n", stats_.ackTimeouts_       );
-	fprintf(f ,"  # NUL periods expired      : %12u\n", stats_.nulTimeouts_       );
-	fprintf(f ,"  # Headers with bad checksum: %12u\n", stats_.badChecksum_       );
-	fprintf(f ,"  # Invalid SYN headers      : %12u\n", stats_.badSynDropped_     );
-	fprintf(f ,"  # Invalid headers          : %12u\n", stats_.badHdrDropped_     );
-	fprintf(f ,"  # RXsegs out of WIN        : %12u\n", stats_.rejectedSegs_      );
-	fprintf(f ,"  # NUL replaced by ACK      : %12u\n", stats_.skippedNULs_       );
-	fprintf(f ,"  # segments ACKed by peer   : %12u\n", stats_.numSegsAckedByPeer_);
-	fprintf(f ,"  # segments delivered to usr: %12u\n", stats_.numSegsGivenToUser_);
-	fprintf(f ,"  # RX segs with BSY asserted: %12u\n", stats_.busyFlagsCountedRx_);
-	fprintf(f ,"  # TX segs with BSY asserted: %12u\n", stats_.busyFlagsCountedTx_);
+	fprintf(f ,"  # outgoing segments dropped: %12" PRIu64 "\n", stats_.outgoingDropped_.get()    );
+	fprintf(f ,"  # retransmitted segments   : %12" PRIu64 "\n", stats_.rexSegments_.get()        );
+	fprintf(f ,"  # retransmission timeouts  : %12" PRIu64 "\n", stats_.rexTimeouts_.get()        );
+	fprintf(f ,"  # retrans. due to BSY deass: %12" PRIu64 "\n", stats_.busyDeassertRex_.get()    );
+	fprintf(f ,"  # cumulative ACK timeouts  : %12" PRIu64 "\n", stats_.ackTimeouts_.get()        );
+	fprintf(f ,"  # NUL periods expired      : %12" PRIu64 "\n", stats_.nulTimeouts_.get()        );
+	fprintf(f ,"  # Headers with bad checksum: %12" PRIu64 "\n", stats_.badChecksum_.get()        );
+	fprintf(f ,"  # Invalid SYN headers      : %12" PRIu64 "\n", stats_.badSynDropped_.get()      );
+	fprintf(f ,"  # Invalid headers          : %12" PRIu64 "\n", stats_.badHdrDropped_.get()      );
+	fprintf(f ,"  # RXsegs out of WIN        : %12" PRIu64 "\n", stats_.rejectedSegs_.get()       );
+	fprintf(f ,"  # NUL replaced by ACK      : %12" PRIu64 "\n", stats_.skippedNULs_.get()        );
+	fprintf(f ,"  # segments ACKed by peer   : %12" PRIu64 "\n", stats_.numSegsAckedByPeer_.get() );
+	fprintf(f ,"  # segments delivered to usr: %12" PRIu64 "\n", stats_.numSegsGivenToUser_.get() );
+	fprintf(f ,"  # RX segs with BSY asserted: %12" PRIu64 "\n", stats_.busyFlagsCountedRx_.get() );
+	fprintf(f ,"  # TX segs with BSY asserted: %12" PRIu64 "\n", stats_.busyFlagsCountedTx_.get() );
+	fprintf(f ,"  # EACKs sent               : %12" PRIu64 "\n", stats_.eacksSent_.get()          );
+	fprintf(f ,"  # segments EACKed by peer  : %12" PRIu64 "\n", stats_.numSegsSackedByPeer_.get());
+	fprintf(f ,"  # fast retransmissions     : %12" PRIu64 "\n", stats_.fastRetransmits_.get()    );
+	fprintf(f ,"  smoothed RTT (us)          : %12" PRIu64 "\n", stats_.srttUs_.get()             );
+	fprintf(f ,"  retransmission timeout (us): %12" PRIu64 "\n", stats_.rtoUs_.get()              );
+	if ( defaults_.txPacing_ ) {
+		fprintf(f ,"  # TX delayed by pacing     : %12" PRIu64 "\n", stats_.pacingDelays_.get()       );
+		fprintf(f ,"  # congestion window cuts   : %12" PRIu64 "\n", stats_.cwndCuts_.get()           );
+		fprintf(f ,"  congestion window (segs)   : %12" PRIu64 "\n", stats_.cwndSegs_.get()           );
+	}
 }
 
 void CRssi::RingBuf::dump()
@@ -663,6 +979,24 @@ unsigned i, u;
 		unAckedSegs_.resize( peerOssMX_ );
 	}
 
+	// no RTT samples yet; start out with the negotiated timeout
+	rto_            = rexTO_;
+
+	cwnd_           = peerOssMX_ << CWND_SHIFT;
+
+	publishGauges();
+
+	// the client requests EACK (if configured); the server grants
+	// a request by echoing the flag.
+	eack_           =    ( isServer_ || defaults_.extendedAcks_ )
+	                  && ( synHdr.getXflgs() & RssiSynHeader::XFL_EAK );
+
+#ifdef RSSI_DEBUG
+	if ( cpsw_rssi_debug > 0 ) {
+		fprintf(CPSW::fDbg(), "RSSI Peer supports EACK: %s\n", eack_ ? "YES" : "NO");
+	}
+#endif
+
 	if ( acceptNegotiated ) {
 
 		// accept server's parameters
@@ -701,7 +1035,7 @@ unsigned i, u;
 
 const CRssiConfigParams & CRssiConfigParams::assertValid() const
 {
-	if ( ldMaxUnackedSegs_        >= 8     )
+	if ( ldMaxUnackedSegs_        >  LD_MAX_UNACKED_SEGS_MAX )
 		throw ConfigurationError("RSSI parameter 'ldMaxUnackedSegs' out too big");
 	if ( rexTimeoutUS_/UNIT_US_DFLT    >= 65536 )
 		throw ConfigurationError("RSSI parameter 'retransmissionTimeoutUS' out too big");
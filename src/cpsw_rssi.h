@@ -20,6 +20,7 @@
 #include <stdint.h>
 
 #include <cpsw_buf.h>
+#include <cpsw_stats.h>
 
 #include <vector>
 
@@ -73,6 +74,15 @@ public:
 
 };
 
+class IPacTimer : public RssiTimer {
+protected:
+	virtual void processPaceTimeout() = 0;
+public:
+	IPacTimer(RssiTimerList *l) : RssiTimer("PAC", l) {}
+	virtual void process() { processPaceTimeout(); }
+
+};
+
 // posts events when the state changes
 class CConnectionStateChangedEventSource : public CIntEventSource {
 public:
@@ -129,6 +139,14 @@ struct CRssiConfigParams {
 	 * (some of them) are negotiated with the peer (as per RUDP spec).
 	 */
 	static const uint8_t  LD_MAX_UNACKED_SEGS_DFLT =    4;
+	/* 2^7 = 128 segments is the largest window: the next power of
+	 * two (256) does not fit the 8-bit OssMX field of the SYN. Also,
+	 * since the receiver holds out-of-order segments (with or without
+	 * EACK), the window must not exceed half of the 8-bit sequence
+	 * space; otherwise retransmitted (old) segments cannot be told
+	 * apart from new ones.
+	 */
+	static const uint8_t  LD_MAX_UNACKED_SEGS_MAX  =    7;
 	static const unsigned         QUEUE_DEPTH_DFLT =    0;
 	static const unsigned             UNIT_US_DFLT = 1000;
 	static const uint64_t      REX_TIMEOUT_US_DFLT =  100*(uint64_t)UNIT_US_DFLT; // ms
@@ -138,6 +156,9 @@ struct CRssiConfigParams {
 	static const uint8_t              CAK_MAX_DFLT =    5;
 	static const unsigned             SGS_MAX_DFLT =    0;
 	static const unsigned         UNIT_US_EXP_DFLT =    3; // value used by server; must match UNIT_US (i.e., UNIT_US = 10^-UNIT_US_EXP)
+	static const bool               TX_PACING_DFLT = false;
+	static const unsigned             TX_RATE_DFLT =    0; // segments/s; 0 -> derived from window and RTT
+	static const bool                  EACKS_DFLT = false;
 
 	uint8_t      ldMaxUnackedSegs_;
 	unsigned     outQueueDepth_;
@@ -148,6 +169,9 @@ struct CRssiConfigParams {
 	uint8_t      rexMax_;
 	uint8_t      cumAckMax_;
 	unsigned     forcedSegsMax_;
+	bool         txPacing_;        // see README.yamlDefinition (txPacing) for when to use
+	unsigned     txRateSegsPerSec_;
+	bool         extendedAcks_;     // client: request EACK in SYN; a server always grants a request
 
 	CRssiConfigParams(
 		uint8_t      ldMaxUnackedSegs = LD_MAX_UNACKED_SEGS_DFLT,
@@ -158,7 +182,10 @@ struct CRssiConfigParams {
 		uint64_t     nulTimeoutUS     = NUL_TIMEOUT_US_DFLT,
 		uint8_t      rexMax           = REX_MAX_DFLT,
 		uint8_t      cumAckMax        = CAK_MAX_DFLT,
-		unsigned     forcedSegsMax    = SGS_MAX_DFLT
+		unsigned     forcedSegsMax    = SGS_MAX_DFLT,
+		bool         txPacing         = TX_PACING_DFLT,
+		unsigned     txRateSegsPerSec = TX_RATE_DFLT,
+		bool         extendedAcks     = EACKS_DFLT
 	)
 	:
 		ldMaxUnackedSegs_( ldMaxUnackedSegs ),
@@ -169,7 +196,10 @@ struct CRssiConfigParams {
 		nulTimeoutUS_    ( nulTimeoutUS     ),
 		rexMax_          ( rexMax           ),
 		cumAckMax_       ( cumAckMax        ),
-		forcedSegsMax_   ( forcedSegsMax    )
+		forcedSegsMax_   ( forcedSegsMax    ),
+		txPacing_        ( txPacing         ),
+		txRateSegsPerSec_( txRateSegsPerSec ),
+		extendedAcks_    ( extendedAcks     )
 	{}
 
 	const CRssiConfigParams & assertValid() const;
@@ -183,6 +213,7 @@ class CRssi : public CRunnable,
               public IRexTimer,
               public IAckTimer,
               public INulTimer,
+              public IPacTimer,
               public CConnectionStateChangedEventSource,
               public CConnectionOpenEventSource,
               public CConnectionNotOpenEventSource,
@@ -209,6 +240,20 @@ public:
 
 	static const uint16_t MAX_SEGMENT_SIZE    = 1500 - 20 - 8 - 8; // - IP - UDP - RSSI
 
+	/*
+	 * Fast retransmission is triggered by this many duplicate ACKs;
+	 * the adaptive retransmission timeout never drops below RTO_MIN_US
+	 * (and never exceeds the negotiated retransmission timeout).
+	 */
+	static const unsigned DUP_ACK_THRESH      = 3;
+	static const uint64_t RTO_MIN_US          = 2000;
+
+	/*
+	 * The congestion window (used with TX pacing) is kept
+	 * in fractions (1/2^CWND_SHIFT) of a segment.
+	 */
+	static const unsigned CWND_SHIFT          = 8;
+
 private:
 	CRssiConfigParams defaults_;
 	bool              isServer_;
@@ -309,14 +354,17 @@ protected:
 
 	class RingBuf : public BufBase {
 	private:
-		BufIdx wp_;
+		BufIdx            wp_;
+		// segments the peer has acknowledged selectively (EACK)
+		std::vector<bool> sacked_;
 
 		friend class iterator;
 
 	public:
 		RingBuf(unsigned ldsz)
 		: BufBase(ldsz),
-		  wp_(rp_)
+		  wp_(rp_),
+		  sacked_(capa_)
 		{}
 
 		void dump();
@@ -349,6 +397,11 @@ protected:
 					return BufChain();
 				return rb_->buf_.at( (idx_ & rb_->msk_) );
 			}
+
+			bool isSacked()
+			{
+				return idx_ != rb_->wp_ && rb_->sacked_[ idx_ & rb_->msk_ ];
+			}
 		};
 
 		iterator begin()
@@ -378,6 +431,23 @@ protected:
 			return cumAck;
 		}
 
+		// mark a segment which was acknowledged selectively;
+		// RETURNS: true if the segment was newly marked
+		bool sack(SeqNo seqNo)
+		{
+		SeqNo    off = seqNo - oldest_;
+		unsigned idx;
+
+			if ( off >= getSize() )
+				return false;
+
+			idx = (rp_ + off) & msk_;
+			if ( sacked_[idx] )
+				return false;
+			sacked_[idx] = true;
+			return true;
+		}
+
 		void push(BufChain b)
 		{
 		unsigned widx = wp_ & msk_;
@@ -387,7 +457,8 @@ protected:
 				// transmits
 				throw InternalError("RingBuf Overflow");
 			}
-			buf_[ widx ] = b;
+			buf_[ widx ]    = b;
+			sacked_[ widx ] = false;
 			wp_++;
 		}
 
@@ -396,24 +467,30 @@ protected:
 		unsigned         i;
 		unsigned         sz = getSize();
 		std::vector<BufChain> tmp( sz );
+		std::vector<bool>     tmps( sz );
 		SeqNo            tmpo = getOldest();
-			for ( i=0; i<sz; i++ )
-				tmp[i] = pop();
+			for ( i=0; i<sz; i++ ) {
+				tmps[i] = sacked_[ rp_ & msk_ ];
+				tmp[i]  = pop();
+			}
 			for ( capa_=1; capa_ < new_capa; capa_<<=1 )
 				;
 			buf_.resize(capa_);
+			sacked_.resize(capa_);
 			rp_  = wp_ = 0;
 			msk_ = capa_ - 1;
 			buf_.resize( capa_ );
 			seed( tmpo );
-			for ( i=0; i<sz; i++ )
+			for ( i=0; i<sz; i++ ) {
 				push( tmp[i] );
+				sacked_[i] = tmps[i];
+			}
 		}
 	};
 
 	class ReassembleBuf : public BufBase {
 	private:
-		SeqNo lim_;
+		unsigned lim_;
 
 	public:
 		// capa is a power of two, limit is anything
@@ -448,6 +525,18 @@ protected:
 			return (getOldest() - 1) & 0xff;
 		}
 
+		// collect the sequence numbers of all segments which
+		// are held (i.e., have not been delivered yet)
+		unsigned getHeld(uint8_t *seqs, unsigned max)
+		{
+		unsigned off, n;
+			for ( off = n = 0; off < lim_ && n < max; off++ ) {
+				if ( buf_[ (off + rp_) & msk_ ] )
+					seqs[n++] = oldest_ + off;
+			}
+			return n;
+		}
+
 		void purge()
 		{
 		unsigned i;
@@ -473,6 +562,7 @@ protected:
 		virtual void processRetransmissionTimeout(CRssi *context);
 		virtual void processAckTimeout(CRssi *context);
 		virtual void processNulTimeout(CRssi *context);
+		virtual void processPaceTimeout(CRssi *context);
 
 		virtual  int getConnectionState(CRssi *context);
 
@@ -555,6 +645,7 @@ protected:
 		virtual BufChain  hasBufToSend(CRssi *context);
 		virtual void processAckTimeout(CRssi *context);
 		virtual void processNulTimeout(CRssi *context);
+		virtual void processPaceTimeout(CRssi *context);
 		virtual  int getConnectionState(CRssi *context);
 	};
 	friend class OPEN;
@@ -564,6 +655,7 @@ protected:
 		OPEN_OUTWIN_FULL():OPEN("OPEN_OUTWIN_FULL") {}
 
 		virtual void handleRxEvent(CRssi *context, IIntEventSource *src);
+		virtual void processPaceTimeout(CRssi *context);
 	};
 	friend class OPEN_OUTWIN_FULL;
 
@@ -593,6 +685,19 @@ private:
 protected:
 
 	CTimeout rexTO_, cakTO_, nulTO_;
+	// adaptive retransmission timeout (RFC 6298) bounded by rexTO_
+	CTimeout rto_;
+	uint64_t srttUs_;   // 0 -> no sample yet
+	uint64_t rttvarUs_;
+	uint64_t minRttUs_; // 0 -> no sample yet
+	bool     rttTiming_;
+	SeqNo    rttSeq_;
+	CTimeout rttStart_;
+	unsigned dupAcks_;
+	// TX pacing and AIMD congestion control (optional)
+	unsigned cwnd_;
+	CTimeout nextTx_;
+	CTimeout lastCwndCut_;
 	unsigned rexMX_;
 	int      cakMX_;
 	uint32_t conID_;
@@ -600,6 +705,7 @@ protected:
 	unsigned numRex_;
 	int      numCak_; // may temporarily fall below zero
 	bool     peerBSY_;
+	bool     eack_;    // both sides support EACK
 
 	struct timespec closedReopenDelay_;
 
@@ -620,7 +726,18 @@ protected:
 	void sendBufAndKeepForRetransmission(BufChain);
 	void sendBuf(BufChain, bool);
 	void armRexAndNulTimer();
-	void processAckNumber(uint8_t, SeqNo);
+	void resetRtt();
+	void updateRtt(uint64_t sampleUs);
+	void backoffRto();
+	void fastRetransmit();
+	unsigned getTxWindow();
+	bool     txPaceOk();
+	uint64_t getTxIntervalNs();
+	void     growCwnd(unsigned acked);
+	void     cutCwnd();
+	void     publishGauges();
+	bool processAckNumber(uint8_t, SeqNo, bool);
+	void processEack(RssiHeader &);
 
 	void sendSYN(bool do_ack);
 	void sendACK();
@@ -630,23 +747,34 @@ protected:
 
 	void extractConnectionParams(RssiSynHeader &synHdr, bool acceptNegotiated);
 
+	// written by the RSSI thread only; may be sampled
+	// by any thread (see cpsw_stats.h)
 	struct {
-		unsigned outgoingDropped_;
-		unsigned rexSegments_;
-		unsigned rexTimeouts_;
-		unsigned ackTimeouts_;
-		unsigned nulTimeouts_;
-		unsigned connFailed_;
-		unsigned badChecksum_;
-		unsigned badSynDropped_;
-		unsigned badHdrDropped_;
-		unsigned rejectedSegs_;
-		unsigned skippedNULs_;
-		unsigned numSegsAckedByPeer_;
-		unsigned numSegsGivenToUser_;
-		unsigned busyFlagsCountedRx_;
-		unsigned busyFlagsCountedTx_;
-		unsigned busyDeassertRex_;
+		CStatCounter outgoingDropped_;
+		CStatCounter rexSegments_;
+		CStatCounter rexTimeouts_;
+		CStatCounter ackTimeouts_;
+		CStatCounter nulTimeouts_;
+		CStatCounter connFailed_;
+		CStatCounter badChecksum_;
+		CStatCounter badSynDropped_;
+		CStatCounter badHdrDropped_;
+		CStatCounter rejectedSegs_;
+		CStatCounter skippedNULs_;
+		CStatCounter numSegsAckedByPeer_;
+		CStatCounter numSegsGivenToUser_;
+		CStatCounter busyFlagsCountedRx_;
+		CStatCounter busyFlagsCountedTx_;
+		CStatCounter busyDeassertRex_;
+		CStatCounter eacksSent_;
+		CStatCounter fastRetransmits_;
+		CStatCounter pacingDelays_;
+		CStatCounter cwndCuts_;
+		CStatCounter numSegsSackedByPeer_;
+		// gauges mirroring srttUs_, rto_ and cwnd_
+		CStatCounter srttUs_;
+		CStatCounter rtoUs_;
+		CStatCounter cwndSegs_;
 	} stats_;
 
 
@@ -663,10 +791,12 @@ protected:
 	virtual void processRetransmissionTimeout();
 	virtual void processAckTimeout();
 	virtual void processNulTimeout();
+	virtual void processPaceTimeout();
 
 	IRexTimer              *rexTimer() { return (IRexTimer*) this; }
 	IAckTimer              *ackTimer() { return (IAckTimer*) this; }
 	INulTimer              *nulTimer() { return (INulTimer*) this; }
+	IPacTimer              *pacTimer() { return (IPacTimer*) this; }
 
 	virtual const CRssiConfigParams *getConfigParams() const
 	{
@@ -680,7 +810,7 @@ protected:
 
 	void getAbsTime(CTimeout *to)
 	{
-		if ( clock_gettime( CLOCK_REALTIME, &to->tv_ ) )
+		if ( clock_gettime( CLOCK_MONOTONIC, &to->tv_ ) )
 			throw InternalError("clock_gettime failed");
 	}
 
@@ -88,11 +88,12 @@ void RssiHeader::dump(FILE *f, int hasPayload)
 char      pld = hasPayload > 0 ? 'P' : hasPayload < 0 ? '?' : '-';
 uint8_t flags = getFlags();
 
-		fprintf(f,"SEQ %d, ACK %d [%c%c%c%c%c%c]",
+		fprintf(f,"SEQ %d, ACK %d [%c%c%c%c%c%c%c]",
 			getSeqNo(),
 			getAckNo(),
 			(flags & RssiHeader::FLG_SYN) ? 'S':'-',
 			(flags & RssiHeader::FLG_ACK) ? 'A':'-',
+			(flags & RssiHeader::FLG_EAC) ? 'E':'-',
 			(flags & RssiHeader::FLG_BSY) ? 'B':'-',
 			(flags & RssiHeader::FLG_RST) ? 'R':'-',
 			(flags & RssiHeader::FLG_NUL) ? 'N':'-',
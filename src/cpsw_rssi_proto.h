@@ -118,6 +118,21 @@ public:
 		return (getFlags() & ~FLG_BSY) == FLG_ACK;
 	}
 
+	bool isEack()
+	{
+		return (getFlags() & ~FLG_BSY) == (FLG_ACK | FLG_EAC);
+	}
+
+	// Extended ACK: the sequence numbers of segments received
+	// out of order are listed between the (spare) bytes 4/5
+	// and the checksum. An odd count is padded by repeating
+	// the last entry (header size must be even).
+	static const unsigned EACK_OFF = 6;
+
+	unsigned getNumEacks()                  { return getHSize() - minHeaderSize(); }
+	uint8_t  getEack(unsigned i)            { return buf_[EACK_OFF + i];           }
+	void     setEack(unsigned i, uint8_t v) { buf_[EACK_OFF + i] = v;              }
+
 	// hasPayload: > 0 yes, == 0 no, < 0 unknown
 	void dump(FILE *f, int hasPayload = -1);
 
@@ -153,6 +168,7 @@ public:
 class RssiSynHeader : public RssiHeader {
 public:
 
+	const static uint8_t XFL_EAK = (1<<1); // sender supports EACK
 	const static uint8_t XFL_CHK = (1<<2);
 	const static uint8_t XFL_ONE = (1<<3);
 
@@ -43,6 +43,11 @@ void CRssi::STATE::processNulTimeout(CRssi *context)
 	throw InternalError("NULTimeout unexpected in this state");
 }
 
+void CRssi::STATE::processPaceTimeout(CRssi *context)
+{
+	// nothing to do unless OPEN
+}
+
 void CRssi::STATE::shutdown(CRssi *context)
 {
 }
@@ -128,6 +133,7 @@ void CRssi::NOTCLOSED::handleRxEvent(CRssi *context, IIntEventSource *src)
 BufChain bc;
 uint8_t  flags;
 bool     hasPayload;
+bool     outOfOrder = false;
 
 	if ( ! (bc = context->tryPopUpstream()) ) {
 		fprintf(CPSW::fErr(), "%s: SRC pending %d\n", context->getName(), src->isPending());
@@ -195,7 +201,15 @@ bool     hasPayload;
 		}
 
 		// clean out our outgoing buffer
-		context->processAckNumber( hdr.getFlags(), hdr.getAckNo() );
+		bool fastRex = context->processAckNumber( hdr.getFlags(), hdr.getAckNo(), hasPayload );
+
+		if ( (flags & RssiHeader::FLG_EAC) && context->eack_ ) {
+			context->processEack( hdr );
+		}
+
+		if ( fastRex && ! context->peerBSY_ ) {
+			context->fastRetransmit();
+		}
 
 		// cache the busy flag (header no longer valid further down);
 		bool peerNowBSY = !! (hdr.getFlags() & RssiHeader::FLG_BSY);
@@ -215,11 +229,31 @@ bool     hasPayload;
 				// AFTER THIS SEQUENCE OF OPERATIONS WE NO LONGER OWN THE BUFFER
 				// NOR THE INCLUDED HEADER, I.E., MUST CACHE HEADER VALUES USED
 				// THEREAFTER!
+				SeqNo seqNo    = hdr.getSeqNo();
+				SeqNo lastRecv = context->lastSeqRecv_;
+
 				b.reset();
-				context->unOrderedSegs_.store( hdr.getSeqNo(), bc );
+				context->unOrderedSegs_.store( seqNo, bc );
 
 				drainReassembleBuffer( context );
 
+				// filled a gap -> ACK immediately; the (pacing)
+				// peer is recovering from a loss. Done only with
+				// pacing so the default behaviour is unchanged.
+				if (    context->defaults_.txPacing_
+				     && (SeqNo)(context->lastSeqRecv_ - lastRecv) > 1 ) {
+					context->forceACK();
+				}
+
+				// still held behind a gap -> let the peer know
+				// immediately (we announce OsaMX = 0)
+				if (    context->eack_
+				     && context->unOrderedSegs_.canAccept( seqNo )
+				     && ! context->unOrderedSegs_.peek() ) {
+					outOfOrder = true;
+					context->forceACK();
+				}
+
 			} else {
 				// should not happen if the peer respects our max. unacked window
 				// but still could as a result of retransmissions...
@@ -260,7 +294,8 @@ bool     hasPayload;
 			BufChain b1 = hasBufToSend(context);
 			if ( b1 )
 				context->sendDAT( b1 );
-			else
+			// DAT does not carry the EACK list
+			if ( ! b1 || outOfOrder )
 				context->sendACK();
 #ifdef RSSI_DEBUG
 			if (cpsw_rssi_debug > 1 ) {
@@ -392,7 +427,7 @@ bool CRssi::CLNT_WAIT_SYN_ACK::handleSYN(CRssi *context, RssiSynHeader &synHdr)
 bool CRssi::NOTCLOSED::handleOTH(CRssi *context, RssiHeader &hdr, bool hasPayload)
 {
 
-	if ( hdr.isPureAck() && ! hasPayload ) {
+	if ( ( hdr.isPureAck() || hdr.isEack() ) && ! hasPayload ) {
 		// pure ACK uses LAST seq no;
 		// whereas 'canAccept()' below expects the next one.
 
@@ -449,6 +484,9 @@ void CRssi::NOTCLOSED::processRetransmissionTimeout(CRssi *context)
 
 	if ( (bc = *it) ) {
 		do {
+			// the peer already holds segments it has EACKed
+			if ( it.isSacked() )
+				continue;
 			context->stats_.rexSegments_++;
 #ifdef RSSI_DEBUG
 			if (cpsw_rssi_debug > 2 ) {
@@ -479,7 +517,12 @@ void CRssi::OPEN::processNulTimeout(CRssi *context)
 
 void CRssi::OPEN::handleUsrInputEvent(CRssi *context, IIntEventSource *src)
 {
-	while ( context->unAckedSegs_.getSize() < context->peerOssMX_ ) {
+	while ( context->unAckedSegs_.getSize() < context->getTxWindow() ) {
+		if ( ! context->txPaceOk() ) {
+			// re-enabled when the pacing timer expires
+			context->usrIEH()->disable();
+			return;
+		}
 		BufChain b = context->inpQ_->tryPop();
 		if ( ! b )
 			return;
@@ -565,7 +608,7 @@ BufChain bc;
 void CRssi::OPEN_OUTWIN_FULL::handleRxEvent(CRssi *context, IIntEventSource *src)
 {
 	CRssi::OPEN::handleRxEvent(context, src);
-	if ( context->unAckedSegs_.getSize() < context->peerOssMX_ ) {
+	if ( context->unAckedSegs_.getSize() < context->getTxWindow() ) {
 		// can accept output again
 		context->usrIEH()->enable();
 		context->changeState( &context->stateOPEN );
@@ -573,6 +616,16 @@ void CRssi::OPEN_OUTWIN_FULL::handleRxEvent(CRssi *context, IIntEventSource *src
 }
 
 
+void CRssi::OPEN::processPaceTimeout(CRssi *context)
+{
+	context->usrIEH()->enable();
+}
+
+void CRssi::OPEN_OUTWIN_FULL::processPaceTimeout(CRssi *context)
+{
+	// input is re-enabled once the window opens
+}
+
 void CRssi::OPEN::processAckTimeout(CRssi *context)
 {
 BufChain bc = hasBufToSend(context);
@@ -596,7 +649,7 @@ BufChain CRssi::NOTCLOSED::hasBufToSend(CRssi *context)
 BufChain CRssi::OPEN::hasBufToSend(CRssi *context)
 {
 BufChain bc;
-	if ( context->unAckedSegs_.getSize() < context->peerOssMX_ )
+	if ( context->unAckedSegs_.getSize() < context->getTxWindow() && context->txPaceOk() )
 		bc = context->inpQ_->tryPop();
 	return bc;
 }
@@ -263,6 +263,24 @@ public:
 		return postConstruct( p );
 	}
 
+	template <typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8>
+	static T create(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7, A8 a8)
+	{
+	Key k;
+	typename T::element_type *p = new typename T::element_type( k, a1, a2, a3, a4, a5, a6, a7, a8 );
+
+		return postConstruct( p );
+	}
+
+	template <typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6, typename A7, typename A8, typename A9>
+	static T create(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7, A8 a8, A9 a9)
+	{
+	Key k;
+	typename T::element_type *p = new typename T::element_type( k, a1, a2, a3, a4, a5, a6, a7, a8, a9 );
+
+		return postConstruct( p );
+	}
+
 };
 
 #endif
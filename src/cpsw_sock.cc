@@ -13,9 +13,12 @@
 
 #include <sys/socket.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <limits.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include <socks/libSocks.h>
 
 CSockSd::SA::SA()
@@ -156,6 +159,20 @@ void CSockSd::init(struct sockaddr_in *dest, struct sockaddr_in *me_p, bool nblk
 		throw IOError("setsockopt(SO_REUSEADDR) ", errno);
 	}
 
+#ifdef SO_TIMESTAMPNS
+	// kernel (software) receive timestamps; not essential
+	optval = 1;
+	::setsockopt( sd_, SOL_SOCKET, SO_TIMESTAMPNS, &optval, sizeof(optval) );
+#endif
+
+#ifdef SO_RXQ_OVFL
+	// report datagrams dropped by the kernel; not essential
+	if ( SOCK_DGRAM == type_ ) {
+		optval = 1;
+		::setsockopt( sd_, SOL_SOCKET, SO_RXQ_OVFL, &optval, sizeof(optval) );
+	}
+#endif
+
 #ifdef USE_TCP_NODELAY
 	optval = 1;
 	if ( SOCK_STREAM == type_ ) {
@@ -197,3 +214,273 @@ CSockSd::~CSockSd()
 	if ( dest_ )
 		delete dest_;
 }
+
+void
+CSockSd::setBufSize(int sd, bool rx, unsigned bytes)
+{
+int optval = bytes;
+
+#if defined(SO_RCVBUFFORCE) && defined(SO_SNDBUFFORCE)
+	if ( 0 == ::setsockopt( sd, SOL_SOCKET, rx ? SO_RCVBUFFORCE : SO_SNDBUFFORCE, &optval, sizeof(optval) ) ) {
+		return;
+	}
+	// not permitted; the kernel clips to the system limit
+#endif
+	if ( ::setsockopt( sd, SOL_SOCKET, rx ? SO_RCVBUF : SO_SNDBUF, &optval, sizeof(optval) ) ) {
+		throw IOError( rx ? "setsockopt(SO_RCVBUF) " : "setsockopt(SO_SNDBUF) ", errno );
+	}
+}
+
+unsigned
+CSockSd::getBufSize(int sd, bool rx)
+{
+int       optval = 0;
+socklen_t optlen = sizeof(optval);
+
+	if ( ::getsockopt( sd, SOL_SOCKET, rx ? SO_RCVBUF : SO_SNDBUF, &optval, &optlen ) ) {
+		throw IOError( rx ? "getsockopt(SO_RCVBUF) " : "getsockopt(SO_SNDBUF) ", errno );
+	}
+	return optval;
+}
+
+ssize_t
+CSockSd::recvInfo(int sd, struct iovec *iov, unsigned niovs, int flags, CSockRxInfo *info, struct sockaddr_in *from)
+{
+struct msghdr   msg;
+ssize_t         got;
+union {
+	struct cmsghdr  align;
+	char            buf[RX_CTRL_SIZE];
+}               ctl;
+
+	memset( &msg, 0, sizeof(msg) );
+	msg.msg_name       = from;
+	msg.msg_namelen    = from ? sizeof(*from) : 0;
+	msg.msg_iov        = iov;
+	msg.msg_iovlen     = niovs;
+	msg.msg_control    = ctl.buf;
+	msg.msg_controllen = sizeof(ctl.buf);
+
+	info->hasTs_    = false;
+	info->hasDrops_ = false;
+	info->gsoSize_  = 0;
+
+	if ( (got = ::recvmsg( sd, &msg, flags )) < 0 ) {
+		return got;
+	}
+
+	parseRxInfo( &msg, info );
+
+	return got;
+}
+
+void
+CSockSd::parseRxInfo(struct msghdr *msg, CSockRxInfo *info)
+{
+struct cmsghdr *cmsg;
+
+	info->hasTs_    = false;
+	info->hasDrops_ = false;
+
+	info->gsoSize_  = 0;
+
+	for ( cmsg = CMSG_FIRSTHDR( msg ); cmsg; cmsg = CMSG_NXTHDR( msg, cmsg ) ) {
+#ifdef UDP_GRO
+		if ( SOL_UDP == cmsg->cmsg_level && UDP_GRO == cmsg->cmsg_type ) {
+		int gsoSize;
+			memcpy( &gsoSize, CMSG_DATA( cmsg ), sizeof(gsoSize) );
+			info->gsoSize_ = gsoSize;
+			continue;
+		}
+#endif
+		if ( SOL_SOCKET != cmsg->cmsg_level )
+			continue;
+#ifdef SO_TIMESTAMPNS
+		if ( SCM_TIMESTAMPNS == cmsg->cmsg_type ) {
+			memcpy( &info->ts_, CMSG_DATA( cmsg ), sizeof(info->ts_) );
+			info->hasTs_ = true;
+		}
+#endif
+#ifdef SO_RXQ_OVFL
+		if ( SO_RXQ_OVFL == cmsg->cmsg_type ) {
+			memcpy( &info->drops_, CMSG_DATA( cmsg ), sizeof(info->drops_) );
+			info->hasDrops_ = true;
+		}
+#endif
+	}
+}
+
+bool
+CSockSd::setUdpGro(int sd)
+{
+#ifdef UDP_GRO
+int optval = 1;
+	return 0 == ::setsockopt( sd, SOL_UDP, UDP_GRO, &optval, sizeof(optval) );
+#else
+	return false;
+#endif
+}
+
+bool
+CSockSd::hasUdpGso(int sd)
+{
+#ifdef UDP_SEGMENT
+int optval = 0;
+	// setting the (default) segment size to zero is harmless and
+	// fails if the kernel does not know the option
+	return 0 == ::setsockopt( sd, SOL_UDP, UDP_SEGMENT, &optval, sizeof(optval) );
+#else
+	return false;
+#endif
+}
+
+CSockRxBufs::CSockRxBufs(size_t capa)
+: capa_   ( capa ),
+  segSize_( 0    )
+{
+	layout( 0 );
+}
+
+void
+CSockRxBufs::setCapacity(size_t capa)
+{
+	capa_ = capa;
+	layout( segSize_ );
+}
+
+// Lay out the scatter list so that it can hold 'capa_' bytes; if
+// 'segSize' is nonzero then every datagram of 'segSize' bytes
+// ends on a buffer boundary.
+void
+CSockRxBufs::layout(unsigned segSize)
+{
+size_t   cap, chunk, left;
+unsigned idx;
+
+	for ( idx = 0, cap = 0, left = segSize; cap < capa_; idx++ ) {
+		if ( idx >= bufs_.size() ) {
+			bufs_.push_back( IBuf::getBuf( IBuf::CAPA_ETH_BIG ) );
+		}
+		chunk = bufs_[idx]->getAvail();
+		if ( segSize ) {
+			if ( chunk >= left ) {
+				chunk = left;
+				left  = segSize;
+			} else {
+				left -= chunk;
+			}
+		}
+		if ( idx >= iov_.size() ) {
+			iov_.push_back( iovec() );
+		}
+		iov_[idx].iov_base = bufs_[idx]->getPayload();
+		iov_[idx].iov_len  = chunk;
+		cap               += chunk;
+	}
+
+	if ( segSize && idx > IOV_MAX ) {
+		// tiny datagrams; use the default layout (and copy)
+		layout( 0 );
+		return;
+	}
+
+	bufs_.resize( idx );
+	iov_.resize( idx );
+	segSize_ = segSize;
+}
+
+ssize_t
+CSockRxBufs::receive(int sd, int flags, struct sockaddr_in *from)
+{
+	return CSockSd::recvInfo( sd, &iov_[0], iov_.size(), flags, &info_, from );
+}
+
+// move 'got' bytes (starting at buffer '*idx_p') into a chain
+// and replace the buffers that were used up
+BufChain
+CSockRxBufs::take(unsigned *idx_p, ssize_t got)
+{
+BufChain bufch = IBufChain::create();
+ssize_t  siz, cap;
+unsigned idx;
+
+	siz = got;
+	idx = *idx_p;
+	while ( siz > 0 ) {
+		if ( siz < (cap = iov_[idx].iov_len) ) {
+			cap = siz;
+		}
+		bufs_[idx]->setSize( cap );
+
+		bufch->addAtTail( bufs_[idx] );
+
+		// get new buffers; they all have the same capacity
+		// and the layout remains valid
+		bufs_[idx] = IBuf::getBuf( IBuf::CAPA_ETH_BIG );
+		iov_[idx].iov_base = bufs_[idx]->getPayload();
+		idx++;
+		siz -= cap;
+	}
+	if ( info_.hasTs_ ) {
+		bufch->setRxTimestamp( &info_.ts_ );
+	}
+	*idx_p = idx;
+	return bufch;
+}
+
+BufChain
+CSockRxBufs::harvest(ssize_t got)
+{
+unsigned idx = 0;
+BufChain bufch = take( &idx, got );
+
+	info_.hasTs_ = false;
+	return bufch;
+}
+
+unsigned
+CSockRxBufs::harvest(ssize_t got, std::vector<BufChain> *dgrams)
+{
+unsigned seg = info_.gsoSize_;
+unsigned idx, n;
+ssize_t  off, len;
+
+	if ( getNumDgrams( got ) < 2 ) {
+		dgrams->push_back( harvest( got ) );
+		return 1;
+	}
+
+	if ( seg == segSize_ ) {
+		// datagram boundaries coincide with buffer boundaries
+		for ( idx = 0, off = 0, n = 0; off < got; off += len, n++ ) {
+			len = got - off < (ssize_t)seg ? got - off : seg;
+			dgrams->push_back( take( &idx, len ) );
+		}
+		info_.hasTs_ = false;
+		return n;
+	}
+
+	// first coalesced message (or the segment size changed);
+	// copy and adapt the layout for the next one
+	{
+	BufChain             all = harvest( got );
+	std::vector<uint8_t> tmp( seg );
+	struct timespec      ts;
+	bool                 hasTs = all->getRxTimestamp( &ts );
+
+		for ( off = 0, n = 0; off < got; off += len, n++ ) {
+			len = got - off < (ssize_t)seg ? got - off : seg;
+			BufChain bufch = IBufChain::create();
+			all->extract( &tmp[0], off, len );
+			bufch->insert( &tmp[0], 0, len, IBuf::CAPA_ETH_BIG );
+			if ( hasTs ) {
+				bufch->setRxTimestamp( &ts );
+			}
+			dgrams->push_back( bufch );
+		}
+	}
+
+	layout( seg );
+
+	return n;
+}
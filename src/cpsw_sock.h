@@ -12,13 +12,32 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <stdint.h>
 #include <cpsw_compat.h>
+#include <cpsw_buf.h>
+
+#include <vector>
 
 class CSockSd;
 typedef shared_ptr<CSockSd> SockSd;
 
 struct LibSocksProxy;
 
+// Ancillary data picked up by CSockSd::recvInfo()
+struct CSockRxInfo {
+	struct timespec ts_;       // kernel receive timestamp (CLOCK_REALTIME)
+	bool            hasTs_;
+	uint32_t        drops_;    // datagrams dropped by the kernel (SO_RXQ_OVFL; cumulative)
+	bool            hasDrops_;
+	unsigned        gsoSize_;  // size of coalesced datagrams (UDP_GRO); 0 if not coalesced
+
+	CSockRxInfo() : hasTs_(false), drops_(0), hasDrops_(false), gsoSize_(0) {}
+};
+
 class CSockSd {
 private:
 	// Wrapper class to get a default constructor
@@ -61,6 +80,99 @@ public:
 	virtual void reconnect();
 
 	virtual int getMTU();
+
+	// set the socket's receive ('rx') or send buffer size;
+	// SO_RCVBUFFORCE/SO_SNDBUFFORCE are tried first so that
+	// privileged processes may exceed the system limits.
+	static void     setBufSize(int sd, bool rx, unsigned bytes);
+	// RETURNS the size reported by the kernel (which
+	// includes bookkeeping overhead)
+	static unsigned getBufSize(int sd, bool rx);
+
+	// recvmsg() into 'iov' and pick up the ancillary data
+	// (and the source address if 'from' is non-NULL).
+	// RETURNS what recvmsg() returns (errno is preserved).
+	static ssize_t  recvInfo(int sd, struct iovec *iov, unsigned niovs, int flags, CSockRxInfo *info, struct sockaddr_in *from = NULL);
+
+	// space for the ancillary data picked up by 'recvInfo'
+	static const unsigned RX_CTRL_SIZE = 128;
+
+	// extract the receive timestamp and drop count from
+	// the ancillary data of a message received by other
+	// means (e.g., io_uring)
+	static void     parseRxInfo(struct msghdr *msg, CSockRxInfo *info);
+
+	// UDP segmentation offload: let the kernel coalesce
+	// received datagrams (UDP_GRO). RETURNS 'false' if
+	// not supported.
+	static bool     setUdpGro(int sd);
+	// RETURNS 'true' if the kernel supports UDP_SEGMENT
+	// (transmit segmentation) on 'sd'
+	static bool     hasUdpGso(int sd);
+
+	// max. number of datagrams/bytes of a UDP_SEGMENT send
+	static const unsigned GSO_MAX_SEGS  = 64;
+	static const unsigned GSO_MAX_BYTES = 65507;
 };
 
+// Receive buffers for a single datagram (scatter list)
+//
+// If the kernel coalesces datagrams (UDP_GRO) then a message
+// holds several datagrams of 'gsoSize_' bytes (the last one
+// may be shorter). Once such a message was seen the lengths
+// of the scatter list are chosen so that datagram boundaries
+// coincide with buffer boundaries (assuming the size does not
+// change) and splitting the message requires no copying.
+class CSockRxBufs {
+private:
+	std::vector<Buf>          bufs_;
+	std::vector<struct iovec> iov_;
+	size_t                    capa_;
+	unsigned                  segSize_;  // layout of 'iov_'
+	CSockRxInfo               info_;
+
+	CSockRxBufs(const CSockRxBufs&);
+	CSockRxBufs & operator=(const CSockRxBufs&);
+
+	void          layout(unsigned segSize);
+	BufChain      take(unsigned *idx_p, ssize_t got);
+
+public:
+	// 'capa': max. size of a message; use IBuf::CAPA_MAX
+	// with UDP_GRO
+	CSockRxBufs(size_t capa = IBuf::CAPA_ETH_JUM);
+
+	void          setCapacity(size_t capa);
+
+	struct iovec *getIov()     { return &iov_[0];    }
+	unsigned      getNumIovs() { return iov_.size(); }
+
+	// receive a datagram from 'sd' into the buffers,
+	// recording the kernel receive timestamp and drop count
+	// (and the sender's address if 'from' is non-NULL)
+	ssize_t       receive(int sd, int flags = 0, struct sockaddr_in *from = NULL);
+
+	// return the first 'got' (> 0) bytes as a chain
+	// (carrying the receive timestamp) and replace the
+	// buffers that were used up
+	BufChain      harvest(ssize_t got);
+
+	// number of datagrams held by the last message
+	// ('got' bytes) received; more than one if they
+	// were coalesced by the kernel
+	unsigned      getNumDgrams(ssize_t got) const
+	{
+		return info_.gsoSize_ && got > (ssize_t)info_.gsoSize_ ? (got + info_.gsoSize_ - 1)/info_.gsoSize_ : 1;
+	}
+
+	// split the first 'got' (> 0) bytes into one chain
+	// per datagram and append them to 'dgrams'
+	// RETURNS the number of chains appended.
+	unsigned      harvest(ssize_t got, std::vector<BufChain> *dgrams);
+
+	const CSockRxInfo *getInfo() const { return &info_; }
+	CSockRxInfo       *getInfo()       { return &info_; }
+};
+
+
 #endif
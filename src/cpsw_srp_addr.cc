@@ -114,6 +114,11 @@ CSRPAddressImpl::CSRPAddressImpl(AKey key, ProtoStackBuilder bldr, ProtoPort sta
                    ),
   asyncXactMgr_   ( IAsyncIOTransactionManager::create( usrTimeout_.getUs() )                      ),
   asyncIOHandler_ ( asyncXactMgr_, this                                                            ),
+  busyPollUs_     ( bldr->getSRPBusyPollUS()                                                       ),
+  rxPoller_       ( 0                                                                              ),
+  nBusyPollHits_  ( 0                                                                              ),
+  nBusyPollMiss_  ( 0                                                                              ),
+  nRxTsRtt_       ( 0                                                                              ),
   mutex_          ( CMtx::AttrRecursive(), "SRPADDR"                                               )
 {
 ProtoModSRPMux       srpMuxMod( dynamic_pointer_cast<ProtoModSRPMux::element_type>( stack->getProtoMod() ) );
@@ -138,6 +143,22 @@ int                  nbits;
 	tidMsk_ = (nbits > 31 ? 0xffffffff : ( (1<<nbits) - 1 ) ) << srpMuxMod->getTidLsb();
 
 	asyncIOPort_ = srpMuxMod->createPort( vc_ | 0x80, bldr->getSRPMuxOutQueueDepth() );
+
+	// busy-polling is only useful if the demultiplexer sits right on top of
+	// a transport which supports it (replies are then dispatched by the
+	// caller itself)
+	if ( busyPollUs_ ) {
+		ProtoMod xprt( srpMuxMod->getUpstreamProtoMod() );
+		if ( xprt && (rxPoller_ = dynamic_cast<IRxPoller*>( xprt.get() )) ) {
+			rxPoller_->setBusyPoll( busyPollUs_ );
+		} else {
+			busyPollUs_ = 0;
+		}
+	}
+
+	// the async handler runs with the same attributes as the SRP demultiplexer
+	asyncIOHandler_.setCpuAffinity( srpMuxMod->getCpuAffinity() );
+	asyncIOHandler_.setSchedPolicy( srpMuxMod->getSchedPolicy() );
 }
 
 void
@@ -190,6 +211,9 @@ CSRPAddressImpl::dumpYamlPart(YAML::Node &node) const
 	writeNode(srpParms, YAML_KEY_dynTimeout      , useDynTimeout_     );
 	writeNode(srpParms, YAML_KEY_retryCount      , retryCnt_          );
 	writeNode(srpParms, YAML_KEY_defaultWriteMode, defaultWriteMode_  );
+	if ( busyPollUs_ ) {
+		writeNode(srpParms, YAML_KEY_busyPollUS  , busyPollUs_        );
+	}
 	writeNode(node, YAML_KEY_SRP, srpParms);
 }
 
@@ -241,7 +265,7 @@ static void time_retry(struct timespec *then, int attempt, const char *pre, Prot
 {
 struct timespec now;
 
-	if ( clock_gettime(CLOCK_REALTIME, &now) ) {
+	if ( clock_gettime(CLOCK_MONOTONIC, &now) ) {
 		throw IOError("clock_gettime(time_retry) failed", errno);
 	}
 	if ( attempt > 0 ) {
@@ -253,6 +277,32 @@ struct timespec now;
 }
 #endif
 
+// Use the kernel receive timestamp of a reply (if any) as its
+// arrival time so that RX thread and queueing latencies do not
+// inflate the round-trip estimate. The timestamp is CLOCK_REALTIME;
+// translate by subtracting its age from (monotonic) 'now' and
+// keep the result within [then, now].
+void
+CSRPAddressImpl::rxArrival(BufChain rchn, struct timespec *now, const struct timespec *then) const
+{
+struct timespec rxTs, real;
+CTimeout        arr;
+
+	if ( ! rchn->getRxTimestamp( &rxTs ) || clock_gettime( CLOCK_REALTIME, &real ) ) {
+		return;
+	}
+	if ( CTimeout( real ) < CTimeout( rxTs ) ) {
+		// clock was stepped
+		return;
+	}
+	arr = CTimeout( *now ) - ( CTimeout( real ) - CTimeout( rxTs ) );
+	if ( arr < CTimeout( *then ) ) {
+		arr = CTimeout( *then );
+	}
+	*now = arr.tv_;
+	nRxTsRtt_++;
+}
+
 #define CMD_WRITE 0x40000000
 
 #define CMD_READ_V3         0x000
@@ -279,6 +329,41 @@ unsigned tidOff = getProtoVersion() == IProtoStackBuilder::SRP_UDP_V2 ? 0 : 4;
 	return toTid( msgTid );
 }
 
+// Spin (polling the transport ourselves) for up to 'busyPollUs_'
+// before blocking for the remainder of the timeout.
+BufChain CSRPAddressImpl::popReply() const
+{
+BufChain        rchn;
+struct timespec then, now;
+uint64_t        tmo, spin, el;
+
+	if ( ! rxPoller_ ) {
+		return door_->pop( dynTimeout_.getp(), IProtoPort::REL_TIMEOUT );
+	}
+
+	tmo  = dynTimeout_.get().getUs();
+	spin = busyPollUs_ < tmo ? busyPollUs_ : tmo;
+
+	clock_gettime( CLOCK_MONOTONIC, &then );
+	do {
+		if ( (rchn = door_->tryPop()) ) {
+			nBusyPollHits_++;
+			return rchn;
+		}
+		rxPoller_->pollRx();
+		clock_gettime( CLOCK_MONOTONIC, &now );
+		el = (CTimeout( now ) - CTimeout( then )).getUs();
+	} while ( el < spin );
+
+	nBusyPollMiss_++;
+
+	if ( el >= tmo ) {
+		return door_->tryPop();
+	}
+	CTimeout rem( tmo - el );
+	return door_->pop( &rem, IProtoPort::REL_TIMEOUT );
+}
+
 uint64_t CSRPAddressImpl::readBlk_unlocked(IField::Cacheable cacheable, uint8_t *dst, uint64_t off, unsigned sbytes, AsyncIO aio) const
 {
 SRPAsyncReadTransaction xact = srpReadTransactionPool.alloc();
@@ -318,13 +403,13 @@ struct timespec retry_then;
 		xact.post( door_, mtu_ );
 
 		struct timespec then, now;
-		if ( clock_gettime(CLOCK_REALTIME, &then) ) {
+		if ( clock_gettime(CLOCK_MONOTONIC, &then) ) {
 			throw IOError("clock_gettime(then) failed", errno);
 		}
 
 		do {
 
-			rchn = door_->pop( dynTimeout_.getp(), IProtoPort::REL_TIMEOUT );
+			rchn = popReply();
 			if ( ! rchn ) {
 #ifdef SRPADDR_DEBUG
 				time_retry( &retry_then, attempt, "READ", door_ );
@@ -332,7 +417,7 @@ struct timespec retry_then;
 				goto retry;
 			}
 
-			if ( clock_gettime(CLOCK_REALTIME, &now) ) {
+			if ( clock_gettime(CLOCK_MONOTONIC, &now) ) {
 				throw IOError("clock_gettime(now) failed", errno);
 			}
 
@@ -340,8 +425,10 @@ struct timespec retry_then;
 
 		} while ( ! tidMatch( tidBits , xact.getTid() ) );
 
-		if ( useDynTimeout_ )
+		if ( useDynTimeout_ ) {
+			rxArrival( rchn, &now, &then );
 			dynTimeout_.update( &now, &then );
+		}
 
 		xact.complete( rchn );
 
@@ -765,7 +852,7 @@ int      posted   = (    POSTED        == defaultWriteMode_
 
 		BufChain rchn;
 		struct timespec then, now;
-		if ( clock_gettime(CLOCK_REALTIME, &then) ) {
+		if ( clock_gettime(CLOCK_MONOTONIC, &then) ) {
 			throw IOError("clock_gettime(then) failed", errno);
 		}
 
@@ -775,7 +862,7 @@ int      posted   = (    POSTED        == defaultWriteMode_
 			return dbytes;
 
 		do {
-			rchn = door_->pop( dynTimeout_.getp(), IProtoPort::REL_TIMEOUT );
+			rchn = popReply();
 			if ( ! rchn ) {
 #ifdef SRPADDR_DEBUG
 				time_retry( &retry_then, attempt, "WRITE", door_ );
@@ -783,14 +870,16 @@ int      posted   = (    POSTED        == defaultWriteMode_
 				goto retry;
 			}
 
-			if ( clock_gettime(CLOCK_REALTIME, &now) ) {
+			if ( clock_gettime(CLOCK_MONOTONIC, &now) ) {
 				throw IOError("clock_gettime(now) failed", errno);
 			}
 
 		} while ( ! tidMatch( extractTid( rchn ), tid ) );
 
-		if ( useDynTimeout_ )
+		if ( useDynTimeout_ ) {
+			rxArrival( rchn, &now, &then );
 			dynTimeout_.update( &now, &then );
+		}
 
 		xact.complete( rchn );
 
@@ -851,6 +940,12 @@ unsigned nWords;
 
 }
 
+void CSRPAddressImpl::getThreads(std::vector<CRunnable*> *threads) const
+{
+	CCommAddressImpl::getThreads( threads );
+	threads->push_back( const_cast<CSRPAsyncHandler&>( asyncIOHandler_ ).getRunnable() );
+}
+
 void CSRPAddressImpl::dump(FILE *f) const
 {
 	fprintf(f,"CSRPAddressImpl:\n");
@@ -870,6 +965,13 @@ void CSRPAddressImpl::dump(FILE *f) const
 	fprintf(f,"  # of reads  (OK)  : %8u\n",   nReads_);
 	fprintf(f,"  Virtual Channel   : %8u\n",   vc_);
 	fprintf(f,"  Async Messages    : %8u\n",   asyncIOHandler_.getMsgCount());
+	if ( busyPollUs_ ) {
+	fprintf(f,"  Busy-poll budget  : %8uus\n", busyPollUs_);
+	fprintf(f,"  Busy-poll hits    : %8u\n",   nBusyPollHits_);
+	fprintf(f,"  Busy-poll misses  : %8u\n",   nBusyPollMiss_);
+	}
+	if ( useDynTimeout_ )
+	fprintf(f,"  RTTs from RX tstmp: %8u\n",   nRxTsRtt_);
 	CCommAddressImpl::dump(f);
 }
 
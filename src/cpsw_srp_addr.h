@@ -71,6 +71,14 @@ public:
 		return CRunnable::threadStop();
 	}
 
+	using CRunnable::setCpuAffinity;
+	using CRunnable::setSchedPolicy;
+
+	CRunnable *getRunnable()
+	{
+		return this;
+	}
+
 	virtual ProtoDoor getDoor() const
 	{
 		return door_;
@@ -105,9 +113,20 @@ private:
 	ProtoPort                 asyncIOPort_;
 	AsyncIOTransactionManager asyncXactMgr_;
 	CSRPAsyncHandler          asyncIOHandler_;
+	unsigned                  busyPollUs_;
+	IRxPoller                *rxPoller_;
+	mutable unsigned          nBusyPollHits_;
+	mutable unsigned          nBusyPollMiss_;
+	mutable unsigned          nRxTsRtt_;
 
 	BufChain         assembleXBuf(struct srp_iovec *iov, unsigned iovlen, int iov_pld, int toput) const;
 
+	// wait for a reply (busy-polling first if enabled)
+	BufChain         popReply() const;
+
+	// replace 'now' by the reply's kernel receive time (if known)
+	void             rxArrival(BufChain rchn, struct timespec *now, const struct timespec *then) const;
+
 protected:
 	mutable CMtx     mutex_;
 	virtual uint64_t readBlk_unlocked(IField::Cacheable cacheable, uint8_t *dst, uint64_t off, unsigned sbytes, AsyncIO aio) const;
@@ -121,7 +140,12 @@ public:
 	: CCommAddressImpl(orig, k),
 	  dynTimeout_(orig.dynTimeout_.get()),
 	  nRetries_(0),
-	  asyncIOHandler_( AsyncIOTransactionManager(), 0 )
+	  asyncIOHandler_( AsyncIOTransactionManager(), 0 ),
+	  busyPollUs_(0),
+	  rxPoller_(0),
+	  nBusyPollHits_(0),
+	  nBusyPollMiss_(0),
+	  nRxTsRtt_(0)
 	{
 		throw InternalError("Clone not implemented"); /* need to clone mutex, ... */
 	}
@@ -134,6 +158,9 @@ public:
 
 	virtual void dump(FILE *f) const;
 
+	// modules' threads plus the async handler
+	virtual void getThreads(std::vector<CRunnable*> *threads) const;
+
 	virtual void startUp();
 
 	virtual unsigned getAlignment()                      const;
@@ -0,0 +1,77 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#include <cpsw_stats.h>
+#include <cpsw_yaml.h>
+
+#include <inttypes.h>
+
+void
+CLatencyHistogram::record(const struct timespec *start)
+{
+struct timespec now_ts;
+int64_t         us;
+
+	now( &now_ts );
+
+	us = ( (int64_t)now_ts.tv_sec - (int64_t)start->tv_sec ) * 1000000
+	   + ( now_ts.tv_nsec - start->tv_nsec ) / 1000;
+
+	record( us < 0 ? 0 : (uint64_t)us );
+}
+
+uint64_t
+CLatencyHistogram::getCount() const
+{
+uint64_t rval = 0;
+unsigned bin;
+	for ( bin = 0; bin < NUM_BINS; bin++ )
+		rval += bins_[bin].get();
+	return rval;
+}
+
+void
+CLatencyHistogram::dumpYaml(YAML::Node &node) const
+{
+YAML::Node bins;
+unsigned   bin;
+uint64_t   cnt;
+
+	writeNode( node, "count", getCount() );
+	writeNode( node, "maxUs", getMaxUs() );
+
+	for ( bin = 0; bin < NUM_BINS; bin++ ) {
+		if ( (cnt = bins_[bin].get()) ) {
+			if ( bin == NUM_BINS - 1 ) {
+				writeNode( bins, "overflow", cnt );
+			} else {
+				bins[ (uint64_t)1 << bin ] = cnt;
+			}
+		}
+	}
+	writeNode( node, "binsUs", bins );
+}
+
+void
+CLatencyHistogram::dumpInfo(FILE *f, const char *indent) const
+{
+unsigned bin;
+uint64_t cnt;
+
+	fprintf(f, "%sLatency histogram (max %" PRIu64 "us):\n", indent, getMaxUs());
+	for ( bin = 0; bin < NUM_BINS; bin++ ) {
+		if ( (cnt = bins_[bin].get()) ) {
+			if ( bin == NUM_BINS - 1 ) {
+				fprintf(f, "%s  >= %8" PRIu64 "us: %10" PRIu64 "\n", indent, (uint64_t)1 << (bin - 1), cnt);
+			} else {
+				fprintf(f, "%s  <  %8" PRIu64 "us: %10" PRIu64 "\n", indent, (uint64_t)1 << bin, cnt);
+			}
+		}
+	}
+}
@@ -0,0 +1,139 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_STATS_H
+#define CPSW_STATS_H
+
+// Lock-free statistics counters for protocol modules.
+//
+// Every counter has a single writer (the module thread which
+// owns it) but may be sampled by any other thread without
+// locking. Updates are therefore implemented as relaxed
+// load/store pairs (no locked RMW on the fast path).
+
+#include <cpsw_compat.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+using cpsw::atomic;
+using cpsw::memory_order_relaxed;
+
+namespace YAML {
+	class Node;
+}
+
+class CStatCounter {
+private:
+	atomic<uint64_t> v_;
+
+	CStatCounter & operator=(const CStatCounter &);
+
+public:
+	CStatCounter()
+	: v_( 0 )
+	{
+	}
+
+	// a copy (e.g., of a cloned module) starts from zero
+	CStatCounter(const CStatCounter &)
+	: v_( 0 )
+	{
+	}
+
+	uint64_t get() const
+	{
+		return v_.load( memory_order_relaxed );
+	}
+
+	void add(uint64_t n)
+	{
+		v_.store( v_.load( memory_order_relaxed ) + n, memory_order_relaxed );
+	}
+
+	// record the current value of a gauge
+	void set(uint64_t n)
+	{
+		v_.store( n, memory_order_relaxed );
+	}
+
+	// record a high-water mark
+	void max(uint64_t n)
+	{
+		if ( n > v_.load( memory_order_relaxed ) )
+			v_.store( n, memory_order_relaxed );
+	}
+
+	void operator++(int)
+	{
+		add( 1 );
+	}
+
+	void operator+=(uint64_t n)
+	{
+		add( n );
+	}
+
+	operator uint64_t() const
+	{
+		return get();
+	}
+};
+
+// Histogram of latencies with power-of-two bins:
+// bin 0 counts latencies < 1us, bin n (n>0) counts
+// latencies in [2^(n-1), 2^n) us; the last bin
+// also collects everything beyond.
+class CLatencyHistogram {
+public:
+	static const unsigned NUM_BINS = 24;
+
+private:
+	CStatCounter bins_[NUM_BINS];
+	CStatCounter maxUs_;
+
+public:
+	// a (monotonic) timestamp to be passed to 'record()'
+	static void now(struct timespec *ts)
+	{
+		clock_gettime( CLOCK_MONOTONIC, ts );
+	}
+
+	void record(uint64_t us)
+	{
+	unsigned bin = 0;
+		maxUs_.max( us );
+		while ( us && bin < NUM_BINS - 1 ) {
+			us >>= 1;
+			bin++;
+		}
+		bins_[bin]++;
+	}
+
+	// record the time elapsed since 'start'
+	void record(const struct timespec *start);
+
+	uint64_t getBin(unsigned bin) const
+	{
+		return bin < NUM_BINS ? bins_[bin].get() : 0;
+	}
+
+	uint64_t getCount() const;
+
+	uint64_t getMaxUs() const
+	{
+		return maxUs_.get();
+	}
+
+	// lists only non-empty bins (keyed by their upper bound in us)
+	void dumpYaml(YAML::Node &) const;
+	void dumpInfo(FILE *f, const char *indent) const;
+};
+
+#endif
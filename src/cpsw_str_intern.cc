@@ -0,0 +1,233 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_str_intern.h>
+#include <cpsw_mutex.h>
+
+#include <string.h>
+#include <pthread.h>
+#include <vector>
+#include <map>
+
+// open addressing; a NULL 'str_' marks an empty slot
+struct CStrTabSlot {
+	uint32_t    hash_;
+	const char *str_;
+};
+
+class CStrTab {
+private:
+	static const size_t CHUNK_SIZE = 16384;
+
+	std::vector<CStrTabSlot>        slots_;
+	std::vector<char*>              chunks_;   // the strings
+	size_t                          chunkUsed_;
+	std::map<const char*, CString>  cstrings_; // shared copies (few)
+	unsigned                        nStrings_;
+	uint64_t                        strBytes_;
+	uint64_t                        savedBytes_;
+	CMtx                            mtx_;
+
+	static uint32_t hash(const char *str)
+	{
+	uint32_t h = 2166136261U;
+		while ( *str ) {
+			h ^= (uint8_t)*str++;
+			h *= 16777619U;
+		}
+		return h;
+	}
+
+	void grow()
+	{
+	std::vector<CStrTabSlot> old;
+	uint32_t                 mask, i;
+	unsigned                 j;
+
+		old.swap( slots_ );
+		slots_.resize( 2*old.size() );
+		mask = slots_.size() - 1;
+
+		for ( j = 0; j < old.size(); j++ ) {
+			if ( old[j].str_ ) {
+				for ( i = old[j].hash_ & mask; slots_[i].str_; i = (i + 1) & mask )
+					;
+				slots_[i] = old[j];
+			}
+		}
+	}
+
+	const char *store(const char *str, size_t l)
+	{
+	char *p;
+		if ( l + 1 > CHUNK_SIZE/4 ) {
+			// big ones get their own chunk (inserted before the current one)
+			p = new char[l + 1];
+			chunks_.insert( chunks_.end() - 1, p );
+			strBytes_ += l + 1;
+		} else {
+			if ( chunkUsed_ + l + 1 > CHUNK_SIZE ) {
+				chunks_.push_back( new char[CHUNK_SIZE] );
+				chunkUsed_  = 0;
+				strBytes_  += CHUNK_SIZE;
+			}
+			p           = chunks_.back() + chunkUsed_;
+			chunkUsed_ += l + 1;
+		}
+		memcpy( p, str, l + 1 );
+		return p;
+	}
+
+public:
+	CStrTab()
+	: slots_     ( 1024                    ),
+	  chunks_    ( 1, new char[CHUNK_SIZE] ),
+	  chunkUsed_ ( 0                       ),
+	  nStrings_  ( 0                       ),
+	  strBytes_  ( CHUNK_SIZE              ),
+	  savedBytes_( 0                       ),
+	  mtx_       ( "CStrIntern"            )
+	{
+	}
+
+	const char *find(const char *str)
+	{
+	uint32_t h    = hash( str );
+	uint32_t mask = slots_.size() - 1;
+	uint32_t i;
+	size_t   l    = strlen( str );
+
+		for ( i = h & mask; slots_[i].str_; i = (i + 1) & mask ) {
+			if ( slots_[i].hash_ == h && 0 == strcmp( slots_[i].str_, str ) ) {
+				savedBytes_ += l + 1;
+				return slots_[i].str_;
+			}
+		}
+
+		// keep the load <= 1/2
+		if ( 2*(nStrings_ + 1) > slots_.size() ) {
+			grow();
+			mask = slots_.size() - 1;
+			for ( i = h & mask; slots_[i].str_; i = (i + 1) & mask )
+				;
+		}
+
+		slots_[i].hash_ = h;
+		slots_[i].str_  = store( str, l );
+		nStrings_++;
+
+		return slots_[i].str_;
+	}
+
+	CString findCString(const char *str)
+	{
+	const char *p = find( str );
+	CString    &c = cstrings_[p];
+		if ( ! c ) {
+			c = CString( new std::string( p ) );
+		}
+		return c;
+	}
+
+	CMtx *getMtx()
+	{
+		return &mtx_;
+	}
+
+	unsigned getNumStrings() const
+	{
+		return nStrings_;
+	}
+
+	uint64_t getMemUsage() const
+	{
+		return   slots_.capacity()  * sizeof(CStrTabSlot)
+		       + chunks_.capacity() * sizeof(char*)
+		       + strBytes_
+		       // approx. (map node, string, control block)
+		       + cstrings_.size()   * ( sizeof(std::string) + 64 );
+	}
+
+	uint64_t getSavedBytes() const
+	{
+		return savedBytes_;
+	}
+};
+
+// never destroyed -- entries (and their names) may be
+// destroyed by static destructors
+static CStrTab        *theTab  = 0;
+static pthread_once_t  tabOnce = PTHREAD_ONCE_INIT;
+
+static void
+createTab()
+{
+	theTab = new CStrTab();
+}
+
+static CStrTab *
+getTab()
+{
+	pthread_once( &tabOnce, createTab );
+	return theTab;
+}
+
+const char *
+CStrIntern::intern(const char *str)
+{
+CStrTab  *t = getTab();
+CMtx::lg  GUARD( t->getMtx() );
+	return t->find( str );
+}
+
+CString
+CStrIntern::internCString(const char *str)
+{
+CStrTab  *t = getTab();
+CMtx::lg  GUARD( t->getMtx() );
+	return t->findCString( str );
+}
+
+unsigned
+CStrIntern::getNumStrings()
+{
+CStrTab  *t = getTab();
+CMtx::lg  GUARD( t->getMtx() );
+	return t->getNumStrings();
+}
+
+uint64_t
+CStrIntern::getMemUsage()
+{
+CStrTab  *t = getTab();
+CMtx::lg  GUARD( t->getMtx() );
+	return t->getMemUsage();
+}
+
+uint64_t
+CStrIntern::getSavedBytes()
+{
+CStrTab  *t = getTab();
+CMtx::lg  GUARD( t->getMtx() );
+	return t->getSavedBytes();
+}
+
+void
+CStrIntern::dumpInfo(FILE *f)
+{
+CStrTab  *t = getTab();
+CMtx::lg  GUARD( t->getMtx() );
+	fprintf(f, "CStrIntern:\n");
+	fprintf(f, "  Strings   : %15u\n",   t->getNumStrings());
+	fprintf(f, "  Mem usage : %15" PRIu64 "\n", t->getMemUsage());
+	fprintf(f, "  Saved     : %15" PRIu64 "\n", t->getSavedBytes());
+}
@@ -0,0 +1,51 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_STR_INTERN_H
+#define CPSW_STR_INTERN_H
+
+#include <cpsw_api_user.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+
+// Process-wide table of interned strings (names, descriptions and
+// enum items). A hierarchy made of many replicated devices holds
+// the same few strings thousands of times; with interning every
+// distinct string is stored once and entries just keep a pointer.
+//
+// Interned strings are never released -- the table only grows by
+// the distinct strings ever used. Identical strings are mapped to
+// the identical pointer (may be compared with '==').
+//
+// All methods are thread-safe.
+
+class CStrIntern {
+public:
+	// RETURNS: pointer to the interned copy of 'str'
+	static const char *intern(const char *str);
+	static const char *intern(const std::string &str)
+	{
+		return intern( str.c_str() );
+	}
+
+	// shared copy for APIs which hand out a CString (enum items)
+	static CString     internCString(const char *str);
+
+	static unsigned    getNumStrings();
+	// bytes held by the table (including the strings)
+	static uint64_t    getMemUsage();
+	// bytes private copies would have taken
+	static uint64_t    getSavedBytes();
+
+	static void        dumpInfo(FILE *f);
+};
+
+#endif
@@ -25,6 +25,12 @@ CStreamAdapt::~CStreamAdapt()
 
 int64_t
 CStreamAdapt::read(uint8_t *buf, uint64_t size, const CTimeout timeout, uint64_t off)
+{
+	return read( buf, size, timeout, off, 0 );
+}
+
+int64_t
+CStreamAdapt::read(uint8_t *buf, uint64_t size, const CTimeout timeout, uint64_t off, struct timespec *rxTimestamp)
 {
 	CompositePathIterator it( p_);
 	Address cl = it->c_p_;
@@ -35,6 +41,11 @@ CStreamAdapt::read(uint8_t *buf, uint64_t size, const CTimeout timeout, uint64_t
 	args.nbytes_    = size;
 	args.off_       = off;
 	args.timeout_   = timeout;
+	args.rxTs_      = rxTimestamp;
+	if ( rxTimestamp ) {
+		rxTimestamp->tv_sec  = 0;
+		rxTimestamp->tv_nsec = 0;
+	}
 	return cl->read( &it, &args );
 }
 
@@ -21,6 +21,8 @@ public:
 
 	virtual int64_t read(uint8_t *buf, uint64_t size, const CTimeout timeout, uint64_t off);
 
+	virtual int64_t read(uint8_t *buf, uint64_t size, const CTimeout timeout, uint64_t off, struct timespec *rxTimestamp);
+
 	virtual int64_t write(uint8_t *buf, uint64_t size, const CTimeout timeout);
 
 	virtual Encoding getEncoding() const;
@@ -409,7 +409,7 @@ CIntEntryImpl::createAdapter(IEntryAdapterKey &key, ConstPath p, const std::type
 }
 
 IIntEntryAdapt::IIntEntryAdapt(Key &k, ConstPath p, shared_ptr<const CIntEntryImpl> ie)
-: IEntryAdapt(k, p, ie), nelms_(-1)
+: IEntryAdapt(k, p, ie), nelms_(-1), plan_(p)
 {
 	open();
 }
@@ -896,8 +896,11 @@ public:
 
 unsigned IIntEntryAdapt::checkNelms(unsigned nelms, SlicedPathIterator *it)
 {
-unsigned nelmsOnPath  = (*it).getNelmsLeft();
+	return checkNelms( nelms, (*it).getNelmsLeft() );
+}
 
+unsigned IIntEntryAdapt::checkNelms(unsigned nelms, unsigned nelmsOnPath)
+{
 	if ( nelms >= nelmsOnPath ) {
 		nelms = nelmsOnPath;
 	} else {
@@ -963,6 +966,62 @@ ByteOrder          targetEndian = cl->getByteOrder();
 
 }
 
+unsigned IIntEntryAdapt::getVal(AsyncIO aio, uint8_t *buf, unsigned nelms, unsigned elsz, IndexRange *range)
+{
+CAccessPlan::Slice slice;
+
+	if ( ! plan_.slice( range, &slice ) ) {
+		SlicedPathIterator it( p_, range );
+		return getVal( aio, buf, nelms, elsz, &it );
+	}
+
+	nelms = checkNelms( nelms, slice.getNelms() );
+
+	CReadArgs args;
+
+	shared_ptr<CGetIntValContext> ctxt = cpsw::make_shared<CGetIntValContext> (
+	                                             getSelfAs<IntEntryAdapt>(),
+	                                             buf,
+	                                             nelms,
+	                                             elsz,
+	                                             plan_.getByteOrder(),
+	                                             aio );
+	args.cacheable_ = ie_->getCacheable();
+	args.off_       = 0;
+	args.aio_       = ctxt;
+
+	ctxt->getReadParms( &args );
+
+	plan_.read( &slice, &args );
+
+	return nelms;
+}
+
+unsigned IIntEntryAdapt::getVal(uint8_t *buf, unsigned nelms, unsigned elsz, IndexRange *range)
+{
+CAccessPlan::Slice slice;
+
+	if ( ! plan_.slice( range, &slice ) ) {
+		SlicedPathIterator it( p_, range );
+		return getVal( buf, nelms, elsz, &it );
+	}
+
+	nelms = checkNelms( nelms, slice.getNelms() );
+
+	CReadArgs args;
+
+	CGetIntValContext ctxt( getSelfAs<IntEntryAdapt>(), buf, nelms, elsz, plan_.getByteOrder() );
+
+	args.cacheable_ = ie_->getCacheable();
+	args.off_       = 0;
+	ctxt.getReadParms( &args );
+
+	plan_.read( &slice, &args );
+
+	ctxt.callback( 0 );
+	return nelms;
+}
+
 class CGetStringValContext : public CGetValContext {
 private:
 	uint8_t       *buf_;
@@ -1180,8 +1239,8 @@ static void prib(const char *pre, uint8_t *b)
 
 unsigned IIntEntryAdapt::setVal(uint8_t *buf, unsigned nelms, unsigned elsz, IndexRange *range)
 {
-SlicedPathIterator   it( p_, range );
-Address          cl = it->c_p_;
+CAccessPlan::Slice slice;
+bool             usePlan  = plan_.slice( range, &slice );
 uint64_t         off = 0;
 unsigned         dbytes   = getSize(); // byte-size including lsb shift
 uint64_t         sizeBits = getSizeBits();
@@ -1189,16 +1248,23 @@ unsigned         nbytes   = (sizeBits + 7)/8;  // byte-size w/o lsb shift
 unsigned         sbytes   = elsz;
 int              lsb      = getLsBit();
 ByteOrder        hostEndian= hostByteOrder();
-ByteOrder        targetEndian = cl->getByteOrder();
+ByteOrder        targetEndian;
 uint8_t          msk1     = 0x00;
 uint8_t          mskn     = 0x00;
 
+	if ( usePlan ) {
+		targetEndian = plan_.getByteOrder();
+		nelms        = checkNelms( nelms, slice.getNelms() );
+	} else {
+		SlicedPathIterator it( p_, range );
+		targetEndian = it->c_p_->getByteOrder();
+		nelms        = checkNelms( nelms, &it );
+	}
+
 	if ( NATIVE == targetEndian ) {
 		targetEndian = hostEndian;
 	}
 
-	nelms = checkNelms( nelms, &it );
-
 	bool sign_extend = sizeBits > 8*sbytes;
 	bool truncate    = sizeBits < 8*sbytes;
 	unsigned wlen    = getWordSwap();
@@ -1312,7 +1378,12 @@ uint8_t          mskn     = 0x00;
 	args.msk1_      = msk1;
 	args.mskn_      = mskn;
 
-	cl->write( &it, &args );
+	if ( usePlan ) {
+		plan_.write( &slice, &args );
+	} else {
+		SlicedPathIterator it( p_, range );
+		it->c_p_->write( &it, &args );
+	}
 
 	return nelms;
 }
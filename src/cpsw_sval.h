@@ -12,6 +12,7 @@
 
 #include <cpsw_api_builder.h>
 #include <cpsw_entry_adapt.h>
+#include <cpsw_mmio_dev.h>
 
 using cpsw::static_pointer_cast;
 using cpsw::weak_ptr;
@@ -171,7 +172,8 @@ public:
 
 class IIntEntryAdapt : public IEntryAdapt, public virtual IScalVal_Base {
 private:
-	int nelms_;
+	int         nelms_;
+	CAccessPlan plan_;   // compiled once; used if valid
 public:
 	IIntEntryAdapt(Key &k, ConstPath p, shared_ptr<const CIntEntryImpl> ie);
 	virtual bool     isSigned()    const { return asIntEntry()->isSigned();    }
@@ -193,11 +195,14 @@ protected:
 	virtual unsigned getVal(uint8_t  *, unsigned, unsigned, SlicedPathIterator *it);
 	virtual unsigned getVal(AsyncIO aio, uint8_t  *, unsigned, unsigned, SlicedPathIterator *it);
 
+	// use the access plan (or a SlicedPathIterator if the plan is not valid)
+	virtual unsigned getVal(uint8_t  *, unsigned, unsigned, IndexRange *r);
+	virtual unsigned getVal(AsyncIO aio, uint8_t  *, unsigned, unsigned, IndexRange *r);
+
 	template <typename E> unsigned getVal(E *e, unsigned nelms, IndexRange *r)
 	{
-	SlicedPathIterator it(p_, r);
 		try {
-			return getVal( reinterpret_cast<uint8_t*>(e), nelms, sizeof(E), &it );
+			return getVal( reinterpret_cast<uint8_t*>(e), nelms, sizeof(E), r );
 		} catch (const IOError &ex)  {
 			throw IOError((ex.what() + std::string(": ") + p_->toString()).c_str());
 		}
@@ -205,9 +210,8 @@ protected:
 
 	template <typename E> unsigned getVal(AsyncIO aio, E *e, unsigned nelms, IndexRange *r)
 	{
-	SlicedPathIterator it(p_, r);
 		try {
-			return getVal(aio, reinterpret_cast<uint8_t*>(e), nelms, sizeof(E), &it );
+			return getVal(aio, reinterpret_cast<uint8_t*>(e), nelms, sizeof(E), r );
 		} catch (const IOError &ex)  {
 			throw IOError((ex.what() + std::string(": ") + p_->toString()).c_str());
 		}			
@@ -233,6 +237,7 @@ protected:
 
 
 	virtual unsigned checkNelms(unsigned nelms, SlicedPathIterator *it);
+	virtual unsigned checkNelms(unsigned nelms, unsigned nelmsOnPath);
 
 	virtual unsigned setVal(uint8_t  *, unsigned, unsigned, IndexRange *r = 0);
 
@@ -21,7 +21,13 @@
 #include <errno.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <signal.h>
+#include <sched.h>
+
+#include <set>
+#include <algorithm>
 
 #define CPSW_THREAD_DEBUG 0
 
@@ -31,17 +37,155 @@ int cpsw_thread_debug = CPSW_THREAD_DEBUG;
 
 using std::string;
 
+// Registry of started threads (for 'dumpThreads'). Plain pthread
+// mutex and a never-destroyed set so that threads may be started
+// and stopped by static constructors/destructors.
+static pthread_mutex_t           regMtx = PTHREAD_MUTEX_INITIALIZER;
+
+static std::set<CRunnable*> *
+registry()
+{
+static std::set<CRunnable*> *theRegistry = new std::set<CRunnable*>();
+	return theRegistry;
+}
+
+class CRegLock {
+public:
+	CRegLock()  { pthread_mutex_lock( &regMtx );   }
+	~CRegLock() { pthread_mutex_unlock( &regMtx ); }
+};
+
+// process-wide defaults
+static pthread_once_t dfltOnce   = PTHREAD_ONCE_INIT;
+static int            dfltPolicy = CRunnable::DFLT_POLICY;
+static string         dfltCpus;
+
+static bool
+parsePolicy(const char *str, int *pol_p)
+{
+	if ( 0 == strncmp( str, "SCHED_", 6 ) )
+		str += 6;
+	if ( 0 == strcmp( str, "OTHER" ) )
+		*pol_p = SCHED_OTHER;
+	else if ( 0 == strcmp( str, "FIFO" ) )
+		*pol_p = SCHED_FIFO;
+	else if ( 0 == strcmp( str, "RR" ) )
+		*pol_p = SCHED_RR;
+	else
+		return false;
+	return true;
+}
+
+static const char *
+policyName(int pol)
+{
+	switch ( pol ) {
+		case SCHED_OTHER: return "SCHED_OTHER";
+		case SCHED_FIFO:  return "SCHED_FIFO";
+		case SCHED_RR:    return "SCHED_RR";
+		default:          break;
+	}
+	return "<unknown>";
+}
+
+// Parse a CPU list ("0,2,4-7"); throws InvalidArgError
+#ifdef __linux__
+static void
+parseCpuList(const string &str, cpu_set_t *set)
+{
+const char    *p = str.c_str();
+char          *e;
+unsigned long  lo, hi;
+
+	CPU_ZERO( set );
+	while ( *p ) {
+		lo = strtoul( p, &e, 10 );
+		if ( e == p )
+			throw InvalidArgError( string("Invalid CPU list: ") + str );
+		hi = lo;
+		p  = e;
+		if ( '-' == *p ) {
+			hi = strtoul( ++p, &e, 10 );
+			if ( e == p || hi < lo )
+				throw InvalidArgError( string("Invalid CPU range in list: ") + str );
+			p  = e;
+		}
+		if ( hi >= CPU_SETSIZE )
+			throw InvalidArgError( string("CPU number too big in list: ") + str );
+		while ( lo <= hi ) {
+			CPU_SET( lo, set );
+			lo++;
+		}
+		if ( ',' == *p )
+			p++;
+		else if ( *p )
+			throw InvalidArgError( string("Invalid CPU list: ") + str );
+	}
+}
+
+static string
+formatCpuList(const cpu_set_t *set)
+{
+string rval;
+int    i, j;
+char   buf[32];
+
+	for ( i = 0; i < CPU_SETSIZE; i = j ) {
+		if ( ! CPU_ISSET( i, set ) ) {
+			j = i + 1;
+			continue;
+		}
+		for ( j = i + 1; j < CPU_SETSIZE && CPU_ISSET( j, set ); j++ )
+			;
+		if ( j - 1 > i )
+			snprintf( buf, sizeof(buf), "%s%d-%d", rval.empty() ? "" : ",", i, j - 1 );
+		else
+			snprintf( buf, sizeof(buf), "%s%d",    rval.empty() ? "" : ",", i );
+		rval += buf;
+	}
+	return rval;
+}
+#endif
+
+static void
+initDefaults()
+{
+const char *str;
+
+	if ( (str = getenv( "CPSW_SCHED_POLICY" )) && *str ) {
+		if ( ! parsePolicy( str, &dfltPolicy ) ) {
+			fprintf(CPSW::fErr(), "WARNING: ignoring invalid CPSW_SCHED_POLICY: %s\n", str);
+		}
+	}
+	if ( (str = getenv( "CPSW_CPU_AFFINITY" )) && *str ) {
+#ifdef __linux__
+		try {
+			cpu_set_t set;
+			parseCpuList( str, &set );
+			dfltCpus = str;
+		} catch ( InvalidArgError &e ) {
+			fprintf(CPSW::fErr(), "WARNING: ignoring CPSW_CPU_AFFINITY: %s\n", e.getInfo().c_str());
+		}
+#endif
+	}
+}
+
 CRunnable::CRunnable(const char *name, int prio)
 : started_(false),
   name_(name),
-  prio_(prio)
+  prio_(prio),
+  policy_(DFLT_POLICY),
+  lwp_(0)
 {
 }
 
 CRunnable::CRunnable(const CRunnable &orig)
 : started_(false),
   name_(orig.name_),
-  prio_(orig.prio_)
+  prio_(orig.prio_),
+  policy_(orig.policy_),
+  cpus_(orig.cpus_),
+  lwp_(0)
 {
 }
 
@@ -90,6 +234,21 @@ if ( cpsw_thread_debug > 0 ) {
 }
 #endif
 
+#ifdef __linux__
+	{
+	// thread names are limited to 15 characters
+	string nm( me->getName(), 0, 15 );
+	size_t l = nm.find_last_not_of( ' ' );
+		nm.erase( string::npos == l ? 0 : l + 1 );
+		pthread_setname_np( pthread_self(), nm.c_str() );
+	}
+	{
+	CRegLock lck;
+		me->lwp_ = syscall( SYS_gettid );
+	}
+	me->applyAffinity( pthread_self(), true );
+#endif
+
 	try {
 		rval = me->threadBody();
 	} catch ( CPSWError &e ) {
@@ -101,6 +260,43 @@ if ( cpsw_thread_debug > 0 ) {
 	return rval;
 }
 
+int CRunnable::getEffectivePolicy() const
+{
+	pthread_once( &dfltOnce, initDefaults );
+	if ( DFLT_POLICY != policy_ )
+		return policy_;
+	if ( prio_ > 0 )
+		return SCHED_FIFO;
+	return DFLT_POLICY != dfltPolicy ? dfltPolicy : SCHED_OTHER;
+}
+
+// Failure to set the affinity of a new thread is not fatal
+// (the CPUs may be offline or not permitted by the cpuset);
+// the thread just runs wherever it is allowed to.
+void CRunnable::applyAffinity(pthread_t tid, bool warn)
+{
+#ifdef __linux__
+cpu_set_t set;
+int       err;
+string    cpus;
+
+	pthread_once( &dfltOnce, initDefaults );
+	{
+	CRegLock lck;
+		cpus = cpus_.empty() ? dfltCpus : cpus_;
+	}
+	if ( cpus.empty() )
+		return;
+	parseCpuList( cpus, &set );
+	if ( (err = pthread_setaffinity_np( tid, sizeof(set), &set )) ) {
+		if ( ! warn )
+			throw InvalidArgError( string("Unable to set CPU affinity to ") + cpus + " for " + getName() );
+		ErrnoError e( getName(), err );
+		fprintf(CPSW::fErr(), "WARNING: CRunnable; unable to set CPU affinity (%s) for %s -- IGNORED\n", cpus.c_str(), e.what());
+	}
+#endif
+}
+
 void CRunnable::threadStart()
 {
 int err;
@@ -110,11 +306,10 @@ int attempts;
 		SigMask blockAllSignals; // start new thread with all signals blocked
 
 #if defined _POSIX_THREAD_PRIORITY_SCHEDULING
-		int                pol   = prio_ > 0 ? SCHED_FIFO : SCHED_OTHER;
+		int                pol   = getEffectivePolicy();
 		struct sched_param param;
 
-			pol                  = prio_ > 0 ? SCHED_FIFO : SCHED_OTHER;
-			param.sched_priority = prio_ > 0 ? prio_ : 0;
+			param.sched_priority = SCHED_OTHER == pol ? 0 : ( prio_ > 0 ? prio_ : 1 );
 		if ( (err = pthread_attr_setschedpolicy( attr.getp(), pol )) ) {
 			throw InternalError("ERROR -- pthread_attr_setschedpolicy", err);
 		}
@@ -129,19 +324,25 @@ int attempts;
 #else
 		#warning "_POSIX_THREAD_PRIORITY_SCHEDULING not defined -- always using default priority"
 		prio_ = 0;
+		int pol = SCHED_OTHER;
 #endif
 		if ( (err = pthread_create( &tid_, attr.getp(), wrapper, this )) ) {
-			if ( EPERM == err && prio_ > 0 ) {
+			if ( EPERM == err && SCHED_OTHER != pol ) {
 				ErrnoError warn(getName(), err);
 				fprintf(CPSW::fErr(), "WARNING: CRunnable::threadStart; unable to set priority for %s -- IGNORED\n", warn.what());
 				// Try again with default priority
-				prio_ = 0;
+				prio_   = 0;
+				policy_ = SCHED_OTHER;
 				continue;
 			} else {
 				throw InternalError("ERROR -- pthread_create()", err);
 			}
 		}
 		started_ = true;
+		{
+		CRegLock lck;
+			registry()->insert( this );
+		}
 	}
 }
 
@@ -153,6 +354,11 @@ int   err;
 		throw InternalError("ERROR -- pthread_join()", err);
 	}
 	started_ = false;
+	{
+	CRegLock lck;
+		registry()->erase( this );
+		lwp_ = 0;
+	}
 	return rval;
 }
 
@@ -194,8 +400,11 @@ struct sched_param param;
 int                pol;
 
 	if ( started_ ) {
-		param.sched_priority = prio > 0 ? prio       : 0;
-		pol                  = prio > 0 ? SCHED_FIFO : SCHED_OTHER;
+	int oprio = prio_;
+		prio_                = prio;
+		pol                  = getEffectivePolicy();
+		prio_                = oprio;
+		param.sched_priority = SCHED_OTHER == pol ? 0 : ( prio > 0 ? prio : 1 );
 		if ( (err = pthread_setschedparam( tid_, pol, &param )) ) {
 			if ( EPERM == err ) {
 				ErrnoError warn(getName(), err);
@@ -217,6 +426,172 @@ int                pol;
 #endif
 }
 
+int CRunnable::getSchedPolicy() const
+{
+	return policy_;
+}
+
+void CRunnable::setSchedPolicy(int policy)
+{
+	if ( DFLT_POLICY != policy && SCHED_OTHER != policy && SCHED_FIFO != policy && SCHED_RR != policy ) {
+		throw InvalidArgError("CRunnable::setSchedPolicy: unsupported policy");
+	}
+#if defined _POSIX_THREAD_PRIORITY_SCHEDULING
+	if ( started_ ) {
+	int                err;
+	struct sched_param param;
+	int                pol;
+	int                opol = policy_;
+
+		policy_              = policy;
+		pol                  = getEffectivePolicy();
+		param.sched_priority = SCHED_OTHER == pol ? 0 : ( prio_ > 0 ? prio_ : 1 );
+		if ( (err = pthread_setschedparam( tid_, pol, &param )) ) {
+			policy_ = opol;
+			if ( EPERM == err ) {
+				ErrnoError warn(getName(), err);
+				fprintf(CPSW::fErr(), "WARNING: CRunnable::setSchedPolicy failed for %s\n", warn.what());
+				return;
+			}
+			throw InternalError("ERROR: pthread_setschedparam()", err);
+		}
+	}
+#endif
+	policy_ = policy;
+}
+
+const std::string & CRunnable::getCpuAffinity() const
+{
+	return cpus_;
+}
+
+void CRunnable::setCpuAffinity(const std::string &cpus)
+{
+#ifdef __linux__
+cpu_set_t set;
+	// validate
+	parseCpuList( cpus, &set );
+#endif
+	{
+	CRegLock lck;
+		cpus_ = cpus;
+	}
+	if ( started_ ) {
+		applyAffinity( tid_, false );
+	}
+}
+
+void CRunnable::setDefaultSchedPolicy(int policy)
+{
+	if ( DFLT_POLICY != policy && SCHED_OTHER != policy && SCHED_FIFO != policy && SCHED_RR != policy ) {
+		throw InvalidArgError("CRunnable::setDefaultSchedPolicy: unsupported policy");
+	}
+	pthread_once( &dfltOnce, initDefaults );
+	dfltPolicy = policy;
+}
+
+int CRunnable::getDefaultSchedPolicy()
+{
+	pthread_once( &dfltOnce, initDefaults );
+	return dfltPolicy;
+}
+
+void CRunnable::setDefaultCpuAffinity(const std::string &cpus)
+{
+#ifdef __linux__
+cpu_set_t set;
+	parseCpuList( cpus, &set );
+#endif
+	pthread_once( &dfltOnce, initDefaults );
+	CRegLock lck;
+	dfltCpus = cpus;
+}
+
+std::string CRunnable::getDefaultCpuAffinity()
+{
+	pthread_once( &dfltOnce, initDefaults );
+	CRegLock lck;
+	return dfltCpus;
+}
+
+pid_t CRunnable::getLWP() const
+{
+CRegLock lck;
+	return lwp_;
+}
+
+// CPU the thread last executed on (field 39 of /proc/<pid>/task/<tid>/stat)
+static int
+lastCpu(pid_t lwp)
+{
+#ifdef __linux__
+char  buf[1024];
+char  path[64];
+FILE *f;
+char *p;
+int   fld, cpu;
+
+	snprintf( path, sizeof(path), "/proc/self/task/%ld/stat", (long)lwp );
+	if ( ! (f = fopen( path, "r" )) )
+		return -1;
+	p = fgets( buf, sizeof(buf), f );
+	fclose( f );
+	// the command name (field 2) may contain blanks
+	if ( ! p || ! (p = strrchr( buf, ')' )) )
+		return -1;
+	// field 3 follows
+	for ( fld = 2; fld < 39 && p; fld++ ) {
+		p = strchr( p + 1, ' ' );
+	}
+	if ( ! p || 1 != sscanf( p, "%d", &cpu ) )
+		return -1;
+	return cpu;
+#else
+	return -1;
+#endif
+}
+
+void CRunnable::dumpThreads(FILE *f, const std::vector<CRunnable*> *only)
+{
+std::set<CRunnable*>::const_iterator it;
+CRegLock                             lck;
+
+	fprintf(f, "CPSW Threads:\n");
+	fprintf(f, "  %-8s %4s %-12s %4s %-16s %s\n", "LWP", "CPU", "Policy", "Prio", "Affinity", "Name");
+	for ( it = registry()->begin(); it != registry()->end(); ++it ) {
+		CRunnable          *r = *it;
+		int                 pol = SCHED_OTHER;
+		struct sched_param  param;
+		string              aff("-");
+		char                cpu[16];
+		int                 c;
+
+		if ( only && std::find( only->begin(), only->end(), r ) == only->end() )
+			continue;
+
+		param.sched_priority = 0;
+		pthread_getschedparam( r->tid_, &pol, &param );
+#ifdef __linux__
+		{
+		cpu_set_t set;
+			if ( 0 == pthread_getaffinity_np( r->tid_, sizeof(set), &set ) )
+				aff = formatCpuList( &set );
+		}
+#endif
+		if ( r->lwp_ && (c = lastCpu( r->lwp_ )) >= 0 )
+			snprintf( cpu, sizeof(cpu), "%d", c );
+		else
+			snprintf( cpu, sizeof(cpu), "-" );
+		fprintf(f, "  %-8ld %4s %-12s %4d %-16s %s\n",
+			(long)r->lwp_,
+			cpu,
+			policyName( pol ),
+			param.sched_priority,
+			aff.c_str(),
+			r->getName().c_str());
+	}
+}
+
 //NOTE: the most derived class should call 'stop'
 CRunnable::~CRunnable()
 {
@@ -11,7 +11,10 @@
 #define CPSW_THREAD_HELPER_H
 
 #include <pthread.h>
+#include <sys/types.h>
+#include <stdio.h>
 #include <string>
+#include <vector>
 
 class CRunnable {
 private:
@@ -19,9 +22,15 @@ private:
 	bool          started_;
 	std::string   name_;
 	int           prio_;
+	int           policy_;
+	std::string   cpus_;
+	pid_t         lwp_;
 
 	static void*  wrapper(void*);
 
+	int           getEffectivePolicy() const;
+	void          applyAffinity(pthread_t, bool warn);
+
 	CRunnable & operator=(const CRunnable &);
 
 protected:
@@ -51,6 +60,7 @@ protected:
 public:
 
 	static const int DFLT_PRIORITY = 0;
+	static const int DFLT_POLICY   = -1;
 
 	CRunnable(const char *name, int prio = DFLT_PRIORITY);
 
@@ -78,6 +88,42 @@ public:
 	virtual int  setPrio(int prio);
 	virtual int  getPrio() const;
 
+	// Set the scheduling policy: SCHED_OTHER, SCHED_FIFO, SCHED_RR
+	// or DFLT_POLICY. The latter selects SCHED_FIFO if the priority
+	// is > 0 and the process-wide default otherwise. SCHED_FIFO/RR
+	// with a priority <= 0 use priority 1.
+	// Like 'setPrio' this falls back to SCHED_OTHER (with a warning)
+	// if there is no permission.
+	virtual void setSchedPolicy(int policy);
+	virtual int  getSchedPolicy() const;
+
+	// Restrict the thread to a set of CPUs given as a list of
+	// CPU numbers and/or ranges, e.g., "1,4-7". An empty string
+	// selects the process-wide default. Takes effect immediately
+	// if the thread is running.
+	// Throws InvalidArgError if the list cannot be parsed.
+	virtual void setCpuAffinity(const std::string &cpus);
+	virtual const std::string &getCpuAffinity() const;
+
+	// Process-wide defaults for threads which do not set their
+	// own policy or affinity. Initialized from the environment
+	// variables CPSW_SCHED_POLICY (SCHED_OTHER, SCHED_FIFO, SCHED_RR)
+	// and CPSW_CPU_AFFINITY (CPU list). Only threads started after
+	// changing the defaults are affected.
+	static void setDefaultSchedPolicy(int policy);
+	static int  getDefaultSchedPolicy();
+	static void setDefaultCpuAffinity(const std::string &cpus);
+	static std::string getDefaultCpuAffinity();
+
+	// Kernel thread ID (LWP) of a running thread; 0 if not
+	// running or not supported by the OS.
+	virtual pid_t getLWP() const;
+
+	// List all running CPSW threads (name, LWP, policy, priority,
+	// affinity and the CPU they last executed on). If 'only' is
+	// given then just the running threads in that list are shown.
+	static void dumpThreads(FILE *, const std::vector<CRunnable*> *only = 0);
+
 	// Destructor of subclass should call stop -- cannot
 	// rely on base class to do so because subclass
 	// data is already torn down!
@@ -0,0 +1,128 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#include <cpsw_timer_wheel.h>
+
+CWheelTimer::CWheelTimer( CTimerWheel *wheel, uint64_t exp )
+: next_ ( NULL  ),
+  pprev_( NULL  ),
+  wheel_( wheel ),
+  tick_ ( 0     ),
+  exp_  ( exp   )
+{
+}
+
+void
+CWheelTimer::cancel()
+{
+	if ( pprev_ ) {
+		wheel_->remove( this );
+	}
+}
+
+void
+CWheelTimer::arm_abs(const CTimeout exp)
+{
+	cancel();
+	exp_ = exp;
+	wheel_->insert( this );
+}
+
+void
+CWheelTimer::arm_rel(const CTimeout &exp)
+{
+CTimeout abst;
+	if ( clock_gettime( CLOCK_MONOTONIC, &abst.tv_ ) ) {
+		throw InternalError("clock_gettime failed");
+	}
+	arm_abs( abst += exp );
+}
+
+CTimerWheel::CTimerWheel(unsigned ldSlots, uint64_t tickUs)
+: slots_   ( (1<<ldSlots), (CWheelTimer*)NULL ),
+  msk_     ( (1<<ldSlots) - 1                 ),
+  tickNs_  ( tickUs ? tickUs * 1000 : 1000    ),
+  cursor_  ( 0                                ),
+  numArmed_( 0                                )
+{
+}
+
+void
+CTimerWheel::insert(CWheelTimer *t)
+{
+uint64_t       tick = toTick( t->exp_ );
+CWheelTimer  **head;
+
+	// already expired; the exact expiration time still
+	// orders it correctly within the cursor's slot
+	if ( tick < cursor_ ) {
+		tick = cursor_;
+	}
+
+	t->tick_  = tick;
+	head      = &slots_[ tick & msk_ ];
+	if ( (t->next_ = *head) ) {
+		t->next_->pprev_ = &t->next_;
+	}
+	*head     = t;
+	t->pprev_ = head;
+
+	numArmed_++;
+}
+
+void
+CTimerWheel::remove(CWheelTimer *t)
+{
+	if ( (*t->pprev_ = t->next_) ) {
+		t->next_->pprev_ = t->pprev_;
+	}
+	t->next_  = NULL;
+	t->pprev_ = NULL;
+
+	numArmed_--;
+}
+
+CWheelTimer *
+CTimerWheel::getFirstToExpire()
+{
+CWheelTimer *rval = NULL;
+CWheelTimer *t;
+uint64_t     i, tick;
+
+	if ( 0 == numArmed_ ) {
+		return NULL;
+	}
+
+	// scan (at most) one revolution
+	for ( i = 0; i <= msk_; i++ ) {
+		tick = cursor_ + i;
+		for ( t = slots_[ tick & msk_ ]; t; t = t->next_ ) {
+			// ignore timers of future revolutions
+			if ( t->tick_ == tick && ( ! rval || t->exp_ < rval->exp_ ) ) {
+				rval = t;
+			}
+		}
+		if ( rval ) {
+			cursor_ = tick;
+			return rval;
+		}
+	}
+
+	// all timers are more than one revolution ahead
+	for ( i = 0; i <= msk_; i++ ) {
+		for ( t = slots_[ i ]; t; t = t->next_ ) {
+			if ( ! rval || t->exp_ < rval->exp_ ) {
+				rval = t;
+			}
+		}
+	}
+	cursor_ = rval->tick_;
+
+	return rval;
+}
@@ -0,0 +1,121 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_TIMER_WHEEL_H
+#define CPSW_TIMER_WHEEL_H
+
+// Hashed timer wheel.
+//
+// Timers are hashed into slots by their expiration 'tick'
+// (expiration time / tick-granularity) which makes arming
+// and canceling O(1). Finding the first timer to expire
+// scans forward from a cursor which only advances, i.e.,
+// the cost is amortized over elapsed ticks.
+// The exact expiration time is retained so that timers
+// which share a slot are still ordered correctly.
+//
+// Not thread-safe; a wheel and its timers are meant to be
+// managed by a single thread.
+
+#include <cpsw_error.h>
+#ifdef NO_CPSW
+#include <to.h>
+#else
+#include <cpsw_api_timeout.h>
+#endif
+
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+class CTimerWheel;
+
+class CWheelTimer {
+private:
+	CWheelTimer     *next_;
+	CWheelTimer    **pprev_; // NULL if not armed
+	CTimerWheel     *wheel_;
+	uint64_t         tick_;
+	CTimeout         exp_;
+
+	CWheelTimer(const CWheelTimer &);
+	CWheelTimer & operator=(const CWheelTimer &);
+
+	friend class CTimerWheel;
+
+public:
+	CWheelTimer( CTimerWheel *wheel, uint64_t exp = 0 );
+
+	void cancel();
+
+	void arm_abs(const CTimeout exp);
+
+	// relative to CLOCK_MONOTONIC (the clock used by event sets)
+	void arm_rel(const CTimeout &exp);
+
+	bool isArmed()
+	{
+		return !!pprev_;
+	}
+
+	const CTimeout *getTimeout()
+	{
+		return &exp_;
+	}
+
+	virtual ~CWheelTimer()
+	{
+		cancel();
+	}
+
+	// subclass should implement a useful 'process()'
+	virtual void process()
+	{
+	}
+};
+
+class CTimerWheel {
+public:
+	static const unsigned LD_SLOTS_DFLT = 10;   // 1024 slots
+	static const uint64_t TICK_US_DFLT  = 1000; // ~1s per revolution
+
+private:
+	std::vector<CWheelTimer*> slots_;
+	uint64_t                  msk_;
+	uint64_t                  tickNs_;
+	uint64_t                  cursor_; // no timer expires before this tick
+	unsigned                  numArmed_;
+
+	CTimerWheel(const CTimerWheel &);
+	CTimerWheel & operator=(const CTimerWheel &);
+
+	uint64_t toTick(const CTimeout &t)
+	{
+		return ( (uint64_t)t.tv_.tv_sec * (uint64_t)1000000000 + (uint64_t)t.tv_.tv_nsec ) / tickNs_;
+	}
+
+	friend class CWheelTimer;
+
+	void insert(CWheelTimer *);
+	void remove(CWheelTimer *);
+
+public:
+	CTimerWheel(unsigned ldSlots = LD_SLOTS_DFLT, uint64_t tickUs = TICK_US_DFLT);
+
+	// RETURNS: armed timer with the earliest expiration time
+	//          or NULL if no timer is armed
+	CWheelTimer *getFirstToExpire();
+
+	unsigned getNumArmed()
+	{
+		return numArmed_;
+	}
+};
+
+#endif
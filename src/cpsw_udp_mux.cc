@@ -0,0 +1,348 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_udp_mux.h>
+#include <cpsw_error.h>
+#include <cpsw_stdio.h>
+
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+uint64_t
+CUdpMuxSock::key(const struct sockaddr_in *peer)
+{
+	return ( (uint64_t)ntohl( peer->sin_addr.s_addr ) << 16 ) | ntohs( peer->sin_port );
+}
+
+CUdpMuxSock::CUdpMuxSock()
+: mtx_       ( "CUdpMuxSock" ),
+  handle_    ( 0             ),
+  rcvBufSize_( 0             ),
+  sndBufSize_( 0             ),
+  nDgrams_   ( 0             ),
+  nOctets_   ( 0             ),
+  nStray_    ( 0             ),
+  kernDrops_ ( 0             )
+{
+struct sockaddr_in me;
+
+	me.sin_family      = AF_INET;
+	me.sin_addr.s_addr = INADDR_ANY;
+	me.sin_port        = htons( 0 );
+
+	// not connected; the peers are told apart by their address
+	sd_.init( NULL, &me, true );
+
+	handle_ = CReactor::getTheReactor()->add( sd_.getSd(), this );
+}
+
+CUdpMuxSock::~CUdpMuxSock()
+{
+	if ( handle_ ) {
+		CReactor::getTheReactor()->remove( handle_ );
+	}
+}
+
+unsigned
+CUdpMuxSock::getPort()
+{
+struct sockaddr_in me;
+	sd_.getMyAddr( &me );
+	return ntohs( me.sin_port );
+}
+
+bool
+CUdpMuxSock::hasPeer(const struct sockaddr_in *peer)
+{
+CMtx::lg GUARD( &mtx_ );
+	return peers_.find( key( peer ) ) != peers_.end();
+}
+
+unsigned
+CUdpMuxSock::getNumPeers()
+{
+CMtx::lg GUARD( &mtx_ );
+	return peers_.size();
+}
+
+void
+CUdpMuxSock::attach(const struct sockaddr_in *peer, IUdpMuxHandler *hdlr, unsigned pollSecs)
+{
+Peer p;
+
+	p.addr_     = *peer;
+	p.hdlr_     = hdlr;
+	p.pollSecs_ = pollSecs;
+	p.pollCnt_  = pollSecs;
+	p.active_   = false;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	if ( ! peers_.insert( PeerMap::value_type( key( peer ), p ) ).second ) {
+		throw InternalError( "CUdpMuxSock: peer already attached" );
+	}
+}
+
+void
+CUdpMuxSock::detach(const struct sockaddr_in *peer)
+{
+	// the handler is executed with the lock held
+	CMtx::lg GUARD( &mtx_ );
+	peers_.erase( key( peer ) );
+}
+
+void
+CUdpMuxSock::sendPoll(const struct sockaddr_in *peer)
+{
+uint8_t buf[4];
+
+	memset( buf, 0, sizeof(buf) );
+	if ( ::sendto( sd_.getSd(), buf, 0, 0, (const struct sockaddr*)peer, sizeof(*peer) ) < 0 ) {
+		if ( EAGAIN != errno && EWOULDBLOCK != errno ) {
+			perror("UDP mux poller (sendto)");
+		}
+	}
+}
+
+void
+CUdpMuxSock::setActive(const struct sockaddr_in *peer, bool active)
+{
+PeerMap::iterator it;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	if ( (it = peers_.find( key( peer ) )) == peers_.end() ) {
+		throw InternalError( "CUdpMuxSock: peer not attached" );
+	}
+	if ( active && ! it->second.active_ && it->second.pollSecs_ ) {
+		// first poll right away
+		sendPoll( peer );
+		it->second.pollCnt_ = it->second.pollSecs_;
+	}
+	it->second.active_ = active;
+}
+
+void
+CUdpMuxSock::raiseBufSizes(unsigned rcvBufSize, unsigned sndBufSize)
+{
+	CMtx::lg GUARD( &mtx_ );
+
+	if ( rcvBufSize > rcvBufSize_ ) {
+		CSockSd::setBufSize( sd_.getSd(), true, rcvBufSize );
+		rcvBufSize_ = rcvBufSize;
+	}
+	if ( sndBufSize > sndBufSize_ ) {
+		CSockSd::setBufSize( sd_.getSd(), false, sndBufSize );
+		sndBufSize_ = sndBufSize;
+	}
+}
+
+void
+CUdpMuxSock::poll()
+{
+PeerMap::iterator it;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	for ( it = peers_.begin(); it != peers_.end(); ++it ) {
+		if ( ! it->second.active_ || ! it->second.pollSecs_ ) {
+			continue;
+		}
+		if ( 0 == --it->second.pollCnt_ ) {
+			sendPoll( &it->second.addr_ );
+			it->second.pollCnt_ = it->second.pollSecs_;
+		}
+	}
+}
+
+void
+CUdpMuxSock::handleInput()
+{
+ssize_t            got;
+unsigned           n;
+struct sockaddr_in from;
+PeerMap::iterator  it;
+bool               delivered;
+
+	for ( n = 0; n < RX_BATCH; n++ ) {
+		got = rxBufs_.receive( sd_.getSd(), 0, &from );
+		if ( got < 0 ) {
+			if ( EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno ) {
+				perror("UDP mux socket");
+			}
+			return;
+		}
+		nDgrams_.fetch_add(1,   cpsw::memory_order_relaxed);
+		nOctets_.fetch_add(got, cpsw::memory_order_relaxed);
+		if ( rxBufs_.getInfo()->hasDrops_ ) {
+			kernDrops_.store( rxBufs_.getInfo()->drops_, cpsw::memory_order_relaxed );
+		}
+
+		delivered = false;
+		{
+		CMtx::lg GUARD( &mtx_ );
+			it = peers_.find( key( &from ) );
+			if ( it != peers_.end() && it->second.active_ ) {
+				it->second.hdlr_->handleInput( &rxBufs_, got );
+				delivered = true;
+			}
+		}
+		if ( ! delivered ) {
+			nStray_.fetch_add(1, cpsw::memory_order_relaxed);
+		}
+	}
+}
+
+void
+CUdpMuxSock::dumpInfo(FILE *f)
+{
+	fprintf(f, "  Port %5u: %4u peers, %" PRIu64 " dgrams, %" PRIu64 " octets, %" PRIu64 " stray, %" PRIu64 " kdrops\n",
+	        getPort(), getNumPeers(), getNumDgrams(), getNumOctets(), getNumStray(), getNumKernDrops());
+}
+
+CUdpMux::CUdpMux(unsigned poolSize)
+: mtx_        ( "CUdpMux" ),
+  poolSize_   ( poolSize  ),
+  timerFd_    ( -1        ),
+  timerHandle_( 0         )
+{
+struct itimerspec its;
+
+	if ( (timerFd_ = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC )) < 0 ) {
+		throw InternalError( "CUdpMux: unable to create poll timer", errno );
+	}
+	its.it_value.tv_sec     = 1;
+	its.it_value.tv_nsec    = 0;
+	its.it_interval.tv_sec  = 1;
+	its.it_interval.tv_nsec = 0;
+	if ( timerfd_settime( timerFd_, 0, &its, NULL ) ) {
+		::close( timerFd_ );
+		throw InternalError( "CUdpMux: unable to arm poll timer", errno );
+	}
+	timerHandle_ = CReactor::getTheReactor()->add( timerFd_, this );
+}
+
+CUdpMux::~CUdpMux()
+{
+unsigned i;
+
+	if ( timerHandle_ ) {
+		CReactor::getTheReactor()->remove( timerHandle_ );
+	}
+	::close( timerFd_ );
+	for ( i=0; i<socks_.size(); i++ ) {
+		delete socks_[i];
+	}
+}
+
+CUdpMuxSock *
+CUdpMux::attach(const struct sockaddr_in *peer, IUdpMuxHandler *hdlr, unsigned pollSecs)
+{
+CUdpMuxSock *best = 0;
+unsigned     i, n, bestN = 0;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	for ( i=0; i<socks_.size(); i++ ) {
+		if ( socks_[i]->hasPeer( peer ) ) {
+			continue;
+		}
+		n = socks_[i]->getNumPeers();
+		if ( ! best || n < bestN ) {
+			best  = socks_[i];
+			bestN = n;
+		}
+	}
+
+	// fill the pool before sharing a socket
+	if ( ! best || ( bestN > 0 && socks_.size() < poolSize_ ) ) {
+		best = new CUdpMuxSock();
+		socks_.push_back( best );
+	}
+
+	best->attach( peer, hdlr, pollSecs );
+
+	return best;
+}
+
+void
+CUdpMux::handleInput()
+{
+uint64_t exp;
+unsigned i;
+
+	// consume the expiration count
+	if ( ::read( timerFd_, &exp, sizeof(exp) ) < 0 ) {
+		return;
+	}
+
+	CMtx::lg GUARD( &mtx_ );
+
+	for ( i=0; i<socks_.size(); i++ ) {
+		socks_[i]->poll();
+	}
+}
+
+unsigned
+CUdpMux::getNumSockets()
+{
+CMtx::lg GUARD( &mtx_ );
+	return socks_.size();
+}
+
+void
+CUdpMux::dumpInfo(FILE *f)
+{
+unsigned i;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	fprintf(f, "CUdpMux:\n");
+	fprintf(f, "  Pool size : %15u\n", poolSize_);
+	fprintf(f, "  Sockets   : %15lu\n", (unsigned long)socks_.size());
+	for ( i=0; i<socks_.size(); i++ ) {
+		socks_[i]->dumpInfo( f );
+	}
+}
+
+static CUdpMux        *theMux  = 0;
+static pthread_once_t  muxOnce = PTHREAD_ONCE_INIT;
+
+void
+CUdpMux::createTheMux()
+{
+const char *str = getenv( "CPSW_UDP_MUX_SOCKETS" );
+unsigned    n   = CUdpMux::DFLT_SOCKETS;
+
+	if ( str && 1 != sscanf( str, "%u", &n ) ) {
+		fprintf( CPSW::fErr(), "CUdpMux: ignoring invalid CPSW_UDP_MUX_SOCKETS: %s\n", str );
+		n = CUdpMux::DFLT_SOCKETS;
+	}
+	if ( 0 == n ) {
+		n = 1;
+	}
+	theMux = new CUdpMux( n );
+}
+
+// Like the reactor the pool is never destroyed.
+CUdpMux *
+CUdpMux::getTheMux()
+{
+	pthread_once( &muxOnce, createTheMux );
+	return theMux;
+}
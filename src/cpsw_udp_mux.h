@@ -0,0 +1,158 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_UDP_MUX_H
+#define CPSW_UDP_MUX_H
+
+#include <cpsw_reactor.h>
+#include <cpsw_sock.h>
+#include <cpsw_mutex.h>
+#include <cpsw_compat.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <netinet/in.h>
+#include <map>
+#include <vector>
+
+using cpsw::atomic;
+
+// A (process-wide) pool of UDP sockets which are shared by many
+// peers (i.e., protocol modules). The sockets are not connected;
+// received datagrams are demultiplexed by the sender's address and
+// port. All sockets are serviced by the reactor (which also
+// sends the periodic 'poll' datagrams), i.e., neither the number
+// of sockets nor the number of threads grows with the number
+// of peers.
+//
+// A peer (address/port) can only be attached to a given socket
+// once. If every socket in the pool already serves a peer then
+// an additional socket is created.
+//
+// The number of sockets may be set with the environment variable
+// CPSW_UDP_MUX_SOCKETS (default: 4) before the pool is first used.
+
+class IUdpMuxHandler {
+public:
+	// a datagram of 'got' bytes from the attached peer was
+	// received into 'rxBufs'; the handler must 'harvest' it
+	// (or leave it to be overwritten). Executed by a reactor
+	// thread; must not block.
+	virtual void handleInput(CSockRxBufs *rxBufs, ssize_t got) = 0;
+
+	virtual ~IUdpMuxHandler() {}
+};
+
+class CUdpMuxSock : public IReactorHandler {
+private:
+	struct Peer {
+		struct sockaddr_in addr_;
+		IUdpMuxHandler    *hdlr_;
+		unsigned           pollSecs_;
+		unsigned           pollCnt_;  // seconds until next poll
+		bool               active_;
+	};
+
+	typedef std::map<uint64_t, Peer> PeerMap;
+
+	CSockSd          sd_;
+	CSockRxBufs      rxBufs_;
+	CMtx             mtx_;
+	PeerMap          peers_;
+	uint64_t         handle_;
+	unsigned         rcvBufSize_;
+	unsigned         sndBufSize_;
+	atomic<uint64_t> nDgrams_;
+	atomic<uint64_t> nOctets_;
+	atomic<uint64_t> nStray_;     // from unknown (or inactive) peers
+	atomic<uint32_t> kernDrops_;
+
+	CUdpMuxSock(const CUdpMuxSock&);
+	CUdpMuxSock & operator=(const CUdpMuxSock&);
+
+	void sendPoll(const struct sockaddr_in *peer);
+
+public:
+	// max. datagrams handled per invocation
+	static const unsigned RX_BATCH = 32;
+
+	static uint64_t key(const struct sockaddr_in *peer);
+
+	CUdpMuxSock();
+
+	int      getSd() const { return sd_.getSd(); }
+	unsigned getPort();
+
+	bool     hasPeer(const struct sockaddr_in *peer);
+	unsigned getNumPeers();
+
+	// 'pollSecs' (if > 0): send an empty datagram to the
+	// peer periodically (and when it is activated)
+	void     attach(const struct sockaddr_in *peer, IUdpMuxHandler *hdlr, unsigned pollSecs);
+	// waits for the handler to return if it is executing
+	void     detach(const struct sockaddr_in *peer);
+
+	// datagrams from an inactive peer are discarded
+	void     setActive(const struct sockaddr_in *peer, bool active);
+
+	// the socket buffers are shared; the biggest size
+	// requested by any peer is used
+	void     raiseBufSizes(unsigned rcvBufSize, unsigned sndBufSize);
+
+	// called once a second
+	void     poll();
+
+	virtual void handleInput();
+
+	uint64_t getNumDgrams()    const { return nDgrams_.load( cpsw::memory_order_relaxed );   }
+	uint64_t getNumOctets()    const { return nOctets_.load( cpsw::memory_order_relaxed );   }
+	uint64_t getNumStray()     const { return nStray_.load( cpsw::memory_order_relaxed );    }
+	uint64_t getNumKernDrops() const { return kernDrops_.load( cpsw::memory_order_relaxed ); }
+
+	void dumpInfo(FILE *f);
+
+	virtual ~CUdpMuxSock();
+};
+
+class CUdpMux : public IReactorHandler {
+private:
+	CMtx                        mtx_;
+	std::vector<CUdpMuxSock*>   socks_;
+	unsigned                    poolSize_;
+	int                         timerFd_;
+	uint64_t                    timerHandle_;
+
+	CUdpMux(unsigned poolSize);
+
+	CUdpMux(const CUdpMux&);
+	CUdpMux & operator=(const CUdpMux&);
+
+	static void createTheMux();
+
+public:
+	static const unsigned DFLT_SOCKETS = 4;
+
+	// attach a peer to the least busy socket which does
+	// not serve this peer already; the handler is inactive
+	// until enabled with 'CUdpMuxSock::setActive()'
+	CUdpMuxSock *attach(const struct sockaddr_in *peer, IUdpMuxHandler *hdlr, unsigned pollSecs);
+
+	// poll timer
+	virtual void handleInput();
+
+	unsigned     getNumSockets();
+
+	void         dumpInfo(FILE *f);
+
+	static CUdpMux *getTheMux();
+
+	~CUdpMux();
+};
+
+#endif
@@ -0,0 +1,1014 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <cpsw_uring.h>
+#include <cpsw_error.h>
+#include <cpsw_stdio.h>
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#if defined(__NR_io_uring_setup) && defined(IORING_RECV_MULTISHOT)
+#define URING_SUPPORTED
+#endif
+
+//#define URING_DEBUG
+
+static CUring         *theUring  = 0;
+static pthread_once_t  uringOnce = PTHREAD_ONCE_INIT;
+
+// set in the ring thread only
+static __thread bool   onRingThread = false;
+
+#ifdef URING_SUPPORTED
+
+// buffer group of the provided receive buffers
+#define BGID 0
+
+#define KIND_BITS 3
+#define KIND_MASK ((1<<KIND_BITS) - 1)
+
+struct CUring::Reg {
+	uint64_t                 id_;
+	Kind                     kind_;
+	int                      fd_;
+	IUringHandler           *hdlr_;
+	bool                     armed_;     // operation pending in the kernel
+	bool                     busy_;      // handler executing
+	bool                     paused_;
+	bool                     removing_;
+	bool                     stopped_;   // receive failed
+	bool                     cancelSent_;
+	bool                     scatter_;   // single-shot RECVMSG into 'sbufs_'
+	CSockRxBufs             *sbufs_;
+	struct msghdr            msg_;
+	union {
+		size_t               align; // as struct cmsghdr
+		char                 buf[CSockSd::RX_CTRL_SIZE];
+	}                        ctl_;
+	struct __kernel_timespec ts_;
+
+	Reg(uint64_t id, Kind kind, int fd, IUringHandler *hdlr)
+	: id_        ( id    ),
+	  kind_      ( kind  ),
+	  fd_        ( fd    ),
+	  hdlr_      ( hdlr  ),
+	  armed_     ( false ),
+	  busy_      ( false ),
+	  paused_    ( false ),
+	  removing_  ( false ),
+	  stopped_   ( false ),
+	  cancelSent_( false ),
+	  scatter_   ( false ),
+	  sbufs_     ( NULL  )
+	{
+		memset( &msg_, 0, sizeof(msg_) );
+		memset( &ts_,  0, sizeof(ts_)  );
+	}
+
+	uint64_t userData() const
+	{
+		return (id_ << KIND_BITS) | kind_;
+	}
+
+	~Reg()
+	{
+		delete sbufs_;
+	}
+};
+
+struct CUring::SendOp {
+	Buf      buf_;
+};
+
+static int
+uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return syscall( __NR_io_uring_setup, entries, p );
+}
+
+static int
+uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0 );
+}
+
+static int
+uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+	return syscall( __NR_io_uring_register, fd, opcode, arg, nr_args );
+}
+
+template <typename T> static inline T
+loadAcquire(T *p)
+{
+	return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+}
+
+template <typename T> static inline void
+storeRelease(T *p, T v)
+{
+	__atomic_store_n( p, v, __ATOMIC_RELEASE );
+}
+
+CUring::CRingThread::CRingThread(const char *name, CUring *uring)
+: CRunnable( name ),
+  uring_   ( uring )
+{
+}
+
+void *
+CUring::CRingThread::threadBody()
+{
+unsigned n;
+
+	onRingThread = true;
+
+	while ( 1 ) {
+		// SQEs that 'flush' could not submit (from the ring
+		// thread) are submitted here.
+		n = uring_->sqPending();
+		if ( uring_enter( uring_->fd_, n, 1, IORING_ENTER_GETEVENTS ) < 0 ) {
+			if ( EINTR != errno && EBUSY != errno && EAGAIN != errno ) {
+				throw InternalError( "CUring: io_uring_enter failed", errno );
+			}
+		}
+		uring_->nWakeups_.fetch_add( 1, cpsw::memory_order_relaxed );
+		uring_->reap();
+	}
+	return NULL;
+}
+
+CUring::CUring()
+: fd_         ( -1          ),
+  sqMem_      ( MAP_FAILED  ),
+  sqMemSz_    ( 0           ),
+  cqMem_      ( MAP_FAILED  ),
+  cqMemSz_    ( 0           ),
+  sqeMem_     ( MAP_FAILED  ),
+  sqeMemSz_   ( 0           ),
+  sqTailLocal_( 0           ),
+  sqMtx_      ( "CUring SQ" ),
+  submitting_ ( false       ),
+  bufRing_    ( MAP_FAILED  ),
+  haveBufRing_( false       ),
+  bufTail_    ( 0           ),
+  mtx_        ( "CUring"    ),
+  nextId_     ( 1           ),
+  txPending_  ( 0           ),
+  nWakeups_   ( 0           ),
+  nCqes_      ( 0           ),
+  nSubmits_   ( 0           ),
+  nSqes_      ( 0           ),
+  nDeferred_  ( 0           ),
+  nRxBuf_     ( 0           ),
+  nRxScatter_ ( 0           ),
+  nRxNoBufs_  ( 0           ),
+  nRxTrunc_   ( 0           ),
+  nTxDgrams_  ( 0           ),
+  nTxErrors_  ( 0           ),
+  thread_     ( NULL        )
+{
+	try {
+		setup();
+	} catch ( ... ) {
+		if ( sqeMem_ != MAP_FAILED )
+			munmap( sqeMem_, sqeMemSz_ );
+		if ( cqMem_ != MAP_FAILED && cqMem_ != sqMem_ )
+			munmap( cqMem_, cqMemSz_ );
+		if ( sqMem_ != MAP_FAILED )
+			munmap( sqMem_, sqMemSz_ );
+		if ( fd_ >= 0 )
+			close( fd_ );
+		throw;
+	}
+
+	setupBufRing();
+
+	thread_ = new CRingThread( "CPSW io_uring", this );
+	thread_->threadStart();
+}
+
+void
+CUring::setup()
+{
+struct io_uring_params  p;
+struct io_uring_probe  *probe;
+unsigned                i;
+size_t                  probeSz = sizeof(*probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+static const int        ops[]   = { IORING_OP_RECVMSG, IORING_OP_SEND, IORING_OP_TIMEOUT,
+                                    IORING_OP_TIMEOUT_REMOVE, IORING_OP_ASYNC_CANCEL };
+
+	memset( &p, 0, sizeof(p) );
+	p.flags      = IORING_SETUP_CQSIZE;
+	p.cq_entries = CQ_ENTRIES;
+
+	if ( (fd_ = uring_setup( SQ_ENTRIES, &p )) < 0 ) {
+		throw InternalError( "CUring: io_uring_setup failed", errno );
+	}
+
+	if ( ! (p.features & IORING_FEAT_NODROP) ) {
+		throw InternalError( "CUring: kernel too old (no IORING_FEAT_NODROP)" );
+	}
+
+	probe = static_cast<struct io_uring_probe*>( calloc( 1, probeSz ) );
+	if ( ! probe ) {
+		throw InternalError( "CUring: no memory" );
+	}
+	if ( uring_register( fd_, IORING_REGISTER_PROBE, probe, IORING_OP_LAST ) < 0 ) {
+		int err = errno;
+		free( probe );
+		throw InternalError( "CUring: unable to probe supported operations", err );
+	}
+	for ( i = 0; i < sizeof(ops)/sizeof(ops[0]); i++ ) {
+		if ( ops[i] > probe->last_op || ! (probe->ops[ ops[i] ].flags & IO_URING_OP_SUPPORTED) ) {
+			free( probe );
+			throw InternalError( "CUring: kernel lacks support for required operations" );
+		}
+	}
+	free( probe );
+
+	sqMemSz_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	cqMemSz_ = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+
+	if ( (p.features & IORING_FEAT_SINGLE_MMAP) ) {
+		if ( cqMemSz_ > sqMemSz_ )
+			sqMemSz_ = cqMemSz_;
+		cqMemSz_ = sqMemSz_;
+	}
+
+	sqMem_ = mmap( 0, sqMemSz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING );
+	if ( MAP_FAILED == sqMem_ ) {
+		throw InternalError( "CUring: unable to map SQ ring", errno );
+	}
+	if ( (p.features & IORING_FEAT_SINGLE_MMAP) ) {
+		cqMem_ = sqMem_;
+	} else {
+		cqMem_ = mmap( 0, cqMemSz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING );
+		if ( MAP_FAILED == cqMem_ ) {
+			throw InternalError( "CUring: unable to map CQ ring", errno );
+		}
+	}
+	sqeMemSz_ = p.sq_entries * sizeof(struct io_uring_sqe);
+	sqeMem_   = mmap( 0, sqeMemSz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES );
+	if ( MAP_FAILED == sqeMem_ ) {
+		throw InternalError( "CUring: unable to map SQEs", errno );
+	}
+
+	sqHead_    = reinterpret_cast<unsigned*>( static_cast<char*>( sqMem_ ) + p.sq_off.head );
+	sqTail_    = reinterpret_cast<unsigned*>( static_cast<char*>( sqMem_ ) + p.sq_off.tail );
+	sqMask_    = *reinterpret_cast<unsigned*>( static_cast<char*>( sqMem_ ) + p.sq_off.ring_mask );
+	sqEntries_ = p.sq_entries;
+	cqHead_    = reinterpret_cast<unsigned*>( static_cast<char*>( cqMem_ ) + p.cq_off.head );
+	cqTail_    = reinterpret_cast<unsigned*>( static_cast<char*>( cqMem_ ) + p.cq_off.tail );
+	cqMask_    = *reinterpret_cast<unsigned*>( static_cast<char*>( cqMem_ ) + p.cq_off.ring_mask );
+	cqes_      = static_cast<char*>( cqMem_ ) + p.cq_off.cqes;
+
+	// SQEs are always used in order
+	for ( i = 0; i < p.sq_entries; i++ ) {
+		reinterpret_cast<unsigned*>( static_cast<char*>( sqMem_ ) + p.sq_off.array )[i] = i;
+	}
+	sqTailLocal_ = *sqTail_;
+}
+
+// Register the ring of provided buffers (linux >= 5.19); if
+// this fails then all receives scatter into per-socket buffers.
+void
+CUring::setupBufRing()
+{
+struct io_uring_buf_reg reg;
+size_t                  sz = NUM_RX_BUFS * sizeof(struct io_uring_buf);
+unsigned                bid;
+
+	bufRing_ = mmap( 0, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( MAP_FAILED == bufRing_ ) {
+		return;
+	}
+
+	memset( &reg, 0, sizeof(reg) );
+	reg.ring_addr    = reinterpret_cast<uintptr_t>( bufRing_ );
+	reg.ring_entries = NUM_RX_BUFS;
+	reg.bgid         = BGID;
+
+	if ( uring_register( fd_, IORING_REGISTER_PBUF_RING, &reg, 1 ) < 0 ) {
+		fprintf( CPSW::fErr(), "CUring: unable to register provided buffers (%s); using scatter receives\n", strerror( errno ) );
+		munmap( bufRing_, sz );
+		bufRing_ = MAP_FAILED;
+		return;
+	}
+
+	rxBufs_.resize( NUM_RX_BUFS );
+	bufTail_ = 0;
+	for ( bid = 0; bid < NUM_RX_BUFS; bid++ ) {
+		provideBuf( bid );
+	}
+	publishBufs();
+
+	haveBufRing_ = true;
+}
+
+// NOTE: the ring is accessed as an array of io_uring_buf; the
+// tail overlays the 'resv' member of the first entry. (Don't
+// use io_uring_buf_ring in C++: the flexible array is preceded
+// by an empty struct which has non-zero size in C++.)
+
+// Only executed by the constructor and the ring thread
+void
+CUring::provideBuf(unsigned bid)
+{
+struct io_uring_buf *b = &static_cast<struct io_uring_buf*>( bufRing_ )[ bufTail_ & (NUM_RX_BUFS - 1) ];
+
+	rxBufs_[bid] = IBuf::getBuf( IBuf::CAPA_ETH_BIG );
+	b->addr      = reinterpret_cast<uintptr_t>( rxBufs_[bid]->getPayload() );
+	b->len       = rxBufs_[bid]->getAvail();
+	b->bid       = bid;
+	bufTail_++;
+}
+
+void
+CUring::publishBufs()
+{
+	storeRelease( &static_cast<struct io_uring_buf*>( bufRing_ )[0].resv, (__u16)bufTail_ );
+}
+
+void *
+CUring::getSqe()
+{
+struct io_uring_sqe *sqe;
+
+	if ( sqTailLocal_ - loadAcquire( sqHead_ ) >= sqEntries_ ) {
+		return NULL;
+	}
+	sqe = &static_cast<struct io_uring_sqe*>( sqeMem_ )[ sqTailLocal_ & sqMask_ ];
+	memset( sqe, 0, sizeof(*sqe) );
+	return sqe;
+}
+
+void
+CUring::putSqe()
+{
+	storeRelease( sqTail_, ++sqTailLocal_ );
+}
+
+unsigned
+CUring::sqPending()
+{
+	return loadAcquire( sqTail_ ) - loadAcquire( sqHead_ );
+}
+
+// Hand the queued SQEs to the kernel. If another thread is
+// already doing so then we leave ours to that thread; SQEs
+// queued by concurrent threads are thus submitted in batches.
+//
+// EBUSY/EAGAIN means that completions must be reaped first.
+// Other threads wait for the ring thread to do so. The ring
+// thread itself (handlers call 'resume', 'armTimer' etc.)
+// moves completions off the CQ ring into a backlog which is
+// processed by 'reap' (handlers are not re-entered). If that
+// does not help then submission is left to the ring loop.
+void
+CUring::flush()
+{
+unsigned n;
+int      got;
+unsigned busy = 0;
+
+	if ( submitting_.exchange( true, cpsw::memory_order_acquire ) ) {
+		return;
+	}
+
+	while ( 1 ) {
+		while ( (n = sqPending()) > 0 ) {
+			if ( (got = uring_enter( fd_, n, 0, 0 )) < 0 ) {
+				if ( EINTR == errno )
+					continue;
+				if ( EAGAIN == errno || EBUSY == errno ) {
+					if ( ! onRingThread ) {
+						sched_yield();
+						continue;
+					}
+					if ( ++busy <= 2 ) {
+						drainCq();
+						// let the kernel move overflowed CQEs to the ring
+						uring_enter( fd_, 0, 0, IORING_ENTER_GETEVENTS );
+						drainCq();
+						continue;
+					}
+					nDeferred_.fetch_add( 1, cpsw::memory_order_relaxed );
+					submitting_.store( false, cpsw::memory_order_release );
+					return;
+				}
+				submitting_.store( false, cpsw::memory_order_release );
+				throw InternalError( "CUring: io_uring_enter (submit) failed", errno );
+			}
+			nSubmits_.fetch_add( 1,   cpsw::memory_order_relaxed );
+			nSqes_.fetch_add   ( got, cpsw::memory_order_relaxed );
+		}
+		submitting_.store( false, cpsw::memory_order_release );
+		// SQEs queued while we were releasing the flag?
+		if ( 0 == sqPending() || submitting_.exchange( true, cpsw::memory_order_acquire ) ) {
+			break;
+		}
+	}
+}
+
+// Submit the operation for 'reg'; caller holds 'mtx_'
+void
+CUring::arm(Reg *reg)
+{
+struct io_uring_sqe *sqe;
+
+	{
+	CMtx::lg GUARD( &sqMtx_ );
+
+		while ( ! (sqe = static_cast<struct io_uring_sqe*>( getSqe() )) ) {
+			sqMtx_.u();
+			flush();
+			sched_yield();
+			sqMtx_.l();
+		}
+
+		sqe->fd        = reg->fd_;
+		sqe->user_data = reg->userData();
+
+		if ( KIND_TIMER == reg->kind_ ) {
+			sqe->opcode = IORING_OP_TIMEOUT;
+			sqe->addr   = reinterpret_cast<uintptr_t>( &reg->ts_ );
+			sqe->len    = 1;
+			sqe->fd     = -1;
+		} else if ( reg->scatter_ ) {
+			reg->msg_.msg_iov        = reg->sbufs_->getIov();
+			reg->msg_.msg_iovlen     = reg->sbufs_->getNumIovs();
+			reg->msg_.msg_control    = reg->ctl_.buf;
+			reg->msg_.msg_controllen = sizeof(reg->ctl_.buf);
+			reg->msg_.msg_flags      = 0;
+			sqe->opcode = IORING_OP_RECVMSG;
+			sqe->addr   = reinterpret_cast<uintptr_t>( &reg->msg_ );
+			sqe->len    = 1;
+		} else {
+			// the buffer holds an io_uring_recvmsg_out header,
+			// the control messages and then the payload
+			reg->msg_.msg_iov        = NULL;
+			reg->msg_.msg_iovlen     = 0;
+			reg->msg_.msg_control    = reg->ctl_.buf;
+			reg->msg_.msg_controllen = sizeof(reg->ctl_.buf);
+			reg->msg_.msg_flags      = 0;
+			sqe->opcode    = IORING_OP_RECVMSG;
+			sqe->addr      = reinterpret_cast<uintptr_t>( &reg->msg_ );
+			sqe->len       = 1;
+			sqe->ioprio    = IORING_RECV_MULTISHOT;
+			sqe->flags     = IOSQE_BUFFER_SELECT;
+			sqe->buf_group = BGID;
+		}
+
+		putSqe();
+	}
+
+	reg->armed_      = true;
+	reg->cancelSent_ = false;
+}
+
+// Request cancellation of the pending operation; caller holds 'mtx_'
+void
+CUring::cancel(Reg *reg)
+{
+struct io_uring_sqe *sqe;
+
+	if ( ! reg->armed_ || reg->cancelSent_ ) {
+		return;
+	}
+
+	{
+	CMtx::lg GUARD( &sqMtx_ );
+
+		while ( ! (sqe = static_cast<struct io_uring_sqe*>( getSqe() )) ) {
+			sqMtx_.u();
+			flush();
+			sched_yield();
+			sqMtx_.l();
+		}
+
+		sqe->opcode    = KIND_TIMER == reg->kind_ ? IORING_OP_TIMEOUT_REMOVE : IORING_OP_ASYNC_CANCEL;
+		sqe->fd        = -1;
+		sqe->addr      = reg->userData();
+		sqe->user_data = KIND_CANCEL;
+
+		putSqe();
+	}
+
+	reg->cancelSent_ = true;
+}
+
+uint64_t
+CUring::addRecv(int fd, IUringHandler *hdlr)
+{
+Reg      *reg;
+uint64_t  id;
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+
+		id  = nextId_++;
+		reg = new Reg( id, KIND_RECV, fd, hdlr );
+		if ( ! haveBufRing_ ) {
+			reg->scatter_ = true;
+			reg->sbufs_   = new CSockRxBufs();
+		}
+		regs_[ id ] = reg;
+		arm( reg );
+	}
+
+	flush();
+
+#ifdef URING_DEBUG
+	fprintf( CPSW::fDbg(), "CUring: added fd %d (handle %" PRIu64 ")\n", fd, id );
+#endif
+
+	return id;
+}
+
+uint64_t
+CUring::addTimer(IUringHandler *hdlr)
+{
+CMtx::lg GUARD( &mtx_ );
+uint64_t id = nextId_++;
+
+	regs_[ id ] = new Reg( id, KIND_TIMER, -1, hdlr );
+	return id;
+}
+
+void
+CUring::armTimer(uint64_t handle, unsigned long us)
+{
+RegMap::iterator it;
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+
+		if ( (it = regs_.find( handle )) == regs_.end() ) {
+			return;
+		}
+		if ( it->second->armed_ || it->second->removing_ ) {
+			return;
+		}
+		it->second->ts_.tv_sec  = us / 1000000;
+		it->second->ts_.tv_nsec = (us % 1000000) * 1000;
+		arm( it->second );
+	}
+
+	flush();
+}
+
+void
+CUring::resume(uint64_t handle)
+{
+RegMap::iterator it;
+Reg             *reg;
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+
+		if ( (it = regs_.find( handle )) == regs_.end() ) {
+			return;
+		}
+		reg          = it->second;
+		reg->paused_ = false;
+		if ( reg->armed_ || reg->removing_ || reg->stopped_ ) {
+			// a pending cancellation re-arms on completion
+			return;
+		}
+		arm( reg );
+	}
+
+	flush();
+}
+
+void
+CUring::remove(uint64_t handle)
+{
+RegMap::iterator it;
+Reg             *reg;
+
+	CMtx::lg GUARD( &mtx_ );
+
+	if ( (it = regs_.find( handle )) == regs_.end() ) {
+		return;
+	}
+	reg            = it->second;
+	reg->removing_ = true;
+
+	while ( reg->armed_ || reg->busy_ ) {
+		if ( reg->armed_ && ! reg->cancelSent_ ) {
+			cancel( reg );
+			mtx_.u();
+			flush();
+			mtx_.l();
+			continue;
+		}
+		pthread_cond_wait( idle_.getp(), mtx_.getp() );
+	}
+
+	regs_.erase( handle );
+	delete reg;
+}
+
+bool
+CUring::send(int fd, BufChain bc)
+{
+struct io_uring_sqe *sqe;
+SendOp              *op;
+size_t               sz = bc->getSize();
+
+	if ( txPending_.load( cpsw::memory_order_relaxed ) >= MAX_TX_PENDING ) {
+		return false;
+	}
+
+	op       = new SendOp();
+	op->buf_ = IBuf::getBuf( sz, true );
+	if ( op->buf_->getAvail() < sz ) {
+		delete op;
+		return false;
+	}
+	// a copy; upper layers (e.g., RSSI) modify and re-send
+	// frames they hold on to
+	bc->extract( op->buf_->getPayload(), 0, sz );
+	op->buf_->setSize( sz );
+
+	{
+	CMtx::lg GUARD( &sqMtx_ );
+
+		if ( ! (sqe = static_cast<struct io_uring_sqe*>( getSqe() )) ) {
+			delete op;
+			return false;
+		}
+
+		sqe->opcode    = IORING_OP_SEND;
+		sqe->fd        = fd;
+		sqe->addr      = reinterpret_cast<uintptr_t>( op->buf_->getPayload() );
+		sqe->len       = sz;
+		sqe->msg_flags = MSG_NOSIGNAL;
+		sqe->user_data = reinterpret_cast<uintptr_t>( op ) | KIND_SEND;
+
+		putSqe();
+	}
+
+	txPending_.fetch_add( 1, cpsw::memory_order_relaxed );
+
+	flush();
+
+	return true;
+}
+
+// Only executed by the ring thread
+void
+CUring::drainCq()
+{
+unsigned             head = *cqHead_;
+struct io_uring_cqe *cqe;
+Cqe                  c;
+
+	while ( head != loadAcquire( cqTail_ ) ) {
+		cqe          = &static_cast<struct io_uring_cqe*>( cqes_ )[ head & cqMask_ ];
+		c.user_data_ = cqe->user_data;
+		c.res_       = cqe->res;
+		c.flags_     = cqe->flags;
+		cqBacklog_.push_back( c );
+		storeRelease( cqHead_, ++head );
+		nCqes_.fetch_add( 1, cpsw::memory_order_relaxed );
+	}
+}
+
+// Only executed by the ring thread; the backlog holds
+// older completions than the ring.
+bool
+CUring::nextCqe(Cqe *c)
+{
+unsigned             head;
+struct io_uring_cqe *cqe;
+
+	if ( ! cqBacklog_.empty() ) {
+		*c = cqBacklog_.front();
+		cqBacklog_.pop_front();
+		return true;
+	}
+
+	head = *cqHead_;
+	if ( head == loadAcquire( cqTail_ ) ) {
+		return false;
+	}
+	cqe           = &static_cast<struct io_uring_cqe*>( cqes_ )[ head & cqMask_ ];
+	c->user_data_ = cqe->user_data;
+	c->res_       = cqe->res;
+	c->flags_     = cqe->flags;
+	storeRelease( cqHead_, ++head );
+	nCqes_.fetch_add( 1, cpsw::memory_order_relaxed );
+	return true;
+}
+
+// Only executed by the ring thread
+void
+CUring::reap()
+{
+Cqe  cqe;
+bool prov = false;
+
+	while ( nextCqe( &cqe ) ) {
+		if ( (cqe.flags_ & IORING_CQE_F_BUFFER) ) {
+			prov = true;
+		}
+
+		try {
+			complete( cqe.user_data_, cqe.res_, cqe.flags_ );
+		} catch ( CPSWError &e ) {
+			fprintf( CPSW::fErr(), "CUring: handler threw exception: %s\n", e.getInfo().c_str() );
+		}
+	}
+
+	if ( prov ) {
+		publishBufs();
+	}
+
+	flush();
+}
+
+void
+CUring::complete(uint64_t user_data, int32_t res, uint32_t flags)
+{
+RegMap::iterator it;
+Reg             *reg;
+
+	switch ( (Kind)(user_data & KIND_MASK) ) {
+		case KIND_CANCEL:
+			return;
+
+		case KIND_SEND:
+			completeSend( reinterpret_cast<SendOp*>( user_data & ~(uint64_t)KIND_MASK ), res );
+			return;
+
+		default:
+			break;
+	}
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+		if ( (it = regs_.find( user_data >> KIND_BITS )) == regs_.end() ) {
+			reg = NULL;
+		} else {
+			reg        = it->second;
+			reg->busy_ = true;
+		}
+	}
+
+	if ( ! reg ) {
+		// cannot happen; recycle a provided buffer anyways
+		if ( (flags & IORING_CQE_F_BUFFER) ) {
+			provideBuf( flags >> IORING_CQE_BUFFER_SHIFT );
+		}
+		return;
+	}
+
+	if ( KIND_TIMER == reg->kind_ ) {
+		completeTimer( reg, res );
+	} else {
+		completeRecv( reg, res, flags );
+	}
+}
+
+BufChain
+CUring::takeProvided(Reg *reg, int32_t res, uint32_t flags, CSockRxInfo *info, bool *trunc)
+{
+unsigned                     bid = flags >> IORING_CQE_BUFFER_SHIFT;
+Buf                          b   = rxBufs_[bid];
+struct io_uring_recvmsg_out *out = reinterpret_cast<struct io_uring_recvmsg_out*>( b->getPayload() );
+size_t                       off = sizeof(*out) + reg->msg_.msg_namelen + sizeof(reg->ctl_.buf);
+BufChain                     bc;
+struct msghdr                msg;
+size_t                       len;
+
+	provideBuf( bid );
+
+	nRxBuf_.fetch_add( 1, cpsw::memory_order_relaxed );
+
+	memset( &msg, 0, sizeof(msg) );
+	msg.msg_control    = reinterpret_cast<uint8_t*>( out ) + sizeof(*out) + reg->msg_.msg_namelen;
+	msg.msg_controllen = out->controllen;
+	CSockSd::parseRxInfo( &msg, info );
+
+	*trunc = !!(out->flags & MSG_TRUNC);
+
+	bc = IBufChain::create();
+
+	if ( *trunc ) {
+		return bc;
+	}
+
+	len = out->payloadlen;
+	if ( off + len > (size_t)res ) {
+		len = res > (int32_t)off ? res - off : 0;
+	}
+	if ( len > 0 ) {
+		b->setSize( off + len );
+		b->adjPayload( off );
+		bc->addAtTail( b );
+	}
+	return bc;
+}
+
+void
+CUring::completeRecv(Reg *reg, int32_t res, uint32_t flags)
+{
+bool        more  = !!(flags & IORING_CQE_F_MORE);
+bool        keep  = true;
+bool        trunc = false;
+CSockRxInfo info;
+BufChain    bc;
+
+	if ( res >= 0 ) {
+		if ( (flags & IORING_CQE_F_BUFFER) ) {
+			bc = takeProvided( reg, res, flags, &info, &trunc );
+		} else if ( reg->scatter_ ) {
+			nRxScatter_.fetch_add( 1, cpsw::memory_order_relaxed );
+			CSockSd::parseRxInfo( &reg->msg_, reg->sbufs_->getInfo() );
+			info = *reg->sbufs_->getInfo();
+			bc   = res > 0 ? reg->sbufs_->harvest( res ) : IBufChain::create();
+			trunc = !!(reg->msg_.msg_flags & MSG_TRUNC);
+		} else {
+			bc = IBufChain::create();
+		}
+		if ( trunc ) {
+			// datagram too big for a provided buffer; it is
+			// lost but subsequent ones are scattered
+			nRxTrunc_.fetch_add( 1, cpsw::memory_order_relaxed );
+			if ( ! reg->scatter_ ) {
+				fprintf( CPSW::fErr(), "CUring: datagram truncated (fd %d) -- switching to scatter receives\n", reg->fd_ );
+			}
+		} else {
+			keep = reg->hdlr_->handleRecv( bc, &info );
+		}
+	} else if ( -ENOBUFS == res ) {
+		nRxNoBufs_.fetch_add( 1, cpsw::memory_order_relaxed );
+	} else if ( -EINVAL == res && ! reg->scatter_ ) {
+		// multishot not supported by this kernel/socket
+		trunc = true;
+	} else if ( -ECANCELED != res ) {
+		reg->hdlr_->handleError( -res );
+		reg->stopped_ = true;
+	}
+
+	CMtx::lg GUARD( &mtx_ );
+
+	reg->busy_ = false;
+
+	if ( ! keep ) {
+		reg->paused_ = true;
+	}
+	if ( trunc && ! reg->scatter_ ) {
+		reg->scatter_ = true;
+		reg->sbufs_   = new CSockRxBufs();
+	}
+
+	if ( more ) {
+		if ( reg->paused_ || reg->removing_ || reg->scatter_ ) {
+			cancel( reg );
+		}
+	} else {
+		reg->armed_ = false;
+		if ( ! reg->paused_ && ! reg->removing_ && ! reg->stopped_ ) {
+			arm( reg );
+		}
+	}
+
+	// 'remove' may be waiting for us
+	pthread_cond_broadcast( idle_.getp() );
+}
+
+void
+CUring::completeTimer(Reg *reg, int32_t res)
+{
+bool fire;
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+		reg->armed_ = false;
+		fire        = -ETIME == res && ! reg->removing_;
+	}
+
+	if ( fire ) {
+		reg->hdlr_->handleTimer();
+	}
+
+	CMtx::lg GUARD( &mtx_ );
+
+	reg->busy_ = false;
+	pthread_cond_broadcast( idle_.getp() );
+}
+
+void
+CUring::completeSend(SendOp *op, int32_t res)
+{
+	txPending_.fetch_sub( 1, cpsw::memory_order_relaxed );
+	if ( res < 0 ) {
+		// same as a failing 'writev': the datagram is dropped
+		if ( 0 == nTxErrors_.fetch_add( 1, cpsw::memory_order_relaxed ) ) {
+			fprintf( CPSW::fErr(), "CUring: send failed (%s) -- dropping datagram\n", strerror( -res ) );
+		}
+	} else {
+		nTxDgrams_.fetch_add( 1, cpsw::memory_order_relaxed );
+	}
+	delete op;
+}
+
+void
+CUring::dumpInfo(FILE *f)
+{
+unsigned n;
+uint64_t s;
+	{
+	CMtx::lg GUARD( &mtx_ );
+		n = regs_.size();
+	}
+	s = getNumSubmits();
+	fprintf(f, "CUring:\n");
+	fprintf(f, "  Handlers  : %15u\n",          n);
+	fprintf(f, "  Prov. bufs: %15u\n",          haveBufRing_ ? NUM_RX_BUFS : 0);
+	fprintf(f, "  Wakeups   : %15" PRIu64 "\n", getNumWakeups());
+	fprintf(f, "  CQEs      : %15" PRIu64 "\n", getNumCqes());
+	fprintf(f, "  Submits   : %15" PRIu64 "\n", s);
+	if ( s ) {
+	fprintf(f, "  SQEs/sub. : %15.1f\n",        (double)getNumSqes()/(double)s);
+	}
+	fprintf(f, "  Deferred  : %15" PRIu64 "\n", nDeferred_.load( cpsw::memory_order_relaxed ));
+	fprintf(f, "  #RX bufs  : %15" PRIu64 "\n", nRxBuf_.load( cpsw::memory_order_relaxed ));
+	fprintf(f, "  #RX scatt.: %15" PRIu64 "\n", nRxScatter_.load( cpsw::memory_order_relaxed ));
+	fprintf(f, "  #RX nobufs: %15" PRIu64 "\n", nRxNoBufs_.load( cpsw::memory_order_relaxed ));
+	fprintf(f, "  #RX trunc.: %15" PRIu64 "\n", nRxTrunc_.load( cpsw::memory_order_relaxed ));
+	fprintf(f, "  #TX DGRAMs: %15" PRIu64 "\n", nTxDgrams_.load( cpsw::memory_order_relaxed ));
+	fprintf(f, "  #TX errors: %15" PRIu64 "\n", nTxErrors_.load( cpsw::memory_order_relaxed ));
+}
+
+void
+CUring::createTheUring()
+{
+	try {
+		theUring = new CUring();
+	} catch ( CPSWError &e ) {
+		fprintf( CPSW::fErr(), "%s -- io_uring not available\n", e.getInfo().c_str() );
+		theUring = 0;
+	}
+}
+
+#else /* URING_SUPPORTED */
+
+// Stubs; 'getTheUring()' always returns NULL and
+// nothing else is ever called.
+
+CUring::CUring()                                            { throw InternalError("CUring: not supported"); }
+uint64_t CUring::addRecv(int fd, IUringHandler *hdlr)       { throw InternalError("CUring: not supported"); }
+void     CUring::resume(uint64_t handle)                    { throw InternalError("CUring: not supported"); }
+uint64_t CUring::addTimer(IUringHandler *hdlr)              { throw InternalError("CUring: not supported"); }
+void     CUring::armTimer(uint64_t handle, unsigned long us){ throw InternalError("CUring: not supported"); }
+void     CUring::remove(uint64_t handle)                    { throw InternalError("CUring: not supported"); }
+bool     CUring::send(int fd, BufChain bc)                  { throw InternalError("CUring: not supported"); }
+void     CUring::dumpInfo(FILE *f)                          {}
+
+void
+CUring::createTheUring()
+{
+	fprintf( CPSW::fErr(), "CUring: io_uring not supported by this build\n" );
+	theUring = 0;
+}
+
+#endif /* URING_SUPPORTED */
+
+// The ring is never destroyed; its thread lives as long as
+// the process.
+CUring::~CUring()
+{
+}
+
+CUring *
+CUring::getTheUring()
+{
+	pthread_once( &uringOnce, createTheUring );
+	return theUring;
+}
@@ -0,0 +1,256 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef CPSW_URING_H
+#define CPSW_URING_H
+
+#include <cpsw_buf.h>
+#include <cpsw_sock.h>
+#include <cpsw_thread.h>
+#include <cpsw_mutex.h>
+#include <cpsw_condvar.h>
+#include <cpsw_compat.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <map>
+#include <vector>
+#include <deque>
+
+using cpsw::atomic;
+
+// io_uring transport backend: a single (process-wide) ring,
+// serviced by a single thread, handles the receive side of
+// any number of sockets and the transmit side of datagram
+// sockets.
+//
+//  - receives are 'multishot' RECVMSG operations which pick
+//    their buffers from a ring of IBufs registered with the
+//    kernel ('provided buffers'). A completion hands the IBuf
+//    (holding the datagram or stream segment) to the handler
+//    and a fresh IBuf is provided in its place.
+//    Datagrams which do not fit into a single IBuf are
+//    received (after dropping the truncated one) by
+//    single-shot RECVMSG operations which scatter into a
+//    set of IBufs. The same mode is used if the kernel
+//    does not support provided buffers or multishot
+//    receives.
+//  - transmissions are queued and submitted right away by
+//    the sending thread unless another thread is submitting
+//    already; in that case the latter picks them up, i.e.,
+//    only frames pushed by concurrent threads are submitted
+//    in batches (a single sender makes one system call per
+//    frame, like 'writev').
+//  - timers (for polling peers etc.) are ring operations too.
+//
+// The ring is created when it is first used; 'getTheUring()'
+// returns NULL if the kernel (or the headers CPSW was built
+// against) lack support. Callers are expected to fall back
+// to another transport in this case.
+//
+// All handlers are executed by the ring thread and must not
+// block.
+
+class IUringHandler {
+public:
+	// Data were received; 'bc' holds a datagram (or a segment
+	// of a stream) and carries the kernel receive timestamp.
+	// An empty chain indicates a zero-length datagram (or, on
+	// a stream socket, end-of-file).
+	// RETURNS 'false' to pause reception (see CUring::resume()).
+	virtual bool handleRecv(BufChain bc, const CSockRxInfo *info) = 0;
+
+	// reception failed ('err' is an errno value); the
+	// receive operation is not re-armed.
+	virtual void handleError(int err)                             = 0;
+
+	// a timer armed by CUring::armTimer() expired
+	virtual void handleTimer()                                    {}
+
+	virtual ~IUringHandler() {}
+};
+
+class CUring {
+private:
+	class CRingThread : public CRunnable {
+	private:
+		CUring *uring_;
+	protected:
+		virtual void *threadBody();
+	public:
+		CRingThread(const char *name, CUring *uring);
+		virtual ~CRingThread() { threadStop(); }
+	};
+
+	typedef enum { KIND_RECV = 0, KIND_TIMER = 1, KIND_SEND = 2, KIND_CANCEL = 3 } Kind;
+
+	struct Reg;
+	struct SendOp;
+
+	// a completion taken off the CQ ring but not yet processed
+	struct Cqe {
+		uint64_t user_data_;
+		int32_t  res_;
+		uint32_t flags_;
+	};
+
+	typedef std::map<uint64_t, Reg*> RegMap;
+
+	int                       fd_;
+	void                     *sqMem_;
+	size_t                    sqMemSz_;
+	void                     *cqMem_;
+	size_t                    cqMemSz_;
+	void                     *sqeMem_;
+	size_t                    sqeMemSz_;
+	unsigned                 *sqHead_;
+	unsigned                 *sqTail_;
+	unsigned                  sqMask_;
+	unsigned                  sqEntries_;
+	unsigned                  sqTailLocal_;
+	unsigned                 *cqHead_;
+	unsigned                 *cqTail_;
+	unsigned                  cqMask_;
+	void                     *cqes_;
+	CMtx                      sqMtx_;      // protects SQE allocation
+	atomic<bool>              submitting_;
+	// completions moved off the CQ ring by 'flush' when
+	// it is executed by the ring thread (ring thread only)
+	std::deque<Cqe>           cqBacklog_;
+
+	// provided buffers
+	void                     *bufRing_;
+	bool                      haveBufRing_;
+	unsigned                  bufTail_;
+	std::vector<Buf>          rxBufs_;
+
+	CMtx                      mtx_;        // protects regs_
+	CCond                     idle_;
+	RegMap                    regs_;
+	uint64_t                  nextId_;
+
+	atomic<unsigned>          txPending_;
+
+	atomic<uint64_t>          nWakeups_;
+	atomic<uint64_t>          nCqes_;
+	atomic<uint64_t>          nSubmits_;
+	atomic<uint64_t>          nSqes_;
+	atomic<uint64_t>          nDeferred_;
+	atomic<uint64_t>          nRxBuf_;
+	atomic<uint64_t>          nRxScatter_;
+	atomic<uint64_t>          nRxNoBufs_;
+	atomic<uint64_t>          nRxTrunc_;
+	atomic<uint64_t>          nTxDgrams_;
+	atomic<uint64_t>          nTxErrors_;
+
+	CRingThread              *thread_;
+
+	CUring();
+
+	static void createTheUring();
+
+	CUring(const CUring&);
+	CUring & operator=(const CUring&);
+
+	void     setup();
+	void     setupBufRing();
+	void     provideBuf(unsigned bid);
+	void     publishBufs();
+
+	// SQE management; 'getSqe' returns NULL if the SQ is
+	// full. SQEs are published to the kernel by 'flush'.
+	void    *getSqe();
+	void     putSqe();
+	void     flush();
+	unsigned sqPending();
+
+	void     arm(Reg *reg);
+	void     cancel(Reg *reg);
+
+	void     reap();
+	bool     nextCqe(Cqe *cqe);
+	void     drainCq();
+	void     complete(uint64_t user_data, int32_t res, uint32_t flags);
+	void     completeRecv(Reg *reg, int32_t res, uint32_t flags);
+	void     completeTimer(Reg *reg, int32_t res);
+	void     completeSend(SendOp *op, int32_t res);
+
+	BufChain takeProvided(Reg *reg, int32_t res, uint32_t flags, CSockRxInfo *info, bool *trunc);
+
+public:
+	static const unsigned SQ_ENTRIES     = 256;
+	static const unsigned CQ_ENTRIES     = 4096;
+	// number of provided (receive) buffers; power of two
+	static const unsigned NUM_RX_BUFS    = 256;
+	// max. number of transmissions in flight
+	static const unsigned MAX_TX_PENDING = 1024;
+
+	// Register a receive handler for 'fd'; reception starts
+	// right away. RETURNS a handle to be passed to 'remove'.
+	uint64_t addRecv(int fd, IUringHandler *hdlr);
+
+	// Resume reception paused by the handler (may be called
+	// from any thread, including the ring thread).
+	void     resume(uint64_t handle);
+
+	// Create a timer for 'hdlr'; the timer is idle until it
+	// is armed.
+	uint64_t addTimer(IUringHandler *hdlr);
+
+	// Arm a timer (one-shot); no-op if already armed.
+	void     armTimer(uint64_t handle, unsigned long us);
+
+	// Deregister a receive handler or timer; waits until
+	// the associated operation is cancelled (and the handler,
+	// if it is executing, returns). Must not be called from
+	// the ring thread.
+	void     remove(uint64_t handle);
+
+	// Send the contents of 'bc' as a single datagram. The
+	// data are copied (callers may modify or re-send 'bc'
+	// once this returns). RETURNS 'false' (and the caller
+	// must use another path) if the datagram cannot be
+	// queued (too big, too many transmissions in flight).
+	bool     send(int fd, BufChain bc);
+
+	bool     hasProvidedBufs() const
+	{
+		return haveBufRing_;
+	}
+
+	uint64_t getNumWakeups() const
+	{
+		return nWakeups_.load( cpsw::memory_order_relaxed );
+	}
+
+	uint64_t getNumCqes() const
+	{
+		return nCqes_.load( cpsw::memory_order_relaxed );
+	}
+
+	uint64_t getNumSubmits() const
+	{
+		return nSubmits_.load( cpsw::memory_order_relaxed );
+	}
+
+	uint64_t getNumSqes() const
+	{
+		return nSqes_.load( cpsw::memory_order_relaxed );
+	}
+
+	void dumpInfo(FILE *f);
+
+	// RETURNS NULL if io_uring is not supported
+	static CUring *getTheUring();
+
+	~CUring();
+};
+
+#endif
@@ -14,6 +14,8 @@
 #include <cpsw_compat.h>
 
 #include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 #include <cpsw_api_user.h>
 #include <cpsw_api_builder.h>
@@ -28,6 +30,7 @@
 #include <cpsw_null_dev.h>
 #include <cpsw_mmio_dev.h>
 #include <cpsw_netio_dev.h>
+#include <cpsw_dev_startup.h>
 #include <cpsw_command.h>
 #include <cpsw_preproc.h>
 #include <cpsw_yaml_merge.h>
@@ -70,18 +73,6 @@ PNode::dump( FILE *f ) const
 	fprintf( f, "PNode key: %s, p: %p\n" , key_, parent_ );
 }
 
-class StartupVisitor : public IVisitor {
-public:
-	virtual void visit( Field f )
-	{
-	}
-
-	virtual void visit( Dev   d )
-	{
-		d->startUp();
-	}
-};
-
 
 #if 0
 // assign a new Node to this PNode while preserving parent/child/key
@@ -511,11 +502,72 @@ public:
 	}
 };
 
+// The retained 'children' node of a Dev; the children are
+// created when the Dev first needs them.
+class CYamlLazyChildren : public ILazyChildren {
+private:
+	YAML::Node                         children_;
+	std::string                        path_;     // for messages
+	IYamlFactoryBase<Field>::Registry  registry_;
+
+public:
+	CYamlLazyChildren(YamlState &children, IYamlFactoryBase<Field>::Registry registry)
+	: children_( static_cast<const YAML::Node &>( children ) ),
+	  path_    ( children.toString()                       ),
+	  registry_( registry                                  )
+	{
+	YAML::const_iterator it;
+		// the keys are dealt with later
+		for ( it = children.begin(); it != children.end(); ++it ) {
+			children.keySeen( it->first.as<std::string>().c_str() );
+		}
+	}
+
+	virtual void instantiate(CDevImpl *d)
+	{
+	YamlState          children( NULL, path_.c_str(), children_ );
+	AddChildrenVisitor visitor( d, registry_ );
+
+#ifdef CPSW_YAML_DEBUG
+		if ( (cpsw_yaml_debug & CPSW_YAML_DEBUG_BUILD) ) {
+			fprintf( CPSW::fDbg(), "Adding lazy children to %s\n", d->getName());
+		}
+#endif
+		visitor.visit( &children );
+	}
+};
+
+static bool           lazyDefault = false;
+static pthread_once_t lazyOnce    = PTHREAD_ONCE_INIT;
+
+static void
+readLazyDefault()
+{
+const char *str = getenv( "CPSW_YAML_LAZY" );
+int         val;
+
+	if ( str ) {
+		if ( 1 == sscanf( str, "%i", &val ) ) {
+			lazyDefault = !! val;
+		} else {
+			fprintf( CPSW::fErr(), "CYamlFieldFactoryBase: ignoring invalid CPSW_YAML_LAZY: %s\n", str );
+		}
+	}
+}
+
+bool
+CYamlFieldFactoryBase::getDefaultLazyChildren()
+{
+	pthread_once( &lazyOnce, readLazyDefault );
+	return lazyDefault;
+}
+
 void
 CYamlFieldFactoryBase::addChildren(CDevImpl &d, YamlState &node)
 {
 YamlState           children( &node, YAML_KEY_children );
 AddChildrenVisitor  visitor( &d, getRegistry() );
+bool                lazy = getDefaultLazyChildren();
 
 #ifdef CPSW_YAML_DEBUG
 	if ( (cpsw_yaml_debug & CPSW_YAML_DEBUG_BUILD) ) {
@@ -540,8 +592,14 @@ AddChildrenVisitor  visitor( &d, getRegistry() );
 			fprintf( CPSW::fDbg(), "Adding immediate children to %s\n", d.getName());
 		}
 #endif
-		// handle the 'children' node itself
-		visitor.visit( &children );
+		readNode( node, YAML_KEY_lazyChildren, &lazy );
+
+		if ( lazy ) {
+			d.setLazyChildren( new CYamlLazyChildren( children, getRegistry() ) );
+		} else {
+			// handle the 'children' node itself
+			visitor.visit( &children );
+		}
 	} else {
 		fprintf( CPSW::fErr(), "Warning: no '%s' property in: %s%s",
 		         YAML_KEY_children,
@@ -776,9 +834,26 @@ IPath::loadYamlFile(const char *file_name, const char *root_name, const char *ya
 Path
 IYamlSupport::startHierarchy(Dev rootHub)
 {
-	StartupVisitor start;
-	rootHub->getSelf()->setLocked();
-	rootHub->accept( &start, IVisitable::RECURSE_DEPTH_FIRST );
+DevImpl  root( cpsw::dynamic_pointer_cast<CDevImpl>( rootHub->getSelf() ) );
+unsigned nrep = CDevStartup::getDefaultReport();
+
+	root->setLocked();
+
+	// independent branches are started concurrently
+	CDevStartup start( root );
+
+	try {
+		start.run();
+	} catch ( CPSWError & ) {
+		if ( nrep ) {
+			start.dumpReport( CPSW::fDbg(), nrep );
+		}
+		throw;
+	}
+	if ( nrep ) {
+		start.dumpReport( CPSW::fDbg(), nrep );
+	}
+
 	return IPath::create( rootHub );
 }
 
@@ -461,6 +461,40 @@ namespace YAML {
 			}
 		};
 
+	template<>
+		struct convert<IProtoStackBuilder::SchedPolicy> {
+			static bool decode(const Node& node, IProtoStackBuilder::SchedPolicy& rhs) {
+				if (!node.IsScalar())
+					return false;
+
+				std::string str = node.Scalar();
+
+				if ( str.compare( "SCHED_OTHER" ) == 0 )
+					rhs = IProtoStackBuilder::SCHED_POLICY_OTHER;
+				else if (str.compare( "SCHED_FIFO" ) == 0 )
+					rhs = IProtoStackBuilder::SCHED_POLICY_FIFO;
+				else if (str.compare( "SCHED_RR" ) == 0 )
+					rhs = IProtoStackBuilder::SCHED_POLICY_RR;
+				else if (str.compare( "DEFAULT" ) == 0 )
+					rhs = IProtoStackBuilder::SCHED_POLICY_DEFAULT;
+				else
+					return false;
+
+				return true;
+			}
+
+			static Node encode(const IProtoStackBuilder::SchedPolicy &rhs) {
+				Node node;
+				switch( rhs ) {
+					case IProtoStackBuilder::SCHED_POLICY_OTHER: node = "SCHED_OTHER"; break;
+					case IProtoStackBuilder::SCHED_POLICY_FIFO:  node = "SCHED_FIFO";  break;
+					case IProtoStackBuilder::SCHED_POLICY_RR:    node = "SCHED_RR";    break;
+					default: node = "DEFAULT"; break;
+				}
+				return node;
+			}
+		};
+
 }
 
 // helpers to read map entries
@@ -655,6 +689,9 @@ class CYamlFieldFactoryBase : public IYamlFactoryBase<Field> {
 		static YAML::Node loadPreprocessedYamlFile(const char *file_name,   const char *yaml_dir = 0, bool resolveMergeKeys = true);
 
 		static void dumpClasses(std::ostream &os) { getFieldRegistry_()->dumpClasses( os ); }
+
+		// from the environment variable CPSW_YAML_LAZY
+		static bool getDefaultLazyChildren();
 };
 
 
@@ -18,12 +18,14 @@
 #define YAML_KEY_MERGE  "<<"
 #define YAML_KEY_align  "align"
 #define YAML_KEY_at  "at"
+#define YAML_KEY_busyPollUS  "busyPollUS"
 #define YAML_KEY_byteOrder  "byteOrder"
 #define YAML_KEY_cacheable  "cacheable"
 #define YAML_KEY_children  "children"
 #define YAML_KEY_class  "class"
 #define YAML_KEY_configBase  "configBase"
 #define YAML_KEY_configPrio  "configPrio"
+#define YAML_KEY_cpuAffinity  "cpuAffinity"
 #define YAML_KEY_cumulativeAckTimeoutUS "cumulativeAckTimeoutUS"
 #define YAML_KEY_defaultWriteMode  "defaultWriteMode"
 #define YAML_KEY_depack  "depack"
@@ -36,6 +38,7 @@
 #define YAML_KEY_instantiate  "instantiate"
 #define YAML_KEY_ipAddr  "ipAddr"
 #define YAML_KEY_isSigned  "isSigned"
+#define YAML_KEY_lazyChildren  "lazyChildren"
 #define YAML_KEY_ldFragWinSize  "ldFragWinSize"
 #define YAML_KEY_ldFrameWinSize  "ldFrameWinSize"
 #define YAML_KEY_ldMaxUnackedSegs "ldMaxUnackedSegs"
@@ -51,18 +54,22 @@
 #define YAML_KEY_offset  "offset"
 #define YAML_KEY_outQueueDepth  "outQueueDepth"
 #define YAML_KEY_inpQueueDepth  "inpQueueDepth"
+#define YAML_KEY_inlineDemux  "inlineDemux"
 #define YAML_KEY_pollSecs  "pollSecs"
 #define YAML_KEY_port  "port"
 #define YAML_KEY_protocolVersion  "protocolVersion"
+#define YAML_KEY_rcvBufSize  "rcvBufSize"
 #define YAML_KEY_retryCount  "retryCount"
 #define YAML_KEY_retransmissionTimeoutUS "retransmissionTimeoutUS"
 #define YAML_KEY_RSSI  "RSSI"
 #define YAML_KEY_rssiBridge  "rssiBridge"
+#define YAML_KEY_schedPolicy  "schedPolicy"
 #define YAML_KEY_seekable  "seekable"
 #define YAML_KEY_sequence  "sequence"
 #define YAML_KEY_singleInterfaceOnly  "singleInterfaceOnly"
 #define YAML_KEY_size  "size"
 #define YAML_KEY_sizeBits  "sizeBits"
+#define YAML_KEY_sndBufSize  "sndBufSize"
 #define YAML_KEY_socksProxy "socksProxy"
 #define YAML_KEY_SRP  "SRP"
 #define YAML_KEY_SRPMux  "SRPMux"
@@ -70,12 +77,22 @@
 #define YAML_KEY_stripHeader  "stripHeader"
 #define YAML_KEY_TDEST  "TDEST"
 #define YAML_KEY_TDESTMux  "TDESTMux"
+#define YAML_KEY_txPacing  "txPacing"
+#define YAML_KEY_txRateSegsPerSec "txRateSegsPerSec"
+#define YAML_KEY_extendedAcks "extendedAcks"
 #define YAML_KEY_threadPriority "threadPriority"
 #define YAML_KEY_timeoutUS  "timeoutUS"
 #define YAML_KEY_UDP  "UDP"
+#define YAML_KEY_useReactor  "useReactor"
+#define YAML_KEY_useUring  "useUring"
+#define YAML_KEY_usePacketRing  "usePacketRing"
+#define YAML_KEY_useSharedSocket  "useSharedSocket"
+#define YAML_KEY_useGso  "useGso"
+#define YAML_KEY_useGro  "useGro"
 #define YAML_KEY_TCP  "TCP"
 #define YAML_KEY_value  "value"
 #define YAML_KEY_virtualChannel  "virtualChannel"
 #define YAML_KEY_wordSwap  "wordSwap"
+#define YAML_KEY_zeroCopyThreshold "zeroCopyThreshold"
 
 #endif
@@ -45,8 +45,8 @@ private:
 	ProtoPort  upstream_;
 	ConnHandler hdlr;
 public:
-	CRssiPort(bool isServer)
-	: CRssi(isServer)
+	CRssiPort(bool isServer, const CRssiConfigParams *defaults = 0)
+	: CRssi(isServer, DFLT_PRIORITY, 0, defaults)
 	{
 		StreamStateMonitor::getTheMonitor()->getEventSet()->add((CConnectionStateChangedEventSource*)this, &hdlr);
 	}
@@ -107,9 +107,16 @@ public:
 		return outQ_->getWriteEventSource();
 	}
 
-	static RssiPort create(bool isServer)
+	// signals room for 'push()'/'tryPush()' (the write event
+	// source above is already monitored by the RSSI thread)
+	virtual IEventSource *getPushEventSource()
 	{
-	CRssiPort *p = new CRssiPort(isServer);
+		return inpQ_->getWriteEventSource();
+	}
+
+	static RssiPort create(bool isServer, const CRssiConfigParams *defaults = 0)
+	{
+	CRssiPort *p = new CRssiPort(isServer, defaults);
 		return RssiPort(p);
 	}
 
@@ -119,7 +119,7 @@ public:
 			return ts;
 		}
 
-		if ( clock_gettime( CLOCK_REALTIME, &ts ) )
+		if ( clock_gettime( CLOCK_MONOTONIC, &ts ) )
 			throw InternalError("clock_gettime failed", errno);
 
 		ts.tv_nsec += rel_timeout->tv_.tv_nsec;
@@ -333,6 +333,8 @@ public:
 	virtual bool     adjPayload(ssize_t) { throw InternalError("Not Implemented"); }
 	virtual void     reinit()            { throw InternalError("Not Implemented"); }
 	virtual BufChain getChain()          { throw InternalError("Not Implemented"); }
+	virtual bool     getRxTimestamp(struct timespec *)       { return false;       }
+	virtual void     setRxTimestamp(const struct timespec *) {                     }
 	virtual void     after(Buf)          { throw InternalError("Not Implemented"); }
 	virtual void     before(Buf)         { throw InternalError("Not Implemented"); }
 	virtual void     unlink()            { throw InternalError("Not Implemented"); }
@@ -10,6 +10,7 @@
 #include <cpsw_error.h>
 #include <udpsrv_util.h>
 #include <udpsrv_rssi_port.h>
+#include <rssi_bridge_reactor.h>
 #include <cpsw_thread.h>
 #include <stdio.h>
 #include <getopt.h>
@@ -284,7 +285,7 @@ Bridge::~Bridge()
 static void
 usage(const char *nm)
 {
-	fprintf(stderr,"Usage: %s [-hdCR] -a <dest_ip> [-p <dst_port>[:<tcp_srv_port>]] [-u <dst_port>[:<tcp_srv_port>]]\n", nm);
+	fprintf(stderr,"Usage: %s [-hdCR] [-E <n_workers>] -a <dest_ip> [-p <dst_port>[:<tcp_srv_port>]] [-u <dst_port>[:<tcp_srv_port>]]\n", nm);
 	fprintf(stderr,"       RSSI <-> TCP bridge\n");
 	fprintf(stderr,"       -a <dest_ip>              : remote address where a RSSI server is listening.\n");
 	fprintf(stderr,"       -p <dst_port>[:<tcp_port>]: <dst_port> identifies the remote UDP port and <tcp_port>\n");
@@ -308,6 +309,11 @@ usage(const char *nm)
 	fprintf(stderr,"                                   then connections on the UDP side are only\n");
 	fprintf(stderr,"                                   initiated when a TCP connection is accepted\n");
 	fprintf(stderr,"       -R                        : Do not start the RPC service\n");
+	fprintf(stderr,"       -E <n_workers>            : Relay all connections with <n_workers> shared\n");
+	fprintf(stderr,"                                   epoll threads (moving datagrams in batches)\n");
+	fprintf(stderr,"                                   instead of dedicated threads per connection.\n");
+	fprintf(stderr,"                                   RSSI connections still use one protocol\n");
+	fprintf(stderr,"                                   thread each.\n");
 	fprintf(stderr,"       -v                        : Increase verbosity\n");
 }
 
@@ -326,8 +332,9 @@ uint64_t           rssiMsk     = 0;
 uint64_t           rssiBit     = 1;
 int                useRpc      = 1;
 in_addr_t          peer;
-const char        *opts        = "hRCp:u:a:dv";
+const char        *opts        = "hRCp:u:a:dvE:";
 int                verbose     = 0;
+unsigned           numWorkers  = 0;
 struct sockaddr_in mcsa;
 
 std::vector< PP > ports;
@@ -411,6 +418,13 @@ std::vector< PP > ports;
 			case 'v':
 				verbose++;
 				break;
+
+			case 'E':
+				if ( 1 != sscanf(optarg, "%u", &numWorkers) || 0 == numWorkers ) {
+					fprintf(stderr,"Error: -E argument misformed\n");
+					return rval;
+				}
+				break;
 		}
 	}
 
@@ -463,6 +477,7 @@ std::vector< PP > ports;
 
 try {
 	std::vector< shared_ptr<Bridge> > bridges;
+	BridgeReactor                     reactor;
 
 	rssiBit = 1;
 
@@ -470,21 +485,41 @@ try {
 		flags = (Bridge::Flags)(flags | Bridge::INFO);
 	}
 
+	if ( numWorkers ) {
+		reactor = IBridgeReactor::create( numWorkers );
+	}
+
 	for ( std::vector<PP>::const_iterator it = ports.begin(); it != ports.end(); ++it ) {
 		Bridge::Flags f = flags;
+		PortMap       m;
+
 		if ( (rssiBit & rssiMsk) ) {
 			f = (Bridge::Flags)(f | Bridge::RSSI);
 		}
-		bridges.push_back( cpsw::make_shared<Bridge>( peerIp, it->first, it->second, f ) );
-		shared_ptr<Bridge> b = bridges.back();
 
-		PortMap            m;
-		m.reqPort = b->getPeerPort();
-		m.actPort = b->getPort();
+		m.reqPort = it->first;
 		m.flags   = 0;
-		if ( b->useRssi() ) {
+		if ( (f & Bridge::RSSI) ) {
 			m.flags |= MAP_PORT_DESC_FLG_RSSI;
 		}
+
+		if ( reactor ) {
+			unsigned rf = IBridgeReactor::NONE;
+			if ( (f & Bridge::RSSI) )
+				rf |= IBridgeReactor::RSSI;
+			if ( (f & Bridge::DEBUG) )
+				rf |= IBridgeReactor::DEBUG;
+			if ( (f & Bridge::ALWAYSCONN) )
+				rf |= IBridgeReactor::ALWAYSCONN;
+			m.actPort = reactor->addBridge( peerIp, it->first, it->second, (IBridgeReactor::Flags)rf );
+			if ( 0 == it->second && ( f & Bridge::INFO ) ) {
+				printf("Peer/UDP port %hu served by our TCP port %hu\n", it->first, (unsigned short)m.actPort);
+			}
+		} else {
+			bridges.push_back( cpsw::make_shared<Bridge>( peerIp, it->first, it->second, f ) );
+			m.actPort = bridges.back()->getPort();
+		}
+
 		portMaps.push_back( m );
 
 		rssiBit <<= 1;
@@ -0,0 +1,1029 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#include <rssi_bridge_reactor.h>
+#include <cpsw_error.h>
+#include <cpsw_thread.h>
+#include <cpsw_event.h>
+#include <udpsrv_util.h>
+#include <udpsrv_rssi_port.h>
+
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define RSSI_BR_DEBUG
+
+using cpsw::atomic;
+
+// max. number of datagrams moved per recvmmsg/sendmmsg
+#define BATCH_MAX   32
+// TCP framing: every datagram is preceded by its length (NBO)
+#define FRAME_HDR   sizeof(uint32_t)
+#define FRAME_MAX   (MAXBUFSZ - 64)
+// stop reading more input if that many bytes are waiting to be
+// sent to TCP
+#define TX_HIWATER  (256*1024)
+#define RX_CHUNK    (256*1024)
+// depth of the queue between the reactor and a RSSI thread
+#define UDP_QDEPTH  32
+
+class CReactorWorker;
+class CReactorBridge;
+
+// simple contiguous byte FIFO
+class CByteFifo {
+private:
+	std::vector<uint8_t> buf_;
+	size_t               rd_, wr_;
+
+public:
+	CByteFifo()
+	: rd_( 0 ),
+	  wr_( 0 )
+	{
+	}
+
+	size_t   avail() { return wr_ - rd_;     }
+	uint8_t *rdPtr() { return &buf_[0] + rd_; }
+
+	// make room for 'n' bytes and return the write pointer
+	uint8_t *wrPtr(size_t n)
+	{
+		if ( wr_ + n > buf_.size() ) {
+			if ( rd_ > 0 ) {
+				memmove( &buf_[0], &buf_[0] + rd_, wr_ - rd_ );
+				wr_ -= rd_;
+				rd_  = 0;
+			}
+			if ( wr_ + n > buf_.size() ) {
+				buf_.resize( wr_ + n );
+			}
+		}
+		return &buf_[0] + wr_;
+	}
+
+	size_t   room()  { return buf_.size() - wr_; }
+
+	void produced(size_t n)
+	{
+		wr_ += n;
+	}
+
+	void consumed(size_t n)
+	{
+		if ( (rd_ += n) >= wr_ ) {
+			rd_ = wr_ = 0;
+		}
+	}
+
+	void clear()
+	{
+		rd_ = wr_ = 0;
+	}
+};
+
+// Lower end of a RSSI protocol stack; datagrams are delivered
+// by the reactor and sent directly on the (non-blocking) socket.
+class CReactorUdpPort : public IProtoPort {
+private:
+	int      sd_;
+	BufQueue inpQ_;
+
+public:
+	CReactorUdpPort(int sd)
+	: sd_  ( sd                               ),
+	  inpQ_( IBufQueue::create( UDP_QDEPTH ) )
+	{
+	}
+
+	// drops the datagram if the RSSI thread does not keep up
+	bool deliver(BufChain bc)
+	{
+		return inpQ_->tryPush( bc );
+	}
+
+	virtual BufChain pop(const CTimeout *to)         { return inpQ_->pop( to );               }
+	virtual BufChain tryPop()                        { return inpQ_->tryPop();                }
+
+	virtual IEventSource *getReadEventSource()       { return inpQ_->getReadEventSource();   }
+	virtual IEventSource *getWriteEventSource()      { return NULL;                           }
+
+	virtual ProtoPort getUpstreamPort()              { return ProtoPort();                    }
+
+	virtual void attach(ProtoPort upstream)
+	{
+		throw InternalError("This must be a 'top' port");
+	}
+
+	virtual bool tryPush(BufChain bc)
+	{
+	Buf b = bc->getHead();
+		if ( ! b ) {
+			return true;
+		}
+		return ::send( sd_, b->getPayload(), b->getSize(), MSG_DONTWAIT ) >= 0;
+	}
+
+	virtual bool push(BufChain bc, const CTimeout *to) { return tryPush( bc );                }
+
+	virtual unsigned isConnected()                   { return 1;                              }
+
+	virtual void start()                             { inpQ_->startup();                      }
+	virtual void stop()                              { inpQ_->shutdown();                     }
+};
+
+// Forwards events from RSSI queues (which cannot be polled by
+// epoll) to the workers.
+class CRssiPump : public CRunnable {
+private:
+	EventSet set_;
+
+protected:
+	virtual void *threadBody()
+	{
+		while ( 1 ) {
+			set_->processEvent( true, NULL );
+		}
+		return NULL;
+	}
+
+public:
+	CRssiPump()
+	: CRunnable( "RSSI pump"           ),
+	  set_     ( IEventSet::create()   )
+	{
+	}
+
+	EventSet getEventSet() { return set_; }
+
+	virtual ~CRssiPump()
+	{
+		threadStop();
+	}
+};
+
+class CPumpHandler : public IEventHandler {
+private:
+	CReactorBridge *br_;
+	unsigned        bit_;
+public:
+	CPumpHandler(CReactorBridge *br, unsigned bit)
+	: br_ ( br  ),
+	  bit_( bit )
+	{
+	}
+
+	// one-shot; the worker re-enables when it wants more
+	virtual void handle(IIntEventSource *);
+};
+
+// what an epoll event refers to
+struct CFdRef {
+	CReactorBridge *br_;
+	int             kind_;
+
+	CFdRef(CReactorBridge *br, int kind)
+	: br_  ( br   ),
+	  kind_( kind )
+	{
+	}
+};
+
+class CReactorWorker : public CRunnable {
+private:
+	int                           epfd_;
+	int                           evfd_;
+	// bridges with pending (pump) events; only these
+	// are visited when the worker is woken up
+	std::vector<CReactorBridge *> pending_;
+	std::vector<CReactorBridge *> work_;
+	CMtx                          mtx_;
+	BufChain                      rxBufs_[BATCH_MAX];
+	struct mmsghdr                msgs_[BATCH_MAX];
+	struct iovec                  iovs_[BATCH_MAX];
+
+	CReactorWorker(const CReactorWorker&);
+	CReactorWorker & operator=(const CReactorWorker&);
+
+	void handlePending();
+
+protected:
+	virtual void *threadBody();
+
+public:
+	CReactorWorker(const char *name);
+
+	// queue a bridge for 'handlePending' and wake up the
+	// worker; may be called from any thread
+	void schedule(CReactorBridge *br);
+
+	void ctl(int op, int fd, uint32_t events, CFdRef *ref);
+
+	void wakeup();
+
+	// receive a batch of datagrams; returns the number
+	// received (the buffers are retrieved with 'getRxBuf')
+	int  recvBatch(int sd);
+
+	BufChain getRxBuf(int i, bool keep);
+
+	virtual ~CReactorWorker();
+};
+
+class CReactorBridge {
+public:
+	enum { LISTEN = 0, TCP = 1, UDP = 2 };
+	// PEND_START is set until the bridge is registered with the
+	// worker; this keeps signals from queueing it prematurely
+	enum { PEND_RD = 1, PEND_WR = 2, PEND_START = 4 };
+
+private:
+	CReactorWorker                 *wrk_;
+	EventSet                        pump_;
+	unsigned short                  peerPort_;
+	unsigned short                  myPort_;
+	IBridgeReactor::Flags           flags_;
+	int                             lsd_;
+	int                             tsd_;
+	int                             usd_;
+	uint32_t                        tcpEvs_, udpEvs_, lsnEvs_;
+	CFdRef                          lsnRef_, tcpRef_, udpRef_;
+	CByteFifo                       tcpTx_;
+	CByteFifo                       tcpRx_;
+	bool                            udpBlocked_;
+	RssiPort                        rssiPrt_;
+	shared_ptr<CReactorUdpPort>     udpPrt_;
+	BufChain                        pendingUp_;
+	CPumpHandler                    rdHdl_, wrHdl_;
+	atomic<unsigned>                pend_;
+
+	CReactorBridge(const CReactorBridge&);
+	CReactorBridge & operator=(const CReactorBridge&);
+
+	bool useRssi() { return !!(flags_ & IBridgeReactor::RSSI);  }
+	bool debug()   { return !!(flags_ & IBridgeReactor::DEBUG); }
+
+	void updateInterest();
+
+	void onAccept();
+	void onTcpReadable();
+	void onTcpWritable();
+	void onUdpReadable();
+	void onUdpWritable();
+
+	void closeTcp();
+	void flushTcp();
+	void processTcpRx();
+	void drainRssi();
+	void appendFrame(const uint8_t *p, uint32_t len);
+
+	void up();
+	void down();
+
+public:
+	CReactorBridge(CReactorWorker *wrk, EventSet pump, const char *peerIp, unsigned short peerPort, unsigned short myPort, IBridgeReactor::Flags flags);
+
+	unsigned short getPort() { return myPort_; }
+
+	// register with the worker; events may be handled
+	// (by the worker thread) as soon as this executes.
+	void start();
+
+	void handle(int kind, uint32_t events);
+
+	// may be called from any thread; the bridge is queued
+	// only once until the worker has handled its events
+	void signal(unsigned bit)
+	{
+		if ( 0 == pend_.fetch_or( bit ) ) {
+			wrk_->schedule( this );
+		}
+	}
+
+	void handlePending();
+
+	~CReactorBridge();
+};
+
+void
+CPumpHandler::handle(IIntEventSource *src)
+{
+	disable();
+	br_->signal( bit_ );
+}
+
+CReactorWorker::CReactorWorker(const char *name)
+: CRunnable( name ),
+  epfd_    ( -1   ),
+  evfd_    ( -1   ),
+  mtx_     ( "REACTOR" )
+{
+	if ( (epfd_ = epoll_create1( EPOLL_CLOEXEC )) < 0 ) {
+		throw InternalError("epoll_create1 failed", errno);
+	}
+	if ( (evfd_ = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC )) < 0 ) {
+		close( epfd_ );
+		throw InternalError("eventfd failed", errno);
+	}
+	ctl( EPOLL_CTL_ADD, evfd_, EPOLLIN, NULL );
+
+	memset( msgs_, 0, sizeof(msgs_) );
+}
+
+CReactorWorker::~CReactorWorker()
+{
+	threadStop();
+	close( evfd_ );
+	close( epfd_ );
+}
+
+void
+CReactorWorker::schedule(CReactorBridge *br)
+{
+	{
+	CMtx::lg GUARD( &mtx_ );
+		pending_.push_back( br );
+	}
+	wakeup();
+}
+
+void
+CReactorWorker::ctl(int op, int fd, uint32_t events, CFdRef *ref)
+{
+struct epoll_event ev;
+	ev.events   = events;
+	ev.data.ptr = ref;
+	if ( epoll_ctl( epfd_, op, fd, &ev ) ) {
+		throw InternalError("epoll_ctl failed", errno);
+	}
+}
+
+void
+CReactorWorker::wakeup()
+{
+uint64_t one = 1;
+	if ( write( evfd_, &one, sizeof(one) ) < 0 && EAGAIN != errno ) {
+		throw InternalError("eventfd write failed", errno);
+	}
+}
+
+int
+CReactorWorker::recvBatch(int sd)
+{
+int i, got;
+
+	for ( i = 0; i < BATCH_MAX; i++ ) {
+		if ( ! rxBufs_[i] ) {
+			rxBufs_[i] = IBufChain::create();
+			rxBufs_[i]->createAtHead( IBuf::CAPA_ETH_BIG );
+		}
+		Buf b = rxBufs_[i]->getHead();
+		iovs_[i].iov_base               = b->getPayload();
+		iovs_[i].iov_len                = b->getAvail();
+		msgs_[i].msg_hdr.msg_iov        = &iovs_[i];
+		msgs_[i].msg_hdr.msg_iovlen     = 1;
+		msgs_[i].msg_hdr.msg_name       = 0;
+		msgs_[i].msg_hdr.msg_namelen    = 0;
+		msgs_[i].msg_hdr.msg_control    = 0;
+		msgs_[i].msg_hdr.msg_controllen = 0;
+		msgs_[i].msg_hdr.msg_flags      = 0;
+	}
+
+	if ( (got = recvmmsg( sd, msgs_, BATCH_MAX, MSG_DONTWAIT, NULL )) < 0 ) {
+		if ( EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno || ECONNREFUSED == errno ) {
+			return 0;
+		}
+		throw InternalError("recvmmsg failed", errno);
+	}
+
+	for ( i = 0; i < got; i++ ) {
+		if ( (msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) ) {
+			fprintf(stderr,"Reactor: datagram truncated -- dropping\n");
+			msgs_[i].msg_len = 0;
+		}
+		rxBufs_[i]->getHead()->setSize( msgs_[i].msg_len );
+	}
+
+	return got;
+}
+
+BufChain
+CReactorWorker::getRxBuf(int i, bool keep)
+{
+BufChain rval = rxBufs_[i];
+	if ( ! keep ) {
+		rxBufs_[i].reset();
+	}
+	return rval;
+}
+
+void
+CReactorWorker::handlePending()
+{
+uint64_t cnt;
+unsigned i;
+
+	if ( read( evfd_, &cnt, sizeof(cnt) ) < 0 && EAGAIN != errno ) {
+		throw InternalError("eventfd read failed", errno);
+	}
+
+	{
+	CMtx::lg GUARD( &mtx_ );
+		work_.swap( pending_ );
+	}
+	for ( i = 0; i < work_.size(); i++ ) {
+		work_[i]->handlePending();
+	}
+	work_.clear();
+}
+
+void *
+CReactorWorker::threadBody()
+{
+struct epoll_event evs[64];
+int                n, i;
+
+	while ( 1 ) {
+		if ( (n = epoll_wait( epfd_, evs, sizeof(evs)/sizeof(evs[0]), -1 )) < 0 ) {
+			if ( EINTR == errno )
+				continue;
+			throw InternalError("epoll_wait failed", errno);
+		}
+		for ( i = 0; i < n; i++ ) {
+			CFdRef *ref = static_cast<CFdRef*>( evs[i].data.ptr );
+			if ( ! ref ) {
+				handlePending();
+			} else {
+				ref->br_->handle( ref->kind_, evs[i].events );
+			}
+		}
+	}
+	return NULL;
+}
+
+CReactorBridge::CReactorBridge(CReactorWorker *wrk, EventSet pump, const char *peerIp, unsigned short peerPort, unsigned short myPort, IBridgeReactor::Flags flags)
+: wrk_       ( wrk                  ),
+  pump_      ( pump                 ),
+  peerPort_  ( peerPort             ),
+  myPort_    ( myPort               ),
+  flags_     ( flags                ),
+  lsd_       ( -1                   ),
+  tsd_       ( -1                   ),
+  usd_       ( -1                   ),
+  tcpEvs_    ( 0                    ),
+  udpEvs_    ( 0                    ),
+  lsnEvs_    ( 0                    ),
+  lsnRef_    ( this, LISTEN         ),
+  tcpRef_    ( this, TCP            ),
+  udpRef_    ( this, UDP            ),
+  udpBlocked_( false                ),
+  rdHdl_     ( this, PEND_RD        ),
+  wrHdl_     ( this, PEND_WR        ),
+  pend_      ( PEND_START           )
+{
+struct sockaddr_in sin;
+socklen_t          sl;
+int                yes = 1;
+
+	try {
+		if ( (lsd_ = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 )) < 0 ) {
+			throw InternalError("Unable to create TCP socket", errno);
+		}
+		if ( setsockopt( lsd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes) ) ) {
+			throw InternalError("unable to set SO_REUSEADDR", errno);
+		}
+		sin.sin_family      = AF_INET;
+		sin.sin_addr.s_addr = INADDR_ANY;
+		sin.sin_port        = htons( myPort );
+		if ( ::bind( lsd_, (struct sockaddr*)&sin, sizeof(sin) ) ) {
+			throw InternalError("Unable to bind", errno);
+		}
+		if ( listen( lsd_, 1 ) ) {
+			throw InternalError("Unable to listen", errno);
+		}
+		sl = sizeof(sin);
+		if ( getsockname( lsd_, (struct sockaddr*)&sin, &sl ) ) {
+			throw InternalError("getsockname failed", errno);
+		}
+		myPort_ = ntohs( sin.sin_port );
+
+		if ( (usd_ = socket( AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 )) < 0 ) {
+			throw InternalError("Unable to create UDP socket", errno);
+		}
+		sin.sin_family      = AF_INET;
+		sin.sin_addr.s_addr = inet_addr( peerIp );
+		sin.sin_port        = htons( peerPort );
+		if ( ::connect( usd_, (struct sockaddr*)&sin, sizeof(sin) ) ) {
+			throw InternalError("Unable to connect", errno);
+		}
+
+		if ( useRssi() ) {
+			udpPrt_  = cpsw::make_shared<CReactorUdpPort>( usd_ );
+			rssiPrt_ = CRssiPort::create( false );
+			rssiPrt_->attach( udpPrt_ );
+			wrHdl_.disable();
+			pump_->add( rssiPrt_->getReadEventSource(), &rdHdl_ );
+			pump_->add( rssiPrt_->getPushEventSource(), &wrHdl_ );
+			// the RSSI queues accept data until the protocol thread
+			// first closes them; frames pushed before that would be
+			// lost. Close them now so 'tryPush' fails (and 'wrHdl_'
+			// fires) until the connection is open.
+			down();
+		}
+	} catch ( ... ) {
+		if ( lsd_ >= 0 )
+			close( lsd_ );
+		if ( usd_ >= 0 )
+			close( usd_ );
+		throw;
+	}
+}
+
+CReactorBridge::~CReactorBridge()
+{
+	if ( rssiPrt_ ) {
+		pump_->del( &rdHdl_ );
+		pump_->del( &wrHdl_ );
+		down();
+	}
+	if ( tsd_ >= 0 )
+		close( tsd_ );
+	close( usd_ );
+	close( lsd_ );
+}
+
+void
+CReactorBridge::start()
+{
+	if ( (flags_ & IBridgeReactor::ALWAYSCONN) ) {
+		up();
+	}
+	lsnEvs_ = EPOLLIN;
+	udpEvs_ = EPOLLIN;
+	wrk_->ctl( EPOLL_CTL_ADD, usd_, udpEvs_, &udpRef_ );
+	wrk_->ctl( EPOLL_CTL_ADD, lsd_, lsnEvs_, &lsnRef_ );
+	// PEND_START is still set; handle whatever the pump
+	// signalled before we were registered
+	wrk_->schedule( this );
+}
+
+void
+CReactorBridge::up()
+{
+	for ( ProtoPort p = rssiPrt_; p; p = p->getUpstreamPort() )
+		p->start();
+}
+
+void
+CReactorBridge::down()
+{
+	for ( ProtoPort p = rssiPrt_; p; p = p->getUpstreamPort() )
+		p->stop();
+}
+
+// recompute the epoll interest sets
+void
+CReactorBridge::updateInterest()
+{
+uint32_t evs;
+bool     txFull = tcpTx_.avail() >= TX_HIWATER;
+
+	evs = 0;
+	if ( tsd_ >= 0 ) {
+		if ( ! txFull && ! udpBlocked_ && ! pendingUp_ )
+			evs |= EPOLLIN;
+		if ( tcpTx_.avail() )
+			evs |= EPOLLOUT;
+		if ( evs != tcpEvs_ ) {
+			wrk_->ctl( EPOLL_CTL_MOD, tsd_, evs, &tcpRef_ );
+			tcpEvs_ = evs;
+		}
+	}
+
+	evs = 0;
+	if ( useRssi() || ! txFull )
+		evs |= EPOLLIN;
+	if ( udpBlocked_ )
+		evs |= EPOLLOUT;
+	if ( evs != udpEvs_ ) {
+		wrk_->ctl( EPOLL_CTL_MOD, usd_, evs, &udpRef_ );
+		udpEvs_ = evs;
+	}
+
+	// accept one connection at a time
+	evs = tsd_ >= 0 ? 0 : EPOLLIN;
+	if ( evs != lsnEvs_ ) {
+		wrk_->ctl( EPOLL_CTL_MOD, lsd_, evs, &lsnRef_ );
+		lsnEvs_ = evs;
+	}
+}
+
+void
+CReactorBridge::handle(int kind, uint32_t events)
+{
+	switch ( kind ) {
+		case LISTEN:
+			onAccept();
+			break;
+
+		case TCP:
+			if ( (events & (EPOLLERR | EPOLLHUP)) && ! (events & EPOLLIN) ) {
+				closeTcp();
+				break;
+			}
+			if ( (events & EPOLLOUT) )
+				onTcpWritable();
+			if ( (events & EPOLLIN) && tsd_ >= 0 )
+				onTcpReadable();
+			break;
+
+		case UDP:
+			if ( (events & EPOLLOUT) )
+				onUdpWritable();
+			if ( (events & (EPOLLIN | EPOLLERR)) )
+				onUdpReadable();
+			break;
+
+		default:
+			break;
+	}
+	updateInterest();
+}
+
+void
+CReactorBridge::handlePending()
+{
+unsigned bits = pend_.exchange( 0 );
+
+	if ( (bits & PEND_WR) && pendingUp_ ) {
+		if ( rssiPrt_->tryPush( pendingUp_ ) ) {
+			pendingUp_.reset();
+			processTcpRx();
+		} else {
+			wrHdl_.enable();
+			pump_->notify();
+		}
+	}
+	if ( (bits & PEND_RD) ) {
+		drainRssi();
+	}
+	updateInterest();
+}
+
+void
+CReactorBridge::onAccept()
+{
+int sd;
+
+	if ( (sd = accept4( lsd_, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC )) < 0 ) {
+		if ( EAGAIN != errno && EWOULDBLOCK != errno && EINTR != errno ) {
+			fprintf(stderr,"Reactor: accept failed (port %hu): %s\n", myPort_, strerror(errno));
+		}
+		return;
+	}
+
+	tsd_    = sd;
+	tcpEvs_ = EPOLLIN;
+	wrk_->ctl( EPOLL_CTL_ADD, tsd_, tcpEvs_, &tcpRef_ );
+
+	if ( ! (flags_ & IBridgeReactor::ALWAYSCONN) ) {
+		up();
+	}
+}
+
+void
+CReactorBridge::closeTcp()
+{
+	if ( tsd_ < 0 )
+		return;
+
+	wrk_->ctl( EPOLL_CTL_DEL, tsd_, 0, NULL );
+	close( tsd_ );
+	tsd_        = -1;
+	tcpEvs_     = 0;
+	tcpTx_.clear();
+	tcpRx_.clear();
+	udpBlocked_ = false;
+	pendingUp_.reset();
+
+	if ( ! (flags_ & IBridgeReactor::ALWAYSCONN) ) {
+		down();
+	}
+}
+
+void
+CReactorBridge::appendFrame(const uint8_t *p, uint32_t len)
+{
+uint32_t lenNBO = htonl( len );
+uint8_t *dst    = tcpTx_.wrPtr( FRAME_HDR + len );
+
+	memcpy( dst,             &lenNBO, FRAME_HDR );
+	memcpy( dst + FRAME_HDR, p,       len       );
+	tcpTx_.produced( FRAME_HDR + len );
+}
+
+void
+CReactorBridge::flushTcp()
+{
+ssize_t put;
+
+	while ( tsd_ >= 0 && tcpTx_.avail() ) {
+		if ( (put = ::send( tsd_, tcpTx_.rdPtr(), tcpTx_.avail(), MSG_DONTWAIT | MSG_NOSIGNAL )) < 0 ) {
+			if ( EAGAIN == errno || EWOULDBLOCK == errno ) {
+				break;
+			}
+			if ( EINTR == errno ) {
+				continue;
+			}
+			fprintf(stderr,"Reactor: TCP send failed (port %hu): %s; resetting connection\n", myPort_, strerror(errno));
+			closeTcp();
+			break;
+		}
+		tcpTx_.consumed( put );
+	}
+}
+
+void
+CReactorBridge::onTcpWritable()
+{
+	flushTcp();
+	if ( rssiPrt_ && tcpTx_.avail() < TX_HIWATER ) {
+		drainRssi();
+	}
+}
+
+void
+CReactorBridge::drainRssi()
+{
+BufChain bc;
+
+	if ( ! rssiPrt_ ) {
+		return;
+	}
+
+	while ( tcpTx_.avail() < TX_HIWATER ) {
+		if ( ! (bc = rssiPrt_->tryPop()) ) {
+			// re-arm; the pump re-checks the queue
+			rdHdl_.enable();
+			pump_->notify();
+			break;
+		}
+		if ( tsd_ >= 0 ) {
+			Buf b = bc->getHead();
+#ifdef RSSI_BR_DEBUG
+			if ( debug() ) {
+				printf("RSSI->TCP (%hu): got %ld bytes\n", myPort_, (long)b->getSize());
+			}
+#endif
+			appendFrame( b->getPayload(), b->getSize() );
+		}
+	}
+	flushTcp();
+}
+
+void
+CReactorBridge::onUdpReadable()
+{
+int got, i;
+
+	// bound the work done per wakeup so other bridges get their turn
+	for ( int batches = 0; batches < 4; batches++ ) {
+
+		if ( ! useRssi() && tcpTx_.avail() >= TX_HIWATER )
+			break;
+
+		if ( 0 == (got = wrk_->recvBatch( usd_ )) )
+			break;
+
+#ifdef RSSI_BR_DEBUG
+		if ( debug() ) {
+			printf("UDP (%hu): got batch of %d datagrams\n", peerPort_, got);
+		}
+#endif
+
+		for ( i = 0; i < got; i++ ) {
+			if ( useRssi() ) {
+				if ( wrk_->getRxBuf( i, true )->getSize() > 0 ) {
+					// ownership passes to the RSSI thread
+					udpPrt_->deliver( wrk_->getRxBuf( i, false ) );
+				}
+			} else if ( tsd_ >= 0 ) {
+				Buf b = wrk_->getRxBuf( i, true )->getHead();
+				if ( b->getSize() > 0 ) {
+					appendFrame( b->getPayload(), b->getSize() );
+				}
+			}
+		}
+
+		flushTcp();
+
+		if ( got < BATCH_MAX )
+			break;
+	}
+}
+
+void
+CReactorBridge::onUdpWritable()
+{
+	udpBlocked_ = false;
+	processTcpRx();
+}
+
+void
+CReactorBridge::onTcpReadable()
+{
+ssize_t got;
+
+	while ( tsd_ >= 0 ) {
+		uint8_t *p = tcpRx_.wrPtr( RX_CHUNK );
+		if ( (got = ::recv( tsd_, p, tcpRx_.room(), MSG_DONTWAIT )) <= 0 ) {
+			if ( got < 0 && EINTR == errno ) {
+				continue;
+			}
+			if ( got < 0 && (EAGAIN == errno || EWOULDBLOCK == errno) ) {
+				break;
+			}
+			if ( got < 0 ) {
+				fprintf(stderr,"TCP (%hu): unable to read; resetting connection (%s)\n", myPort_, strerror(errno));
+			}
+			closeTcp();
+			return;
+		}
+		tcpRx_.produced( got );
+		processTcpRx();
+		if ( udpBlocked_ || pendingUp_ || (size_t)got < RX_CHUNK )
+			break;
+	}
+}
+
+// forward complete frames from the TCP input buffer
+void
+CReactorBridge::processTcpRx()
+{
+struct mmsghdr msgs[BATCH_MAX];
+struct iovec   iovs[BATCH_MAX];
+unsigned       n;
+int            sent;
+size_t         off;
+uint32_t       len;
+
+	while ( tsd_ >= 0 && ! udpBlocked_ && ! pendingUp_ ) {
+
+		// collect a batch of complete frames
+		n   = 0;
+		off = 0;
+		while ( n < BATCH_MAX && tcpRx_.avail() - off >= FRAME_HDR ) {
+			memcpy( &len, tcpRx_.rdPtr() + off, FRAME_HDR );
+			len = ntohl( len );
+			if ( len > FRAME_MAX ) {
+				fprintf(stderr,"TCP (%hu): bad frame length (%lu); resetting connection\n", myPort_, (unsigned long)len);
+				closeTcp();
+				return;
+			}
+			if ( tcpRx_.avail() - off < FRAME_HDR + len )
+				break;
+			iovs[n].iov_base = tcpRx_.rdPtr() + off + FRAME_HDR;
+			iovs[n].iov_len  = len;
+			off             += FRAME_HDR + len;
+			n++;
+		}
+
+		if ( 0 == n )
+			break;
+
+#ifdef RSSI_BR_DEBUG
+		if ( debug() ) {
+			printf("TCP (%hu): got batch of %u frames\n", myPort_, n);
+		}
+#endif
+
+		if ( useRssi() ) {
+			for ( sent = 0; sent < (int)n; sent++ ) {
+				BufChain bc = IBufChain::create();
+				Buf      b  = bc->createAtHead( IBuf::CAPA_ETH_BIG );
+				b->setSize( iovs[sent].iov_len );
+				memcpy( b->getPayload(), iovs[sent].iov_base, iovs[sent].iov_len );
+				tcpRx_.consumed( FRAME_HDR + iovs[sent].iov_len );
+				if ( ! rssiPrt_->tryPush( bc ) ) {
+					// resume when the RSSI queue has room
+					pendingUp_ = bc;
+					wrHdl_.enable();
+					pump_->notify();
+					return;
+				}
+			}
+			continue;
+		}
+
+		memset( msgs, 0, n * sizeof(msgs[0]) );
+		for ( sent = 0; sent < (int)n; sent++ ) {
+			msgs[sent].msg_hdr.msg_iov    = &iovs[sent];
+			msgs[sent].msg_hdr.msg_iovlen = 1;
+		}
+
+		if ( (sent = sendmmsg( usd_, msgs, n, MSG_DONTWAIT )) < 0 ) {
+			if ( EINTR == errno ) {
+				continue;
+			}
+			if ( EAGAIN == errno || EWOULDBLOCK == errno ) {
+				udpBlocked_ = true;
+				return;
+			}
+			// e.g., ECONNREFUSED; drop this datagram (as a plain sendto would)
+			sent = 1;
+		}
+
+		while ( sent > 0 ) {
+			sent--;
+			tcpRx_.consumed( FRAME_HDR + iovs[sent].iov_len );
+		}
+	}
+}
+
+class CBridgeReactor : public IBridgeReactor {
+private:
+	std::vector< shared_ptr<CReactorWorker> > workers_;
+	std::vector< shared_ptr<CReactorBridge> > bridges_;
+	shared_ptr<CRssiPump>                     pump_;
+	unsigned                                  next_;
+
+public:
+	CBridgeReactor(unsigned numWorkers);
+
+	virtual unsigned short addBridge(const char *peerIp, unsigned short peerPort, unsigned short myPort, Flags flags);
+
+	virtual unsigned       getNumWorkers()
+	{
+		return workers_.size();
+	}
+
+	virtual ~CBridgeReactor();
+};
+
+CBridgeReactor::CBridgeReactor(unsigned numWorkers)
+: pump_( cpsw::make_shared<CRssiPump>() ),
+  next_( 0                              )
+{
+char     nam[32];
+unsigned i;
+
+	if ( 0 == numWorkers ) {
+		throw InvalidArgError("Reactor needs at least one worker");
+	}
+	for ( i = 0; i < numWorkers; i++ ) {
+		snprintf( nam, sizeof(nam), "bridge%u", i );
+		workers_.push_back( cpsw::make_shared<CReactorWorker>( nam ) );
+		workers_.back()->threadStart();
+	}
+	pump_->threadStart();
+}
+
+unsigned short
+CBridgeReactor::addBridge(const char *peerIp, unsigned short peerPort, unsigned short myPort, Flags flags)
+{
+shared_ptr<CReactorWorker> wrk = workers_[ next_ ];
+shared_ptr<CReactorBridge> br  = cpsw::make_shared<CReactorBridge>( wrk.get(), pump_->getEventSet(), peerIp, peerPort, myPort, flags );
+
+	bridges_.push_back( br );
+
+	// round-robin
+	if ( ++next_ == workers_.size() ) {
+		next_ = 0;
+	}
+
+	br->start();
+
+	return br->getPort();
+}
+
+CBridgeReactor::~CBridgeReactor()
+{
+unsigned i;
+	for ( i = 0; i < workers_.size(); i++ ) {
+		workers_[i]->threadStop();
+	}
+	bridges_.clear();
+	pump_->threadStop();
+}
+
+BridgeReactor
+IBridgeReactor::create(unsigned numWorkers)
+{
+	return cpsw::make_shared<CBridgeReactor>( numWorkers );
+}
@@ -0,0 +1,48 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef RSSI_BRIDGE_REACTOR_H
+#define RSSI_BRIDGE_REACTOR_H
+
+#include <cpsw_compat.h>
+
+// Relay many bridged connections with a small, fixed set of
+// epoll worker threads rather than with a pair of 'mover'
+// threads (plus UDP and TCP RX threads) per connection.
+//
+// Each bridge is owned by a single worker which handles its
+// sockets in non-blocking mode. Datagrams are received with
+// recvmmsg and TCP frames are forwarded with sendmmsg, i.e.,
+// in batches.
+//
+// RSSI connections still need a protocol thread each (CRssi);
+// the worker feeds its queues directly and a single 'pump'
+// thread (shared by all bridges) forwards queue events to
+// the workers.
+
+class IBridgeReactor;
+typedef shared_ptr<IBridgeReactor> BridgeReactor;
+
+class IBridgeReactor {
+public:
+	typedef enum { NONE = 0, RSSI = 1, DEBUG = 2, ALWAYSCONN = 4 } Flags;
+
+	// Create a bridge between UDP 'peerIp:peerPort' and a TCP server
+	// listening on 'myPort' (0 lets the system choose). Returns the
+	// actual TCP port.
+	virtual unsigned short addBridge(const char *peerIp, unsigned short peerPort, unsigned short myPort, Flags flags) = 0;
+
+	virtual unsigned       getNumWorkers()                                                                        = 0;
+
+	virtual ~IBridgeReactor() {}
+
+	static BridgeReactor create(unsigned numWorkers);
+};
+
+#endif
@@ -54,7 +54,7 @@ struct timespec now, fut;
 		m1   = "write";
 	}
 
-	if ( clock_gettime( CLOCK_REALTIME, &now ) )
+	if ( clock_gettime( CLOCK_MONOTONIC, &now ) )
 		return -1;
 
 	fut.tv_sec  = now.tv_sec + SOCKS_NEGO_TIMEOUT;
@@ -101,7 +101,7 @@ struct timespec now, fut;
 		/* more to do; prepare for calculating new timeout */
 
 		buf += xfr;
-		if ( clock_gettime( CLOCK_REALTIME, &now ) )
+		if ( clock_gettime( CLOCK_MONOTONIC, &now ) )
 			return -1;
 		
 	} while ( 1 );
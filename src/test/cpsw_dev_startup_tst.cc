@@ -0,0 +1,201 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+// Parallel startup of a hierarchy of Devs which take a while
+// to start (like NetIODevs waiting for an RSSI connection):
+//  - all Devs must be started, every Dev after the Devs below it
+//  - independent Devs must be started concurrently
+//  - an error must be propagated
+
+#include <cpsw_api_builder.h>
+#include <cpsw_hub.h>
+#include <cpsw_dev_startup.h>
+#include <cpsw_compat.h>
+#include <cpsw_obj_cnt.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+
+class TestFailed {
+public:
+	const char *msg_;
+	TestFailed(const char *msg) : msg_(msg) {}
+};
+
+#define NBOARDS 16
+#define DELAYUS 100000
+
+class CSlowDevImpl;
+typedef shared_ptr<CSlowDevImpl> SlowDevImpl;
+
+static cpsw::atomic<int> nStarted( 0 );
+
+class CSlowDevImpl : public CDevImpl {
+private:
+	unsigned delayUs_;
+	bool     fail_;
+	int      order_;
+public:
+	CSlowDevImpl(Key &k, const char *name, unsigned delayUs, bool fail)
+	: CDevImpl( k, name ),
+	  delayUs_( delayUs ),
+	  fail_   ( fail    ),
+	  order_  ( -1      )
+	{
+	}
+
+	CSlowDevImpl(const CSlowDevImpl &orig, Key &k)
+	: CDevImpl( orig, k ),
+	  delayUs_( orig.delayUs_ ),
+	  fail_   ( orig.fail_    ),
+	  order_  ( -1            )
+	{
+	}
+
+	virtual CSlowDevImpl *clone(Key &k) { return new CSlowDevImpl( *this, k ); }
+
+	virtual void startUp()
+	{
+		usleep( delayUs_ );
+		if ( fail_ ) {
+			throw IOError( "startup failed (on purpose)" );
+		}
+		CDevImpl::startUp();
+		order_ = nStarted.fetch_add( 1 );
+	}
+
+	int getOrder() const { return order_; }
+
+	static SlowDevImpl create(const char *name, unsigned delayUs, bool fail = false)
+	{
+		return CShObj::create<SlowDevImpl>( name, delayUs, fail );
+	}
+};
+
+static int64_t
+runStartup(unsigned nThreads, bool fail)
+{
+SlowDevImpl root = CSlowDevImpl::create( "root", 0 );
+SlowDevImpl boards[NBOARDS];
+SlowDevImpl subs[NBOARDS];
+char        nm[32];
+unsigned    i;
+bool        caught = false;
+
+	nStarted.store( 0 );
+
+	for ( i = 0; i < NBOARDS; i++ ) {
+		snprintf( nm, sizeof(nm), "board%u", i );
+		boards[i] = CSlowDevImpl::create( nm, DELAYUS, fail && i == NBOARDS/2 );
+		subs[i]   = CSlowDevImpl::create( "sub", DELAYUS/10 );
+		boards[i]->addAtAddress( subs[i], 1 );
+		root->addAtAddress( boards[i], 1 );
+	}
+
+	root->setLocked();
+
+	CDevStartup start( root );
+
+	if ( start.getNumDevs() != 2*NBOARDS + 1 ) {
+		throw TestFailed("not all Devs found");
+	}
+
+	try {
+		start.run( nThreads );
+	} catch ( CPSWError &e ) {
+		printf("Caught (expected: %d): %s\n", fail, e.getInfo().c_str());
+		caught = true;
+	}
+
+	start.dumpReport( stdout, 4 );
+
+	if ( fail ) {
+		if ( ! caught ) {
+			throw TestFailed("error not propagated");
+		}
+		if ( root->getOrder() >= 0 ) {
+			throw TestFailed("root started despite error");
+		}
+		return start.getTotalUs();
+	}
+
+	if ( caught ) {
+		throw TestFailed("unexpected error");
+	}
+
+	for ( i = 0; i < NBOARDS; i++ ) {
+		if ( subs[i]->getOrder() < 0 || boards[i]->getOrder() < 0 ) {
+			throw TestFailed("Dev not started");
+		}
+		if ( boards[i]->getOrder() < subs[i]->getOrder() || root->getOrder() < boards[i]->getOrder() ) {
+			throw TestFailed("Dev started before its children");
+		}
+	}
+
+	return start.getTotalUs();
+}
+
+static void
+usage(const char *nm)
+{
+	fprintf(stderr, "Usage: %s [-h] [-t <threads>]\n", nm);
+}
+
+int
+main(int argc, char **argv)
+{
+int      opt;
+unsigned nThreads = 8;
+int64_t  serUs, parUs;
+
+	while ( (opt = getopt(argc, argv, "ht:")) > 0 ) {
+		switch ( opt ) {
+			case 'h': usage( argv[0] ); return 0;
+			case 't':
+				if ( 1 != sscanf( optarg, "%u", &nThreads ) || nThreads < 2 ) {
+					fprintf(stderr, "Invalid number of threads (must be >= 2): %s\n", optarg);
+					return 1;
+				}
+				break;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+	}
+
+	try {
+		serUs = runStartup( 1,        false );
+		parUs = runStartup( nThreads, false );
+
+		// the serial startup takes > NBOARDS * DELAYUS
+		if ( parUs * 2 > serUs ) {
+			fprintf(stderr, "serial: %lldus, parallel (%u threads): %lldus\n", (long long)serUs, nThreads, (long long)parUs);
+			throw TestFailed("no speedup");
+		}
+
+		runStartup( nThreads, true );
+		runStartup( 1,        true );
+
+	} catch ( TestFailed &e ) {
+		fprintf(stderr, "Test FAILED: %s\n", e.msg_);
+		return 1;
+	} catch ( CPSWError &e ) {
+		fprintf(stderr, "CPSW Error: %s\n", e.getInfo().c_str());
+		return 1;
+	}
+
+	if ( CpswObjCounter::report(stderr) ) {
+		fprintf(stderr, "FAILED -- Objects leaked!\n");
+		return 1;
+	}
+
+	printf("Dev startup test PASSED\n");
+	return 0;
+}
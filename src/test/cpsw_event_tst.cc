@@ -0,0 +1,165 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <cpsw_error.h>
+
+#include <cpsw_event.h>
+
+#include <string>
+
+using std::string;
+
+#define NSRCS   256
+#define NITER   100000
+
+class TestFailed {
+public:
+	string e_;
+	TestFailed(const char *e):e_(e) {}
+};
+
+// count how often the event set polls us
+class CCountingSource : public CIntEventSource {
+public:
+	static unsigned long polls_;
+protected:
+	virtual bool checkForEvent()
+	{
+		polls_++;
+		return CIntEventSource::checkForEvent();
+	}
+};
+
+unsigned long CCountingSource::polls_ = 0;
+
+class CRecordingHandler : public IEventHandler {
+public:
+	static IIntEventSource *last_;
+
+	virtual void handle(IIntEventSource *src)
+	{
+		last_ = src;
+	}
+};
+
+IIntEventSource *CRecordingHandler::last_ = 0;
+
+static double
+now_ms()
+{
+struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1.0E3 + (double)ts.tv_nsec / 1.0E6;
+}
+
+static void *
+lateSender(void *arg)
+{
+struct timespec ts;
+	ts.tv_sec  = 0;
+	ts.tv_nsec = 10000000;
+	nanosleep( &ts, 0 );
+	static_cast<CIntEventSource*>( arg )->sendEvent( 1 );
+	return 0;
+}
+
+static void
+expectEvent(EventSet evs, CCountingSource *exp, const char *msg)
+{
+	CRecordingHandler::last_ = 0;
+	if ( ! evs->processEvent( false, 0 ) || CRecordingHandler::last_ != exp )
+		throw TestFailed( msg );
+}
+
+int
+main(int argc, char **argv)
+{
+EventSet           evs = IEventSet::create();
+CCountingSource   *src = new CCountingSource[NSRCS];
+CRecordingHandler *hdl = new CRecordingHandler[NSRCS];
+unsigned           i, j;
+unsigned long      polls;
+double             t0, el;
+CTimeout           abst;
+pthread_t          tid;
+
+	for ( i=0; i<NSRCS; i++ )
+		evs->add( &src[i], &hdl[i] );
+
+	srand48( 17 );
+
+	try {
+		if ( evs->processEvent( false, 0 ) )
+			throw TestFailed("event set reported a spurious event");
+
+		// only sources which posted an event should be polled
+		polls = CCountingSource::polls_;
+		for ( i=0; i<NITER; i++ ) {
+			j = lrand48() % NSRCS;
+			src[j].sendEvent( i + 1 );
+			expectEvent( evs, &src[j], "wrong source dispatched" );
+		}
+		polls = CCountingSource::polls_ - polls;
+		printf("%.2f polls per event (%u sources)\n", (double)polls/(double)NITER, NSRCS);
+		if ( polls > 3*NITER )
+			throw TestFailed("too many sources polled");
+
+		// sources added earlier have priority
+		src[5].sendEvent( 1 );
+		src[2].sendEvent( 1 );
+		expectEvent( evs, &src[2], "priority not respected (first)" );
+		expectEvent( evs, &src[5], "priority not respected (second)" );
+
+		// a disabled handler retains the event until re-enabled
+		hdl[7].disable();
+		src[7].sendEvent( 1 );
+		if ( evs->processEvent( false, 0 ) )
+			throw TestFailed("event dispatched to disabled handler");
+		hdl[7].enable();
+		expectEvent( evs, &src[7], "event lost while handler was disabled" );
+
+		// timeout
+		t0 = now_ms();
+		CTimeout rel( 20000 );
+		evs->getAbsTimeout( &abst, &rel );
+		if ( evs->processEvent( true, &abst ) )
+			throw TestFailed("event reported instead of timeout");
+		el = now_ms() - t0;
+		printf("20ms timeout took %.2fms\n", el);
+		if ( el < 20.0 || el > 1000.0 )
+			throw TestFailed("bad timeout");
+
+		// wakeup by another thread
+		CTimeout relLong( 1000000 );
+		evs->getAbsTimeout( &abst, &relLong );
+		if ( pthread_create( &tid, 0, lateSender, &src[NSRCS-1] ) )
+			throw TestFailed("pthread_create failed");
+		CRecordingHandler::last_ = 0;
+		if ( ! evs->processEvent( true, &abst ) || CRecordingHandler::last_ != &src[NSRCS-1] )
+			throw TestFailed("not woken by other thread");
+		pthread_join( tid, 0 );
+
+	} catch ( TestFailed e ) {
+		fprintf(stderr, "Test FAILED: %s\n", e.e_.c_str());
+		return 1;
+	}
+
+	for ( i=0; i<NSRCS; i++ )
+		evs->del( &src[i] );
+
+	delete [] src;
+	delete [] hdl;
+
+	printf("Event set test PASSED\n");
+	return 0;
+}
@@ -10,6 +10,7 @@
 #include <cpsw_api_builder.h>
 #include <cpsw_mmio_dev.h>
 #include <cpsw_hub.h>
+#include <cpsw_regmap.h>
 #include <cpsw_obj_cnt.h>
 
 #include <string.h>
@@ -17,9 +18,11 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <getopt.h>
+#include <vector>
 
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <malloc.h>
 
 
 #define VLEN 123
@@ -34,6 +37,15 @@ static uint64_t tv2usec(struct timeval *a)
 return (uint64_t)a->tv_sec * 1000000ULL + (uint64_t)a->tv_usec;
 }
 
+static int64_t heap_used()
+{
+#if defined(__GLIBC__) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 33 ) )
+	return mallinfo2().uordblks;
+#else
+	return mallinfo().uordblks;
+#endif
+}
+
 static uint64_t us_so_far()
 {
 struct rusage r;
@@ -52,6 +64,12 @@ uint64_t init_us  = us_so_far();
 uint64_t build_us = 0;
 uint64_t lkup_us  = 0;
 uint64_t read_us  = 0;
+uint64_t cmpl_us  = 0;
+uint64_t tbl_us   = 0;
+uint64_t tlkp_us  = 0;
+uint64_t tmp_us;
+unsigned tbl_mem  = 0;
+int64_t  bld_mem  = heap_used();
 
 int  elsz = 32;
 int  elszb;
@@ -124,6 +142,7 @@ uint64_t   uv;
 	}
 
 	build_us = us_so_far() - init_us;
+	bld_mem  = heap_used() - bld_mem;
 
 	Path pre = IPath::create( rmem );
 
@@ -150,15 +169,102 @@ uint64_t   uv;
 	}
 
 	read_us = us_so_far() - lkup_us;
+
+	// flat register table of the (locked) hierarchy
+	tmp_us  = us_so_far();
+
+	rmem->getSelf()->setLocked();
+
+	const CRegMap *map = rmem->getSelf()->isConstDevImpl()->getRegMap();
+
+	if ( ! map || map->getNumLeaves() != (unsigned)nelms ) {
+		printf( "FAILED: register table not compiled or has wrong size\n" );
+		throw TestFailed();
+	}
+
+	cmpl_us = us_so_far() - tmp_us;
+	tmp_us  = us_so_far();
+
+	uint8_t raw[8];
+
+	bufp = rmem->getBufp();
+
+	for (int i=0; i<nelms; i++) {
+		::sprintf(nm,"mmio/r-%i",i);
+		const CRegMap::Leaf *l = map->find( nm );
+		if ( ! l || ! l->plan_.isValid() || l->plan_.getOffset() != (uint64_t)elszb*i || ! l->bulk_ ) {
+			printf( "FAILED: bad register table entry for %s\n", nm );
+			throw TestFailed();
+		}
+		if ( map->read( l, raw ) != (uint64_t)elszb || memcmp( raw, bufp + elszb*i, elszb ) ) {
+			printf( "FAILED: raw read of %s through register table\n", nm );
+			throw TestFailed();
+		}
+	}
+
+	tbl_us  = us_so_far() - tmp_us;
+	tbl_mem = map->getMemUsage();
+
+	if ( map->find( "mmio/r-x" ) || map->find( "mmio" ) ) {
+		printf( "FAILED: register table found non-existing leaf\n" );
+		throw TestFailed();
+	}
+
+	// findByName now resolves through the table
+	tmp_us  = us_so_far();
+
+	for (int i=0; i<nelms; i++) {
+		::sprintf(nm,"mmio/r-%i",i);
+		Path p = pre->findByName( nm );
+		if ( p->getNelms() != 1 || p->tail()->getName() != std::string( nm + 5 ) ) {
+			printf( "FAILED: findByName through register table (%s)\n", nm );
+			throw TestFailed();
+		}
+	}
+
+	tlkp_us = us_so_far() - tmp_us;
+
+	if ( pre->findByName( "mmio/r-0" )->toString() != vals[0]->getPath()->toString() ) {
+		printf( "FAILED: path from register table differs\n" );
+		throw TestFailed();
+	}
+
+	// snapshot and restore (the snapshot is in table order)
+	std::vector<uint8_t> snap;
+	std::vector<uint8_t> orig( bufp, bufp + map->getRawSize() );
+
+	if ( rmem->saveRegisters( &snap ) != (uint64_t)elszb*nelms ) {
+		printf( "FAILED: register table snapshot\n" );
+		throw TestFailed();
+	}
+
+	for ( unsigned i=0, off=0; i<map->getNumLeaves(); i++, off += elszb ) {
+		if ( memcmp( &snap[off], bufp + map->getLeaf(i)->plan_.getOffset(), elszb ) ) {
+			printf( "FAILED: register table snapshot (%s)\n", map->getName( map->getLeaf(i) ) );
+			throw TestFailed();
+		}
+	}
+
+	memset( bufp, 0, snap.size() );
+
+	rmem->restoreRegisters( snap );
+
+	if ( memcmp( &orig[0], bufp, snap.size() ) ) {
+		printf( "FAILED: register table restore\n" );
+		throw TestFailed();
+	}
 } catch (CPSWError &e) {
 	printf("CPSW Error: %s\n", e.getInfo().c_str());
 	throw;
 }
 
 	printf("Large test successful; read %i registers of size %u-bits\n", nelms, (unsigned)elsz);
-	printf("Building hierarchy:                 %8" PRIu64 "us\n", build_us);
+	printf("Building hierarchy:                 %8" PRIu64 "us (%" PRId64 " bytes/register)\n", build_us, bld_mem/nelms);
 	printf("Name lookup:                        %8" PRIu64 "us\n", lkup_us);
 	printf("Reading (from memory pseudo device) %8" PRIu64 "us\n", read_us);
+	printf("Compiling register table:           %8" PRIu64 "us (%u bytes)\n", cmpl_us, tbl_mem);
+	printf("Table lookup + raw read:            %8" PRIu64 "us\n", tbl_us);
+	printf("Name lookup (through table):        %8" PRIu64 "us\n", tlkp_us);
 
 	if ( CpswObjCounter::report(stderr) ) {
 		fprintf(stderr,"FAILED -- Objects leaked!\n");
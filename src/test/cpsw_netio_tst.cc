@@ -121,10 +121,14 @@ int      retryCount  =  4;
 const char *use_yaml =  0;
 const char *dmp_yaml =  0;
 int      depack2     =  0;
+int      sockBufSize =  0;
+int      useUring    =  0;
+int      usePktRing  =  0;
+const char *cpuAff   =  0;
 
 	setCPSWVerbosity("rssi",1);
 
-	for ( int opt; (opt = getopt(argc, argv, "a:V:p:rt:bY:y:R:2")) > 0; ) {
+	for ( int opt; (opt = getopt(argc, argv, "a:V:p:rt:bY:y:R:2S:UPA:")) > 0; ) {
 		i_p = 0;
 		switch ( opt ) {
 			case 'a': ip_addr     = optarg;      break;
@@ -137,6 +141,10 @@ int      depack2     =  0;
 			case 'y': dmp_yaml    = optarg;      break;
 			case 'R': i_p         = &retryCount; break;
 			case '2': depack2     = 1;           break;
+			case 'S': i_p         = &sockBufSize;break;
+			case 'U': useUring    = 1;           break;
+			case 'P': usePktRing  = 1;           break;
+			case 'A': cpuAff      = optarg;      break;
 			default:
 				fprintf(stderr,"Unknown option '%c'\n", opt);
 				throw TestFailed();
@@ -198,6 +206,20 @@ int      depack2     =  0;
 		if ( tDest >= 0 ) {
 			pbldr->setTDestMuxTDEST       (                 tDest );
 		}
+		if ( sockBufSize > 0 ) {
+			pbldr->setUdpRcvBufSize( sockBufSize );
+			pbldr->setUdpSndBufSize( sockBufSize );
+		}
+		if ( useUring ) {
+			pbldr->setUdpUseUring( true );
+		}
+		if ( usePktRing ) {
+			pbldr->setUdpUsePacketRing( true );
+		}
+		if ( cpuAff ) {
+			pbldr->setThreadCpuAffinity( cpuAff );
+			pbldr->setThreadSchedPolicy( IProtoStackBuilder::SCHED_POLICY_OTHER );
+		}
 		if ( depack2 ) {
 			pbldr->useDepack( true );
 			pbldr->setDepackVersion( IProtoStackBuilder::DEPACKETIZER_V2 );
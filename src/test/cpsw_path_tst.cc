@@ -9,12 +9,14 @@
 
 #include <cpsw_api_builder.h>
 #include <cpsw_path.h>
+#include <cpsw_hub.h>
 #include <cpsw_obj_cnt.h>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <cpsw_yaml.h>
 
@@ -204,6 +206,93 @@ static void test_dotdot_across_root_f8560f57884( Hub r )
 	r->findByName("outer/../outer/inner");
 }
 
+static void test_many_children_and_cache()
+{
+std::ostringstream yaml;
+unsigned           i;
+char               nm[64];
+Hub                root;
+CPathCache        *cache;
+Path               p, q;
+uint64_t           hits;
+
+	yaml << "#schemaversion 3.0.0\n";
+	yaml << "root:\n";
+	yaml << "  " YAML_KEY_class ": Dev\n";
+	yaml << "  " YAML_KEY_children ":\n";
+	yaml << "    dev:\n";
+	yaml << "      " YAML_KEY_class ": Dev\n";
+	yaml << "      " YAML_KEY_at ":\n";
+	yaml << "        " YAML_KEY_nelms ": 2\n";
+	yaml << "      " YAML_KEY_children ":\n";
+	for ( i=0; i<1000; i++ ) {
+		yaml << "        reg" << i << ":\n";
+		yaml << "          " YAML_KEY_class ": Field\n";
+		yaml << "          " YAML_KEY_size ": 1\n";
+		yaml << "          " YAML_KEY_at ":\n";
+		yaml << "            " YAML_KEY_nelms ": " << (i % 7) + 1 << "\n";
+	}
+
+	root  = IPath::loadYamlStream( yaml.str().c_str(), "root" )->origin();
+
+	cache = cpsw::dynamic_pointer_cast<const CDevImpl>( root )->getPathCache();
+
+	if ( ! cache || cache->getCapacity() != 4 ) {
+		fprintf(stderr,"Path cache not created\n");
+		throw TestFailed();
+	}
+
+	// hashed lookup of every child
+	for ( i=0; i<1000; i++ ) {
+		sprintf(nm, "dev/reg%u", i);
+		p = root->findByName( nm );
+		if ( strcmp( p->tail()->getName(), nm + 4 ) || p->getNelms() != 2*((i % 7) + 1) ) {
+			fprintf(stderr,"Lookup of %s failed\n", nm);
+			throw TestFailed();
+		}
+	}
+
+	try {
+		root->findByName("dev/reg1000");
+		throw TestFailed();
+	} catch ( NotFoundError &e ) {
+	}
+	try {
+		// prefix of an existing name
+		root->findByName("dev/reg1[0]/../reg");
+		throw TestFailed();
+	} catch ( NotFoundError &e ) {
+	}
+
+	if ( cache->getSize() != 4 ) {
+		fprintf(stderr,"Path cache not full\n");
+		throw TestFailed();
+	}
+
+	// 'dev/reg999' is cached; modifying a returned path must not affect the cache
+	hits = cache->getNumHits();
+	p    = root->findByName( "dev/reg999" );
+	p->up();
+	q    = root->findByName( "dev/reg999" );
+	if ( cache->getNumHits() != hits + 2 || q->toString() != "/dev[0-1]/reg999[0-5]" ) {
+		fprintf(stderr,"Path cache hit failed (%s)\n", q->toString().c_str());
+		throw TestFailed();
+	}
+
+	// 'dev/reg0' was evicted
+	root->findByName( "dev/reg0" );
+	if ( cache->getNumHits() != hits + 2 ) {
+		fprintf(stderr,"Path cache did not evict\n");
+		throw TestFailed();
+	}
+
+	// relative lookups are not cached
+	q = p->findByName( "reg5" );
+	if ( cache->getNumHits() != hits + 2 || q->toString() != "/dev[0-1]/reg5[0-5]" ) {
+		throw TestFailed();
+	}
+}
+
 using std::cout;
 
 class DumpNameVisitor : public IPathVisitor {
@@ -320,10 +409,11 @@ Field  c4 = IField::create("leaf1", 8);
 int
 main(int argc, char **argv)
 {
-bool use_yaml = false;
+bool use_yaml  = false;
+bool use_cache = false;
 int  opt;
 
-while ( (opt = getopt(argc, argv, "Y")) > 0 ) {
+while ( (opt = getopt(argc, argv, "YC")) > 0 ) {
 	switch (opt) {
 		default:
 			fprintf(stderr,"Unknown option -%c\n", opt);
@@ -331,7 +421,28 @@ while ( (opt = getopt(argc, argv, "Y")) > 0 ) {
 		case 'Y':
 			use_yaml = true;
 		break;
+		case 'C':
+			use_cache = true;
+		break;
+	}
+}
+
+if ( use_cache ) {
+	// exercise the path cache (hierarchies loaded from YAML);
+	// the capacity is read once per process, so the cache test
+	// runs on its own and the other tests stay uncached.
+	setenv("CPSW_PATH_CACHE_SIZE", "4", 1);
+	try {
+		test_many_children_and_cache();
+	} catch (CPSWError &e ) {
+		fprintf(stderr, "CPSW Error: %s\n", e.getInfo().c_str());
+		throw;
+	}
+	if ( CpswObjCounter::report(stderr) ) {
+		fprintf(stderr,"FAILED -- objects leaked\n");
+		throw TestFailed();
 	}
+	return 0;
 }
 
 try {
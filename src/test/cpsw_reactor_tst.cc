@@ -0,0 +1,289 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+// Ping-pong frames through many UDP protocol stacks (one per
+// simulated board) against a local echo server; compare the
+// thread-per-module model with the shared reactor ('-R') and
+// the io_uring backend ('-U') and the shared socket pool ('-M').
+// Every board has its own (loopback) address.
+// Reports round-trip latency percentiles, the number of threads
+// and sockets and the number of context switches.
+
+#include <cpsw_api_builder.h>
+#include <cpsw_error.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <vector>
+#include <algorithm>
+
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+class TestFailed {};
+
+// reply from the address the request was sent to
+// (IP_PKTINFO) so that every board has a distinct address
+static void *
+echoServer(void *arg)
+{
+int                sd = *(int*)arg;
+uint8_t            buf[9000];
+struct sockaddr_in sa;
+struct msghdr      msg;
+struct iovec       iov;
+ssize_t            got;
+union {
+	struct cmsghdr align;
+	char           buf[CMSG_SPACE(sizeof(struct in_pktinfo))];
+}                  ctl;
+
+	while ( 1 ) {
+		iov.iov_base       = buf;
+		iov.iov_len        = sizeof(buf);
+		memset( &msg, 0, sizeof(msg) );
+		msg.msg_name       = &sa;
+		msg.msg_namelen    = sizeof(sa);
+		msg.msg_iov        = &iov;
+		msg.msg_iovlen     = 1;
+		msg.msg_control    = ctl.buf;
+		msg.msg_controllen = sizeof(ctl.buf);
+		if ( (got = recvmsg( sd, &msg, 0 )) < 0 ) {
+			perror("echo recvmsg");
+			return NULL;
+		}
+		// don't bother echoing polls
+		if ( got > 0 ) {
+			iov.iov_len = got;
+			sendmsg( sd, &msg, 0 );
+		}
+	}
+	return NULL;
+}
+
+static unsigned
+countSockets()
+{
+DIR           *d = opendir("/proc/self/fd");
+struct dirent *e;
+char           path[300], lnk[64];
+ssize_t        l;
+unsigned       n = 0;
+
+	if ( ! d )
+		return 0;
+	while ( (e = readdir( d )) ) {
+		snprintf( path, sizeof(path), "/proc/self/fd/%s", e->d_name );
+		if ( (l = readlink( path, lnk, sizeof(lnk) - 1 )) > 0 ) {
+			lnk[l] = 0;
+			if ( 0 == strncmp( lnk, "socket:", 7 ) )
+				n++;
+		}
+	}
+	closedir( d );
+	return n;
+}
+
+static unsigned
+countThreads()
+{
+DIR           *d = opendir("/proc/self/task");
+struct dirent *e;
+unsigned       n = 0;
+
+	if ( ! d )
+		return 0;
+	while ( (e = readdir( d )) ) {
+		if ( '.' != e->d_name[0] )
+			n++;
+	}
+	closedir( d );
+	return n;
+}
+
+static uint64_t
+ctxSwitches()
+{
+struct rusage ru;
+	getrusage( RUSAGE_SELF, &ru );
+	return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+static double
+now_us()
+{
+struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1.0E6 + (double)ts.tv_nsec / 1.0E3;
+}
+
+static void
+usage(const char *nm)
+{
+	fprintf(stderr,"Usage: %s [-N <boards>] [-n <rounds>] [-s <size>] [-R] [-U] [-M] [-h]\n", nm);
+	fprintf(stderr,"       -N <boards> : number of protocol stacks (default 20; max 250)\n");
+	fprintf(stderr,"       -n <rounds> : number of ping-pong rounds over all boards (default 500)\n");
+	fprintf(stderr,"       -s <size>   : frame size in bytes (default 64)\n");
+	fprintf(stderr,"       -R          : use the shared reactor for UDP\n");
+	fprintf(stderr,"       -U          : use io_uring for UDP\n");
+	fprintf(stderr,"       -M          : use the shared UDP socket pool\n");
+}
+
+int
+main(int argc, char **argv)
+{
+unsigned           nBoards = 20;
+unsigned           nRounds = 500;
+unsigned           size    = 64;
+bool               reactor = false;
+bool               uring   = false;
+bool               mux     = false;
+int                one     = 1;
+unsigned          *u_p;
+int                opt;
+int                sd;
+struct sockaddr_in sin;
+socklen_t          sl = sizeof(sin);
+pthread_t          tid;
+unsigned           i, r;
+char               nm[32];
+char               ip[32];
+
+	while ( (opt = getopt(argc, argv, "N:n:s:RUMh")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'N': u_p = &nBoards; break;
+			case 'n': u_p = &nRounds; break;
+			case 's': u_p = &size;    break;
+			case 'R': reactor = true; break;
+			case 'U': uring   = true; break;
+			case 'M': mux     = true; break;
+			case 'h': usage( argv[0] ); return 0;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr,"Unable to scan argument to option '-%c'\n", opt);
+			return 1;
+		}
+	}
+
+	if ( size < sizeof(uint32_t) || size > 1024 || 0 == nBoards || nBoards > 250 || 0 == nRounds ) {
+		fprintf(stderr,"Invalid size, number of boards or rounds\n");
+		return 1;
+	}
+
+	if ( (sd = socket( AF_INET, SOCK_DGRAM, 0 )) < 0 ) {
+		perror("socket");
+		return 1;
+	}
+	sin.sin_family      = AF_INET;
+	sin.sin_addr.s_addr = INADDR_ANY;
+	sin.sin_port        = htons( 0 );
+	if ( setsockopt( sd, SOL_IP, IP_PKTINFO, &one, sizeof(one) ) ) {
+		perror("setsockopt(IP_PKTINFO)");
+		return 1;
+	}
+	if ( bind( sd, (struct sockaddr*)&sin, sizeof(sin) ) || getsockname( sd, (struct sockaddr*)&sin, &sl ) ) {
+		perror("unable to set up echo server");
+		return 1;
+	}
+	if ( pthread_create( &tid, NULL, echoServer, &sd ) ) {
+		perror("pthread_create");
+		return 1;
+	}
+
+try {
+	std::vector<NetIODev> roots;
+	std::vector<Stream>   strms;
+	std::vector<double>   lat;
+	uint8_t               buf[1024];
+	uint8_t               rbuf[1024];
+	uint32_t              seq;
+	int64_t               got;
+	unsigned              threadsBefore = countThreads();
+	unsigned              socksBefore   = countSockets();
+	uint64_t              csw;
+	double                t0, t1, tot;
+
+	for ( i = 0; i < nBoards; i++ ) {
+		ProtoStackBuilder bldr = IProtoStackBuilder::create();
+
+		snprintf( nm, sizeof(nm), "board%u", i );
+		snprintf( ip, sizeof(ip), "127.0.0.%u", i + 1 );
+		NetIODev root = INetIODev::create( nm, ip );
+
+		bldr->setSRPVersion   ( IProtoStackBuilder::SRP_UDP_NONE );
+		bldr->setUdpPort      ( ntohs( sin.sin_port )             );
+		bldr->setUdpUseReactor( reactor                           );
+		bldr->setUdpUseUring  ( uring                             );
+		bldr->setUdpUseSharedSocket( mux                          );
+
+		root->addAtAddress( IField::create("strm"), bldr );
+
+		roots.push_back( root );
+		strms.push_back( IStream::create( root->findByName("strm") ) );
+	}
+
+	memset( buf, 0x55, sizeof(buf) );
+	lat.reserve( nBoards * nRounds );
+
+	csw = ctxSwitches();
+	tot = now_us();
+
+	for ( r = 0; r < nRounds; r++ ) {
+		for ( i = 0; i < nBoards; i++ ) {
+			seq = (r << 8) | (i & 0xff);
+			memcpy( buf, &seq, sizeof(seq) );
+			t0 = now_us();
+			strms[i]->write( buf, size );
+			got = strms[i]->read( rbuf, sizeof(rbuf), CTimeout( 1000000 ) );
+			t1 = now_us();
+			if ( got != (int64_t)size || memcmp( buf, rbuf, size ) ) {
+				fprintf(stderr,"Round %u, board %u: bad or missing reply (got %" PRId64 ")\n", r, i, got);
+				throw TestFailed();
+			}
+			lat.push_back( t1 - t0 );
+		}
+	}
+
+	tot = now_us() - tot;
+	csw = ctxSwitches() - csw;
+
+	std::sort( lat.begin(), lat.end() );
+
+	printf("%s model, %u boards, %u rounds of %u-byte frames\n", mux ? "Shared-socket" : uring ? "io_uring" : reactor ? "Reactor" : "Thread-per-module", nBoards, nRounds, size);
+	printf("  Threads (CPSW)     : %u\n",   countThreads() - threadsBefore);
+	printf("  Sockets (CPSW)     : %u\n",   countSockets() - socksBefore);
+	printf("  Round trip p50     : %.1f us\n", lat[ lat.size()/2 ]);
+	printf("  Round trip p99     : %.1f us\n", lat[ (lat.size()*99)/100 ]);
+	printf("  Round trips/s      : %.0f\n", (double)lat.size() / tot * 1.0E6);
+	printf("  Context switches   : %" PRIu64 " (%.2f per round trip)\n", csw, (double)csw/(double)lat.size());
+
+} catch ( CPSWError &e ) {
+	fprintf(stderr,"CPSW Error: %s\n", e.getInfo().c_str());
+	return 1;
+} catch ( TestFailed &e ) {
+	fprintf(stderr,"Test FAILED\n");
+	return 1;
+}
+
+	printf("TEST PASSED\n");
+	return 0;
+}
@@ -16,6 +16,10 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <getopt.h>
+#include <time.h>
+#include <dirent.h>
+#include <vector>
+#include <algorithm>
 
 #include <udpsrv_regdefs.h>
 
@@ -75,6 +79,52 @@ static CMtx mtx_;
 
 CMtx M::mtx_;
 
+static unsigned
+countThreads()
+{
+DIR           *d = opendir("/proc/self/task");
+struct dirent *e;
+unsigned       n = 0;
+
+	if ( ! d )
+		return 0;
+	while ( (e = readdir( d )) ) {
+		if ( '.' != e->d_name[0] )
+			n++;
+	}
+	closedir( d );
+	return n;
+}
+
+static double
+now_us()
+{
+struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (double)ts.tv_sec * 1.0E6 + (double)ts.tv_nsec / 1.0E3;
+}
+
+// time single-register reads
+static void
+measureLatency(unsigned n)
+{
+Path                p( IDev::getRootDev()->findByName("comm/mmio_vc_1/val[0]") );
+ScalVal_RO          v( IScalVal_RO::create( p ) );
+std::vector<double> lat;
+uint32_t            val;
+double              t0;
+unsigned            i;
+
+	lat.reserve( n );
+	for ( i = 0; i < n; i++ ) {
+		t0 = now_us();
+		v->getVal( &val, 1 );
+		lat.push_back( now_us() - t0 );
+	}
+	std::sort( lat.begin(), lat.end() );
+	printf("Register read latency (%u reads): p50 %.1f us, p99 %.1f us\n", n, lat[ n/2 ], lat[ (n*99)/100 ]);
+}
+
 static void* test_thread(void* arg)
 {
 char nm[100];
@@ -157,20 +207,29 @@ int  rval      = 1;
 int  useRssi   = 0;
 int  tDest     = -1;
 int  depack2   = 0;
+int  inlDemux  = 0;
+int  nLat      = 0;
+int  busyPoll  = 0;
 
-	while ( (opt = getopt(argc, argv, "hV:p:r2")) > 0 ) {
+	while ( (opt = getopt(argc, argv, "hV:p:r2IL:B:")) > 0 ) {
 		i_p = 0;
 		switch ( opt ) {
 			case 'V': i_p = &ivers; break;
 			case 'p': i_p = &port;  break;
 			case 'r': useRssi = 1;  break;
 			case '2': depack2 = 1;  break;
+			case 'I': inlDemux = 1; break;
+			case 'L': i_p = &nLat;  break;
+			case 'B': i_p = &busyPoll; break;
 			case 'h':
 				rval = 0;
 				/* fall thru */
 			default:
 				fprintf(stderr,"Unknown option '-%c'\n", opt);
-				fprintf(stderr,"usage: %s [-V <proto_vers>] [-p <dest_port>] [-2] [-r] [-h]\n", argv[0]);
+				fprintf(stderr,"usage: %s [-V <proto_vers>] [-p <dest_port>] [-2] [-r] [-I] [-L <reads>] [-B <us>] [-h]\n", argv[0]);
+				fprintf(stderr,"       -I          : demultiplex inline (no demultiplexer threads)\n");
+				fprintf(stderr,"       -L <reads>  : measure register read latency\n");
+				fprintf(stderr,"       -B <us>     : busy-poll for replies (spin budget in us)\n");
 				return rval;
 		}
 		if ( i_p && 1 != sscanf(optarg,"%i",i_p) ) {
@@ -219,11 +278,20 @@ int  depack2   = 0;
 //		bldr->setSRPDefaultWriteMode( SYNCHRONOUS );
 		bldr->setUdpPort          (    port );
 		bldr->useRssi             ( useRssi );
+		if ( inlDemux ) {
+			bldr->setSRPMuxInlineDemux( true );
+		}
+		if ( busyPoll > 0 ) {
+			bldr->setSRPBusyPollUS( busyPoll );
+		}
 		if ( tDest >= 0 ) {
 			bldr->setTDestMuxTDEST(   tDest );
 			if ( depack2 ) {
 				bldr->setDepackVersion( IProtoStackBuilder::DEPACKETIZER_V2 );
 			}
+			if ( inlDemux ) {
+				bldr->setTDestMuxInlineDemux( true );
+			}
 		}
 
 		bldr->setSRPMuxVirtualChannel( vc1 );
@@ -285,6 +353,11 @@ int  depack2   = 0;
 			}
 		}
 
+		if ( nLat > 0 ) {
+			measureLatency( nLat );
+			printf("Threads: %u\n", countThreads());
+		}
+
 	} catch (CPSWError &e) {
 		fprintf(stderr,"CPSW Error: %s\n", e.getInfo().c_str());
 		throw;
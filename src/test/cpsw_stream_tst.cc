@@ -11,6 +11,7 @@
 #include <cpsw_proto_mod_depack.h>
 #include <crc32-le-tbl-4.h>
 #include <pthread.h>
+#include <yaml-cpp/yaml.h>
 
 #include <stdio.h>
 #define __STDC_FORMAT_MACROS
@@ -22,7 +23,7 @@ class TestFailed {};
 
 static void usage(const char *nm)
 {
-	fprintf(stderr,"Usage: %s [-h] [-s <port>] [-q <input_queue_depth>] [-Q <output queue depth>] [-L <log2(frameWinSize)>] [-l <fragWinSize>] [-T <timeout_us>] [-e err_percent] [-n n_frames] [-R] [-y dump-yaml] [-Y load-yaml] [-2]\n", nm);
+	fprintf(stderr,"Usage: %s [-h] [-s <port>] [-q <input_queue_depth>] [-Q <output queue depth>] [-L <log2(frameWinSize)>] [-l <fragWinSize>] [-T <timeout_us>] [-e err_percent] [-n n_frames] [-R] [-y dump-yaml] [-Y load-yaml] [-2] [-P]\n", nm);
 }
 
 #define STRT(chnl) (0x01<<(chnl))
@@ -42,6 +43,8 @@ struct StrmCtxt {
 	int       quiet;
 	Path      strmPath;
 	unsigned  goodf;
+	unsigned  nread;   // all frames read (incl. rejected and drained)
+	Stream    strm;    // kept open until the statistics are checked
 	int       status;  // written by thread
 	bool      started; // written by main
 	pthread_t tid;
@@ -133,10 +136,13 @@ unsigned attempts;
 unsigned hsiz, tsiz;
 int64_t  got;
 unsigned tdest;
+unsigned drained;
+struct timespec rxTs, now;
 
 	lfram    = -1;
 	errs     = 0;
 	c->goodf = 0;
+	c->nread = 0;
 	attempts = 0;
 
 try {
@@ -162,7 +168,7 @@ printf("Rcvr startup: %s\n", c->strmPath ? c->strmPath->toString().c_str() : "<N
 			sendMsg( strm, STRT(c->chnl), c->depack2 );
 		}
 
-		got = strm->read( buf, sizeof(buf), CTimeout(c->timeoutUs), 0 );
+		got = strm->read( buf, sizeof(buf), CTimeout(c->timeoutUs), 0, &rxTs );
 
 		if ( c->debug > 1 )
 			printf("Read %" PRIu64 " octets\n", got);
@@ -172,6 +178,19 @@ printf("Rcvr startup: %s\n", c->strmPath ? c->strmPath->toString().c_str() : "<N
 			throw StrmRxFailed();
 		}
 
+		c->nread++;
+
+		// kernel receive timestamp must be present and recent
+		clock_gettime( CLOCK_REALTIME, &now );
+		if ( 0 == rxTs.tv_sec && 0 == rxTs.tv_nsec ) {
+			fprintf(stderr,"Read -- frame without RX timestamp\n");
+			throw StrmRxFailed();
+		}
+		if ( CTimeout( now ) < CTimeout( rxTs ) || now.tv_sec - rxTs.tv_sec > 10 ) {
+			fprintf(stderr,"Read -- bad RX timestamp (%ld.%09ld; now %ld.%09ld)\n", (long)rxTs.tv_sec, rxTs.tv_nsec, (long)now.tv_sec, now.tv_nsec);
+			throw StrmRxFailed();
+		}
+
 		if ( c->debug > 1 ) {
 			for ( unsigned k = 0; k<8; k++ )
 				printf("FRM/FRG 0x%" PRIx8 "\n", buf[k]);
@@ -225,6 +244,22 @@ printf("Rcvr startup: %s\n", c->strmPath ? c->strmPath->toString().c_str() : "<N
 	sendMsg( strm, STOP(c->chnl), c->depack2 );
 	sendMsg( strm, STOP(c->chnl), c->depack2 );
 
+	// read what is still in flight so that the statistics can
+	// be compared exactly; the stream stays open until main
+	// has looked at them.
+	drained = 0;
+	while ( strm->read( buf, sizeof(buf), CTimeout( 500000 ) ) > 0 ) {
+		c->nread++;
+		if ( ++drained > 10000 ) {
+			fprintf(stderr,"Stream does not stop\n");
+			goto bail;
+		}
+		if ( (drained & 31) == 0 ) {
+			sendMsg( strm, STOP(c->chnl), c->depack2 );
+		}
+	}
+	c->strm = strm;
+
 } catch ( CPSWError &e ) {
 		fprintf(stderr,"CPSW Error in reader thread (%s): %s\n", c->strmPath->toString().c_str(), e.getInfo().c_str());
 		throw;
@@ -243,6 +278,75 @@ bail:
 }
 
 
+// verify that the statistics exported by the TDEST demultiplexer
+// (or the depacketizer if there is none) account for exactly the
+// frames we read. The readers drained the streams and still hold
+// them open, i.e., nothing is in flight or discarded. Frames
+// on other TDESTs (e.g., udpsrv echoing our messages) are seen
+// by the depacketizer but never by the reader.
+static int
+checkStats(Hub root, StrmCtxt *ctxt, int depack2)
+{
+shared_ptr<const INetIODev> netio = cpsw::dynamic_pointer_cast<const INetIODev>( root );
+YAML::Node                  stats;
+YAML::Node                  ports;
+uint64_t                    nFrames;
+uint64_t                    nOther = 0, nReadOther = 0;
+unsigned                    i;
+bool                        known, unknown = false;
+
+	if ( ! netio ) {
+		return 0;
+	}
+
+	netio->dumpStats( stats );
+
+	ports = stats["data"][ depack2 ? "TDEST Demultiplexer V2" : "TDEST Demultiplexer" ]["ports"];
+
+	if ( ! ports ) {
+		// no demultiplexer -- a single stream
+		nFrames = stats["data"]["AXIS Depack"]["framesCompleted"].as<uint64_t>();
+		if ( nFrames != ctxt[0].nread ) {
+			fprintf(stderr,"Statistics report %" PRIu64 " frames but %u were read\n", nFrames, ctxt[0].nread);
+			return -1;
+		}
+		return 0;
+	}
+
+	// with a YAML file we don't know the readers' TDESTs; they
+	// must account for all the frames on the remaining ports
+	for ( YAML::const_iterator it = ports.begin(); it != ports.end(); ++it ) {
+		nFrames = (*it)["rxFrames"].as<uint64_t>() - (*it)["outQueueDrops"].as<uint64_t>();
+		known   = false;
+		for ( i=0; i<NUM_STREAMS; i++ ) {
+			if ( ctxt[i].started && (*it)["TDEST"].as<unsigned>() == ctxt[i].tdest ) {
+				known = true;
+				if ( nFrames != ctxt[i].nread ) {
+					fprintf(stderr,"Statistics report %" PRIu64 " frames but %u were read (stream %u)\n", nFrames, ctxt[i].nread, i);
+					return -1;
+				}
+			}
+		}
+		if ( ! known ) {
+			nOther += nFrames;
+		}
+	}
+
+	for ( i=0; i<NUM_STREAMS; i++ ) {
+		if ( ctxt[i].started && (unsigned)-1 == ctxt[i].tdest ) {
+			nReadOther += ctxt[i].nread;
+			unknown     = true;
+		}
+	}
+
+	if ( unknown && nOther != nReadOther ) {
+		fprintf(stderr,"Statistics report %" PRIu64 " frames but %" PRIu64 " were read\n", nOther, nReadOther);
+		return -1;
+	}
+
+	return 0;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -256,6 +360,7 @@ unsigned sport       = 8193;
 const char *dmp_yaml = 0;
 const char *use_yaml = 0;
 unsigned err_percent = 0;
+int      usePacketRing = 0;
 int      err;
 int      i;
 int      opt;
@@ -279,7 +384,7 @@ StrmCtxt ctxt[NUM_STREAMS];
 		ctxt[i].tdest   = -1;
 	}
 
-	while ( (opt=getopt(argc, argv, "dl:L:hT:e:n:Rs:t:y:Y:2")) > 0 ) {
+	while ( (opt=getopt(argc, argv, "dl:L:hT:e:n:Rs:t:y:Y:2P")) > 0 ) {
 		i_p = 0;
 		switch ( opt ) {
 			case 'd': debug++;               break;
@@ -296,6 +401,7 @@ StrmCtxt ctxt[NUM_STREAMS];
 			case 'Y': use_yaml    = optarg;  break;
 			case 'y': dmp_yaml    = optarg;  break;
 			case '2': depack2 = 1;           break;
+			case 'P': usePacketRing = 1;     break;
 			default:
 			case 'h': usage(argv[0]); return 1;
 		}
@@ -353,6 +459,7 @@ try {
 		bldr->setDepackLdFrameWinSize(                   ldFrameWinSize );
 		bldr->setDepackLdFragWinSize (                    ldFragWinSize );
 		bldr->useRssi                (                          useRssi );
+		bldr->setUdpUsePacketRing    (                    usePacketRing );
 		if ( depack2 && tDest > 254 ) {
 			tDest = 0;
 		}
@@ -407,6 +514,16 @@ try {
 		ctxt[0].strmPath->tail()->dump();
 
 	for ( i=0; i<NUM_STREAMS; i++ ) {
+		if ( ctxt[i].started && ctxt[i].status ) {
+			goto bail;
+		}
+	}
+	if ( checkStats( root, ctxt, depack2 ) ) {
+		goto bail;
+	}
+
+	for ( i=0; i<NUM_STREAMS; i++ ) {
+		ctxt[i].strm.reset();
 		ctxt[i].strmPath.reset();
 	}
 
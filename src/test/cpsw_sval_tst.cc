@@ -12,6 +12,7 @@
 #include <cpsw_obj_cnt.h>
 
 #include <cpsw_mem_dev.h>
+#include <cpsw_mmio_dev.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -430,6 +431,10 @@ v_be->getPath()->dump(stdout); std::cout << "\n";
 	if ( v_arr->getNelms() != NELMS )
 		throw TestFailed("expected number of elements mismatch");
 
+	// single-dimensional arrays are accessed via a precompiled plan
+	if ( ! CAccessPlan( p_le->findByName( "i32-0-u-0" ) ).isValid() )
+		throw TestFailed("no access plan for 1-D array");
+
 	uint32_t buf[NELMS];
 	
 
@@ -512,6 +517,9 @@ v_be->getPath()->dump(stdout); std::cout << "\n";
 
 			v_arr = IScalVal::create( root->findByName( nam ) );
 
+			// must use the path
+			if ( CAccessPlan( root->findByName( nam ) ).isValid() )
+				throw TestFailed("unexpected access plan for 2-D array");
 
 			memset(bufp, 0, memDev->getSize());
 
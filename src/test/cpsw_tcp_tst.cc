@@ -0,0 +1,301 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+// Stream frames through the TCP transport against a local
+// echo server and report the frame rate, the number of
+// 'read' system calls per received frame, the number of
+// bytes per 'send' system call and the zero-copy hit rate.
+
+#include <cpsw_api_builder.h>
+#include <cpsw_error.h>
+#include <yaml-cpp/yaml.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+class TestFailed {};
+
+#define MAX_WRITERS 16
+
+// frames written by several threads; the first word of a
+// frame holds the writer index (upper byte) and a per-writer
+// sequence number.
+struct Writers {
+	Stream          strm;
+	unsigned        nFrames;
+	unsigned        size;
+	unsigned        window;
+	unsigned        inFlight;
+	bool            failed;
+	pthread_mutex_t mtx;
+	pthread_cond_t  cnd;
+};
+
+struct Writer {
+	Writers        *w;
+	unsigned        idx;
+	unsigned        nFrames;
+};
+
+static void *
+writer(void *arg)
+{
+Writer  *me = (Writer*)arg;
+Writers *w  = me->w;
+uint8_t  buf[8192];
+uint32_t hdr;
+unsigned i;
+
+	memset( buf, 0xaa, sizeof(buf) );
+
+	try {
+		for ( i = 0; i < me->nFrames; i++ ) {
+			pthread_mutex_lock( &w->mtx );
+				while ( w->inFlight >= w->window ) {
+					pthread_cond_wait( &w->cnd, &w->mtx );
+				}
+				w->inFlight++;
+			pthread_mutex_unlock( &w->mtx );
+			hdr = (me->idx << 24) | i;
+			memcpy( buf, &hdr, sizeof(hdr) );
+			w->strm->write( buf, w->size );
+		}
+	} catch ( CPSWError &e ) {
+		fprintf(stderr,"Writer %u -- CPSW Error: %s\n", me->idx, e.getInfo().c_str());
+		w->failed = true;
+	}
+	return NULL;
+}
+
+// plain TCP echo -- it does not care about framing
+static void *
+echoServer(void *arg)
+{
+int     lsd = *(int*)arg;
+int     sd;
+uint8_t buf[65536];
+ssize_t got, put, off;
+
+	if ( (sd = accept( lsd, NULL, NULL )) < 0 ) {
+		perror("accept");
+		return NULL;
+	}
+	while ( (got = read( sd, buf, sizeof(buf) )) > 0 ) {
+		for ( off = 0; off < got; off += put ) {
+			if ( (put = write( sd, buf + off, got - off )) <= 0 ) {
+				perror("echo write");
+				close( sd );
+				return NULL;
+			}
+		}
+	}
+	close( sd );
+	return NULL;
+}
+
+static void
+usage(const char *nm)
+{
+	fprintf(stderr,"Usage: %s [-n <frames>] [-s <size>] [-w <window>] [-T <writers>] [-z <bytes>] [-U] [-h]\n", nm);
+	fprintf(stderr,"       -n <frames> : number of frames to send (default 100000)\n");
+	fprintf(stderr,"       -s <size>   : frame size in bytes (default 32)\n");
+	fprintf(stderr,"       -w <window> : max. number of frames in flight (default 32)\n");
+	fprintf(stderr,"       -T <writers>: number of writer threads (default 1)\n");
+	fprintf(stderr,"       -z <bytes>  : zero-copy threshold (default 0: off)\n");
+	fprintf(stderr,"       -U          : receive through io_uring\n");
+}
+
+int
+main(int argc, char **argv)
+{
+unsigned           nFrames = 100000;
+unsigned           size    = 32;
+unsigned           window  = 32;
+unsigned           nWriters= 1;
+unsigned           zcThres = 0;
+bool               useUring= false;
+unsigned          *u_p;
+int                opt;
+int                lsd;
+struct sockaddr_in sin;
+socklen_t          sl = sizeof(sin);
+pthread_t          tid;
+pthread_t          wtid[MAX_WRITERS];
+Writer             wrtr[MAX_WRITERS];
+Writers            w;
+unsigned           expected[MAX_WRITERS];
+unsigned           rcvd, seq, idx, i;
+struct timespec    then, now;
+double             secs;
+
+	while ( (opt = getopt(argc, argv, "n:s:w:T:z:Uh")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'n': u_p = &nFrames; break;
+			case 's': u_p = &size;    break;
+			case 'w': u_p = &window;  break;
+			case 'T': u_p = &nWriters;break;
+			case 'z': u_p = &zcThres; break;
+			case 'U': useUring = true;break;
+			case 'h': usage( argv[0] ); return 0;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr,"Unable to scan argument to option '-%c'\n", opt);
+			return 1;
+		}
+	}
+
+	if ( size < sizeof(seq) || size > 8192 || 0 == window || 0 == nWriters || nWriters > MAX_WRITERS || nFrames >= (1<<24) ) {
+		fprintf(stderr,"Invalid size, window, number of writers or frames\n");
+		return 1;
+	}
+
+	if ( (lsd = socket( AF_INET, SOCK_STREAM, 0 )) < 0 ) {
+		perror("socket");
+		return 1;
+	}
+	sin.sin_family      = AF_INET;
+	sin.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sin.sin_port        = htons( 0 );
+	if ( bind( lsd, (struct sockaddr*)&sin, sizeof(sin) ) || listen( lsd, 1 ) || getsockname( lsd, (struct sockaddr*)&sin, &sl ) ) {
+		perror("unable to set up echo server");
+		return 1;
+	}
+	if ( pthread_create( &tid, NULL, echoServer, &lsd ) ) {
+		perror("pthread_create");
+		return 1;
+	}
+
+try {
+	NetIODev          root = INetIODev::create("fpga", "127.0.0.1");
+	ProtoStackBuilder bldr = IProtoStackBuilder::create();
+
+	bldr->setSRPVersion( IProtoStackBuilder::SRP_UDP_NONE );
+	bldr->setTcpPort   ( ntohs( sin.sin_port )             );
+	bldr->setTcpZeroCopyThreshold( zcThres );
+	bldr->setTcpUseUring( useUring );
+
+	root->addAtAddress( IField::create("strm"), bldr );
+
+	uint8_t  rbuf[8192];
+	uint8_t  pat[8192];
+	int64_t  got;
+
+	memset( pat, 0xaa, sizeof(pat) );
+
+	w.strm     = IStream::create( root->findByName("strm") );
+	w.nFrames  = nFrames;
+	w.size     = size;
+	w.window   = window;
+	w.inFlight = 0;
+	w.failed   = false;
+	pthread_mutex_init( &w.mtx, NULL );
+	pthread_cond_init ( &w.cnd, NULL );
+
+	clock_gettime( CLOCK_MONOTONIC, &then );
+
+	for ( i = 0; i < nWriters; i++ ) {
+		wrtr[i].w       = &w;
+		wrtr[i].idx     = i;
+		wrtr[i].nFrames = nFrames/nWriters + ( i < nFrames % nWriters ? 1 : 0 );
+		expected[i]     = 0;
+		if ( pthread_create( &wtid[i], NULL, writer, &wrtr[i] ) ) {
+			perror("pthread_create (writer)");
+			throw TestFailed();
+		}
+	}
+
+	for ( rcvd = 0; rcvd < nFrames; rcvd++ ) {
+		if ( (got = w.strm->read( rbuf, sizeof(rbuf), CTimeout( 2000000 ) )) != (int64_t)size ) {
+			fprintf(stderr,"Frame %u: unexpected size %" PRId64 "\n", rcvd, got);
+			throw TestFailed();
+		}
+		memcpy( &seq, rbuf, sizeof(seq) );
+		idx = seq >> 24;
+		seq = seq & ((1<<24) - 1);
+		if ( idx >= nWriters || seq != expected[idx] || memcmp( rbuf + sizeof(seq), pat, size - sizeof(seq) ) ) {
+			fprintf(stderr,"Frame %u: data mismatch (writer %u, seq %u)\n", rcvd, idx, seq);
+			throw TestFailed();
+		}
+		expected[idx]++;
+		pthread_mutex_lock( &w.mtx );
+			w.inFlight--;
+			pthread_cond_signal( &w.cnd );
+		pthread_mutex_unlock( &w.mtx );
+	}
+
+	for ( i = 0; i < nWriters; i++ ) {
+		pthread_join( wtid[i], NULL );
+	}
+
+	if ( w.failed ) {
+		throw TestFailed();
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	secs = (double)(now.tv_sec - then.tv_sec) + (double)(now.tv_nsec - then.tv_nsec)/1.0E9;
+
+	YAML::Node stats;
+	root->dumpStats( stats );
+
+	uint64_t frames = stats["strm"]["TCP"]["rxFrames"].as<uint64_t>();
+	uint64_t reads  = stats["strm"]["TCP"]["rxReads"].as<uint64_t>();
+
+	uint64_t octets = stats["strm"]["TCP"]["txOctets"].as<uint64_t>();
+	uint64_t calls  = stats["strm"]["TCP"]["txCalls"].as<uint64_t>();
+
+	printf("%u frames of %u bytes (window %u, %u writer(s)): %.0f frames/s\n", nFrames, size, window, nWriters, (double)nFrames/secs);
+	if ( useUring ) {
+	printf("RX: %" PRIu64 " frames, %" PRIu64 " reads (%.2f reads/frame), %" PRIu64 " paused\n",
+		frames, reads, frames ? (double)reads/(double)frames : 0.0,
+		stats["strm"]["TCP"]["rxPaused"].as<uint64_t>());
+	} else {
+	printf("RX: %" PRIu64 " frames, %" PRIu64 " reads (%.2f reads/frame), %" PRIu64 " direct\n",
+		frames, reads, frames ? (double)reads/(double)frames : 0.0,
+		stats["strm"]["TCP"]["rxDirectReads"].as<uint64_t>());
+	}
+	printf("TX: %" PRIu64 " octets, %" PRIu64 " calls (%.1f bytes/call)\n",
+		octets, calls, calls ? (double)octets/(double)calls : 0.0);
+	if ( zcThres ) {
+		uint64_t zc     = stats["strm"]["TCP"]["txZeroCopyCalls"].as<uint64_t>();
+		uint64_t copied = stats["strm"]["TCP"]["txZeroCopyCopied"].as<uint64_t>();
+		printf("TX: %" PRIu64 " zero-copy calls, %" PRIu64 " copied by the kernel (hit rate %.1f%%)\n",
+			zc, copied, zc ? 100.0*(double)(zc - copied)/(double)zc : 0.0);
+	}
+
+	if ( frames != nFrames ) {
+		fprintf(stderr,"RX frame count mismatch\n");
+		throw TestFailed();
+	}
+
+} catch ( CPSWError &e ) {
+	fprintf(stderr,"CPSW Error: %s\n", e.getInfo().c_str());
+	return 1;
+} catch ( TestFailed &e ) {
+	fprintf(stderr,"Test FAILED\n");
+	return 1;
+}
+
+	printf("TEST PASSED\n");
+	return 0;
+}
@@ -0,0 +1,207 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <cpsw_error.h>
+
+#include <cpsw_thread.h>
+
+#include <string>
+
+using std::string;
+
+class TestFailed {
+public:
+	string e_;
+	TestFailed(const char *e):e_(e) {}
+};
+
+class CTestThread : public CRunnable {
+public:
+	volatile int  cpu_;
+	volatile bool running_;
+	char          name_[32];
+
+	CTestThread(const char *name, int prio = DFLT_PRIORITY)
+	: CRunnable( name, prio ),
+	  cpu_     ( -1       ),
+	  running_ ( false    )
+	{
+		name_[0] = 0;
+	}
+
+	virtual void *threadBody()
+	{
+		pthread_getname_np( pthread_self(), name_, sizeof(name_) );
+		cpu_     = sched_getcpu();
+		__sync_synchronize();
+		running_ = true;
+		while ( 1 ) {
+			cpu_ = sched_getcpu();
+			usleep( 1000 );
+		}
+		return 0;
+	}
+
+	void waitRunning()
+	{
+	int i;
+		for ( i = 0; i < 1000 && ! running_; i++ ) {
+			usleep( 1000 );
+		}
+		if ( ! running_ )
+			throw TestFailed("thread did not start");
+		__sync_synchronize();
+	}
+
+	pthread_t tid()
+	{
+		return getTid();
+	}
+
+	virtual ~CTestThread()
+	{
+		threadStop();
+	}
+};
+
+static bool
+allowedOnly(pthread_t tid, int cpu)
+{
+cpu_set_t set;
+	if ( pthread_getaffinity_np( tid, sizeof(set), &set ) )
+		return false;
+	return 1 == CPU_COUNT( &set ) && CPU_ISSET( cpu, &set );
+}
+
+static void
+expectInvalid(const char *lst)
+{
+CTestThread t("invalid");
+	try {
+		t.setCpuAffinity( lst );
+	} catch ( InvalidArgError &e ) {
+		return;
+	}
+	fprintf(stderr, "CPU list '%s':", lst);
+	throw TestFailed("invalid CPU list accepted");
+}
+
+int
+main(int argc, char **argv)
+{
+int      lastCpu = sysconf( _SC_NPROCESSORS_ONLN ) - 1;
+char     buf[4096];
+char     lst[32];
+FILE    *f;
+size_t   got;
+
+	try {
+		{
+		CTestThread t("Thread Test Number One");
+
+			t.setCpuAffinity( "0" );
+			t.threadStart();
+			t.waitRunning();
+
+			if ( strcmp( t.name_, "Thread Test Num" ) )
+				throw TestFailed("thread name not set (or not truncated)");
+			if ( 0 != t.cpu_ )
+				throw TestFailed("thread not running on CPU 0");
+			if ( 0 == t.getLWP() )
+				throw TestFailed("no LWP recorded");
+
+			// listed by 'dumpThreads'
+			if ( ! (f = tmpfile()) )
+				throw TestFailed("unable to create tmpfile");
+			CRunnable::dumpThreads( f );
+			rewind( f );
+			got = fread( buf, 1, sizeof(buf) - 1, f );
+			fclose( f );
+			buf[got] = 0;
+			fputs( buf, stdout );
+			snprintf( lst, sizeof(lst), "%ld", (long)t.getLWP() );
+			if ( ! strstr( buf, "Thread Test Number One" ) || ! strstr( buf, lst ) )
+				throw TestFailed("thread not listed by dumpThreads");
+
+			// restricted to a list of threads
+			{
+			CTestThread              o("Other Thread");
+			std::vector<CRunnable*>  only;
+				o.threadStart();
+				o.waitRunning();
+				only.push_back( &o );
+				if ( ! (f = tmpfile()) )
+					throw TestFailed("unable to create tmpfile");
+				CRunnable::dumpThreads( f, &only );
+				rewind( f );
+				got = fread( buf, 1, sizeof(buf) - 1, f );
+				fclose( f );
+				buf[got] = 0;
+				if ( ! strstr( buf, "Other Thread" ) || strstr( buf, "Thread Test Number One" ) )
+					throw TestFailed("dumpThreads did not restrict output to the given threads");
+			}
+
+			// change while running
+			snprintf( lst, sizeof(lst), "%d", lastCpu );
+			t.setCpuAffinity( lst );
+			if ( ! allowedOnly( t.tid(), lastCpu ) )
+				throw TestFailed("affinity of running thread not changed");
+		}
+
+		// process-wide default
+		CRunnable::setDefaultCpuAffinity( "0" );
+		{
+		CTestThread t("dflt");
+			t.threadStart();
+			t.waitRunning();
+			if ( ! allowedOnly( t.tid(), 0 ) )
+				throw TestFailed("process-wide default affinity not applied");
+		}
+		CRunnable::setDefaultCpuAffinity( "" );
+
+		// real-time policy; falls back to SCHED_OTHER if not permitted
+		{
+		CTestThread        t("fifo");
+		int                pol;
+		struct sched_param param;
+
+			t.setSchedPolicy( SCHED_FIFO );
+			t.threadStart();
+			t.waitRunning();
+			if ( pthread_getschedparam( t.tid(), &pol, &param ) )
+				throw TestFailed("pthread_getschedparam failed");
+			printf("SCHED_FIFO request: %s, priority %d\n", SCHED_FIFO == pol ? "granted" : "fell back", param.sched_priority);
+			if ( SCHED_FIFO == pol ? 1 != param.sched_priority : SCHED_OTHER != pol )
+				throw TestFailed("unexpected scheduling policy/priority");
+		}
+
+		expectInvalid( "x" );
+		expectInvalid( "1-" );
+		expectInvalid( "3-1" );
+		expectInvalid( "0,,1" );
+		expectInvalid( "100000" );
+
+	} catch ( TestFailed e ) {
+		fprintf(stderr, "Test FAILED: %s\n", e.e_.c_str());
+		return 1;
+	}
+
+	printf("Thread test PASSED\n");
+	return 0;
+}
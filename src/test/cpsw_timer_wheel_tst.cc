@@ -0,0 +1,109 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cpsw_error.h>
+
+#include <cpsw_timer_wheel.h>
+
+#include <string>
+
+using std::string;
+
+#define NTIMERS 20
+#define NITER   200000
+
+class TestFailed {
+public:
+	string e_;
+	TestFailed(const char *e):e_(e) {}
+};
+
+// brute-force reference
+static CWheelTimer *
+findFirst(CWheelTimer **t, unsigned n)
+{
+CWheelTimer *rval = 0;
+unsigned     i;
+	for ( i=0; i<n; i++ ) {
+		if ( t[i]->isArmed() && ( ! rval || *t[i]->getTimeout() < *rval->getTimeout() ) )
+			rval = t[i];
+	}
+	return rval;
+}
+
+int
+main(int argc, char **argv)
+{
+CTimerWheel  wheel( 4, 1000 ); // small wheel; 16ms per revolution
+CWheelTimer *t[NTIMERS];
+CWheelTimer *exp, *got;
+CTimeout     now( 1000, 0 );
+unsigned     i, j, armed;
+
+	for ( i=0; i<NTIMERS; i++ )
+		t[i] = new CWheelTimer( &wheel );
+
+	srand48( 17 );
+
+	try {
+		if ( wheel.getFirstToExpire() )
+			throw TestFailed("empty wheel returned a timer");
+
+		for ( i=0; i<NITER; i++ ) {
+			j = lrand48() % NTIMERS;
+			switch ( lrand48() % 4 ) {
+				case 0:
+					t[j]->cancel();
+					break;
+				case 1:
+					// far beyond one revolution
+					t[j]->arm_abs( now + CTimeout( lrand48() % 100000 ) );
+					break;
+				default:
+					// mostly within one revolution; some already expired
+					t[j]->arm_abs( now + CTimeout( lrand48() % 20000 ) - CTimeout( 2000 ) );
+					break;
+			}
+
+			for ( j=armed=0; j<NTIMERS; j++ )
+				if ( t[j]->isArmed() )
+					armed++;
+			if ( armed != wheel.getNumArmed() )
+				throw TestFailed("number of armed timers mismatch");
+
+			exp = findFirst( t, NTIMERS );
+			got = wheel.getFirstToExpire();
+			if ( ( exp != got ) && ( ! exp || ! got || *exp->getTimeout() < *got->getTimeout() || *got->getTimeout() < *exp->getTimeout() ) )
+				throw TestFailed("wrong timer found to expire first");
+
+			// let time advance and 'process' the first timer
+			if ( got && (lrand48() & 1) ) {
+				if ( now < *got->getTimeout() )
+					now = *got->getTimeout();
+				got->cancel();
+			}
+		}
+	} catch ( TestFailed e ) {
+		fprintf(stderr, "Test FAILED: %s (iteration %u)\n", e.e_.c_str(), i);
+		return 1;
+	}
+
+	for ( i=0; i<NTIMERS; i++ )
+		delete t[i];
+
+	if ( wheel.getNumArmed() ) {
+		fprintf(stderr, "Test FAILED: destroyed timers still armed\n");
+		return 1;
+	}
+
+	printf("Timer wheel test PASSED\n");
+	return 0;
+}
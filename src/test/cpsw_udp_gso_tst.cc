@@ -0,0 +1,296 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+// Exercise UDP segmentation offload of the UDP protocol module
+// against a local peer socket:
+//  - a train of equal-sized frames (plus a short one) pushed
+//    into the module must arrive as the same datagrams; the
+//    peer (with UDP_GRO) should see them coalesced.
+//  - a coalesced message sent by the peer (UDP_SEGMENT) must
+//    be split into the original datagrams by the module.
+// The test is skipped if the kernel supports neither.
+
+#include <cpsw_api_builder.h>
+#include <cpsw_proto_mod_udp.h>
+#include <cpsw_error.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <errno.h>
+#include <vector>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+
+class TestFailed {
+public:
+	const char *msg_;
+	TestFailed(const char *msg) : msg_(msg) {}
+};
+
+static uint8_t
+pattern(unsigned dgram, unsigned off)
+{
+	return (uint8_t)(dgram * 37 + off);
+}
+
+static BufChain
+mkFrame(unsigned dgram, unsigned len)
+{
+BufChain             bc = IBufChain::create();
+std::vector<uint8_t> tmp( len );
+unsigned             i;
+
+	for ( i=0; i<len; i++ )
+		tmp[i] = pattern( dgram, i );
+	bc->insert( &tmp[0], 0, len, IBuf::CAPA_ETH_BIG );
+	return bc;
+}
+
+static void
+chkFrame(const uint8_t *p, unsigned dgram, unsigned len)
+{
+unsigned i;
+
+	for ( i=0; i<len; i++ ) {
+		if ( p[i] != pattern( dgram, i ) ) {
+			fprintf(stderr, "datagram %u: mismatch at offset %u\n", dgram, i);
+			throw TestFailed("data mismatch");
+		}
+	}
+}
+
+// receive (all datagrams of) a message at the peer;
+// RETURNS the size of the datagrams (0 if not coalesced)
+static ssize_t
+peerRecv(int sd, uint8_t *buf, size_t bufsz, unsigned *gsoSize_p)
+{
+struct msghdr   msg;
+struct iovec    iov;
+struct cmsghdr *cmsg;
+ssize_t         got;
+int             gsoSize = 0;
+union {
+	struct cmsghdr align;
+	char           buf[CMSG_SPACE(sizeof(int))];
+}               ctl;
+
+	iov.iov_base = buf;
+	iov.iov_len  = bufsz;
+	memset( &msg, 0, sizeof(msg) );
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = ctl.buf;
+	msg.msg_controllen = sizeof(ctl.buf);
+
+	if ( (got = recvmsg( sd, &msg, 0 )) < 0 ) {
+		perror("peer recvmsg");
+		throw TestFailed("peer recvmsg");
+	}
+	for ( cmsg = CMSG_FIRSTHDR( &msg ); cmsg; cmsg = CMSG_NXTHDR( &msg, cmsg ) ) {
+		if ( SOL_UDP == cmsg->cmsg_level && UDP_GRO == cmsg->cmsg_type ) {
+			memcpy( &gsoSize, CMSG_DATA( cmsg ), sizeof(gsoSize) );
+		}
+	}
+	*gsoSize_p = gsoSize;
+	return got;
+}
+
+static void
+testTx(ProtoModUdp udp, ProtoDoor door, int peer, unsigned segSize, unsigned nSegs, unsigned lastSize)
+{
+std::vector<BufChain> train;
+std::vector<uint8_t>  buf( 65536 );
+unsigned              i, gsoSize, dgram, len;
+ssize_t               got, off;
+CTimeout              tmo( 1000000 );
+uint64_t              nGso = udp->getNumGsoSends();
+
+	for ( i=0; i<nSegs; i++ )
+		train.push_back( mkFrame( i, segSize ) );
+	train.push_back( mkFrame( nSegs, lastSize ) );
+
+	if ( ! door->pushTrain( train, &tmo, false ) )
+		throw TestFailed("pushTrain failed");
+
+	if ( udp->usesGso() && udp->getNumGsoSends() != nGso + 1 )
+		throw TestFailed("train not sent as a single GSO message");
+
+	// the peer may receive the datagrams coalesced or not
+	for ( dgram = 0; dgram <= nSegs; ) {
+		got = peerRecv( peer, &buf[0], buf.size(), &gsoSize );
+		if ( gsoSize && gsoSize != segSize )
+			throw TestFailed("peer: unexpected GRO segment size");
+		for ( off = 0; off < got; off += len, dgram++ ) {
+			len = dgram < nSegs ? segSize : lastSize;
+			if ( off + len > got || ( ! gsoSize && (ssize_t)len != got ) ) {
+				fprintf(stderr, "peer: got %ld, datagram %u (len %u) at offset %ld\n", (long)got, dgram, len, (long)off);
+				throw TestFailed("peer: bad datagram size");
+			}
+			chkFrame( &buf[off], dgram, len );
+		}
+	}
+	printf("TX: %u x %u + %u bytes; GSO messages sent: %lu\n", nSegs, segSize, lastSize, (unsigned long)udp->getNumGsoSends());
+}
+
+static void
+testRx(ProtoModUdp udp, ProtoDoor door, int peer, struct sockaddr_in *modAddr, unsigned segSize, unsigned nSegs, unsigned lastSize)
+{
+std::vector<uint8_t>  buf;
+unsigned              i, len;
+struct msghdr         msg;
+struct iovec          iov;
+struct cmsghdr       *cmsg;
+CTimeout              tmo( 1000000 );
+BufChain              bc;
+union {
+	struct cmsghdr align;
+	char           buf[CMSG_SPACE(sizeof(uint16_t))];
+}                     ctl;
+
+	for ( i=0; i<=nSegs; i++ ) {
+		len = i < nSegs ? segSize : lastSize;
+		std::vector<uint8_t> tmp( len );
+		mkFrame( i, len )->extract( &tmp[0], 0, len );
+		buf.insert( buf.end(), tmp.begin(), tmp.end() );
+	}
+
+	iov.iov_base = &buf[0];
+	iov.iov_len  = buf.size();
+	memset( &msg, 0, sizeof(msg) );
+	msg.msg_name       = modAddr;
+	msg.msg_namelen    = sizeof(*modAddr);
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = ctl.buf;
+	msg.msg_controllen = sizeof(ctl.buf);
+	cmsg               = CMSG_FIRSTHDR( &msg );
+	cmsg->cmsg_level   = SOL_UDP;
+	cmsg->cmsg_type    = UDP_SEGMENT;
+	cmsg->cmsg_len     = CMSG_LEN(sizeof(uint16_t));
+	*(uint16_t*)CMSG_DATA( cmsg ) = segSize;
+
+	if ( sendmsg( peer, &msg, 0 ) < 0 ) {
+		perror("peer sendmsg (UDP_SEGMENT)");
+		throw TestFailed("peer sendmsg");
+	}
+
+	for ( i=0; i<=nSegs; i++ ) {
+		len = i < nSegs ? segSize : lastSize;
+		if ( ! (bc = door->pop( &tmo, false )) )
+			throw TestFailed("RX: timeout");
+		if ( bc->getSize() != len ) {
+			fprintf(stderr, "RX: datagram %u has %lu bytes (expected %u)\n", i, (unsigned long)bc->getSize(), len);
+			throw TestFailed("RX: bad datagram size");
+		}
+		std::vector<uint8_t> tmp( len );
+		bc->extract( &tmp[0], 0, len );
+		chkFrame( &tmp[0], i, len );
+	}
+	printf("RX: %u x %u + %u bytes; GRO messages: %lu\n", nSegs, segSize, lastSize, (unsigned long)udp->getNumGroMsgs());
+}
+
+static void
+usage(const char *nm)
+{
+	fprintf(stderr, "Usage: %s [-h] [-R]\n", nm);
+	fprintf(stderr, "       -R : use the reactor (default: RX thread)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+int                opt;
+bool               useReactor = false;
+int                rval       = 1;
+int                peer;
+int                one        = 1;
+struct sockaddr_in peerAddr, modAddr;
+socklen_t          sl;
+uint8_t            buf[16];
+
+	while ( (opt = getopt(argc, argv, "hR")) > 0 ) {
+		switch ( opt ) {
+			case 'h': usage( argv[0] ); return 0;
+			case 'R': useReactor = true; break;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+	}
+
+	if ( (peer = socket( AF_INET, SOCK_DGRAM, 0 )) < 0 ) {
+		perror("socket");
+		return 1;
+	}
+
+	peerAddr.sin_family      = AF_INET;
+	peerAddr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	peerAddr.sin_port        = htons( 0 );
+	if ( bind( peer, (struct sockaddr*)&peerAddr, sizeof(peerAddr) ) ) {
+		perror("bind");
+		return 1;
+	}
+	sl = sizeof(peerAddr);
+	getsockname( peer, (struct sockaddr*)&peerAddr, &sl );
+
+	if ( setsockopt( peer, SOL_UDP, UDP_GRO, &one, sizeof(one) ) ) {
+		perror("setsockopt(UDP_GRO) -- peer");
+	}
+
+	try {
+	ProtoModUdp udp = CShObj::create<ProtoModUdp>( &peerAddr, 64, IProtoStackBuilder::DFLT_THREAD_PRIORITY, 1, 1, useReactor );
+	ProtoDoor   door;
+
+		udp->setOffload( true, true );
+		if ( ! udp->usesGso() && ! udp->usesGro() ) {
+			printf("Kernel supports neither UDP_SEGMENT nor UDP_GRO -- test skipped\n");
+			close( peer );
+			return 0;
+		}
+
+		door = udp->open();
+		udp->modStartup();
+
+		// learn the module's address from the poll
+		sl = sizeof(modAddr);
+		if ( recvfrom( peer, buf, sizeof(buf), 0, (struct sockaddr*)&modAddr, &sl ) < 0 ) {
+			perror("recvfrom");
+			throw TestFailed("no poll message");
+		}
+
+		testTx( udp, door, peer, 1000, 10,  500 );
+		testTx( udp, door, peer, 1400, 20, 1400 );
+		testRx( udp, door, peer, &modAddr, 1200, 8,  300 );
+		testRx( udp, door, peer, &modAddr, 1200, 8,  300 );
+		testRx( udp, door, peer, &modAddr, 3000, 4, 3000 );
+
+		udp->dumpInfo( stdout );
+
+		udp->modShutdown();
+
+		rval = 0;
+	} catch ( TestFailed &e ) {
+		fprintf(stderr, "Test FAILED: %s\n", e.msg_);
+	} catch ( CPSWError &e ) {
+		fprintf(stderr, "CPSW Error: %s\n", e.getInfo().c_str());
+	}
+
+	close( peer );
+
+	if ( 0 == rval )
+		printf("UDP GSO/GRO test PASSED\n");
+
+	return rval;
+}
@@ -0,0 +1,352 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+// Lazy instantiation of YAML-defined subtrees:
+//  - build + startup time and memory of a large hierarchy in
+//    eager and lazy mode are reported
+//  - lazy mode must create only the children which are used
+//  - registers must behave the same in both modes
+//  - children created late must be started
+//  - dumping the configuration must create everything
+//  - replicated names/descriptions are stored once
+//  - a YAML dump preserves the 'lazyChildren' opt-in
+//  - an error while creating the children is reported on
+//    every access (not just the first one)
+
+#include <cpsw_api_user.h>
+#include <cpsw_yaml_keydefs.h>
+#include <cpsw_hub.h>
+#include <cpsw_shared_obj.h>
+#include <cpsw_obj_cnt.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <malloc.h>
+#include <getopt.h>
+#include <string>
+
+#include <yaml-cpp/yaml.h>
+
+using cpsw::dynamic_pointer_cast;
+
+class TestFailed {
+public:
+	const char *msg_;
+	TestFailed(const char *msg) : msg_(msg) {}
+};
+
+#define NBOARDS 128
+#define NREGS    64
+#define BOARDSZ  (4*NREGS)
+
+static int64_t
+now()
+{
+struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t
+heapUsed()
+{
+#if defined(__GLIBC__) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 33 ) )
+	return mallinfo2().uordblks;
+#else
+	return mallinfo().uordblks;
+#endif
+}
+
+static std::string
+mkYaml(unsigned nBoards, unsigned nRegs, bool lazy)
+{
+std::string y;
+char        buf[256];
+unsigned    b, r;
+
+	snprintf( buf, sizeof(buf),
+		"#schemaversion 3.0.0\n"
+		"root:\n"
+		"  " YAML_KEY_class ": MemDev\n"
+		"  " YAML_KEY_size  ": %u\n"
+		"  " YAML_KEY_children ":\n"
+		"    mmio:\n"
+		"      " YAML_KEY_class ": MMIODev\n"
+		"      " YAML_KEY_size  ": %u\n"
+		"      " YAML_KEY_lazyChildren ": %s\n"
+		"      " YAML_KEY_at ":\n"
+		"        " YAML_KEY_nelms ": 1\n"
+		"      " YAML_KEY_children ":\n",
+		nBoards * BOARDSZ, nBoards * BOARDSZ, lazy ? "true" : "false" );
+	y += buf;
+
+	for ( b = 0; b < nBoards; b++ ) {
+		snprintf( buf, sizeof(buf),
+			"        board%u:\n"
+			"          " YAML_KEY_class ": MMIODev\n"
+			"          " YAML_KEY_size  ": %u\n"
+			"          " YAML_KEY_lazyChildren ": %s\n"
+			"          " YAML_KEY_at ":\n"
+			"            " YAML_KEY_offset ": %u\n"
+			"          " YAML_KEY_children ":\n",
+			b, BOARDSZ, lazy ? "true" : "false", b * BOARDSZ );
+		y += buf;
+		for ( r = 0; r < nRegs; r++ ) {
+			snprintf( buf, sizeof(buf),
+				"            reg%u:\n"
+				"              " YAML_KEY_class ": IntField\n"
+				"              " YAML_KEY_description ": \"Scratch register %u of a board; any value may be written\"\n"
+				"              " YAML_KEY_sizeBits ": 32\n"
+				"              " YAML_KEY_at ":\n"
+				"                " YAML_KEY_offset ": %u\n",
+				r, r, 4*r );
+			y += buf;
+		}
+	}
+	return y;
+}
+
+static unsigned
+objs()
+{
+	return CShObj::sh_ocnt_().get();
+}
+
+static bool
+started(Path p)
+{
+ConstDevImpl d = dynamic_pointer_cast<const CDevImpl>( p->tail()->isHub() );
+	return d && d->isStarted();
+}
+
+// RETURNS: number of objects created for the hierarchy (eventually)
+//          and by building + starting it in 'built'
+static unsigned
+runMode(const std::string &yaml, unsigned nBoards, bool lazy, unsigned *built)
+{
+unsigned  o0 = objs();
+int64_t   m0 = heapUsed();
+int64_t   t0 = now();
+Path      root;
+unsigned  o1, o2;
+int64_t   m1, t1;
+uint32_t  v;
+
+	root = IPath::loadYamlStream( yaml.c_str(), "root" );
+
+	t1 = now();
+	m1 = heapUsed();
+	o1 = objs();
+
+	printf("%-5s: build + startup %8lldus, %6u objects, %10lld bytes of heap\n",
+	       lazy ? "lazy" : "eager",
+	       (long long)(t1 - t0),
+	       o1 - o0,
+	       (long long)(m1 - m0));
+
+	{
+	ScalVal r = IScalVal::create( root->findByName( "mmio/board7/reg3" ) );
+		r->setVal( 0xdeadbeef );
+		r->getVal( &v );
+		if ( 0xdeadbeef != v ) {
+			throw TestFailed("readback mismatch");
+		}
+		// same registers through a different path
+		r = IScalVal::create( root->findByName( "mmio/board7/reg4" ) );
+		r->setVal( 0x12345678 );
+		r = IScalVal::create( root->findByName( "mmio/board7/reg3" ) );
+		r->getVal( &v );
+		if ( 0xdeadbeef != v ) {
+			throw TestFailed("register clobbered");
+		}
+	}
+
+	o2 = objs();
+
+	// interned
+	if ( root->findByName( "mmio/board7/reg3" )->tail()->getDescription() != root->findByName( "mmio/board8/reg3" )->tail()->getDescription() ) {
+		throw TestFailed("identical descriptions not shared");
+	}
+
+	if ( ! started( root->findByName( "mmio/board7" ) ) || ! started( root->findByName( "mmio/board100" ) ) ) {
+		throw TestFailed("Dev not started");
+	}
+
+	try {
+		root->findByName( "mmio/board7/nonexisting" );
+		throw TestFailed("NotFoundError not thrown");
+	} catch ( NotFoundError &e ) {
+	}
+
+	if ( lazy ) {
+		printf("lazy : %u objects created by accessing a register\n", o2 - o1);
+	}
+
+	if ( root->findByName( "mmio" )->tail()->isHub()->getChildren()->size() != nBoards ) {
+		throw TestFailed("wrong number of children");
+	}
+
+	{
+	YAML::Node cfg;
+		// creates everything
+		root->dumpConfigToYaml( cfg );
+	}
+
+	printf("%-5s: everything created:  %6u objects, %10lld bytes of heap\n",
+	       lazy ? "lazy" : "eager",
+	       objs() - o0,
+	       (long long)(heapUsed() - m0));
+
+	*built = o1 - o0;
+
+	return objs() - o0;
+}
+
+static ConstDevImpl
+asDev(Path p)
+{
+	return dynamic_pointer_cast<const CDevImpl>( p->tail()->isHub() );
+}
+
+static void
+testRoundTrip()
+{
+Path          root = IPath::loadYamlStream( mkYaml( 2, 8, true ).c_str(), "root" );
+YAML::Node    top, dump;
+YAML::Emitter emit;
+std::string   y( "#schemaversion 3.0.0\n" );
+
+	dynamic_pointer_cast<const CDevImpl>( root->origin() )->dumpYaml( dump );
+	top["root"] = dump;
+	emit << top;
+	y += emit.c_str();
+
+	root = IPath::loadYamlStream( y.c_str(), "root" );
+
+	if ( ! asDev( root->findByName( "mmio" ) )->hasLazyChildren() ) {
+		throw TestFailed("'lazyChildren' lost by YAML dump/reload");
+	}
+	if ( ! asDev( root->findByName( "mmio/board1" ) )->hasLazyChildren() ) {
+		throw TestFailed("'lazyChildren' of a nested Dev lost by YAML dump/reload");
+	}
+	IScalVal::create( root->findByName( "mmio/board1/reg7" ) )->setVal( 1 );
+}
+
+static void
+testFailure()
+{
+Path root = IPath::loadYamlStream(
+	"#schemaversion 3.0.0\n"
+	"root:\n"
+	"  " YAML_KEY_class ": MemDev\n"
+	"  " YAML_KEY_size  ": 16\n"
+	"  " YAML_KEY_children ":\n"
+	"    mmio:\n"
+	"      " YAML_KEY_class ": MMIODev\n"
+	"      " YAML_KEY_size  ": 16\n"
+	"      " YAML_KEY_lazyChildren ": true\n"
+	"      " YAML_KEY_at ":\n"
+	"        " YAML_KEY_nelms ": 1\n"
+	"      " YAML_KEY_children ":\n"
+	"        reg:\n"
+	"          " YAML_KEY_class ": IntField\n"
+	"          " YAML_KEY_sizeBits ": 32\n"
+	"          " YAML_KEY_at ":\n"
+	"            " YAML_KEY_offset ": 64\n",
+	"root" );
+std::string first;
+unsigned    i;
+
+	for ( i = 0; i < 2; i++ ) {
+		try {
+			root->findByName( "mmio/reg" );
+			throw TestFailed("creating an invalid lazy child did not throw");
+		} catch ( CPSWError &e ) {
+			if ( 0 == i ) {
+				first = e.getInfo();
+			} else if ( e.getInfo() != first ) {
+				fprintf(stderr, "first: %s, then: %s\n", first.c_str(), e.getInfo().c_str());
+				throw TestFailed("error creating lazy children not reported again");
+			}
+		}
+	}
+}
+
+static void
+usage(const char *nm)
+{
+	fprintf(stderr, "Usage: %s [-h] [-n <boards>] [-r <regs per board>]\n", nm);
+}
+
+int
+main(int argc, char **argv)
+{
+int      opt;
+unsigned nBoards = NBOARDS;
+unsigned nRegs   = NREGS;
+unsigned eager, lazy;
+unsigned eagerBuilt, lazyBuilt;
+
+	while ( (opt = getopt(argc, argv, "hn:r:")) > 0 ) {
+		switch ( opt ) {
+			case 'h': usage( argv[0] ); return 0;
+			case 'n':
+				if ( 1 != sscanf( optarg, "%u", &nBoards ) || nBoards < NBOARDS ) {
+					fprintf(stderr, "Invalid number of boards (must be >= %u): %s\n", NBOARDS, optarg);
+					return 1;
+				}
+				break;
+			case 'r':
+				if ( 1 != sscanf( optarg, "%u", &nRegs ) || nRegs < 8 || nRegs > NREGS ) {
+					fprintf(stderr, "Invalid number of registers (8..%u): %s\n", NREGS, optarg);
+					return 1;
+				}
+				break;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+	}
+
+	try {
+		eager = runMode( mkYaml( nBoards, nRegs, false ), nBoards, false, &eagerBuilt );
+		lazy  = runMode( mkYaml( nBoards, nRegs, true  ), nBoards, true,  &lazyBuilt  );
+
+		if ( lazyBuilt * 10 > eagerBuilt ) {
+			fprintf(stderr, "eager: %u objects, lazy: %u objects\n", eagerBuilt, lazyBuilt);
+			throw TestFailed("lazy mode created too many objects");
+		}
+
+		// everything has been created by the config dump; the
+		// exact number may differ by some cached objects.
+		if ( lazy + nBoards < eager || eager + nBoards < lazy ) {
+			fprintf(stderr, "eager: %u objects, lazy (all created): %u objects\n", eager, lazy);
+			throw TestFailed("lazy mode did not create all children");
+		}
+
+		testRoundTrip();
+		testFailure();
+
+	} catch ( TestFailed &e ) {
+		fprintf(stderr, "Test FAILED: %s\n", e.msg_);
+		return 1;
+	} catch ( CPSWError &e ) {
+		fprintf(stderr, "CPSW Error: %s\n", e.getInfo().c_str());
+		return 1;
+	}
+
+	if ( CpswObjCounter::report(stderr) ) {
+		fprintf(stderr, "FAILED -- Objects leaked!\n");
+		return 1;
+	}
+
+	printf("YAML lazy instantiation test PASSED\n");
+	return 0;
+}
@@ -0,0 +1,267 @@
+ //@C Copyright Notice
+ //@C ================
+ //@C This file is part of CPSW. It is subject to the license terms in the LICENSE.txt
+ //@C file found in the top-level directory of this distribution and at
+ //@C https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ //@C
+ //@C No part of CPSW, including this file, may be copied, modified, propagated, or
+ //@C distributed except according to the terms contained in the LICENSE.txt file.
+
+// Relay frames through the reactor-mode rssi_bridge: every
+// bridge connects to a local UDP echo server (optionally with
+// RSSI, '-r') and is driven by a TCP client speaking the bridge's
+// framing (length in NBO followed by the payload). All clients
+// run concurrently; every frame must come back intact and in order.
+
+#include <rssi_bridge_reactor.h>
+#include <udpsrv_port.h>
+#include <cpsw_error.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define MAX_SIZE 8192
+
+class TestFailed {};
+
+static void *
+echoServer(void *arg)
+{
+IoPrt   port = (IoPrt)arg;
+uint8_t buf[MAX_SIZE];
+int     got;
+
+	while ( (got = ioPrtRecv( port, buf, sizeof(buf), NULL )) >= 0 ) {
+		if ( got > 0 ) {
+			ioPrtSend( port, buf, got );
+		}
+	}
+	return NULL;
+}
+
+struct Client {
+	unsigned short port;
+	unsigned       idx;
+	unsigned       nFrames;
+	unsigned       size;
+	unsigned       window;
+	bool           failed;
+};
+
+static bool
+xfer(int sd, uint8_t *buf, size_t len, bool rd)
+{
+ssize_t got;
+
+	while ( len > 0 ) {
+		got = rd ? ::recv( sd, buf, len, 0 ) : ::send( sd, buf, len, MSG_NOSIGNAL );
+		if ( got <= 0 ) {
+			return false;
+		}
+		buf += got;
+		len -= got;
+	}
+	return true;
+}
+
+// 'buf' must provide room for the header in front of the payload
+static bool
+sendFrame(int sd, uint8_t *buf, uint32_t size)
+{
+uint32_t lenNBO = htonl( size );
+	memcpy( buf - sizeof(lenNBO), &lenNBO, sizeof(lenNBO) );
+	return xfer( sd, buf - sizeof(lenNBO), sizeof(lenNBO) + size, false );
+}
+
+static bool
+recvFrame(int sd, uint8_t *buf, uint32_t size)
+{
+uint32_t lenNBO;
+	if ( ! xfer( sd, (uint8_t*)&lenNBO, sizeof(lenNBO), true ) ) {
+		return false;
+	}
+	return ntohl( lenNBO ) == size && xfer( sd, buf, size, true );
+}
+
+// send a window full of frames, then read them back
+static void *
+client(void *arg)
+{
+Client            *me = static_cast<Client*>( arg );
+int                sd;
+struct sockaddr_in sin;
+struct timeval     tmo;
+uint8_t            fbuf[sizeof(uint32_t) + MAX_SIZE];
+uint8_t           *sbuf = fbuf + sizeof(uint32_t);
+uint8_t            rbuf[MAX_SIZE];
+unsigned           sent, rcvd, i;
+
+	me->failed = true;
+
+	if ( (sd = socket( AF_INET, SOCK_STREAM, 0 )) < 0 ) {
+		perror("client socket");
+		return NULL;
+	}
+	tmo.tv_sec          = 5;
+	tmo.tv_usec         = 0;
+	sin.sin_family      = AF_INET;
+	sin.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sin.sin_port        = htons( me->port );
+	if ( setsockopt( sd, SOL_SOCKET, SO_RCVTIMEO, &tmo, sizeof(tmo) ) || connect( sd, (struct sockaddr*)&sin, sizeof(sin) ) ) {
+		perror("client connect");
+		close( sd );
+		return NULL;
+	}
+
+	for ( i = 0; i < me->size; i++ ) {
+		sbuf[i] = (uint8_t)(me->idx + i);
+	}
+
+	for ( rcvd = sent = 0; rcvd < me->nFrames; ) {
+		while ( sent < me->nFrames && sent - rcvd < me->window ) {
+			memcpy( sbuf, &sent, sizeof(sent) );
+			if ( ! sendFrame( sd, sbuf, me->size ) ) {
+				fprintf(stderr,"Client %u: send failed\n", me->idx);
+				close( sd );
+				return NULL;
+			}
+			sent++;
+		}
+		while ( rcvd < sent ) {
+			if ( ! recvFrame( sd, rbuf, me->size ) ) {
+				fprintf(stderr,"Client %u: frame %u missing or bad length\n", me->idx, rcvd);
+				close( sd );
+				return NULL;
+			}
+			memcpy( sbuf, &rcvd, sizeof(rcvd) );
+			if ( memcmp( sbuf, rbuf, me->size ) ) {
+				fprintf(stderr,"Client %u: frame %u data mismatch\n", me->idx, rcvd);
+				close( sd );
+				return NULL;
+			}
+			rcvd++;
+		}
+	}
+
+	close( sd );
+	me->failed = false;
+	return NULL;
+}
+
+static void
+usage(const char *nm)
+{
+	fprintf(stderr,"Usage: %s [-w <workers>] [-b <bridges>] [-n <frames>] [-s <size>] [-W <window>] [-p <port>] [-r] [-h]\n", nm);
+	fprintf(stderr,"       -w <workers>: number of reactor workers (default 2)\n");
+	fprintf(stderr,"       -b <bridges>: number of bridges/clients (default 6)\n");
+	fprintf(stderr,"       -n <frames> : frames per client (default 1000)\n");
+	fprintf(stderr,"       -s <size>   : frame size in bytes (default 64)\n");
+	fprintf(stderr,"       -W <window> : max. number of frames in flight per client (default 8)\n");
+	fprintf(stderr,"       -p <port>   : first UDP port of the echo servers (default 8310)\n");
+	fprintf(stderr,"       -r          : use RSSI between bridge and echo server\n");
+}
+
+int
+main(int argc, char **argv)
+{
+unsigned               nWorkers = 2;
+unsigned               nBridges = 6;
+unsigned               nFrames  = 1000;
+unsigned               size     = 64;
+unsigned               window   = 8;
+unsigned               udpPort  = 8310;
+bool                   useRssi  = false;
+unsigned              *u_p;
+int                    opt;
+unsigned               i;
+std::vector<Client>    clients;
+std::vector<pthread_t> tids;
+pthread_t              tid;
+bool                   failed   = false;
+
+	while ( (opt = getopt(argc, argv, "w:b:n:s:W:p:rh")) > 0 ) {
+		u_p = 0;
+		switch ( opt ) {
+			case 'w': u_p = &nWorkers; break;
+			case 'b': u_p = &nBridges; break;
+			case 'n': u_p = &nFrames;  break;
+			case 's': u_p = &size;     break;
+			case 'W': u_p = &window;   break;
+			case 'p': u_p = &udpPort;  break;
+			case 'r': useRssi = true;  break;
+			case 'h': usage( argv[0] ); return 0;
+			default:
+				usage( argv[0] );
+				return 1;
+		}
+		if ( u_p && 1 != sscanf(optarg, "%i", u_p) ) {
+			fprintf(stderr,"Unable to scan argument to option '-%c'\n", opt);
+			return 1;
+		}
+	}
+
+	if ( size < sizeof(unsigned) || size > MAX_SIZE || 0 == window || 0 == nBridges ) {
+		fprintf(stderr,"Invalid size, window or number of bridges\n");
+		return 1;
+	}
+
+try {
+	BridgeReactor reactor = IBridgeReactor::create( nWorkers );
+
+	clients.resize( nBridges );
+	tids.resize( nBridges );
+
+	for ( i = 0; i < nBridges; i++ ) {
+		IoPrt echo = udpPrtCreate( "127.0.0.1", udpPort + i, 0, 0, useRssi ? WITH_RSSI : WITHOUT_RSSI );
+		if ( pthread_create( &tid, NULL, echoServer, echo ) ) {
+			perror("pthread_create (echo)");
+			throw TestFailed();
+		}
+		clients[i].port    = reactor->addBridge( "127.0.0.1", udpPort + i, 0, useRssi ? IBridgeReactor::RSSI : IBridgeReactor::NONE );
+		clients[i].idx     = i;
+		clients[i].nFrames = nFrames;
+		clients[i].size    = size;
+		clients[i].window  = window;
+		clients[i].failed  = true;
+	}
+
+	for ( i = 0; i < nBridges; i++ ) {
+		if ( pthread_create( &tids[i], NULL, client, &clients[i] ) ) {
+			perror("pthread_create (client)");
+			throw TestFailed();
+		}
+	}
+
+	for ( i = 0; i < nBridges; i++ ) {
+		pthread_join( tids[i], NULL );
+		failed = failed || clients[i].failed;
+	}
+
+	if ( failed ) {
+		throw TestFailed();
+	}
+
+	printf("%u bridges (%u workers, %s): relayed %u frames of %u bytes each\n",
+		nBridges, reactor->getNumWorkers(), useRssi ? "RSSI" : "plain UDP", nFrames, size);
+
+} catch ( CPSWError &e ) {
+	fprintf(stderr,"CPSW Error: %s\n", e.getInfo().c_str());
+	return 1;
+} catch ( TestFailed ) {
+	fprintf(stderr,"Test FAILED\n");
+	return 1;
+}
+
+	printf("Test PASSED\n");
+	return 0;
+}
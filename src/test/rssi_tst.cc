@@ -10,6 +10,57 @@
 #include <udpsrv_rssi_port.h>
 #include <stdio.h>
 #include <signal.h>
+#include <time.h>
+
+// Benchmark consumer; verifies the sequence and records
+// the arrival time of the last segment.
+class CCountingSink : public CRunnable {
+private:
+	ProtoPort              port_;
+	unsigned               n_;
+	cpsw::atomic<unsigned> got_;
+	cpsw::atomic<bool>     bad_;
+	struct timespec        done_;
+
+public:
+	CCountingSink(ProtoPort port, unsigned n)
+	: CRunnable( "Counting Sink" ),
+	  port_    ( port            ),
+	  n_       ( n               ),
+	  got_     ( 0               ),
+	  bad_     ( false           )
+	{
+	}
+
+	virtual void *threadBody()
+	{
+	unsigned i, got;
+		while ( (got = got_.load()) < n_ ) {
+			BufChain bc = port_->pop( NULL );
+			memcpy( &i, bc->getHead()->getPayload(), sizeof(i) );
+			if ( i != got ) {
+				fprintf(stderr,"Counting Sink: mismatch @i: %u, expected: %u\n", i, got);
+				bad_.store( true );
+				break;
+			}
+			if ( got + 1 == n_ )
+				clock_gettime( CLOCK_MONOTONIC, &done_ );
+			got_.store( got + 1 );
+		}
+		return NULL;
+	}
+
+	unsigned getCount() { return got_.load(); }
+	bool     isBad()    { return bad_.load(); }
+
+	// valid once all segments have been received
+	const struct timespec *getDone() { return &done_; }
+
+	virtual ~CCountingSink()
+	{
+		threadStop();
+	}
+};
 
 
 static void sh(int sig)
@@ -19,9 +70,16 @@ static void sh(int sig)
 
 static void usage(const char *nm)
 {
-	fprintf(stderr,"Usage: %s [-s <sleep_us>] [-n <packets>] [-L <percent dropped packets>] [-G garblDepth] [-h]\n", nm);
+	fprintf(stderr,"Usage: %s [-s <sleep_us>] [-n <packets>] [-L <percent dropped packets>] [-G garblDepth] [-W ldWindow] [-b] [-P] [-E] [-R rate] [-Q depth] [-h]\n", nm);
 	fprintf(stderr,"Note: garbled packet depth quickly leads to out-of sequence packets\n");
 	fprintf(stderr,"      probability a packet is delayed more than N cycles is ((Depth-1)/Depth)^N\n");
+	fprintf(stderr,"      ldWindow: log2 of max. unacked segments (default %u)\n", CRssiConfigParams::LD_MAX_UNACKED_SEGS_DFLT);
+	fprintf(stderr,"      -b      : benchmark; wait for all packets to arrive and report goodput\n");
+	fprintf(stderr,"      -P      : enable TX pacing/congestion control\n");
+	fprintf(stderr,"      -E      : request extended (selective) ACKs\n");
+	fprintf(stderr,"      -R rate : max. pacing rate (segments/s; default: auto)\n");
+	fprintf(stderr,"      -Q depth: depth of loopback queues (default: 2*window);\n");
+	fprintf(stderr,"                a small depth simulates a small switch buffer/FIFO\n");
 }
 
 int
@@ -32,17 +90,29 @@ unsigned sleep_us                = 0;
 unsigned dropped_packets_percent = 0;
 unsigned garbl_depth             = 0;
 unsigned n_packets               = 100000;
+unsigned ld_window               = CRssiConfigParams::LD_MAX_UNACKED_SEGS_DFLT;
+unsigned tx_rate                 = CRssiConfigParams::TX_RATE_DFLT;
+unsigned loop_depth              = 0;
+bool     benchmark               = false;
+bool     pacing                  = CRssiConfigParams::TX_PACING_DFLT;
+bool     eacks                   = CRssiConfigParams::EACKS_DFLT;
 int      opt;
 unsigned *i_p;
 int      rval = 1;
 
-	while ( (opt = getopt(argc, argv, "s:L:G:n:h")) > 0 ) {
+	while ( (opt = getopt(argc, argv, "s:L:G:n:W:bPER:Q:h")) > 0 ) {
 		i_p = 0;
 		switch (opt) {
+			case 'b': benchmark = true;               continue;
+			case 'P': pacing    = true;               continue;
+			case 'E': eacks     = true;               continue;
+			case 'R': i_p = &tx_rate;                 break;
+			case 'Q': i_p = &loop_depth;              break;
 			case 's': i_p = &sleep_us;                break;
 			case 'L': i_p = &dropped_packets_percent; break;
 			case 'G': i_p = &garbl_depth;             break;
 			case 'n': i_p = &n_packets;               break;
+			case 'W': i_p = &ld_window;               break;
 
 			case 'h': rval = 0;
 			default:
@@ -61,31 +131,66 @@ int      rval = 1;
 		return 1;
 	}
 
+	if ( ld_window > CRssiConfigParams::LD_MAX_UNACKED_SEGS_MAX ) {
+		fprintf(stderr,"requested window too big\n");
+		usage(argv[0]);
+		return 1;
+	}
+
 	if ( signal(SIGINT, sh) ) {
 		perror("Unable to install signal handler");
 	}
 
 for ( j=0; j<1; j++ ) {
-	RssiPort  server = CRssiPort::create(true);
-	RssiPort  client = CRssiPort::create(false);
+	CRssiConfigParams config( ld_window );
+	config.txPacing_         = pacing;
+	config.txRateSegsPerSec_ = tx_rate;
+	config.extendedAcks_     = eacks;
+	RssiPort  server = CRssiPort::create(true,  &config);
+	RssiPort  client = CRssiPort::create(false, &config);
 	ProtoPort sSink  = ISink::create("Server Sink");
-	ProtoPort cSink  = ISink::create("Client Sink", sleep_us);
+	ProtoPort cSink;
+	CCountingSink *cCnt = 0;
 	unsigned i = 0;
+	struct timespec start;
+	double          secs;
 
-	LoopbackPorts loop = ILoopbackPorts::create(32,dropped_packets_percent,garbl_depth);
+	if ( ! loop_depth )
+		loop_depth = 2*(1<<ld_window);
+
+	LoopbackPorts loop = ILoopbackPorts::create(loop_depth,dropped_packets_percent,garbl_depth);
 
 	printf("Loopback created\n");
 	client->attach( loop->getPortA() );
 	server->attach( loop->getPortB() );
 
 	sSink->attach( server );
-	cSink->attach( client );
 
 	server->start();
 	client->start();
-	cSink->start();
+	if ( benchmark ) {
+		cCnt = new CCountingSink( client, n_packets );
+		cCnt->threadStart();
+	} else {
+		cSink = ISink::create("Client Sink", sleep_us);
+		cSink->attach( client );
+		cSink->start();
+	}
 	sSink->start();
 
+	if ( cCnt ) {
+		// segments queued while the connection is being
+		// (re-)established are discarded
+		for ( i = 0; i < 10000 && ! ( server->isConnected() && client->isConnected() ); i++ ) {
+			struct timespec wai;
+			wai.tv_sec  = 0;
+			wai.tv_nsec = 1000000;
+			nanosleep( &wai, NULL );
+		}
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
 	for ( i=0; i<n_packets; i++ ) {
 		BufChain bc = IBufChain::create();
 		Buf b       = bc->createAtHead( IBuf::CAPA_ETH_HDR );
@@ -95,17 +200,47 @@ for ( j=0; j<1; j++ ) {
 		sSink->push(bc, NULL);
 	}
 
+	if ( cCnt ) {
+		// allow for 1ms per segment (incl. connection setup)
+		for ( i = 0; i < n_packets + 5000 && cCnt->getCount() < n_packets && ! cCnt->isBad(); i++ ) {
+			struct timespec wai;
+			wai.tv_sec  = 0;
+			wai.tv_nsec = 1000000;
+			nanosleep( &wai, NULL );
+		}
+		if ( cCnt->getCount() < n_packets ) {
+			fprintf(stderr,"Benchmark FAILED: only %u out of %u segments received\n", cCnt->getCount(), n_packets);
+		} else {
+			secs = (double)(cCnt->getDone()->tv_sec  - start.tv_sec)
+			     + (double)(cCnt->getDone()->tv_nsec - start.tv_nsec)/1.0E9;
+			printf("Goodput (%s, %u%% loss, window %u, queue depth %u): %.0f segments/s\n",
+				pacing ? "paced" : "unpaced",
+				dropped_packets_percent,
+				1<<ld_window,
+				loop_depth,
+				(double)n_packets/secs);
+			rval = 0;
+		}
+	}
+
 	server->dumpStats(stderr);
 	client->dumpStats(stderr);
 
 	sSink->stop();
-	cSink->stop();
+	if ( cCnt ) {
+		delete cCnt;
+	} else {
+		cSink->stop();
+	}
 	client->stop();
 	server->stop();
 
 
 }
 	printf("Left braces\n");
+	if ( benchmark ) {
+		return rval;
+	}
 #if 0
 	printf("Bufs Free %d, alloced %d in use %d\n",
 		IBuf::numBufsFree(),
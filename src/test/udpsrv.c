@@ -467,7 +467,7 @@ RxBuf         rxbuf;
 	while ( 1 ) {
 
 		do {
-			clock_gettime( CLOCK_REALTIME, &to );
+			clock_gettime( CLOCK_MONOTONIC, &to );
 
 			to.tv_sec  += STREAM_POLL_SECS;
 
@@ -825,7 +825,7 @@ unsigned fram = -1;
 			do {
 				struct timespec to;
 
-				clock_gettime( CLOCK_REALTIME, &to );
+				clock_gettime( CLOCK_MONOTONIC, &to );
 
 				to.tv_nsec += sa->isRunning ? 10000000 : 100000000;
 				if ( to.tv_nsec >= 1000000000 ) {
@@ -834,7 +834,7 @@ unsigned fram = -1;
 				}
 
 				if ( sa->ileave ) {
-					clock_nanosleep( CLOCK_REALTIME, TIMER_ABSTIME, &to, 0 );
+					clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &to, 0 );
 				} else {
 					fragger_rx( sa, &to );
 				}